@@ -3,11 +3,20 @@
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
-#ifdef _WIN32
-#include <windows.h>
-#endif
-
-#define MAX_LEN 100
+#include "scheduler.h"
+#include "server.h"
+#include "platform.h"
+#include "perf.h"
+#include "memstat.h"
+#include "trace.h"
+#include "reminder.h"
+#include "autoremind.h"
+#include "notify.h"
+#include "qrcode.h"
+
+#define TRACE_EVENTS (1 << 20) // most recent spans kept by --trace
+#define NOTIFY_DELAY_MILLIS 2000 // changes this close together go to each recipient as one message
+#define NOTIFY_MAX_PENDING 1000  // unless this many are waiting
 
 // ANSI color codes for vibrant CLI
 #define COLOR_RESET "\033[0m"
@@ -18,65 +27,36 @@
 #define COLOR_ERROR "\033[1;38;5;196m"   // Red
 #define COLOR_HILITE "\033[1;38;5;208m"  // Orange
 
-typedef struct Lecture
-{
-    char day[MAX_LEN];
-    char time[MAX_LEN];
-    char subject[MAX_LEN];
-    char faculty[MAX_LEN];
-    char section;
-    struct Lecture *next;
-} Lecture;
-
-Lecture *head = NULL;
-
-// Stack for undo
-Lecture *stack[100];
-int top = -1;
-
-// Queue for swap
-Lecture *queue[100];
-int front = -1, rear = -1;
-
-// Structure to store teacher workload
-typedef struct
-{
-    char name[MAX_LEN];
-    int lectureCount;
-    char sections[4]; // To store which sections they teach
-    int sectionCount;
-} TeacherLoad;
-
-// Structure to store subject information
+// The timetable edited by this CLI (one client of the scheduler library)
+Timetable *tt = NULL;
+TimetableTxn *batchTxn = NULL; // open batch transaction between begin and commit
+ReminderQueue *reminders = NULL; // reminders fire on their own thread, see --reminders
+ReminderSink reminderSink;       // where they go, shared with the lecture reminders
+void *reminderSinkCtx;
+FILE *reminderLog = NULL;        // file of the file: reminder sink
+char reminderCommand[256];       // command of the cmd: reminder sink
+LectureReminders *lectureReminders = NULL; // reminders before every lecture, when on
+NotifyQueue *notices = NULL;     // outbound notifications, sent in batches on their own thread, see --notify
+FILE *notifyLog = NULL;          // file of the file: notification transport
+char notifyCommand[256];         // command of the cmd: notification transport
+#define EXPORT_CACHE_SIZE 64 // exports remembered, the least recently used dropped first
+#define ROW_IO_BUFFER (1 << 20) // stdio buffer for CSV and JSON lines files
+
+// A file written by an export and the content hash it was written from
 typedef struct
 {
-    char code[MAX_LEN];
-    char name[MAX_LEN];
-    int isLab;
-} SubjectInfo;
+    char key[SECTION_NAME_LEN]; // section, "" for the full timetable
+    unsigned long long hash;
+    char filename[100];
+} ExportEntry;
 
-// Structure to store time slot information
-typedef struct
-{
-    char day[4];
-    char time[MAX_LEN];
-    char section;
-} TimeSlot;
-
-// Global variables
-SubjectInfo curriculum[] = {
-    {"TMC201", "Advanced Database Management Systems", 0},
-    {"TMC202", "Advanced Java Programming", 0},
-    {"TMC203", "Data Structures", 0},
-    {"TMC215", "DSE-II: Human-Computer Interaction", 0},
-    {"TMC221", "GE-I: Research Methodology", 0},
-    {"XMC201", "Career Skills-II", 0},
-    {"PMC201", "ADBMS Laboratory", 1},
-    {"PMC202", "Advanced Java Programming Lab", 1},
-    {"PMC203", "Data Structures Laboratory", 1},
-    {"GP201", "General Proficiency", 0},
-    {"PBL", "PROJECT BASED LEARNING", 0}};
-const int CURRICULUM_SIZE = sizeof(curriculum) / sizeof(curriculum[0]);
+ExportEntry exportCache[EXPORT_CACHE_SIZE]; // most recently used first
+int exportCacheCount = 0;
+long long exportsWritten = 0, exportsReused = 0;
+char shareBaseUrl[256] = "";    // where shared files are published, see --share-url
+char termStart[16] = "", termEnd[16] = ""; // YYYY-MM-DD dates the calendar exports run between, see --term
+char diffSection[SECTION_NAME_LEN];            // section of the last change written to a diff report
+const TimetableVersion *notifiedVersion = NULL; // last version teachers were told about, while change notifications are on
 
 // Multi-language support (English/Hindi demo)
 #define LANG_EN 0
@@ -105,474 +85,341 @@ const char *UI_LANG_PROMPT = "Select Language / भाषा चुनें:\n1
 #define UI(idx) UI_MENU[idx][currentLang]
 
 // Function declarations
-void insertLecture(char *day, char *time, char *subject, char *faculty, char section);
-const char *getSubjectName(const char *subjectCode);
-void printTimetable(char section);
+void insertLecture(char *day, char *time, char *subject, char *faculty, const char *section);
+void printTimetable(const char *section);
 void initializeTimetable(void);
-void swapTeachersFlexible(char section1, char section2, int swapTeacher);
-void swapWithinSection(char section, const char *day, int slot1, int slot2, int swapTeacher);
+void swapTeachersFlexible(int swapTeacher);
+void swapWithinSection(const char *section, const char *day, int slot1, int slot2, int swapTeacher);
 void saveTimetableAs(const char *filename);
 void url_encode(const char *src, char *dest, int max_len);
 void shareLinkToWhatsAppGroup(const char *link);
+int runBatch(const char *filename);
+int writeRoomReport(FILE *fp);
 
-// Insert a new lecture
-void insertLecture(char *day, char *time, char *subject, char *faculty, char section)
+// Lecture theatre each section is taught in, shared by two sections for combined lectures
+static const char *const HOME_ROOMS[][2] = {{"A", "LT-402"}, {"B", "LT-402"}, {"C", "LT-501"}, {"D", "LT-501"}};
+
+const char *homeRoom(const char *section)
 {
-    Lecture *newLecture = (Lecture *)malloc(sizeof(Lecture));
-    if (newLecture == NULL)
+    for (size_t i = 0; i < sizeof(HOME_ROOMS) / sizeof(HOME_ROOMS[0]); i++)
     {
-        printf("Memory allocation failed!\n");
-        return;
+        if (strcmp(HOME_ROOMS[i][0], section) == 0)
+            return HOME_ROOMS[i][1];
     }
-    strcpy(newLecture->day, day);
-    strcpy(newLecture->time, time);
-    strcpy(newLecture->subject, subject);
-    strcpy(newLecture->faculty, faculty);
-    newLecture->section = section;
-    newLecture->next = head;
-    head = newLecture;
+    return NULL;
 }
 
-// Push to undo stack
-void push(Lecture *lec)
+// Insert a new lecture; a teacher's lecture without a room of its own is booked
+// into the section's lecture theatre
+void insertLecture(char *day, char *time, char *subject, char *faculty, const char *section)
 {
-    stack[++top] = lec;
+    char booked[MAX_LEN];
+    const char *room = homeRoom(section);
+    if (room != NULL && strcmp(faculty, "-") != 0 && strchr(faculty, '(') == NULL)
+    {
+        snprintf(booked, sizeof(booked), "%s (%s)", faculty, room);
+        faculty = booked;
+    }
+    int status = timetableInsertLecture(tt, day, time, subject, faculty, section);
+    if (status != TT_OK)
+    {
+        printf("Could not add %s on %s %s: %s\n", subject, day, time, timetableStrError(status));
+    }
 }
 
-// Pop from undo stack
-Lecture *pop()
+// Print the lectures of one day as a table, already sorted by time
+void printLectureRows(const Lecture lectures[], int lectureCount)
 {
-    if (top == -1)
-        return NULL;
-    return stack[top--];
-}
+    printf("-----------------------------------------------------------------------------------\n");
+    printf("%-13s | %-7s | %-35s | %-15s | %-15s |\n",
+           "Time", "Code", "Subject", "Faculty", "Room");
+    printf("-----------------------------------------------------------------------------------\n");
 
-// Add to queue
-void enqueue(Lecture *lec)
-{
-    if (front == -1)
-        front = 0;
-    queue[++rear] = lec;
-}
+    for (int j = 0; j < lectureCount; j++)
+    {
+        char truncatedSubject[36] = "";
+        char truncatedFaculty[16] = "";
 
-// Remove from queue
-Lecture *dequeue()
-{
-    if (front == -1 || front > rear)
-        return NULL;
-    return queue[front++];
+        // Truncate subject and faculty if necessary
+        strncpy(truncatedSubject, getSubjectName(lectures[j].subject), 35);
+        truncatedSubject[35] = '\0';
+        strncpy(truncatedFaculty, lectures[j].faculty, 15);
+        truncatedFaculty[15] = '\0';
+
+        printf("%-13s | %-7s | %-35s | %-15s | %-15s |\n",
+               lectures[j].time,
+               lectures[j].subject,
+               truncatedSubject,
+               truncatedFaculty,
+               lectures[j].room);
+    }
+    printf("-----------------------------------------------------------------------------------\n");
 }
 
 // Print timetable for a section
-void printTimetable(char section)
+void printTimetable(const char *section)
 {
-    Lecture *temp = head;
     printf("\n================================================================\n");
-    printf("                    TIMETABLE FOR SECTION %c                        \n", section);
+    printf("                    TIMETABLE FOR SECTION %s                        \n", section);
     printf("================================================================\n\n");
 
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-    const char *fullDays[] = {"MONDAY", "TUESDAY", "WEDNESDAY", "THURSDAY", "FRIDAY", "SATURDAY"};
-
     // For each day
-    for (int i = 0; i < 6; i++)
+    for (int i = 0; i < DAY_COUNT; i++)
     {
-        int hasLecture = 0;
-        temp = head;
-        while (temp)
-        {
-            if (temp->section == section && strcmp(temp->day, days[i]) == 0)
-            {
-                hasLecture = 1;
-                break;
-            }
-            temp = temp->next;
-        }
-
-        if (hasLecture)
+        Lecture lectures[MAX_DAY_LECTURES];
+        int lectureCount = timetableCollectDay(tt, section, DAY_CODES[i], lectures, MAX_DAY_LECTURES);
+        if (lectureCount > 0)
         {
-            printf("\n%s:\n", fullDays[i]);
-            printf("----------------------------------------------------------------\n");
-            printf("%-13s | %-7s | %-35s | %-15s |\n",
-                   "Time", "Code", "Subject", "Faculty");
-            printf("----------------------------------------------------------------\n");
-
-            // Sort lectures by time for this day
-            Lecture *sortedLectures[20];
-            int lectureCount = 0;
-
-            temp = head;
-            while (temp)
-            {
-                if (temp->section == section && strcmp(temp->day, days[i]) == 0)
-                {
-                    sortedLectures[lectureCount++] = temp;
-                }
-                temp = temp->next;
-            }
-
-            // Simple bubble sort by time
-            for (int j = 0; j < lectureCount - 1; j++)
-            {
-                for (int k = 0; k < lectureCount - j - 1; k++)
-                {
-                    if (strcmp(sortedLectures[k]->time, sortedLectures[k + 1]->time) > 0)
-                    {
-                        Lecture *temp = sortedLectures[k];
-                        sortedLectures[k] = sortedLectures[k + 1];
-                        sortedLectures[k + 1] = temp;
-                    }
-                }
-            }
-
-            // Print sorted lectures
-            for (int j = 0; j < lectureCount; j++)
-            {
-                const char *subjectName = getSubjectName(sortedLectures[j]->subject);
-                char truncatedSubject[36] = "";
-                char truncatedFaculty[16] = "";
-
-                // Truncate subject if necessary
-                strncpy(truncatedSubject, subjectName, 35);
-                truncatedSubject[35] = '\0';
-
-                // Truncate faculty if necessary
-                strncpy(truncatedFaculty, sortedLectures[j]->faculty, 15);
-                truncatedFaculty[15] = '\0';
-
-                printf("%-13s | %-7s | %-35s | %-15s |\n",
-                       sortedLectures[j]->time,
-                       sortedLectures[j]->subject,
-                       truncatedSubject,
-                       truncatedFaculty);
-            }
-            printf("----------------------------------------------------------------\n");
+            printf("\n%s:\n", DAY_NAMES[i]);
+            printLectureRows(lectures, lectureCount);
         }
     }
     printf("\n================================================================\n");
 }
 
 // Mark teacher unavailable and swap
-void handleUnavailable(char *faculty, char section)
+void handleUnavailable(char *faculty, const char *section)
 {
-    Lecture *temp = head;
-    while (temp)
-    {
-        if (strcmp(temp->faculty, faculty) == 0 && temp->section == section)
-        {
-            push(temp); // Save for undo
-            printf("\nTeacher %s unavailable for %s (%s).\n", faculty, temp->subject, temp->time);
-
-            // Try to swap with a lecture not using same teacher
-            Lecture *trySwap = head;
-            while (trySwap)
-            {
-                if (trySwap->section == section &&
-                    strcmp(trySwap->faculty, faculty) != 0 &&
-                    strcmp(trySwap->time, temp->time) != 0)
-                {
-
-                    printf("Swapped with %s (%s).\n", trySwap->subject, trySwap->faculty);
-
-                    // Swap contents
-                    char tmpSubject[MAX_LEN], tmpFaculty[MAX_LEN];
-                    strcpy(tmpSubject, temp->subject);
-                    strcpy(tmpFaculty, temp->faculty);
-                    strcpy(temp->subject, trySwap->subject);
-                    strcpy(temp->faculty, trySwap->faculty);
-                    strcpy(trySwap->subject, tmpSubject);
-                    strcpy(trySwap->faculty, tmpFaculty);
-
-                    return;
-                }
-                trySwap = trySwap->next;
-            }
-
-            printf("No swap possible. Marked as Free Period.\n");
-            strcpy(temp->subject, "Free Period");
-            strcpy(temp->faculty, "-");
-        }
-        temp = temp->next;
-    }
+    int status = timetableMarkUnavailable(tt, faculty, section);
+    if (status == 1)
+        printf("\nTeacher %s unavailable in Section %s, lecture swapped.\n", faculty, section);
+    else if (status == 0)
+        printf("\nTeacher %s unavailable in Section %s. No swap possible. Marked as Free Period.\n", faculty, section);
+    else
+        printf("\nTeacher %s has no lectures in Section %s.\n", faculty, section);
 }
 
 // Undo last change
 void undo()
 {
-    Lecture *lec = pop();
-    if (lec == NULL)
+    Lecture lec;
+    if (timetableUndo(tt, &lec) != TT_OK)
     {
         printf("Nothing to undo.\n");
         return;
     }
-    printf("Undo: Restored %s (%s).\n", lec->subject, lec->faculty);
+    printf("Undo: Restored %s (%s).\n", lec.subject, lec.faculty);
 }
 
 // Initial timetable data
 void initializeTimetable()
 {
+    // Lecture theatres seat two sections for combined lectures, labs two lab groups
+    timetableAddRoom(tt, "LT-402", 2);
+    timetableAddRoom(tt, "LT-501", 2);
+    timetableAddRoom(tt, "Lab 7", 2);
+    timetableAddRoom(tt, "IoT Lab", 2);
+
     // MONDAY
     // Section A & B (LT-402)
-    insertLecture("MON", "8:00-8:55", "TMC202", "Mr. Amit Juyal", 'A');
-    insertLecture("MON", "8:55-9:50", "TMC201", "Dr. Udham Singh", 'A');
-    insertLecture("MON", "10:10-11:05", "PBL", "-", 'A');
-    insertLecture("MON", "11:05-12:00", "XMC201", "Mr. Digamber", 'A');
+    insertLecture("MON", "8:00-8:55", "TMC202", "Mr. Amit Juyal", "A");
+    insertLecture("MON", "8:55-9:50", "TMC201", "Dr. Udham Singh", "A");
+    insertLecture("MON", "10:10-11:05", "PBL", "-", "A");
+    insertLecture("MON", "11:05-12:00", "XMC201", "Mr. Digamber", "A");
 
-    insertLecture("MON", "8:00-8:55", "TMC202", "Mr. Amit Juyal", 'B');
-    insertLecture("MON", "8:55-9:50", "TMC201", "Dr. Udham Singh", 'B');
-    insertLecture("MON", "10:10-11:05", "PBL", "-", 'B');
-    insertLecture("MON", "11:05-12:00", "XMC201", "Mr. Digamber", 'B');
+    insertLecture("MON", "8:00-8:55", "TMC202", "Mr. Amit Juyal", "B");
+    insertLecture("MON", "8:55-9:50", "TMC201", "Dr. Udham Singh", "B");
+    insertLecture("MON", "10:10-11:05", "PBL", "-", "B");
+    insertLecture("MON", "11:05-12:00", "XMC201", "Mr. Digamber", "B");
 
     // Section C & D (LT-501)
-    insertLecture("MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'C');
-    insertLecture("MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'C');
-    insertLecture("MON", "10:10-11:05", "PBL", "-", 'C');
-    insertLecture("MON", "11:05-12:00", "PBL", "-", 'C');
+    insertLecture("MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", "C");
+    insertLecture("MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "C");
+    insertLecture("MON", "10:10-11:05", "PBL", "-", "C");
+    insertLecture("MON", "11:05-12:00", "PBL", "-", "C");
 
-    insertLecture("MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'D');
-    insertLecture("MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'D');
-    insertLecture("MON", "10:10-11:05", "PBL", "-", 'D');
-    insertLecture("MON", "11:05-12:00", "PBL", "-", 'D');
+    insertLecture("MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", "D");
+    insertLecture("MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "D");
+    insertLecture("MON", "10:10-11:05", "PBL", "-", "D");
+    insertLecture("MON", "11:05-12:00", "PBL", "-", "D");
 
     // TUESDAY
     // Section A & B (LT-402)
-    insertLecture("TUE", "8:00-9:50", "PMC201", "Sec. A (Lab 7)", 'A');
-    insertLecture("TUE", "8:00-9:50", "PMC202", "Sec. B (IoT Lab)", 'B');
-    insertLecture("TUE", "10:10-11:05", "TMC203", "Mr. Neeraj", 'A');
-    insertLecture("TUE", "10:10-11:05", "TMC203", "Mr. Neeraj", 'B');
+    insertLecture("TUE", "8:00-9:50", "PMC201", "Sec. A (Lab 7)", "A");
+    insertLecture("TUE", "8:00-9:50", "PMC202", "Sec. B (IoT Lab)", "B");
+    insertLecture("TUE", "10:10-11:05", "TMC203", "Mr. Neeraj", "A");
+    insertLecture("TUE", "10:10-11:05", "TMC203", "Mr. Neeraj", "B");
 
     // Section C & D (LT-501)
-    insertLecture("TUE", "12:00-12:55", "PMC201", "Sec. C (Lab 7)", 'C');
-    insertLecture("TUE", "12:00-12:55", "PMC202", "Sec. D (IoT Lab)", 'D');
-    insertLecture("TUE", "2:10-3:05", "PMC203", "Sec. D (IoT Lab)", 'D');
+    insertLecture("TUE", "12:00-12:55", "PMC201", "Sec. C (Lab 7)", "C");
+    insertLecture("TUE", "12:00-12:55", "PMC202", "Sec. D (IoT Lab)", "D");
+    insertLecture("TUE", "2:10-3:05", "PMC203", "Sec. D (IoT Lab)", "D");
 
     // WEDNESDAY
     // Section A & B (LT-402)
-    insertLecture("WED", "8:00-8:55", "XMC201", "Mr. Aanand", 'A');
-    insertLecture("WED", "8:55-9:50", "TMC201", "Dr. Udham Singh", 'A');
-    insertLecture("WED", "10:10-11:05", "TMC203", "Mr. Neeraj", 'A');
-    insertLecture("WED", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", 'A');
-    insertLecture("WED", "12:00-12:55", "TMC202", "Mr. Amit Juyal", 'A');
-    insertLecture("WED", "2:10-3:05", "PMC201", "Sec. B (Lab 7)", 'A');
-
-    insertLecture("WED", "8:00-8:55", "XMC201", "Mr. Aanand", 'B');
-    insertLecture("WED", "8:55-9:50", "TMC201", "Dr. Udham Singh", 'B');
-    insertLecture("WED", "10:10-11:05", "TMC203", "Mr. Neeraj", 'B');
-    insertLecture("WED", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", 'B');
-    insertLecture("WED", "12:00-12:55", "TMC202", "Mr. Amit Juyal", 'B');
-    insertLecture("WED", "2:10-3:05", "PMC201", "Sec. B (Lab 7)", 'B');
+    insertLecture("WED", "8:00-8:55", "XMC201", "Mr. Aanand", "A");
+    insertLecture("WED", "8:55-9:50", "TMC201", "Dr. Udham Singh", "A");
+    insertLecture("WED", "10:10-11:05", "TMC203", "Mr. Neeraj", "A");
+    insertLecture("WED", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", "A");
+    insertLecture("WED", "12:00-12:55", "TMC202", "Mr. Amit Juyal", "A");
+    insertLecture("WED", "2:10-3:05", "PMC201", "Sec. B (Lab 7)", "A");
+
+    insertLecture("WED", "8:00-8:55", "XMC201", "Mr. Aanand", "B");
+    insertLecture("WED", "8:55-9:50", "TMC201", "Dr. Udham Singh", "B");
+    insertLecture("WED", "10:10-11:05", "TMC203", "Mr. Neeraj", "B");
+    insertLecture("WED", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", "B");
+    insertLecture("WED", "12:00-12:55", "TMC202", "Mr. Amit Juyal", "B");
+    insertLecture("WED", "2:10-3:05", "PMC201", "Sec. B (Lab 7)", "B");
 
     // Section C & D (LT-501)
-    insertLecture("WED", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'C');
-    insertLecture("WED", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'C');
-    insertLecture("WED", "11:05-12:00", "TMC203", "Mr. Neeraj", 'C');
-    insertLecture("WED", "12:00-12:55", "PMC203", "Sec. C (IoT Lab)", 'C');
+    insertLecture("WED", "8:00-8:55", "TMC201", "Dr. Udham Singh", "C");
+    insertLecture("WED", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "C");
+    insertLecture("WED", "11:05-12:00", "TMC203", "Mr. Neeraj", "C");
+    insertLecture("WED", "12:00-12:55", "PMC203", "Sec. C (IoT Lab)", "C");
 
-    insertLecture("WED", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'D');
-    insertLecture("WED", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'D');
-    insertLecture("WED", "11:05-12:00", "TMC203", "Mr. Neeraj", 'D');
+    insertLecture("WED", "8:00-8:55", "TMC201", "Dr. Udham Singh", "D");
+    insertLecture("WED", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "D");
+    insertLecture("WED", "11:05-12:00", "TMC203", "Mr. Neeraj", "D");
 
     // THURSDAY
     // Section A & B (LT-402)
-    insertLecture("THU", "8:00-9:50", "PMC202", "Sec. A (IoT Lab)", 'A');
-    insertLecture("THU", "8:00-9:50", "PMC203", "Sec. B (Lab 7)", 'B');
-    insertLecture("THU", "10:10-11:05", "TMC201", "Dr. Udham Singh", 'A');
-    insertLecture("THU", "10:10-11:05", "TMC201", "Dr. Udham Singh", 'B');
+    insertLecture("THU", "8:00-9:50", "PMC202", "Sec. A (IoT Lab)", "A");
+    insertLecture("THU", "8:00-9:50", "PMC203", "Sec. B (Lab 7)", "B");
+    insertLecture("THU", "10:10-11:05", "TMC201", "Dr. Udham Singh", "A");
+    insertLecture("THU", "10:10-11:05", "TMC201", "Dr. Udham Singh", "B");
 
     // Section C & D (LT-501)
-    insertLecture("THU", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'C');
-    insertLecture("THU", "8:55-9:50", "XMC201", "Mr. Aanand", 'C');
-    insertLecture("THU", "11:05-12:00", "TMC203", "Mr. Neeraj", 'C');
-    insertLecture("THU", "12:00-12:55", "PMC201", "Sec. D (Lab 7)", 'C');
-    insertLecture("THU", "12:00-12:55", "PMC202", "Sec. C (IoT Lab)", 'C');
-    insertLecture("THU", "2:10-3:05", "PDP PRACTICAL", "Ms. Sakshi", 'C');
-
-    insertLecture("THU", "8:00-8:55", "TMC201", "Dr. Udham Singh", 'D');
-    insertLecture("THU", "8:55-9:50", "XMC201", "Mr. Aanand", 'D');
-    insertLecture("THU", "11:05-12:00", "TMC203", "Mr. Neeraj", 'D');
-    insertLecture("THU", "12:00-12:55", "PMC201", "Sec. D (Lab 7)", 'D');
-    insertLecture("THU", "12:00-12:55", "PMC202", "Sec. C (IoT Lab)", 'D');
-    insertLecture("THU", "2:10-3:05", "PDP PRACTICAL", "Ms. Sakshi", 'D');
+    insertLecture("THU", "8:00-8:55", "TMC201", "Dr. Udham Singh", "C");
+    insertLecture("THU", "8:55-9:50", "XMC201", "Mr. Aanand", "C");
+    insertLecture("THU", "11:05-12:00", "TMC203", "Mr. Neeraj", "C");
+    insertLecture("THU", "12:00-12:55", "PMC201", "Sec. D (Lab 7)", "C");
+    insertLecture("THU", "12:00-12:55", "PMC202", "Sec. C (IoT Lab)", "C");
+    insertLecture("THU", "2:10-3:05", "PDP PRACTICAL", "Ms. Sakshi", "C");
+
+    insertLecture("THU", "8:00-8:55", "TMC201", "Dr. Udham Singh", "D");
+    insertLecture("THU", "8:55-9:50", "XMC201", "Mr. Aanand", "D");
+    insertLecture("THU", "11:05-12:00", "TMC203", "Mr. Neeraj", "D");
+    insertLecture("THU", "12:00-12:55", "PMC201", "Sec. D (Lab 7)", "D");
+    insertLecture("THU", "12:00-12:55", "PMC202", "Sec. C (IoT Lab)", "D");
+    insertLecture("THU", "2:10-3:05", "PDP PRACTICAL", "Ms. Sakshi", "D");
 
     // FRIDAY
     // Section A & B (LT-402)
-    insertLecture("FRI", "8:00-8:55", "TMC203", "Mr. Neeraj", 'A');
-    insertLecture("FRI", "8:55-9:50", "XMC201", "Mr. Aanand", 'A');
-    insertLecture("FRI", "10:10-11:05", "TMC202", "Mr. Amit Juyal", 'A');
-    insertLecture("FRI", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", 'A');
+    insertLecture("FRI", "8:00-8:55", "TMC203", "Mr. Neeraj", "A");
+    insertLecture("FRI", "8:55-9:50", "XMC201", "Mr. Aanand", "A");
+    insertLecture("FRI", "10:10-11:05", "TMC202", "Mr. Amit Juyal", "A");
+    insertLecture("FRI", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", "A");
 
-    insertLecture("FRI", "8:00-8:55", "TMC203", "Mr. Neeraj", 'B');
-    insertLecture("FRI", "8:55-9:50", "XMC201", "Mr. Aanand", 'B');
-    insertLecture("FRI", "10:10-11:05", "TMC202", "Mr. Amit Juyal", 'B');
-    insertLecture("FRI", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", 'B');
+    insertLecture("FRI", "8:00-8:55", "TMC203", "Mr. Neeraj", "B");
+    insertLecture("FRI", "8:55-9:50", "XMC201", "Mr. Aanand", "B");
+    insertLecture("FRI", "10:10-11:05", "TMC202", "Mr. Amit Juyal", "B");
+    insertLecture("FRI", "11:05-12:00", "PDP PRACTICAL", "Ms. Sakshi", "B");
 
     // Section C & D (LT-501)
-    insertLecture("FRI", "8:00-8:55", "XMC201", "Mr. Aanand", 'C');
-    insertLecture("FRI", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'C');
-    insertLecture("FRI", "10:10-11:05", "TMC203", "Mr. Neeraj", 'C');
-    insertLecture("FRI", "12:00-12:55", "XMC201", "Mr. Vishal", 'C');
+    insertLecture("FRI", "8:00-8:55", "XMC201", "Mr. Aanand", "C");
+    insertLecture("FRI", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "C");
+    insertLecture("FRI", "10:10-11:05", "TMC203", "Mr. Neeraj", "C");
+    insertLecture("FRI", "12:00-12:55", "XMC201", "Mr. Vishal", "C");
 
-    insertLecture("FRI", "8:00-8:55", "XMC201", "Mr. Aanand", 'D');
-    insertLecture("FRI", "8:55-9:50", "TMC202", "Mr. Amit Juyal", 'D');
-    insertLecture("FRI", "10:10-11:05", "TMC203", "Mr. Neeraj", 'D');
-    insertLecture("FRI", "12:00-12:55", "XMC201", "Mr. Vishal", 'D');
+    insertLecture("FRI", "8:00-8:55", "XMC201", "Mr. Aanand", "D");
+    insertLecture("FRI", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "D");
+    insertLecture("FRI", "10:10-11:05", "TMC203", "Mr. Neeraj", "D");
+    insertLecture("FRI", "12:00-12:55", "XMC201", "Mr. Vishal", "D");
 
     // SATURDAY
     // Section A & B (LT-402)
-    insertLecture("SAT", "11:05-12:00", "PBL", "-", 'A');
-    insertLecture("SAT", "12:55-1:50", "PMC203", "Sec. A (Lab 7)", 'A');
+    insertLecture("SAT", "11:05-12:00", "PBL", "-", "A");
+    insertLecture("SAT", "12:55-1:50", "PMC203", "Sec. A (Lab 7)", "A");
 
     // Section C & D (LT-501)
     // No classes shown in timetable
 }
 
 // Function to print timetable for a specific day
-void printDayTimetable(char section, const char *day)
+void printDayTimetable(const char *section, const char *day)
 {
-    Lecture *temp = head;
-    int hasLecture = 0;
-
-    while (temp)
-    {
-        if (temp->section == section && strcmp(temp->day, day) == 0)
-        {
-            hasLecture = 1;
-            break;
-        }
-        temp = temp->next;
-    }
+    Lecture lectures[MAX_DAY_LECTURES];
+    int lectureCount = timetableCollectDay(tt, section, day, lectures, MAX_DAY_LECTURES);
 
-    if (!hasLecture)
+    if (lectureCount == 0)
     {
-        printf("\nNo lectures scheduled for this day in Section %c\n", section);
+        printf("\nNo lectures scheduled for this day in Section %s\n", section);
         return;
     }
 
     printf("\n================================================================\n");
-    printf("              TIMETABLE FOR SECTION %c - %s                        \n", section, day);
+    printf("              TIMETABLE FOR SECTION %s - %s                        \n", section, day);
     printf("================================================================\n");
-    printf("----------------------------------------------------------------\n");
-    printf("%-13s | %-7s | %-35s | %-15s |\n",
-           "Time", "Code", "Subject", "Faculty");
-    printf("----------------------------------------------------------------\n");
-
-    // Sort lectures by time
-    Lecture *sortedLectures[20];
-    int lectureCount = 0;
-
-    temp = head;
-    while (temp)
-    {
-        if (temp->section == section && strcmp(temp->day, day) == 0)
-        {
-            sortedLectures[lectureCount++] = temp;
-        }
-        temp = temp->next;
-    }
-
-    // Simple bubble sort by time
-    for (int i = 0; i < lectureCount - 1; i++)
-    {
-        for (int j = 0; j < lectureCount - i - 1; j++)
-        {
-            if (strcmp(sortedLectures[j]->time, sortedLectures[j + 1]->time) > 0)
-            {
-                Lecture *temp = sortedLectures[j];
-                sortedLectures[j] = sortedLectures[j + 1];
-                sortedLectures[j + 1] = temp;
-            }
-        }
-    }
-
-    // Print sorted lectures
-    for (int i = 0; i < lectureCount; i++)
-    {
-        const char *subjectName = getSubjectName(sortedLectures[i]->subject);
-        char truncatedSubject[36] = "";
-        char truncatedFaculty[16] = "";
-
-        // Truncate subject if necessary
-        strncpy(truncatedSubject, subjectName, 35);
-        truncatedSubject[35] = '\0';
-
-        // Truncate faculty if necessary
-        strncpy(truncatedFaculty, sortedLectures[i]->faculty, 15);
-        truncatedFaculty[15] = '\0';
-
-        printf("%-13s | %-7s | %-35s | %-15s |\n",
-               sortedLectures[i]->time,
-               sortedLectures[i]->subject,
-               truncatedSubject,
-               truncatedFaculty);
-    }
-    printf("----------------------------------------------------------------\n");
+    printLectureRows(lectures, lectureCount);
 }
 
 // Function to get available time slots for a section
-void getAvailableTimeSlots(char section, const char *day, int showAll)
+void getAvailableTimeSlots(const char *section, const char *day, int showAll)
 {
-    Lecture *temp = head;
-    int found = 0;
+    Lecture lectures[MAX_DAY_LECTURES];
+    int timeCount = timetableCollectDay(tt, section, day, lectures, MAX_DAY_LECTURES);
 
-    printf("\nAvailable time slots for Section %c on %s:\n", section, day);
+    printf("\nAvailable time slots for Section %s on %s:\n", section, day);
     printf("----------------------------------------\n");
 
-    // First pass: collect all time slots
-    char times[20][20];
-    int timeCount = 0;
-    while (temp)
-    {
-        if (temp->section == section && strcmp(temp->day, day) == 0)
-        {
-            strcpy(times[timeCount], temp->time);
-            timeCount++;
-        }
-        temp = temp->next;
-    }
-
-    // Sort time slots
-    for (int i = 0; i < timeCount - 1; i++)
-    {
-        for (int j = 0; j < timeCount - i - 1; j++)
-        {
-            if (strcmp(times[j], times[j + 1]) > 0)
-            {
-                char temp[20];
-                strcpy(temp, times[j]);
-                strcpy(times[j], times[j + 1]);
-                strcpy(times[j + 1], temp);
-            }
-        }
-    }
-
     // Display time slots
     for (int i = 0; i < timeCount; i++)
     {
-        temp = head;
-        while (temp)
+        if (showAll || strcmp(lectures[i].faculty, "-") == 0)
         {
-            if (temp->section == section && strcmp(temp->day, day) == 0 && strcmp(temp->time, times[i]) == 0)
-            {
-                if (showAll || strcmp(temp->faculty, "-") == 0)
-                {
-                    printf("%d. %s - %s - %s\n",
-                           i + 1,
-                           times[i],
-                           temp->subject,
-                           strcmp(temp->faculty, "-") == 0 ? "Free" : temp->faculty);
-                }
-                break;
-            }
-            temp = temp->next;
+            printf("%d. %s - %s - %s\n",
+                   i + 1,
+                   lectures[i].time,
+                   lectures[i].subject,
+                   strcmp(lectures[i].faculty, "-") == 0 ? "Free" : lectures[i].faculty);
         }
     }
     printf("----------------------------------------\n");
 }
 
+// Time of the n-th (1-based) slot listed by getAvailableTimeSlots, 0 if out of range
+int slotTime(const char *section, const char *day, int slot, char *time)
+{
+    Lecture lectures[MAX_DAY_LECTURES];
+    int count = timetableCollectDay(tt, section, day, lectures, MAX_DAY_LECTURES);
+    if (slot < 1 || slot > count)
+        return 0;
+    strcpy(time, lectures[slot - 1].time);
+    return 1;
+}
+
+// Function to read a section name after a prompt listing the sections; returns 1
+// if the timetable has that section
+int readSection(const char *prompt, char *section)
+{
+    char hint[128] = "";
+    int sectionCount = timetableSectionCount(tt);
+    if (sectionCount > 6)
+        snprintf(hint, sizeof(hint), "%s ... %s, %d sections", timetableSectionName(tt, 0),
+                 timetableSectionName(tt, sectionCount - 1), sectionCount);
+    for (int i = 0; i < sectionCount && sectionCount <= 6; i++)
+    {
+        strcat(hint, i > 0 ? "/" : "");
+        strcat(hint, timetableSectionName(tt, i));
+    }
+    printf("%s (%s): %s", prompt, hint, prompt[0] == '\033' ? COLOR_RESET : "");
+    section[0] = '\0';
+    if (scanf("%15s", section) != 1)
+        return 0;
+    return timetableSectionId(tt, section) >= 0;
+}
+
+// Function to list the days and read a choice, returns the day index or -1
+int chooseDay(void)
+{
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        printf("%d. %c", d + 1, DAY_NAMES[d][0]);
+        for (const char *c = DAY_NAMES[d] + 1; *c; c++)
+            putchar(tolower((unsigned char)*c));
+        putchar('\n');
+    }
+    printf("Enter choice (1-%d): ", DAY_COUNT);
+    int choice;
+    if (scanf("%d", &choice) != 1 || choice < 1 || choice > DAY_COUNT)
+        return -1;
+    return choice - 1;
+}
+
 // Function to swap teachers between two sections
-void swapTeachers(char section1, char section2)
+void swapTeachers(const char *section1, const char *section2)
 {
-    if (section1 == section2)
+    if (strcmp(section1, section2) == 0)
     {
         printf("\nCannot swap teachers within the same section!\n");
         return;
@@ -580,108 +427,65 @@ void swapTeachers(char section1, char section2)
 
     // Show day options
     printf("\nSelect Day:\n");
-    printf("1. Monday\n");
-    printf("2. Tuesday\n");
-    printf("3. Wednesday\n");
-    printf("4. Thursday\n");
-    printf("5. Friday\n");
-    printf("6. Saturday\n");
-    printf("Enter choice (1-6): ");
-
-    int dayChoice;
-    scanf("%d", &dayChoice);
-
-    if (dayChoice < 1 || dayChoice > 6)
+    int d = chooseDay();
+    if (d < 0)
     {
         printf("Invalid day choice!\n");
         return;
     }
 
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-    const char *fullDays[] = {"Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-    const char *selectedDay = days[dayChoice - 1];
+    const char *selectedDay = DAY_CODES[d];
 
     // Show available time slots for both sections
-    printf("\nTime slots for Section %c:\n", section1);
+    printf("\nTime slots for Section %s:\n", section1);
     getAvailableTimeSlots(section1, selectedDay, 1);
 
-    printf("\nTime slots for Section %c:\n", section2);
+    printf("\nTime slots for Section %s:\n", section2);
     getAvailableTimeSlots(section2, selectedDay, 1);
 
     // Get time slot choice
-    printf("\nEnter time slot number for Section %c: ", section1);
+    printf("\nEnter time slot number for Section %s: ", section1);
     int timeChoice1;
     scanf("%d", &timeChoice1);
 
-    printf("Enter time slot number for Section %c: ", section2);
+    printf("Enter time slot number for Section %s: ", section2);
     int timeChoice2;
     scanf("%d", &timeChoice2);
 
     // Find the lectures
-    Lecture *temp = head;
-    Lecture *lec1 = NULL;
-    Lecture *lec2 = NULL;
-    char time1[20] = "", time2[20] = "";
-
-    // Get time slots
-    int count = 0;
-    while (temp)
-    {
-        if (temp->section == section1 && strcmp(temp->day, selectedDay) == 0)
-        {
-            count++;
-            if (count == timeChoice1)
-            {
-                strcpy(time1, temp->time);
-            }
-        }
-        temp = temp->next;
-    }
-
-    count = 0;
-    temp = head;
-    while (temp)
-    {
-        if (temp->section == section2 && strcmp(temp->day, selectedDay) == 0)
-        {
-            count++;
-            if (count == timeChoice2)
-            {
-                strcpy(time2, temp->time);
-            }
-        }
-        temp = temp->next;
+    char time1[MAX_LEN] = "", time2[MAX_LEN] = "";
+    int found = slotTime(section1, selectedDay, timeChoice1, time1) &&
+                slotTime(section2, selectedDay, timeChoice2, time2);
+    int status = TT_ERR_NOT_FOUND;
+    TxnFailure failure;
+
+    if (found)
+    {
+        // Swap subjects, then everything back, so only the teachers change places.
+        // Both steps commit together, nobody sees the half-swapped state.
+        TimetableTxn *txn = timetableBegin(tt);
+        status = TT_ERR_NOMEM;
+        if (txn != NULL &&
+            txnSwap(txn, section1, selectedDay, time1, section2, selectedDay, time2, 0) == TT_OK &&
+            txnSwap(txn, section1, selectedDay, time1, section2, selectedDay, time2, 1) == TT_OK)
+            status = timetableCommit(txn, &failure);
+        else
+            timetableRollback(txn);
     }
 
-    // Find lectures for swapping
-    temp = head;
-    while (temp)
+    if (status == TT_OK)
     {
-        if (strcmp(temp->day, selectedDay) == 0)
-        {
-            if (temp->section == section1 && strcmp(temp->time, time1) == 0)
-            {
-                lec1 = temp;
-            }
-            if (temp->section == section2 && strcmp(temp->time, time2) == 0)
-            {
-                lec2 = temp;
-            }
-        }
-        temp = temp->next;
+        Lecture lec1, lec2;
+        timetableGetLecture(tt, section1, selectedDay, time1, &lec1);
+        timetableGetLecture(tt, section2, selectedDay, time2, &lec2);
+        printf("\nTeachers swapped successfully!\n");
+        printf("Section %s (%s): %s - %s\n", section1, time1, lec1.subject, lec1.faculty);
+        printf("Section %s (%s): %s - %s\n", section2, time2, lec2.subject, lec2.faculty);
     }
-
-    if (lec1 && lec2)
+    else if (status == TT_ERR_CONFLICT)
     {
-        // Swap faculty members
-        char tempFaculty[MAX_LEN];
-        strcpy(tempFaculty, lec1->faculty);
-        strcpy(lec1->faculty, lec2->faculty);
-        strcpy(lec2->faculty, tempFaculty);
-
-        printf("\nTeachers swapped successfully!\n");
-        printf("Section %c (%s): %s - %s\n", section1, time1, lec1->subject, lec1->faculty);
-        printf("Section %c (%s): %s - %s\n", section2, time2, lec2->subject, lec2->faculty);
+        printf("\nSwap cancelled: %s would teach Section %s and Section %s at %s.\n",
+               failure.lecture.faculty, failure.lecture.section, failure.other.section, failure.lecture.time);
     }
     else
     {
@@ -690,11 +494,8 @@ void swapTeachers(char section1, char section2)
 }
 
 // Function to change class of a section
-void changeClassSection(char oldSection, char newSection)
+void changeClassSection(const char *oldSection, const char *newSection)
 {
-    Lecture *temp = head;
-    int found = 0;
-
     printf("\nEnter the day (MON/TUE/WED/THU/FRI/SAT): ");
     char day[10];
     scanf("%s", day);
@@ -704,18 +505,14 @@ void changeClassSection(char oldSection, char newSection)
     scanf("%s", time);
 
     // Find the lecture to change
-    while (temp)
+    int found = timetableMoveSection(tt, oldSection, day, time, newSection) == TT_OK;
+    if (found)
     {
-        if (temp->section == oldSection && strcmp(temp->day, day) == 0 && strcmp(temp->time, time) == 0)
-        {
-            temp->section = newSection;
-            found = 1;
-            printf("\nClass changed successfully!\n");
-            printf("Changed from Section %c to Section %c\n", oldSection, newSection);
-            printf("Details: %s - %s - %s\n", temp->subject, temp->faculty, temp->time);
-            break;
-        }
-        temp = temp->next;
+        Lecture lec;
+        timetableGetLecture(tt, newSection, day, time, &lec);
+        printf("\nClass changed successfully!\n");
+        printf("Changed from Section %s to Section %s\n", oldSection, newSection);
+        printf("Details: %s - %s - %s\n", lec.subject, lec.faculty, lec.time);
     }
 
     if (!found)
@@ -724,115 +521,18 @@ void changeClassSection(char oldSection, char newSection)
     }
 }
 
-// Function to check if a string contains "Lab" or "Sec"
-int isLabOrSection(const char *str)
-{
-    return (strstr(str, "Lab") != NULL || strstr(str, "Sec") != NULL);
-}
-
-// Function to normalize teacher names
-void normalizeTeacherName(char *name)
-{
-    // Convert "Mr. Neeraj" and "Mr. Neeraj Panwar" to "Mr. Neeraj Panwar"
-    if (strcmp(name, "Mr. Neeraj") == 0)
-    {
-        strcpy(name, "Mr. Neeraj Panwar");
-    }
-}
-
 // Function to analyze teacher workload
 void analyzeTeacherLoad()
 {
-    TeacherLoad teachers[20]; // Assuming max 20 teachers
-    int teacherCount = 0;
-    const int MAX_LECTURES = 15; // Threshold for overloaded teachers
-
-    // Initialize teacher array
-    for (int i = 0; i < 20; i++)
-    {
-        teachers[i].lectureCount = 0;
-        teachers[i].sectionCount = 0;
-        memset(teachers[i].sections, 0, sizeof(teachers[i].sections));
-    }
-
-    // First pass: collect all unique teachers (excluding labs)
-    Lecture *temp = head;
-    while (temp)
-    {
-        if (strcmp(temp->faculty, "-") != 0 && !isLabOrSection(temp->faculty))
-        { // Skip free periods and labs
-            char normalizedName[MAX_LEN];
-            strcpy(normalizedName, temp->faculty);
-            normalizeTeacherName(normalizedName);
-
-            int found = 0;
-            for (int i = 0; i < teacherCount; i++)
-            {
-                if (strcmp(teachers[i].name, normalizedName) == 0)
-                {
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found)
-            {
-                strcpy(teachers[teacherCount].name, normalizedName);
-                teacherCount++;
-            }
-        }
-        temp = temp->next;
-    }
-
-    // Second pass: count lectures and collect sections (excluding labs)
-    temp = head;
-    while (temp)
-    {
-        if (strcmp(temp->faculty, "-") != 0 && !isLabOrSection(temp->faculty))
-        { // Skip free periods and labs
-            char normalizedName[MAX_LEN];
-            strcpy(normalizedName, temp->faculty);
-            normalizeTeacherName(normalizedName);
-
-            for (int i = 0; i < teacherCount; i++)
-            {
-                if (strcmp(teachers[i].name, normalizedName) == 0)
-                {
-                    teachers[i].lectureCount++;
-
-                    // Add section if not already present
-                    int sectionExists = 0;
-                    for (int j = 0; j < teachers[i].sectionCount; j++)
-                    {
-                        if (teachers[i].sections[j] == temp->section)
-                        {
-                            sectionExists = 1;
-                            break;
-                        }
-                    }
-                    if (!sectionExists)
-                    {
-                        teachers[i].sections[teachers[i].sectionCount++] = temp->section;
-                    }
-                    break;
-                }
-            }
-        }
-        temp = temp->next;
-    }
-
-    // Sort teachers by lecture count (descending)
-    for (int i = 0; i < teacherCount - 1; i++)
+    TeacherLoad teachers[64];
+    int teacherCount = timetableTeacherLoad(tt, teachers, 64);
+    if (teacherCount < 0)
     {
-        for (int j = 0; j < teacherCount - i - 1; j++)
-        {
-            if (teachers[j].lectureCount < teachers[j + 1].lectureCount)
-            {
-                TeacherLoad temp = teachers[j];
-                teachers[j] = teachers[j + 1];
-                teachers[j + 1] = temp;
-            }
-        }
+        printf("Memory allocation failed!\n");
+        return;
     }
+    int sectionCount = timetableSectionCount(tt);
+    const int MAX_LECTURES = 15; // Threshold for overloaded teachers
 
     // Display results
     printf("\n================================================================\n");
@@ -843,26 +543,12 @@ void analyzeTeacherLoad()
 
     for (int i = 0; i < teacherCount; i++)
     {
-        char sections[10] = "";
-        // Sort sections alphabetically
-        for (int j = 0; j < teachers[i].sectionCount - 1; j++)
-        {
-            for (int k = 0; k < teachers[i].sectionCount - j - 1; k++)
-            {
-                if (teachers[i].sections[k] > teachers[i].sections[k + 1])
-                {
-                    char temp = teachers[i].sections[k];
-                    teachers[i].sections[k] = teachers[i].sections[k + 1];
-                    teachers[i].sections[k + 1] = temp;
-                }
-            }
-        }
-
-        for (int j = 0; j < teachers[i].sectionCount; j++)
+        char sections[64] = "";
+        size_t used = 0;
+        for (int id = 0; id < sectionCount && used < sizeof(sections); id++)
         {
-            char temp[3];
-            sprintf(temp, "%c ", teachers[i].sections[j]);
-            strcat(sections, temp);
+            if (TEACHES_SECTION(&teachers[i], id))
+                used += snprintf(sections + used, sizeof(sections) - used, "%s ", timetableSectionName(tt, id));
         }
 
         printf("%-25s | %-15d | %-15s | %s\n",
@@ -877,88 +563,18 @@ void analyzeTeacherLoad()
 }
 
 // Function to check if time slot is available
-int isTimeSlotAvailable(const char *day, const char *time, char section)
-{
-    Lecture *temp = head;
-    while (temp)
-    {
-        if (temp->section == section &&
-            strcmp(temp->day, day) == 0 &&
-            strcmp(temp->time, time) == 0)
-        {
-            return 0; // Time slot is occupied
-        }
-        temp = temp->next;
-    }
-    return 1; // Time slot is available
-}
-
-// Function to get time string from choice
-void getTimeString(int choice, char *time)
-{
-    switch (choice)
-    {
-    case 1:
-        strcpy(time, "8:00-8:55");
-        break;
-    case 2:
-        strcpy(time, "8:55-9:50");
-        break;
-    case 3:
-        strcpy(time, "10:10-11:05");
-        break;
-    case 4:
-        strcpy(time, "11:05-12:00");
-        break;
-    case 5:
-        strcpy(time, "12:00-12:55");
-        break;
-    case 6:
-        strcpy(time, "2:10-3:05");
-        break;
-    case 7:
-        strcpy(time, "3:05-4:00");
-        break;
-    case 8:
-        strcpy(time, "4:00-4:55");
-        break;
-    case 9:
-        strcpy(time, "4:55-5:50");
-        break;
-    }
-}
-
-// Function to get unique subjects from timetable
-void getUniqueSubjects(SubjectInfo subjects[], int *count)
+int isTimeSlotAvailable(const char *day, const char *time, const char *section)
 {
-    *count = 0;
-
-    // Copy from curriculum
-    for (int i = 0; i < CURRICULUM_SIZE; i++)
-    {
-        strcpy(subjects[*count].code, curriculum[i].code);
-        strcpy(subjects[*count].name, curriculum[i].name);
-        subjects[*count].isLab = curriculum[i].isLab;
-        (*count)++;
-    }
+    return timetableIsSlotFree(tt, section, day, time);
 }
 
-// Function to find existing time slots for a subject
-void findExistingTimeSlots(const char *subject, TimeSlot slots[], int *count)
+// Function to get time string from choice (1-based period number of the day)
+void getTimeString(int day, int choice, char *time)
 {
-    *count = 0;
-    Lecture *temp = head;
-
-    while (temp)
+    const Calendar *calendar = timetableCalendar(tt);
+    if (choice >= 1 && choice <= calendarPeriodCount(calendar, day))
     {
-        if (strcmp(temp->subject, subject) == 0)
-        {
-            strcpy(slots[*count].day, temp->day);
-            strcpy(slots[*count].time, temp->time);
-            slots[*count].section = temp->section;
-            (*count)++;
-        }
-        temp = temp->next;
+        strcpy(time, calendarLabel(calendar, day, choice - 1));
     }
 }
 
@@ -969,10 +585,8 @@ void assignNewTeacher()
     char subject[MAX_LEN];
     char time[MAX_LEN];
     char day[4];
-    int dayChoice;
     int timeChoice;
     int subjectChoice;
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
 
     printf("\nEnter new teacher name: ");
     scanf(" %[^\n]s", teacherName);
@@ -1028,14 +642,14 @@ void assignNewTeacher()
             TimeSlot existingSlots[20];
             int slotCount = 0;
 
-            findExistingTimeSlots(subject, existingSlots, &slotCount);
+            slotCount = timetableFindSubjectSlots(tt, subject, existingSlots, 20);
 
             if (slotCount > 0)
             {
                 printf("\nFound existing time slots for %s:\n", subject);
                 for (int i = 0; i < slotCount; i++)
                 {
-                    printf("Section %c: %s %s\n",
+                    printf("Section %s: %s %s\n",
                            existingSlots[i].section,
                            existingSlots[i].day,
                            existingSlots[i].time);
@@ -1044,15 +658,7 @@ void assignNewTeacher()
                 printf("\nAssigning %s to these time slots...\n", teacherName);
 
                 // Update all existing slots with the new teacher
-                Lecture *temp = head;
-                while (temp)
-                {
-                    if (strcmp(temp->subject, subject) == 0)
-                    {
-                        strcpy(temp->faculty, teacherName);
-                    }
-                    temp = temp->next;
-                }
+                timetableAssignSubject(tt, subject, teacherName);
 
                 printf("\nTeacher assigned successfully!\n");
                 return;
@@ -1085,67 +691,71 @@ void assignNewTeacher()
     // or existing subjects with no time slots
 
     // For each section
-    char sections[] = {'A', 'B', 'C', 'D'};
-    for (int i = 0; i < 4; i++)
+    int sectionCount = timetableSectionCount(tt);
+    for (int i = 0; i < sectionCount; i++)
     {
-        char currentSection = sections[i];
+        const char *currentSection = timetableSectionName(tt, i);
         int validTimeSlot = 0;
 
         while (!validTimeSlot)
         {
             // Select day for current section
-            printf("\nSection %c - Select Day:\n", currentSection);
-            printf("1. Monday\n");
-            printf("2. Tuesday\n");
-            printf("3. Wednesday\n");
-            printf("4. Thursday\n");
-            printf("5. Friday\n");
-            printf("6. Saturday\n");
-            printf("Enter choice (1-6): ");
-            scanf("%d", &dayChoice);
-
-            if (dayChoice < 1 || dayChoice > 6)
+            printf("\nSection %s - Select Day:\n", currentSection);
+            int d = chooseDay();
+            if (d < 0)
             {
                 printf("Invalid day choice! Please try again.\n");
                 continue;
             }
 
-            strcpy(day, days[dayChoice - 1]);
+            strcpy(day, DAY_CODES[d]);
 
-            // Show available time slots and mark occupied ones
-            printf("\nAvailable Time Slots for Section %c on %s:\n", currentSection, days[dayChoice - 1]);
-            for (int j = 1; j <= 9; j++)
+            // Show available time slots and mark the ones the section (labs take
+            // several periods) or the teacher already has
+            const Calendar *calendar = timetableCalendar(tt);
+            int periodCount = calendarPeriodCount(calendar, d);
+            unsigned int teacherBusy = timetableTeacherPeriods(tt, teacherName, day);
+            printf("\nAvailable Time Slots for Section %s on %s:\n", currentSection, DAY_CODES[d]);
+            for (int j = 1; j <= periodCount; j++)
             {
                 char tempTime[MAX_LEN];
-                getTimeString(j, tempTime);
+                getTimeString(d, j, tempTime);
                 printf("%d. %s %s\n", j, tempTime,
-                       isTimeSlotAvailable(day, tempTime, currentSection) ? "(Available)" : "(Occupied)");
+                       !isTimeSlotAvailable(day, tempTime, currentSection) ? "(Occupied)"
+                       : teacherBusy & (1u << (j - 1))                     ? "(Teacher busy)"
+                                                                           : "(Available)");
             }
 
-            printf("\nEnter time slot number (1-9): ");
+            printf("\nEnter time slot number (1-%d): ", periodCount);
             scanf("%d", &timeChoice);
 
-            if (timeChoice < 1 || timeChoice > 9)
+            if (timeChoice < 1 || timeChoice > periodCount)
             {
                 printf("Invalid time choice! Please try again.\n");
                 continue;
             }
 
-            getTimeString(timeChoice, time);
+            getTimeString(d, timeChoice, time);
 
             // Check if time slot is available
             if (!isTimeSlotAvailable(day, time, currentSection))
             {
-                printf("\nError: Time slot %s on %s is already occupied for Section %c!\n",
+                printf("\nError: Time slot %s on %s is already occupied for Section %s!\n",
                        time, day, currentSection);
                 printf("Please choose a different time slot.\n");
                 continue;
             }
+            if (teacherBusy & (1u << (timeChoice - 1)))
+            {
+                printf("\nError: %s already teaches at %s on %s!\n", teacherName, time, day);
+                printf("Please choose a different time slot.\n");
+                continue;
+            }
 
             // Time slot is valid and available
             validTimeSlot = 1;
             insertLecture(day, time, subject, teacherName, currentSection);
-            printf("\nLecture added for Section %c: %s at %s on %s\n",
+            printf("\nLecture added for Section %s: %s at %s on %s\n",
                    currentSection, subject, time, day);
         }
     }
@@ -1154,260 +764,476 @@ void assignNewTeacher()
     printf("You can use the View Timetable option to check the updated schedule.\n");
 }
 
-// Function to get subject name from code
-const char *getSubjectName(const char *subjectCode)
+// Function to find the file an earlier export of key wrote from the same content,
+// NULL if there is none or it has been deleted since
+const char *cachedExport(const char *key, unsigned long long hash)
 {
-    static char subjectName[MAX_LEN]; // Make it static to persist after function returns
-
-    // First check curriculum array
-    for (int i = 0; i < CURRICULUM_SIZE; i++)
+    for (int i = 0; i < exportCacheCount; i++)
     {
-        if (strcmp(curriculum[i].code, subjectCode) == 0)
-        {
-            strcpy(subjectName, curriculum[i].name);
-            return subjectName;
-        }
+        if (strcmp(exportCache[i].key, key) != 0)
+            continue;
+        FILE *fp = exportCache[i].hash == hash ? fopen(exportCache[i].filename, "r") : NULL;
+        if (fp == NULL)
+            return NULL;
+        fclose(fp);
+        ExportEntry entry = exportCache[i];
+        memmove(&exportCache[1], &exportCache[0], sizeof(ExportEntry) * i);
+        exportCache[0] = entry;
+        return exportCache[0].filename;
     }
-
-    // If not found in curriculum, return the code itself
-    strcpy(subjectName, subjectCode);
-    return subjectName;
+    return NULL;
 }
 
-// Function to save timetable to file
-void saveTimetable()
+// Function to remember the file an export of key wrote
+void rememberExport(const char *key, unsigned long long hash, const char *filename)
 {
-    FILE *fp;
-    char filename[100];
-
-    // Create filename with current timestamp
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
-    strftime(filename, sizeof(filename), "timetable_%Y%m%d_%H%M%S.txt", t);
+    int i = 0;
+    while (i < exportCacheCount && strcmp(exportCache[i].key, key) != 0)
+        i++;
+    if (i == exportCacheCount && exportCacheCount < EXPORT_CACHE_SIZE)
+        exportCacheCount++;
+    if (i == EXPORT_CACHE_SIZE)
+        i--; // replace the least recently used
+    memmove(&exportCache[1], &exportCache[0], sizeof(ExportEntry) * i);
+    snprintf(exportCache[0].key, sizeof(exportCache[0].key), "%s", key);
+    exportCache[0].hash = hash;
+    snprintf(exportCache[0].filename, sizeof(exportCache[0].filename), "%s", filename);
+}
 
-    fp = fopen(filename, "w");
-    if (fp == NULL)
+// Function to export the full timetable (section "") or one section to a timestamped
+// file. When nothing it shows changed since an earlier export that file is reused
+// and nothing is written. filename gets the file's name; returns 1 if it was
+// written, 2 if reused and 0 on error.
+int exportTimetable(const char *section, char *filename, size_t filenameSize)
+{
+    unsigned long long hash = section[0] ? timetableSectionHash(tt, section) : timetableContentHash(tt);
+    const char *cached = cachedExport(section, hash);
+    if (cached != NULL)
     {
-        printf("\nError: Could not create file %s!\n", filename);
-        return;
+        snprintf(filename, filenameSize, "%s", cached);
+        exportsReused++;
+        return 2;
     }
-
-    // Write header
-    fprintf(fp, "================================================================\n");
-    fprintf(fp, "                        TIMETABLE DATA                            \n");
-    fprintf(fp, "                  Saved on: %s", ctime(&now));
-    fprintf(fp, "================================================================\n\n");
-
-    // Write timetable data for each section
-    char sections[] = {'A', 'B', 'C', 'D'};
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-
-    for (int s = 0; s < 4; s++)
+    time_t now = time(NULL);
+    struct tm local;
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localTime(&now, &local));
+    if (section[0])
+        snprintf(filename, filenameSize, "section_%s_timetable_%s.txt", section, stamp);
+    else
+        snprintf(filename, filenameSize, "timetable_%s.txt", stamp);
+    int status;
+    if (section[0])
     {
-        fprintf(fp, "\nSECTION %c TIMETABLE\n", sections[s]);
-        fprintf(fp, "----------------------------------------------------------------\n");
-        fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %s\n",
-                "Day", "Time", "Code", "Subject Name", "Faculty");
-        fprintf(fp, "----------------------------------------------------------------\n");
-
-        // For each day
-        for (int d = 0; d < 6; d++)
-        {
-            Lecture *temp = head;
-            int hasLecture = 0;
-
-            while (temp)
-            {
-                if (temp->section == sections[s] && strcmp(temp->day, days[d]) == 0)
-                {
-                    const char *subjectName = getSubjectName(temp->subject);
-                    fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %s\n",
-                            temp->day,
-                            temp->time,
-                            temp->subject,
-                            subjectName,
-                            temp->faculty);
-                    hasLecture = 1;
-                }
-                temp = temp->next;
-            }
-
-            if (hasLecture)
-            {
-                fprintf(fp, "----------------------------------------------------------------\n");
-            }
-        }
+        FILE *fp = fopen(filename, "w");
+        status = fp == NULL ? TT_ERR_IO : timetableWriteSection(tt, section, fp);
+        if (fp != NULL && fclose(fp) != 0)
+            status = TT_ERR_IO;
     }
+    else
+        status = timetableSave(tt, filename);
+    if (status != TT_OK)
+        return 0;
+    rememberExport(section, hash, filename);
+    exportsWritten++;
+    return 1;
+}
 
-    // Write subject legend
-    fprintf(fp, "\n\nSUBJECT LEGEND:\n");
-    fprintf(fp, "----------------------------------------------------------------\n");
-    fprintf(fp, "%-8s | %-40s | %s\n", "Code", "Subject Name", "Type");
-    fprintf(fp, "----------------------------------------------------------------\n");
-
-    SubjectInfo subjects[50];
-    int subjectCount = 0;
-    getUniqueSubjects(subjects, &subjectCount);
-
-    for (int i = 0; i < subjectCount; i++)
+// Function to save timetable to file; filename gets its name (NULL if not needed).
+// Returns 0 if it could not be written.
+int saveTimetable(char *filename, size_t filenameSize)
+{
+    char name[100];
+    int status = exportTimetable("", name, sizeof(name));
+    if (status == 0)
     {
-        fprintf(fp, "%-8s | %-40s | %s\n",
-                subjects[i].code,
-                subjects[i].name,
-                subjects[i].isLab ? "Lab" : "Theory");
+        printf("\nError: Could not create file %s!\n", name);
+        return 0;
     }
-    fprintf(fp, "----------------------------------------------------------------\n");
-
-    fprintf(fp, "\n================================================================\n");
-    fprintf(fp, "                          END OF DATA                             \n");
-    fprintf(fp, "================================================================\n");
-
-    fclose(fp);
-    printf("\nTimetable saved successfully to file: %s\n", filename);
+    if (status == 2)
+        printf("\nTimetable unchanged since it was saved to file: %s\n", name);
+    else
+        printf("\nTimetable saved successfully to file: %s\n", name);
+    if (filename != NULL)
+        snprintf(filename, filenameSize, "%s", name);
+    return 1;
 }
 
-// Function to trim whitespace from a string
-void trim(char *str)
+// Function to map a format name to its EXPORT_ code, 0 if unknown
+int exportFormat(const char *name)
 {
-    char *end;
-
-    // Trim leading space
-    while (isspace((unsigned char)*str))
-        str++;
+    if (strcmp(name, "text") == 0 || strcmp(name, "txt") == 0)
+        return EXPORT_TEXT;
+    if (strcmp(name, "csv") == 0)
+        return EXPORT_CSV;
+    if (strcmp(name, "jsonl") == 0 || strcmp(name, "json") == 0)
+        return EXPORT_JSONL;
+    return 0;
+}
 
-    if (*str == 0)
-        return; // All spaces?
+// Function to pick a file's format from its extension: .csv, .jsonl or .json for
+// rows, anything else for the text layout
+int fileFormat(const char *filename)
+{
+    const char *dot = strrchr(filename, '.');
+    int format = dot != NULL ? exportFormat(dot + 1) : 0;
+    return format == EXPORT_CSV || format == EXPORT_JSONL ? format : EXPORT_TEXT;
+}
 
-    // Trim trailing space
-    end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end))
-        end--;
+// Function to load a timetable file into target in the format its extension names;
+// returns the lectures loaded or a TT_ERR_ code, rejected gets the rows that were not lectures
+int loadTimetableFile(Timetable *target, const char *filename, int *rejected)
+{
+    int format = fileFormat(filename);
+    *rejected = 0;
+    if (format == EXPORT_TEXT)
+        return timetableLoad(target, filename);
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    setvbuf(fp, NULL, _IOFBF, ROW_IO_BUFFER);
+    int loaded = timetableReadRows(target, format, fp, rejected);
+    fclose(fp);
+    return loaded;
+}
 
-    // Write new null terminator character
-    end[1] = '\0';
+// Function to save a timetable in the format the file's extension names
+int saveTimetableFile(Timetable *source, const char *filename)
+{
+    int format = fileFormat(filename);
+    if (format == EXPORT_TEXT)
+        return timetableSave(source, filename);
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    setvbuf(fp, NULL, _IOFBF, ROW_IO_BUFFER);
+    int written = timetableWriteRows(source, format, fp);
+    if (fclose(fp) != 0 && written >= 0)
+        written = TT_ERR_IO;
+    return written < 0 ? written : TT_OK;
 }
 
 // Function to load timetable from file
 void loadTimetable(const char *filename)
 {
-    FILE *fp = fopen(filename, "r");
-    if (fp == NULL)
+    int rejected;
+    if (loadTimetableFile(tt, filename, &rejected) < 0)
     {
         printf("\nError: Could not open file %s!\n", filename);
         return;
     }
+    printf("\nTimetable loaded successfully from file: %s\n", filename);
+    if (rejected > 0)
+        printf("%d line(s) were not lectures and were skipped\n", rejected);
+}
 
-    // Clear existing timetable
-    while (head != NULL)
+// Function to write one change of a diff report, starting a new section's heading
+// when the section changes
+int writeDiffChange(int kind, const Lecture *before, const Lecture *after, void *ctx)
+{
+    FILE *fp = (FILE *)ctx;
+    const Lecture *lec = before != NULL ? before : after;
+    if (strcmp(diffSection, lec->section) != 0)
+    {
+        strcpy(diffSection, lec->section);
+        fprintf(fp, "\nSection %s\n", diffSection);
+    }
+    switch (kind)
     {
-        Lecture *temp = head;
-        head = head->next;
-        free(temp);
+    case DIFF_MOVED:
+        fprintf(fp, "  moved       %s %s -> %s %s | %s | %s\n", before->day, before->time, after->day, after->time,
+                lec->subject, lec->faculty);
+        break;
+    case DIFF_RESTAFFED:
+        fprintf(fp, "  re-staffed  %s %s | %s | %s -> %s\n", lec->day, lec->time, lec->subject, before->faculty,
+                after->faculty);
+        break;
+    case DIFF_ROOM:
+        fprintf(fp, "  room        %s %s | %s | %s -> %s\n", lec->day, lec->time, lec->subject,
+                before->room[0] ? before->room : "-", after->room[0] ? after->room : "-");
+        break;
+    default:
+        fprintf(fp, "  %-11s %s %s | %s | %s%s%s\n", kind == DIFF_ADDED ? "added" : "removed", lec->day, lec->time,
+                lec->subject, lec->faculty, lec->room[0] ? " | " : "", lec->room);
+        break;
     }
+    return ferror(fp);
+}
 
-    char line[256];
-    char day[10], time[20], subject[50], faculty[50];
-    char section = '\0';
+// Function to compare two timetable files of any supported format. Both are loaded
+// into one scratch timetable, so their sections share ids and versionCompare can
+// pair them; the changes go to reportFile and, when given, a patch that turns the
+// older file into the newer one to patchFile. Returns a TT_ERR_ code on failure.
+int diffTimetableFiles(const char *oldFile, const char *newFile, const char *reportFile, const char *patchFile,
+                       DiffReport *report)
+{
+    int rejected;
+    Timetable *scratch = timetableCreate();
+    if (scratch == NULL)
+        return TT_ERR_NOMEM;
+    int status = loadTimetableFile(scratch, oldFile, &rejected);
+    const TimetableVersion *before = status >= 0 ? timetablePin(scratch) : NULL;
+    if (status >= 0)
+        status = loadTimetableFile(scratch, newFile, &rejected);
+    const TimetableVersion *after = status >= 0 ? timetablePin(scratch) : NULL;
+
+    FILE *fp = status >= 0 ? fopen(reportFile, "w") : NULL;
+    if (status >= 0 && fp == NULL)
+        status = TT_ERR_IO;
+    if (fp != NULL)
+    {
+        diffSection[0] = '\0';
+        fprintf(fp, "Changes from %s to %s\n", oldFile, newFile);
+        status = timetableDiff(before, after, writeDiffChange, fp, report);
+        if (status == TT_OK)
+            fprintf(fp, "\n%d added, %d removed, %d moved, %d re-staffed, %d room change(s) in %d section(s)\n",
+                    report->added, report->removed, report->moved, report->restaffed, report->rooms,
+                    report->sections);
+        int failed = ferror(fp);
+        if ((fclose(fp) != 0 || failed) && status == TT_OK)
+            status = TT_ERR_IO;
+    }
+    if (status == TT_OK && patchFile != NULL)
+    {
+        FILE *patch = fopen(patchFile, "w");
+        status = patch == NULL ? TT_ERR_IO : timetableWritePatch(before, after, patch, NULL);
+        if (patch != NULL && fclose(patch) != 0 && status == TT_OK)
+            status = TT_ERR_IO;
+    }
+    if (after != NULL)
+        timetableUnpin(after);
+    if (before != NULL)
+        timetableUnpin(before);
+    timetableDestroy(scratch);
+    return status < 0 ? status : TT_OK;
+}
 
-    // Skip header until we find a section
-    while (fgets(line, sizeof(line), fp))
+// Function to describe one merge conflict in the report
+int writeMergeConflict(int kind, const Lecture *base, const Lecture *ours, const Lecture *theirs, void *ctx)
+{
+    FILE *fp = (FILE *)ctx;
+    const Lecture *slot = theirs != NULL ? theirs : base;
+    fprintf(fp, "\n%s %s %s: %s\n", slot->section, slot->day, slot->time,
+            kind == MERGE_TEACHER ? "teacher double-booked" : "changed on both sides");
+    const Lecture *rows[3] = {base, ours, theirs};
+    const char *labels[3] = {"base", "ours", "theirs"};
+    for (int i = 0; i < 3; i++)
+    {
+        if (rows[i] == NULL)
+            fprintf(fp, "  %-7s free\n", labels[i]);
+        else
+            fprintf(fp, "  %-7s %s %s %s | %s | %s%s%s\n", labels[i], rows[i]->section, rows[i]->day, rows[i]->time,
+                    rows[i]->subject, rows[i]->faculty, rows[i]->room[0] ? " | " : "", rows[i]->room);
+    }
+    return ferror(fp);
+}
+
+// Function to merge two edited copies of a base timetable file: the changes only
+// theirs made are applied to ours and the result saved to outputFile, conflicts
+// (ours kept) are listed in reportFile. All three are loaded into one scratch
+// timetable, ours last, so they share section ids. Returns a TT_ERR_ code on failure.
+int mergeTimetableFiles(const char *baseFile, const char *oursFile, const char *theirsFile, const char *outputFile,
+                        const char *reportFile, MergeReport *report)
+{
+    int rejected;
+    Timetable *scratch = timetableCreate();
+    if (scratch == NULL)
+        return TT_ERR_NOMEM;
+    int status = loadTimetableFile(scratch, baseFile, &rejected);
+    const TimetableVersion *base = status >= 0 ? timetablePin(scratch) : NULL;
+    if (status >= 0)
+        status = loadTimetableFile(scratch, theirsFile, &rejected);
+    const TimetableVersion *theirs = status >= 0 ? timetablePin(scratch) : NULL;
+    if (status >= 0)
+        status = loadTimetableFile(scratch, oursFile, &rejected);
+
+    FILE *fp = status >= 0 ? fopen(reportFile, "w") : NULL;
+    if (status >= 0 && fp == NULL)
+        status = TT_ERR_IO;
+    if (fp != NULL)
+    {
+        fprintf(fp, "Merge of %s (ours) and %s (theirs) from %s\n", oursFile, theirsFile, baseFile);
+        status = timetableMerge(scratch, base, theirs, writeMergeConflict, fp, report);
+        if (status == TT_OK)
+            fprintf(fp, "\n%d slot(s) of ours kept, %d of theirs applied, %d changed alike, %d conflict(s)\n",
+                    report->ours, report->theirs, report->same, report->conflicts);
+        int failed = ferror(fp);
+        if ((fclose(fp) != 0 || failed) && status == TT_OK)
+            status = TT_ERR_IO;
+    }
+    if (status == TT_OK)
+        status = saveTimetableFile(scratch, outputFile);
+    if (theirs != NULL)
+        timetableUnpin(theirs);
+    if (base != NULL)
+        timetableUnpin(base);
+    timetableDestroy(scratch);
+    return status < 0 ? status : TT_OK;
+}
+
+// Function to apply a patch written by diff to the timetable, as one undoable edit
+int applyPatchFile(const char *filename, char *result, size_t resultSize)
+{
+    TxnFailure failure;
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
     {
-        if (strstr(line, "SECTION") != NULL)
-        {
-            section = line[8]; // Get section letter
+        snprintf(result, resultSize, "could not open %s", filename);
+        return 0;
+    }
+    int applied = timetableApplyPatch(tt, fp, &failure);
+    fclose(fp);
+    if (applied >= 0)
+    {
+        snprintf(result, resultSize, "applied %d row(s) of %s", applied, filename);
+        return 1;
+    }
+    if (failure.op >= 0)
+        snprintf(result, resultSize, "not applied: line %d of %s (%s)", failure.op + 1, filename,
+                 applied == TT_ERR_NOT_FOUND ? "lecture to remove is not there as written"
+                                             : timetableStrError(applied));
+    else
+        snprintf(result, resultSize, "not applied: %s", timetableStrError(applied));
+    return 0;
+}
 
-            // Skip header lines
-            fgets(line, sizeof(line), fp); // separator
-            fgets(line, sizeof(line), fp); // column headers
-            fgets(line, sizeof(line), fp); // separator
+// Function to set the term calendar exports run between; returns 0 for dates not in
+// the YYYY-MM-DD form
+int setTerm(const char *start, const char *end)
+{
+    int year, month, day;
+    if (sscanf(start, "%4d-%2d-%2d", &year, &month, &day) != 3 || sscanf(end, "%4d-%2d-%2d", &year, &month, &day) != 3 ||
+        strlen(start) >= sizeof(termStart) || strlen(end) >= sizeof(termEnd))
+        return 0;
+    strcpy(termStart, start);
+    strcpy(termEnd, end);
+    return 1;
+}
 
-            // Read lectures
-            while (fgets(line, sizeof(line), fp) && strlen(line) > 2)
-            {
-                // Skip separator lines
-                if (strstr(line, "---") != NULL || strstr(line, "SECTION") != NULL)
-                {
-                    break;
-                }
+// Function to default the term to sixteen weeks from today
+void defaultTerm()
+{
+    time_t now = time(NULL);
+    struct tm day;
+    localTime(&now, &day);
+    strftime(termStart, sizeof(termStart), "%Y-%m-%d", &day);
+    day.tm_mday += 16 * 7;
+    day.tm_isdst = -1;
+    mktime(&day);
+    strftime(termEnd, sizeof(termEnd), "%Y-%m-%d", &day);
+}
 
-                // Parse line
-                if (sscanf(line, "%s | %[^|] | %[^|] | %[^\n]", day, time, subject, faculty) == 4)
-                {
-                    // Trim whitespace from each field
-                    trim(time);
-                    trim(subject);
-                    trim(faculty);
+// Function to write the .ics calendar of a section or a teacher (the other NULL) for
+// the term; returns the events written or a TT_ERR_ code
+int writeCalendarFile(const char *section, const char *teacher, const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    int events = timetableWriteCalendar(tt, section, teacher, termStart, termEnd, fp);
+    if (fclose(fp) != 0 && events >= 0)
+        events = TT_ERR_IO;
+    if (events < 0)
+        remove(filename);
+    return events;
+}
 
-                    // Insert lecture
-                    insertLecture(day, time, subject, faculty, section);
-                }
-            }
-        }
+// Function to save a section's calendar next to its timetable export; filename gets
+// its name. Returns 0 if it could not be written.
+int saveSectionCalendar(const char *section, char *filename, size_t filenameSize)
+{
+    snprintf(filename, filenameSize, "section_%s_timetable.ics", section);
+    int events = writeCalendarFile(section, NULL, filename);
+    if (events < 0)
+    {
+        printf(COLOR_ERROR "\nError: Could not create file %s: %s\n" COLOR_RESET, filename, timetableStrError(events));
+        return 0;
     }
+    printf(COLOR_SUCCESS "Section %s calendar (%d weekly lectures, %s to %s) saved to file: %s\n" COLOR_RESET, section,
+           events, termStart, termEnd, filename);
+    return 1;
+}
 
-    fclose(fp);
-    printf("\nTimetable loaded successfully from file: %s\n", filename);
+// Function to save the calendars of every section and teacher into a directory
+void saveAllCalendars()
+{
+    char directory[100];
+    printf(COLOR_INPUT "Enter directory: " COLOR_RESET);
+    scanf(" %99s", directory);
+    CalendarReport report;
+    int status = timetableExportCalendars(tt, directory, termStart, termEnd, &report);
+    if (status != TT_OK)
+    {
+        printf(COLOR_ERROR "\nError: Could not export calendars to %s: %s\n" COLOR_RESET, directory, timetableStrError(status));
+        return;
+    }
+    printf(COLOR_SUCCESS "\nCalendars of %d sections and %d teachers (%s to %s) saved to %s\n" COLOR_RESET,
+           report.sections, report.teachers, termStart, termEnd, directory);
+    printf(COLOR_HILITE "Open a .ics file to add its weekly lectures to any calendar app.\n" COLOR_RESET);
+}
+
+// Function to save every section to its own file in a directory, with a manifest
+void saveAllSections()
+{
+    char directory[100], formatName[16];
+    printf(COLOR_INPUT "Enter directory: " COLOR_RESET);
+    scanf(" %99s", directory);
+    printf(COLOR_INPUT "Format (text/csv/jsonl): " COLOR_RESET);
+    scanf(" %15s", formatName);
+    int format = exportFormat(formatName);
+    if (format == 0)
+    {
+        printf(COLOR_ERROR "Invalid format!\n" COLOR_RESET);
+        return;
+    }
+    ExportReport report;
+    int status = timetableExportSections(tt, directory, format, 0, &report);
+    if (status != TT_OK)
+    {
+        printf(COLOR_ERROR "\nError: Could not export to %s: %s\n" COLOR_RESET, directory, timetableStrError(status));
+        return;
+    }
+    printf(COLOR_SUCCESS "\n%d section timetables saved to %s (list in %s/manifest.csv)\n" COLOR_RESET,
+           report.sections, directory, directory);
 }
 
 // Print full timetable for all sections
 void displayFullTimetable()
 {
-    char sections[] = {'A', 'B', 'C', 'D'};
-    for (int i = 0; i < 4; i++)
+    int sectionCount = timetableSectionCount(tt);
+    for (int i = 0; i < sectionCount; i++)
     {
         printf(COLOR_HEADER "\n==============================\n" COLOR_RESET);
-        printf(COLOR_HEADER "      SECTION %c TIMETABLE      \n" COLOR_RESET, sections[i]);
+        printf(COLOR_HEADER "      SECTION %s TIMETABLE      \n" COLOR_RESET, timetableSectionName(tt, i));
         printf(COLOR_HEADER "==============================\n" COLOR_RESET);
-        printTimetable(sections[i]);
+        printTimetable(timetableSectionName(tt, i));
     }
 }
 
-// Save timetable for a single section
-void displaySaveSectionTimetable(char section)
+// Save timetable for a single section; filename gets its name (NULL if not needed).
+// Returns 0 if it could not be written.
+int displaySaveSectionTimetable(const char *section, char *filename, size_t filenameSize)
 {
-    FILE *fp;
-    char filename[100];
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
-    snprintf(filename, sizeof(filename), "section_%c_timetable_%04d%02d%02d_%02d%02d%02d.txt", section, t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
-    fp = fopen(filename, "w");
-    if (fp == NULL)
-    {
-        printf(COLOR_ERROR "\nError: Could not create file %s!\n" COLOR_RESET, filename);
-        return;
-    }
-    fprintf(fp, "==============================\n");
-    fprintf(fp, "  SECTION %c TIMETABLE\n", section);
-    fprintf(fp, "==============================\n");
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-    for (int d = 0; d < 6; d++)
+    char name[100];
+    int status = exportTimetable(section, name, sizeof(name));
+    if (status == 0)
     {
-        Lecture *temp = head;
-        int hasLecture = 0;
-        while (temp)
-        {
-            if (temp->section == section && strcmp(temp->day, days[d]) == 0)
-            {
-                const char *subjectName = getSubjectName(temp->subject);
-                fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %s\n",
-                        temp->day, temp->time, temp->subject, subjectName, temp->faculty);
-                hasLecture = 1;
-            }
-            temp = temp->next;
-        }
-        if (hasLecture)
-        {
-            fprintf(fp, "----------------------------------------------\n");
-        }
+        printf(COLOR_ERROR "\nError: Could not create file %s!\n" COLOR_RESET, name);
+        return 0;
     }
-    fclose(fp);
-    printf(COLOR_SUCCESS "\nSection %c timetable saved to file: %s\n" COLOR_RESET, section, filename);
+    if (status == 2)
+        printf(COLOR_SUCCESS "\nSection %s timetable unchanged since it was saved to file: %s\n" COLOR_RESET, section, name);
+    else
+        printf(COLOR_SUCCESS "\nSection %s timetable saved to file: %s\n" COLOR_RESET, section, name);
+    if (filename != NULL)
+        snprintf(filename, filenameSize, "%s", name);
+    return 1;
 }
 
 // Swap classes (between or within section, with/without teacher)
 void swapClasses()
 {
-    char section1, section2;
+    char section1[SECTION_NAME_LEN], section2[SECTION_NAME_LEN];
     printf(CLI_COLOR_MENU "\nSwap Classes Menu\n" COLOR_RESET);
     printf("1. Swap between two sections\n");
     printf("2. Swap within the same section\n");
@@ -1416,16 +1242,14 @@ void swapClasses()
     scanf("%d", &swapChoice);
     if (swapChoice == 1)
     {
-        printf("Enter first section (A/B/C/D): ");
-        scanf(" %c", &section1);
-        printf("Enter second section (A/B/C/D): ");
-        scanf(" %c", &section2);
-        if ((section1 >= 'A' && section1 <= 'D') && (section2 >= 'A' && section2 <= 'D') && section1 != section2)
+        int valid = readSection("Enter first section", section1);
+        valid = readSection("Enter second section", section2) && valid;
+        if (valid && strcmp(section1, section2) != 0)
         {
             printf("Do you want to swap teachers as well? (1-Yes, 0-No): ");
             int swapTeacher;
             scanf("%d", &swapTeacher);
-            swapTeachersFlexible(section1, section2, swapTeacher);
+            swapTeachersFlexible(swapTeacher);
         }
         else
         {
@@ -1434,20 +1258,16 @@ void swapClasses()
     }
     else if (swapChoice == 2)
     {
-        printf("Enter section (A/B/C/D): ");
-        scanf(" %c", &section1);
-        if (section1 >= 'A' && section1 <= 'D')
+        if (readSection("Enter section", section1))
         {
-            printf("Select Day:\n1. Monday\n2. Tuesday\n3. Wednesday\n4. Thursday\n5. Friday\n6. Saturday\nEnter choice (1-6): ");
-            int dayChoice;
-            scanf("%d", &dayChoice);
-            if (dayChoice < 1 || dayChoice > 6)
+            printf("Select Day:\n");
+            int d = chooseDay();
+            if (d < 0)
             {
                 printf(COLOR_ERROR "Invalid day choice!\n" COLOR_RESET);
                 return;
             }
-            const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-            const char *selectedDay = days[dayChoice - 1];
+            const char *selectedDay = DAY_CODES[d];
             getAvailableTimeSlots(section1, selectedDay, 1);
             printf("Enter first time slot number: ");
             int slot1;
@@ -1472,13 +1292,12 @@ void swapClasses()
 }
 
 // Flexible swap between sections, with/without teacher
-void swapTeachersFlexible(char section1, char section2, int swapTeacher)
+void swapTeachersFlexible(int swapTeacher)
 {
-    char day1[10], time1[20], subject1[MAX_LEN], teacher1[MAX_LEN];
-    char day2[10], time2[20], subject2[MAX_LEN], teacher2[MAX_LEN];
+    char section1[SECTION_NAME_LEN], day1[10], time1[20], subject1[MAX_LEN], teacher1[MAX_LEN];
+    char section2[SECTION_NAME_LEN], day2[10], time2[20], subject2[MAX_LEN], teacher2[MAX_LEN];
     printf("\nEnter details for the first class to swap:\n");
-    printf("Section (A/B/C/D): ");
-    scanf(" %c", &section1);
+    readSection("Section", section1);
     printf("Day (MON/TUE/WED/THU/FRI/SAT): ");
     scanf("%s", day1);
     printf("Time (e.g., 8:00-8:55): ");
@@ -1493,8 +1312,7 @@ void swapTeachersFlexible(char section1, char section2, int swapTeacher)
         teacher1[len1 - 1] = '\0';
 
     printf("\nEnter details for the second class to swap with:\n");
-    printf("Section (A/B/C/D): ");
-    scanf(" %c", &section2);
+    readSection("Section", section2);
     printf("Day (MON/TUE/WED/THU/FRI/SAT): ");
     scanf("%s", day2);
     printf("Time (e.g., 8:00-8:55): ");
@@ -1508,33 +1326,18 @@ void swapTeachersFlexible(char section1, char section2, int swapTeacher)
     if (len2 > 0 && teacher2[len2 - 1] == '\n')
         teacher2[len2 - 1] = '\0';
 
-    Lecture *lec1 = NULL, *lec2 = NULL, *temp = head;
-    while (temp)
+    // Both classes must match the given subject and teacher before anything is swapped
+    Lecture lec1, lec2;
+    int found = timetableGetLecture(tt, section1, day1, time1, &lec1) == TT_OK &&
+                timetableGetLecture(tt, section2, day2, time2, &lec2) == TT_OK &&
+                strcmp(lec1.subject, subject1) == 0 && strcmp(lec1.faculty, teacher1) == 0 &&
+                strcmp(lec2.subject, subject2) == 0 && strcmp(lec2.faculty, teacher2) == 0;
+    if (found && timetableSwap(tt, section1, day1, time1, section2, day2, time2, swapTeacher) == TT_OK)
     {
-        if (temp->section == section1 && strcmp(temp->day, day1) == 0 && strcmp(temp->time, time1) == 0 && strcmp(temp->subject, subject1) == 0 && strcmp(temp->faculty, teacher1) == 0)
-        {
-            lec1 = temp;
-        }
-        if (temp->section == section2 && strcmp(temp->day, day2) == 0 && strcmp(temp->time, time2) == 0 && strcmp(temp->subject, subject2) == 0 && strcmp(temp->faculty, teacher2) == 0)
-        {
-            lec2 = temp;
-        }
-        temp = temp->next;
-    }
-    if (lec1 && lec2)
-    {
-        char tmpSubject[MAX_LEN], tmpFaculty[MAX_LEN];
-        strcpy(tmpSubject, lec1->subject);
-        if (swapTeacher)
-            strcpy(tmpFaculty, lec1->faculty);
-        strcpy(lec1->subject, lec2->subject);
-        if (swapTeacher)
-            strcpy(lec1->faculty, lec2->faculty);
-        strcpy(lec2->subject, tmpSubject);
-        if (swapTeacher)
-            strcpy(lec2->faculty, tmpFaculty);
+        timetableGetLecture(tt, section1, day1, time1, &lec1);
+        timetableGetLecture(tt, section2, day2, time2, &lec2);
         printf(COLOR_SUCCESS "\nClasses swapped successfully!\n" COLOR_RESET);
-        saveTimetable();
+        saveTimetable(NULL, 0);
         char notify;
         printf("Do you want to notify the teacher about the change? (y/n): ");
         scanf(" %c", &notify);
@@ -1543,12 +1346,12 @@ void swapTeachersFlexible(char section1, char section2, int swapTeacher)
             char number[32];
             printf("Enter WhatsApp number (with country code, e.g., 919999999999): ");
             scanf("%s", number);
-            char msg[512], encoded[1024], command[1200];
-            snprintf(msg, sizeof(msg), "Class is swapped: %s (%s) <-> %s (%s)", lec1->faculty, lec1->subject, lec2->faculty, lec2->subject);
-            url_encode(msg, encoded, sizeof(encoded));
-            snprintf(command, sizeof(command), "start \"\" \"https://wa.me/%s?text=%s\"", number, encoded);
-            printf(COLOR_SUCCESS "\nOpening WhatsApp Web to notify the teacher...\n" COLOR_RESET);
-            system(command);
+            char msg[512];
+            snprintf(msg, sizeof(msg), "Class is swapped: %s (%s) <-> %s (%s)", lec1.faculty, lec1.subject, lec2.faculty, lec2.subject);
+            if (notices != NULL && notifyPost(notices, number, msg) == 0)
+                printf(COLOR_SUCCESS "\nNotification queued, WhatsApp Web opens with it shortly.\n" COLOR_RESET);
+            else
+                printf(COLOR_ERROR "\nNotifications are off.\n" COLOR_RESET);
         }
     }
     else
@@ -1557,54 +1360,13 @@ void swapTeachersFlexible(char section1, char section2, int swapTeacher)
     }
 }
 
-// Swap within the same section
-void swapWithinSection(char section, const char *day, int slot1, int slot2, int swapTeacher)
+// Swap within the same section; slots are numbered as listed by getAvailableTimeSlots
+void swapWithinSection(const char *section, const char *day, int slot1, int slot2, int swapTeacher)
 {
-    // Find lectures for the two slots
-    Lecture *temp = head;
-    Lecture *lec1 = NULL;
-    Lecture *lec2 = NULL;
-    int count = 0;
-    char time1[20] = "", time2[20] = "";
-    // Get time strings for slots
-    int idx = 0;
-    temp = head;
-    while (temp)
-    {
-        if (temp->section == section && strcmp(temp->day, day) == 0)
-        {
-            idx++;
-            if (idx == slot1)
-                strcpy(time1, temp->time);
-            if (idx == slot2)
-                strcpy(time2, temp->time);
-        }
-        temp = temp->next;
-    }
-    temp = head;
-    while (temp)
+    char time1[MAX_LEN] = "", time2[MAX_LEN] = "";
+    if (slotTime(section, day, slot1, time1) && slotTime(section, day, slot2, time2) &&
+        timetableSwap(tt, section, day, time1, section, day, time2, swapTeacher) == TT_OK)
     {
-        if (temp->section == section && strcmp(temp->day, day) == 0)
-        {
-            if (strcmp(temp->time, time1) == 0)
-                lec1 = temp;
-            if (strcmp(temp->time, time2) == 0)
-                lec2 = temp;
-        }
-        temp = temp->next;
-    }
-    if (lec1 && lec2)
-    {
-        char tmpSubject[MAX_LEN], tmpFaculty[MAX_LEN];
-        strcpy(tmpSubject, lec1->subject);
-        if (swapTeacher)
-            strcpy(tmpFaculty, lec1->faculty);
-        strcpy(lec1->subject, lec2->subject);
-        if (swapTeacher)
-            strcpy(lec1->faculty, lec2->faculty);
-        strcpy(lec2->subject, tmpSubject);
-        if (swapTeacher)
-            strcpy(lec2->faculty, tmpFaculty);
         printf(COLOR_SUCCESS "\nClasses swapped successfully!\n" COLOR_RESET);
     }
     else
@@ -1643,8 +1405,8 @@ void url_encode(const char *src, char *dest, int max_len)
 void shareViaWhatsApp()
 {
     int shareChoice;
-    char section;
-    char filename[128];
+    char section[SECTION_NAME_LEN];
+    char filename[128], calendarFile[128];
     printf(COLOR_HILITE "\nShare Timetable Options:\n" COLOR_RESET);
     printf("1. Share Full Timetable (All Sections)\n");
     printf("2. Share Section Timetable\n");
@@ -1652,24 +1414,18 @@ void shareViaWhatsApp()
     scanf("%d", &shareChoice);
     if (shareChoice == 1)
     {
-        // Save full timetable
-        saveTimetable();
-        // Find the latest file generated by saveTimetable (by timestamped name)
-        time_t now = time(NULL);
-        struct tm *t = localtime(&now);
-        strftime(filename, sizeof(filename), "timetable_%Y%m%d_%H%M%S.txt", t);
+        // Save full timetable, or find the unchanged earlier save
+        if (!saveTimetable(filename, sizeof(filename)))
+            return;
     }
     else if (shareChoice == 2)
     {
-        printf(COLOR_INPUT "Enter section (A/B/C/D): " COLOR_RESET);
-        scanf(" %c", &section);
-        if (section >= 'A' && section <= 'D')
+        if (readSection(COLOR_INPUT "Enter section", section))
         {
-            // Save section timetable
-            time_t now = time(NULL);
-            struct tm *t = localtime(&now);
-            snprintf(filename, sizeof(filename), "section_%c_timetable_%04d%02d%02d_%02d%02d%02d.txt", section, t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
-            displaySaveSectionTimetable(section);
+            // Save section timetable, and its calendar for calendar apps
+            if (!displaySaveSectionTimetable(section, filename, sizeof(filename)) ||
+                !saveSectionCalendar(section, calendarFile, sizeof(calendarFile)))
+                return;
         }
         else
         {
@@ -1698,44 +1454,36 @@ void shareViaWhatsApp()
     else
     {
         snprintf(message, sizeof(message),
-                 "📅 *MCA Timetable - Section %c*\n\n"
-                 "Hello Section %c! Here's your updated timetable.\n\n"
-                 "📁 File: %s\n\n"
+                 "📅 *MCA Timetable - Section %s*\n\n"
+                 "Hello Section %s! Here's your updated timetable.\n\n"
+                 "📁 File: %s\n"
+                 "📆 Calendar: %s (open it to add every lecture of the term to your calendar app)\n\n"
                  "Please download and share with your section mates! 📚✨\n\n"
-                 "Note: You'll need to attach the file manually in WhatsApp Web.",
-                 section, section, filename);
+                 "Note: You'll need to attach the files manually in WhatsApp Web.",
+                 section, section, filename, calendarFile);
     }
 
-    char encoded[2048];
-    url_encode(message, encoded, sizeof(encoded));
-    char command[3200];
-    snprintf(command, sizeof(command), "start \"\" \"https://wa.me/?text=%s\"", encoded);
-    printf(COLOR_SUCCESS "\nOpening WhatsApp Web in your browser...\n" COLOR_RESET);
-    printf(COLOR_HILITE "The message is pre-filled. You can now select the MCA group or any contact to send it to.\n" COLOR_RESET);
+    if (notices == NULL || notifyPost(notices, "", message) != 0)
+    {
+        printf(COLOR_ERROR "\nNotifications are off.\n" COLOR_RESET);
+        return;
+    }
+    printf(COLOR_SUCCESS "\nMessage queued, WhatsApp Web opens with it shortly...\n" COLOR_RESET);
+    printf(COLOR_HILITE "The message is pre-filled. You can then select the MCA group or any contact to send it to.\n" COLOR_RESET);
     printf(COLOR_HILITE "Please attach the file '%s' manually in WhatsApp Web.\n" COLOR_RESET, filename);
-    system(command);
+    if (shareChoice == 2)
+        printf(COLOR_HILITE "Attach '%s' as well, for calendar apps.\n" COLOR_RESET, calendarFile);
 
     // Also provide the group invite link
     printf(COLOR_HILITE "\nMCA Group Link: https://chat.whatsapp.com/KJZLZnetrNW4rDr4N8eKYi\n" COLOR_RESET);
 }
 
-// Helper: case-insensitive substring search (portable strcasestr)
-char *strcasestr_portable(const char *haystack, const char *needle)
+// Print one search result
+int printSearchResult(const Lecture *lec, void *ctx)
 {
-    if (!*needle)
-        return (char *)haystack;
-    for (; *haystack; haystack++)
-    {
-        const char *h = haystack, *n = needle;
-        while (*h && *n && tolower((unsigned char)*h) == tolower((unsigned char)*n))
-        {
-            h++;
-            n++;
-        }
-        if (!*n)
-            return (char *)haystack;
-    }
-    return NULL;
+    (void)ctx;
+    printf("Section %s | %s | %s | %s | %s\n", lec->section, lec->day, lec->time, lec->subject, lec->faculty);
+    return 0;
 }
 
 void searchTimetable()
@@ -1751,20 +1499,8 @@ void searchTimetable()
     size_t len = strlen(query);
     if (len > 0 && query[len - 1] == '\n')
         query[len - 1] = '\0';
-    Lecture *temp = head;
-    int found = 0;
     printf("\nSearch Results:\n");
-    while (temp)
-    {
-        if ((searchType == 1 && strcasestr_portable(temp->faculty, query)) ||
-            (searchType == 2 && (strcasestr_portable(temp->subject, query) || strcasestr_portable(getSubjectName(temp->subject), query))) ||
-            (searchType == 3 && strcasestr_portable(temp->time, query)))
-        {
-            printf("Section %c | %s | %s | %s | %s\n", temp->section, temp->day, temp->time, temp->subject, temp->faculty);
-            found = 1;
-        }
-        temp = temp->next;
-    }
+    int found = timetableSearch(tt, searchType, query, printSearchResult, NULL);
     if (!found)
         printf("No matches found.\n");
 }
@@ -1773,28 +1509,26 @@ void searchTimetable()
 void emailTimetable()
 {
     int emailChoice;
-    char section;
-    char filename[128];
+    char section[SECTION_NAME_LEN];
+    char filename[128], attachments[300];
     printf("\n1. Email Full Timetable\n2. Email Section Timetable\n");
     printf("Enter choice: ");
     scanf("%d", &emailChoice);
     if (emailChoice == 1)
     {
-        saveTimetable();
-        time_t now = time(NULL);
-        struct tm *t = localtime(&now);
-        strftime(filename, sizeof(filename), "timetable_%Y%m%d_%H%M%S.txt", t);
+        if (!saveTimetable(filename, sizeof(filename)))
+            return;
+        snprintf(attachments, sizeof(attachments), "%s", filename);
     }
     else if (emailChoice == 2)
     {
-        printf("Enter section (A/B/C/D): ");
-        scanf(" %c", &section);
-        if (section >= 'A' && section <= 'D')
+        char calendarFile[128];
+        if (readSection("Enter section", section))
         {
-            time_t now = time(NULL);
-            struct tm *t = localtime(&now);
-            snprintf(filename, sizeof(filename), "section_%c_timetable_%04d%02d%02d_%02d%02d%02d.txt", section, t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
-            displaySaveSectionTimetable(section);
+            if (!displaySaveSectionTimetable(section, filename, sizeof(filename)) ||
+                !saveSectionCalendar(section, calendarFile, sizeof(calendarFile)))
+                return;
+            snprintf(attachments, sizeof(attachments), "%s and %s", filename, calendarFile);
         }
         else
         {
@@ -1810,232 +1544,525 @@ void emailTimetable()
     char gmail_url[1024];
     snprintf(gmail_url, sizeof(gmail_url),
              "start \"\" \"https://mail.google.com/mail/?view=cm&fs=1&su=Timetable&body=Please find the timetable attached: %s. Please attach the file manually.\"",
-             filename);
-    printf("\nOpening Gmail compose window in your browser...\nPlease attach the file '%s' manually.\n", filename);
+             attachments);
+    printf("\nOpening Gmail compose window in your browser...\nPlease attach %s manually.\n", attachments);
     system(gmail_url);
 }
 
-// Notification/Reminder (demo: immediate notification)
-void setNotification()
-{
-    char msg[128];
-    int delayMin;
-    printf("Enter reminder message: ");
-    getchar();
-    fgets(msg, sizeof(msg), stdin);
-    size_t len = strlen(msg);
-    if (len > 0 && msg[len - 1] == '\n')
-        msg[len - 1] = '\0';
-    printf("In how many minutes do you want to see this notification? ");
-    scanf("%d", &delayMin);
-    printf("Waiting %d minute(s)...\n", delayMin);
-#ifdef _WIN32
-    Sleep(delayMin * 60 * 1000); // Sleep takes milliseconds
-#else
-    sleep(delayMin * 60); // POSIX fallback
-#endif
-    char command[512];
-    snprintf(command, sizeof(command),
-             "powershell -Command \"Add-Type -AssemblyName PresentationFramework; [System.Windows.MessageBox]::Show('%s')\"",
-             msg);
-    system(command);
-}
-
-// Statistics Dashboard
-void statisticsDashboard()
+// Function to start the reminder thread with a sink: "stdout", "file:<path>"
+// (appended to) or "cmd:<command line>" (run with the reminder text as its argument)
+int startReminders(const char *sink, char *result, size_t resultSize)
 {
-    // Most loaded teacher
-    TeacherLoad teachers[20];
-    int teacherCount = 0;
-    for (int i = 0; i < 20; i++)
+    if (strcmp(sink, "stdout") == 0)
     {
-        teachers[i].lectureCount = 0;
-        teachers[i].sectionCount = 0;
-        memset(teachers[i].sections, 0, sizeof(teachers[i].sections));
+        reminderSink = reminderStdoutSink;
+        reminderSinkCtx = NULL;
     }
-    Lecture *temp = head;
-    while (temp)
+    else if (strncmp(sink, "file:", 5) == 0)
     {
-        if (strcmp(temp->faculty, "-") != 0 && !strstr(temp->faculty, "Lab") && !strstr(temp->faculty, "Sec"))
+        reminderLog = fopen(sink + 5, "a");
+        if (reminderLog == NULL)
         {
-            int found = 0;
-            for (int i = 0; i < teacherCount; i++)
-            {
-                if (strcmp(teachers[i].name, temp->faculty) == 0)
-                {
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found)
-            {
-                strcpy(teachers[teacherCount].name, temp->faculty);
-                teacherCount++;
-            }
+            snprintf(result, resultSize, "could not open %s", sink + 5);
+            return 0;
         }
-        temp = temp->next;
+        reminderSink = reminderFileSink;
+        reminderSinkCtx = reminderLog;
     }
-    temp = head;
-    while (temp)
+    else if (strncmp(sink, "cmd:", 4) == 0 && sink[4] != '\0' && strlen(sink + 4) < sizeof(reminderCommand))
     {
-        if (strcmp(temp->faculty, "-") != 0 && !strstr(temp->faculty, "Lab") && !strstr(temp->faculty, "Sec"))
-        {
-            for (int i = 0; i < teacherCount; i++)
-            {
-                if (strcmp(teachers[i].name, temp->faculty) == 0)
-                {
-                    teachers[i].lectureCount++;
-                    int sectionExists = 0;
-                    for (int j = 0; j < teachers[i].sectionCount; j++)
-                    {
-                        if (teachers[i].sections[j] == temp->section)
-                        {
-                            sectionExists = 1;
-                            break;
-                        }
-                    }
-                    if (!sectionExists)
-                    {
-                        teachers[i].sections[teachers[i].sectionCount++] = temp->section;
-                    }
-                    break;
-                }
-            }
-        }
-        temp = temp->next;
+        strcpy(reminderCommand, sink + 4);
+        reminderSink = reminderCommandSink;
+        reminderSinkCtx = reminderCommand;
     }
-    int maxLectures = 0, maxIdx = -1;
-    for (int i = 0; i < teacherCount; i++)
+    else
     {
-        if (teachers[i].lectureCount > maxLectures)
-        {
-            maxLectures = teachers[i].lectureCount;
-            maxIdx = i;
-        }
+        snprintf(result, resultSize, "unknown reminder sink %s (stdout, file:<path> or cmd:<command>)", sink);
+        return 0;
     }
-    printf("\nMost loaded teacher: %s (%d lectures)\n", maxIdx >= 0 ? teachers[maxIdx].name : "N/A", maxLectures);
-    // Busiest day for each section
-    char sections[] = {'A', 'B', 'C', 'D'};
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-    for (int s = 0; s < 4; s++)
+    reminders = reminderStart(reminderSink, reminderSinkCtx);
+    if (reminders == NULL)
     {
-        int maxDay = 0, maxLect = 0;
-        for (int d = 0; d < 6; d++)
-        {
-            int count = 0;
-            temp = head;
-            while (temp)
-            {
-                if (temp->section == sections[s] && strcmp(temp->day, days[d]) == 0)
-                    count++;
-                temp = temp->next;
-            }
-            if (count > maxLect)
-            {
-                maxLect = count;
-                maxDay = d;
-            }
-        }
-        printf("Busiest day for Section %c: %s (%d lectures)\n", sections[s], days[maxDay], maxLect);
+        snprintf(result, resultSize, "could not start the reminder thread");
+        return 0;
     }
-    // Free periods per section
-    for (int s = 0; s < 4; s++)
+    snprintf(result, resultSize, "reminders go to %s", sink);
+    return 1;
+}
+
+// Function to turn lecture reminders on leadMinutes before every lecture (replacing
+// any running ones), or off when leadMinutes is negative
+int setLectureReminders(int leadMinutes, char *result, size_t resultSize)
+{
+    lectureRemindersStop(lectureReminders);
+    lectureReminders = NULL;
+    if (leadMinutes < 0)
+    {
+        snprintf(result, resultSize, "lecture reminders off");
+        return 1;
+    }
+    if (reminders == NULL && !startReminders("stdout", result, resultSize))
+        return 0;
+    lectureReminders = lectureRemindersStart(tt, leadMinutes, reminderSink, reminderSinkCtx);
+    if (lectureReminders == NULL)
+    {
+        snprintf(result, resultSize, "out of memory");
+        return 0;
+    }
+    ReminderStats stats;
+    lectureRemindersStats(lectureReminders, &stats);
+    snprintf(result, resultSize, "%d lecture reminder(s) queued, %d minute(s) ahead", stats.pending, leadMinutes);
+    return 1;
+}
+
+// Function to bring lecture reminders in line with edits, if they are on
+void syncLectureReminders(void)
+{
+    if (lectureReminders != NULL && lectureRemindersSync(lectureReminders) < 0)
+        fprintf(stderr, "Error: Could not update lecture reminders, out of memory!\n");
+}
+
+// Function to stop the reminder threads, dropping reminders not yet due
+void stopReminders(void)
+{
+    lectureRemindersStop(lectureReminders);
+    lectureReminders = NULL;
+    reminderStop(reminders);
+    reminders = NULL;
+    if (reminderLog != NULL)
+        fclose(reminderLog);
+    reminderLog = NULL;
+}
+
+// Function to hand a batch of notifications to WhatsApp Web, pre-filled for the
+// recipient's number (any contact when the recipient is not a number)
+int whatsAppTransport(const Notification *note, void *ctx)
+{
+    (void)ctx;
+    const char *number = note->recipient;
+    for (const char *c = number; *c; c++)
     {
-        int freeCount = 0;
-        temp = head;
-        while (temp)
+        if (!isdigit((unsigned char)*c))
         {
-            if (temp->section == sections[s] && strcmp(temp->faculty, "-") == 0)
-                freeCount++;
-            temp = temp->next;
+            number = "";
+            break;
         }
-        printf("Free periods for Section %c: %d\n", sections[s], freeCount);
     }
+    char encoded[3 * NOTIFY_BODY_LEN + 1], url[3 * NOTIFY_BODY_LEN + 64];
+    url_encode(note->body, encoded, sizeof(encoded));
+    snprintf(url, sizeof(url), "https://wa.me/%s?text=%s", number, encoded);
+    return notifyOpenUrl(url);
 }
 
-void shareTimetableViaQR()
+// Function to start the notification thread with a transport: "whatsapp", "stdout",
+// "file:<path>" (appended to) or "cmd:<command line>" (run with recipient and message)
+int startNotifications(const char *transport, char *result, size_t resultSize)
 {
-    // 1. Save timetable to file as 'timetable.txt'
-    char filename[32] = "timetable.txt";
-    saveTimetableAs(filename);
-    // 1.5. Get absolute path and check if file exists
-    char absPath[260];
-#ifdef _WIN32
-    if (_fullpath(absPath, filename, sizeof(absPath)) != NULL)
-    {
-        printf("Timetable file absolute path: %s\n", absPath);
+    NotifyTransport send;
+    void *ctx = NULL;
+    if (strcmp(transport, "whatsapp") == 0)
+        send = whatsAppTransport;
+    else if (strcmp(transport, "stdout") == 0)
+        send = notifyStdoutTransport;
+    else if (strncmp(transport, "file:", 5) == 0)
+    {
+        notifyLog = fopen(transport + 5, "a");
+        if (notifyLog == NULL)
+        {
+            snprintf(result, resultSize, "could not open %s", transport + 5);
+            return 0;
+        }
+        send = notifyFileTransport;
+        ctx = notifyLog;
     }
-#else
-    realpath(filename, absPath);
-    printf("Timetable file absolute path: %s\n", absPath);
-#endif
-    FILE *test = fopen(absPath, "r");
-    if (!test)
+    else if (strncmp(transport, "cmd:", 4) == 0 && transport[4] != '\0' && strlen(transport + 4) < sizeof(notifyCommand))
     {
-        printf(COLOR_ERROR "File %s does not exist before upload!\n" COLOR_RESET, absPath);
-        return;
+        strcpy(notifyCommand, transport + 4);
+        send = notifyCommandTransport;
+        ctx = notifyCommand;
     }
-    fclose(test);
-    // 2. Upload to catbox.moe and extract the link
-    char curlCmd[512];
-    char linkFile[64] = "catbox_link.txt";
-    snprintf(curlCmd, sizeof(curlCmd), "curl.exe -s -F \"reqtype=fileupload\" -F \"fileToUpload=@%s\" https://catbox.moe/user/api.php > %s", absPath, linkFile);
-    printf("Running: %s\n", curlCmd);
-    system(curlCmd);
-    // 3. Read the link from the output file
-    FILE *fp = fopen(linkFile, "r");
-    if (!fp)
-    {
-        printf(COLOR_ERROR "Could not open catbox.moe response file.\n" COLOR_RESET);
-        return;
-    }
-    char link[512] = "";
-    if (!fgets(link, sizeof(link), fp))
+    else
     {
-        printf(COLOR_ERROR "Failed to read catbox.moe response.\n" COLOR_RESET);
-        fclose(fp);
-        return;
+        snprintf(result, resultSize, "unknown notification transport %s (whatsapp, stdout, file:<path> or cmd:<command>)",
+                 transport);
+        return 0;
     }
-    fclose(fp);
-    // Remove trailing newline if present
-    size_t linkLen = strlen(link);
-    if (linkLen > 0 && link[linkLen - 1] == '\n')
-        link[linkLen - 1] = '\0';
-    if (link[0] == '\0')
+    notices = notifyStart(send, ctx, NOTIFY_DELAY_MILLIS, NOTIFY_MAX_PENDING);
+    if (notices == NULL)
     {
-        printf(COLOR_ERROR "Failed to extract catbox.moe link.\n" COLOR_RESET);
-        return;
+        snprintf(result, resultSize, "could not start the notification thread");
+        return 0;
     }
+    snprintf(result, resultSize, "notifications go to %s", transport);
+    return 1;
+}
 
-    // 4. Ask user what they want to do with the link
-    printf(COLOR_SUCCESS "\nTimetable uploaded successfully!\n" COLOR_RESET);
-    printf(COLOR_HILITE "Generated link: %s\n" COLOR_RESET, link);
-    printf("\nWhat would you like to do?\n");
-    printf("1. Open QR code in browser\n");
-    printf("2. Share link to WhatsApp group\n");
-    printf("3. Both\n");
-    printf(COLOR_INPUT "Enter choice (1-3): " COLOR_RESET);
+// Function to tell a teacher about a changed lecture, unless the "teacher" is a free
+// period or a lab group
+void notifyTeacher(const char *faculty, const char *text)
+{
+    if (isTeacher(faculty) && notifyPost(notices, faculty, text) != 0)
+        fprintf(stderr, "Error: Could not queue a notification, out of memory!\n");
+}
 
-    int shareChoice;
+// Function to describe a lecture's subject, teacher and room for a notification
+void describeLecture(char *out, size_t size, const Lecture *lec)
+{
+    snprintf(out, size, "%.24s with %.60s%s%.24s", lec->subject, lec->faculty, lec->room[0] ? " in " : "", lec->room);
+}
+
+// Called by versionCompare for each lecture an edit changed
+int notifyChange(const Lecture *before, const Lecture *after, void *ctx)
+{
+    (void)ctx;
+    char now[160], was[160], text[2 * 160 + 3 * MAX_LEN];
+    if (after == NULL)
+    {
+        if (before == NULL)
+            return 0;
+        describeLecture(was, sizeof(was), before);
+        snprintf(text, sizeof(text), "%s %s, Section %s: cancelled %s", before->day, before->time, before->section,
+                 was);
+    }
+    else if (before == NULL)
+    {
+        describeLecture(now, sizeof(now), after);
+        snprintf(text, sizeof(text), "%s %s, Section %s: new %s", after->day, after->time, after->section, now);
+    }
+    else
+    {
+        describeLecture(now, sizeof(now), after);
+        describeLecture(was, sizeof(was), before);
+        snprintf(text, sizeof(text), "%s %s, Section %s: now %s (was %s)", after->day, after->time, after->section,
+                 now, was);
+    }
+    if (after != NULL)
+        notifyTeacher(after->faculty, text);
+    if (before != NULL && (after == NULL || strcmp(before->faculty, after->faculty) != 0))
+        notifyTeacher(before->faculty, text);
+    return 0;
+}
+
+// Function to turn notifying teachers of every change to their lectures on or off
+int setChangeNotifications(int on, char *result, size_t resultSize)
+{
+    if (notifiedVersion != NULL)
+        timetableUnpin(notifiedVersion);
+    notifiedVersion = NULL;
+    if (!on)
+    {
+        snprintf(result, resultSize, "change notifications off");
+        return 1;
+    }
+    if (notices == NULL && !startNotifications("stdout", result, resultSize))
+        return 0;
+    notifiedVersion = timetablePin(tt);
+    snprintf(result, resultSize, "teachers are notified of changes from version %lu", versionId(notifiedVersion));
+    return 1;
+}
+
+// Function to queue notifications for what changed since the last call, if change
+// notifications are on. Only the lectures that differ are visited, and teachers are
+// sent them later in one message each, so this never waits for a transport.
+void syncNotifications(void)
+{
+    if (notifiedVersion == NULL)
+        return;
+    const TimetableVersion *current = timetablePin(tt);
+    if (versionId(current) != versionId(notifiedVersion))
+        versionCompare(notifiedVersion, current, notifyChange, NULL);
+    timetableUnpin(notifiedVersion);
+    notifiedVersion = current;
+}
+
+// Function to stop the notification thread once what is pending has been sent
+void stopNotifications(void)
+{
+    setChangeNotifications(0, NULL, 0);
+    notifyStop(notices);
+    notices = NULL;
+    if (notifyLog != NULL)
+        fclose(notifyLog);
+    notifyLog = NULL;
+}
+
+// Notification/Reminder: queued for the reminder thread, the menu carries on at once
+void setNotification()
+{
+    char msg[REMINDER_TEXT_LEN];
+    int delayMin, kind;
+    printf("1. One-off reminder\n2. Remind before every lecture\n3. Stop lecture reminders\nEnter choice: ");
+    if (scanf("%d", &kind) != 1 || kind < 1 || kind > 3)
+    {
+        printf(COLOR_ERROR "Invalid choice!\n" COLOR_RESET);
+        return;
+    }
+    if (kind > 1)
+    {
+        int lead = -1;
+        if (kind == 2)
+        {
+            printf("How many minutes before each lecture? ");
+            if (scanf("%d", &lead) != 1 || lead < 0)
+            {
+                printf(COLOR_ERROR "Invalid lead time!\n" COLOR_RESET);
+                return;
+            }
+        }
+        char message[256];
+        int ok = setLectureReminders(lead, message, sizeof(message));
+        printf("%s%s.\n" COLOR_RESET, ok ? COLOR_SUCCESS : COLOR_ERROR, message);
+        return;
+    }
+    printf("Enter reminder message: ");
+    getchar();
+    if (fgets(msg, sizeof(msg), stdin) == NULL)
+        return;
+    size_t len = strlen(msg);
+    if (len > 0 && msg[len - 1] == '\n')
+        msg[len - 1] = '\0';
+    printf("In how many minutes do you want to see this notification? ");
+    if (scanf("%d", &delayMin) != 1 || delayMin < 0)
+    {
+        printf(COLOR_ERROR "Invalid delay!\n" COLOR_RESET);
+        return;
+    }
+    time_t due = time(NULL) + (time_t)delayMin * 60;
+    if (reminderAdd(reminders, due, msg, 0) < 0)
+    {
+        printf(COLOR_ERROR "Memory allocation failed!\n" COLOR_RESET);
+        return;
+    }
+    ReminderStats stats;
+    reminderStats(reminders, &stats);
+    char clock[16];
+    struct tm dueTime;
+    strftime(clock, sizeof(clock), "%H:%M", localTime(&due, &dueTime));
+    printf(COLOR_SUCCESS "Reminder set for %s (%d pending).\n" COLOR_RESET, clock, stats.pending);
+}
+
+// Statistics Dashboard
+void statisticsDashboard()
+{
+    TimetableStats stats;
+    int sectionCount = timetableSectionCount(tt);
+    SectionStats *sections = (SectionStats *)malloc(sizeof(SectionStats) * (sectionCount > 0 ? sectionCount : 1));
+    if (sections == NULL)
+    {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    sectionCount = timetableStatistics(tt, &stats, sections, sectionCount);
+    if (sectionCount < 0)
+    {
+        free(sections);
+        printf("Memory allocation failed!\n");
+        return;
+    }
+
+    // Most loaded teacher
+    printf("\nMost loaded teacher: %s (%d lectures)\n", stats.mostLoaded.name, stats.mostLoaded.lectureCount);
+    // Busiest day for each section
+    for (int s = 0; s < sectionCount; s++)
+    {
+        printf("Busiest day for Section %s: %s (%d lectures)\n", timetableSectionName(tt, s),
+               DAY_CODES[sections[s].busiestDay], sections[s].busiestDayLectures);
+    }
+    // Free periods per section
+    for (int s = 0; s < sectionCount; s++)
+    {
+        printf("Free periods for Section %s: %d\n", timetableSectionName(tt, s), sections[s].freePeriods);
+    }
+    free(sections);
+    printf("\n");
+    writeRoomReport(stdout);
+}
+
+// Function to show the hot-path latency report and optionally dump it to a file
+void performanceReport()
+{
+    if (!perfEnabled())
+    {
+        printf(COLOR_ERROR "Instrumentation is off. Rebuild with -DSCHEDULER_PERF to collect latencies.\n" COLOR_RESET);
+        return;
+    }
+    perfWriteReport(stdout);
+
+    char answer[8], filename[100];
+    printf(COLOR_INPUT "Dump report to a file? (y/n): " COLOR_RESET);
+    scanf(" %7s", answer);
+    if (answer[0] != 'y' && answer[0] != 'Y')
+        return;
+    printf(COLOR_INPUT "Enter filename: " COLOR_RESET);
+    scanf(" %99s", filename);
+    if (perfDump(filename) != 0)
+        printf(COLOR_ERROR "Error: Could not create file %s!\n" COLOR_RESET, filename);
+    else
+        printf(COLOR_SUCCESS "Performance report written to %s\n" COLOR_RESET, filename);
+}
+
+// Room utilisation over the week; returns the number of overbooked periods, -1 on error
+int writeRoomReport(FILE *fp)
+{
+    int roomCount = timetableRoomCount(tt);
+    RoomUsage *usage = (RoomUsage *)malloc(sizeof(RoomUsage) * (roomCount > 0 ? roomCount : 1));
+    if (usage == NULL)
+        return -1;
+    roomCount = timetableRoomUsage(tt, usage, roomCount);
+    int overbooked = 0;
+    fprintf(fp, "%-15s | %8s | %13s | %11s | %10s\n", "Room", "Capacity", "Periods used", "Utilisation", "Overbooked");
+    fprintf(fp, "------------------------------------------------------------------------\n");
+    for (int r = 0; r < roomCount; r++)
+    {
+        const RoomUsage *room = &usage[r];
+        double percent = room->availablePeriods > 0 ? 100.0 * room->bookedPeriods / room->availablePeriods : 0.0;
+        fprintf(fp, "%-15s | %8d | %6d of %3d | %10.1f%% | %10d\n", room->name, room->capacity, room->bookedPeriods,
+                room->availablePeriods, percent, room->overbookedPeriods);
+        overbooked += room->overbookedPeriods;
+    }
+    if (roomCount == 0)
+        fprintf(fp, "No rooms registered.\n");
+    free(usage);
+    return ferror(fp) ? -1 : overbooked;
+}
+
+// Function to write the per-subsystem memory table and where this timetable's bytes go
+int writeMemoryReport(FILE *fp)
+{
+    TimetableMemory memory;
+    timetableMemory(tt, &memory);
+    memWriteReport(fp);
+    fprintf(fp, "\nTIMETABLE\n");
+    fprintf(fp, "Lectures:          %d (%zu bytes each)\n", memory.lectures, memory.lectureSize);
+    fprintf(fp, "Lecture blocks:    %zu bytes in %ld blocks", memory.lectureBytes, memory.blocks);
+    if (memory.lectures > 0)
+        fprintf(fp, " (%.1f bytes per lecture)", (double)memory.lectureBytes / memory.lectures);
+    fprintf(fp, "\nIndex nodes:       %zu bytes\n", memory.indexBytes);
+    fprintf(fp, "Undo history:      %zu bytes for %d edits (%zu lecture blocks, %zu index)\n",
+            memory.undoLectureBytes + memory.undoIndexBytes, memory.undoVersions, memory.undoLectureBytes,
+            memory.undoIndexBytes);
+    return ferror(fp) ? -1 : 0;
+}
+
+// Function to show current and peak memory use, optionally writing it to a file
+void memoryReport()
+{
+    writeMemoryReport(stdout);
+
+    char answer[8], filename[100];
+    printf(COLOR_INPUT "Save report to a file? (y/n): " COLOR_RESET);
+    scanf(" %7s", answer);
+    if (answer[0] != 'y' && answer[0] != 'Y')
+        return;
+    printf(COLOR_INPUT "Enter filename: " COLOR_RESET);
+    scanf(" %99s", filename);
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+    {
+        printf(COLOR_ERROR "Error: Could not create file %s!\n" COLOR_RESET, filename);
+        return;
+    }
+    writeMemoryReport(fp);
+    fclose(fp);
+    printf(COLOR_SUCCESS "Memory report written to %s\n" COLOR_RESET, filename);
+}
+
+// Function to build the link a shared file is reached by: the --share-url base
+// followed by the file name, or a file: URL of its absolute path
+void shareLink(const char *filename, const char *absPath, char *link, size_t linkSize)
+{
+    if (shareBaseUrl[0] != '\0')
+    {
+        size_t baseLen = strlen(shareBaseUrl);
+        snprintf(link, linkSize, "%s%s%s", shareBaseUrl, shareBaseUrl[baseLen - 1] == '/' ? "" : "/", filename);
+        return;
+    }
+    size_t j = (size_t)snprintf(link, linkSize, "file://%s", absPath[0] == '/' ? "" : "/");
+    for (const char *c = absPath; *c != '\0' && j + 4 < linkSize; c++)
+    {
+        if (*c == ' ')
+            j += (size_t)snprintf(link + j, linkSize - j, "%%20");
+        else
+            link[j++] = *c == '\\' ? '/' : *c;
+    }
+    link[j] = '\0';
+}
+
+void shareTimetableViaQR()
+{
+    // 1. Save timetable to file, or find the unchanged earlier save: the link and
+    // QR code then stay the same
+    char filename[100];
+    if (!saveTimetable(filename, sizeof(filename)))
+        return;
+    // 1.5. Get absolute path and check if file exists
+    char absPath[260];
+#ifdef _WIN32
+    if (_fullpath(absPath, filename, sizeof(absPath)) != NULL)
+    {
+        printf("Timetable file absolute path: %s\n", absPath);
+    }
+#else
+    realpath(filename, absPath);
+    printf("Timetable file absolute path: %s\n", absPath);
+#endif
+    FILE *test = fopen(absPath, "r");
+    if (!test)
+    {
+        printf(COLOR_ERROR "File %s does not exist; save the timetable first.\n" COLOR_RESET, absPath);
+        return;
+    }
+    fclose(test);
+    // 2. Link to the file, no upload: under --share-url when the file is published
+    // there, otherwise the file itself
+    char link[512];
+    shareLink(filename, absPath, link, sizeof(link));
+
+    // 3. Ask user what they want to do with the link
+    printf(COLOR_SUCCESS "\nTimetable saved.\n" COLOR_RESET);
+    printf(COLOR_HILITE "Link: %s\n" COLOR_RESET, link);
+    printf("\nWhat would you like to do?\n");
+    printf("1. Show QR code\n");
+    printf("2. Share link to WhatsApp group\n");
+    printf("3. Both\n");
+    printf(COLOR_INPUT "Enter choice (1-3): " COLOR_RESET);
+
+    int shareChoice;
     scanf("%d", &shareChoice);
 
     if (shareChoice == 1 || shareChoice == 3)
     {
-        // 4a. Open QR code in browser using api.qrserver.com
-        char qrUrl[1024];
-        snprintf(qrUrl, sizeof(qrUrl), "start \"\" \"https://api.qrserver.com/v1/create-qr-code/?data=%s&size=200x200\"", link);
-        printf(COLOR_SUCCESS "\nOpening QR code in your browser. Scan it to download the timetable.\n" COLOR_RESET);
-        system(qrUrl);
+        // 3a. Encode the QR code here, for the terminal and as an image
+        QrCode *qr = (QrCode *)malloc(sizeof(QrCode));
+        if (qr == NULL || qrEncode(link, (int)strlen(link), QR_ECC_MEDIUM, qr) != 0)
+            printf(COLOR_ERROR "Could not encode the link as a QR code.\n" COLOR_RESET);
+        else
+        {
+            printf("\n");
+            qrPrint(qr, stdout);
+            printf(COLOR_SUCCESS "\nScan it to open the timetable.\n" COLOR_RESET);
+            // The image only changes with the link, which only changes with the timetable
+            static char svgLink[512] = "";
+            FILE *svg = strcmp(svgLink, link) == 0 ? fopen("timetable_qr.svg", "r") : NULL;
+            if (svg != NULL)
+            {
+                fclose(svg);
+                printf(COLOR_HILITE "Unchanged in timetable_qr.svg for printing.\n" COLOR_RESET);
+            }
+            else if (qrWriteSvg(qr, "timetable_qr.svg", 8) == 0)
+            {
+                snprintf(svgLink, sizeof(svgLink), "%s", link);
+                printf(COLOR_HILITE "Also saved as timetable_qr.svg for printing.\n" COLOR_RESET);
+            }
+        }
+        free(qr);
     }
 
     if (shareChoice == 2 || shareChoice == 3)
     {
-        // 4b. Share link to WhatsApp group
+        // 3b. Share link to WhatsApp group
         shareLinkToWhatsAppGroup(link);
     }
-
-    // Optionally, clean up
-    remove(linkFile);
 }
 
 // Function to share link to WhatsApp group
@@ -2050,123 +2077,781 @@ void shareLinkToWhatsAppGroup(const char *link)
              "📅 *MCA Timetable Update*\n\n"
              "Hello everyone! Here's the updated timetable:\n"
              "%s\n\n"
-             "You can download the complete timetable file from this link. "
+             "You can open the complete timetable file from this link. "
              "Please share this with your classmates! 📚✨",
              link);
 
-    // URL encode the message
-    char encodedMessage[2048];
-    url_encode(message, encodedMessage, sizeof(encodedMessage));
-
-    // Create WhatsApp Web URL with pre-filled message
-    char whatsappUrl[3072];
-    snprintf(whatsappUrl, sizeof(whatsappUrl),
-             "https://wa.me/?text=%s", encodedMessage);
-
-    // Open WhatsApp Web in browser
-    char command[3200];
-    snprintf(command, sizeof(command), "start \"\" \"%s\"", whatsappUrl);
-
-    printf(COLOR_SUCCESS "\nOpening WhatsApp Web in your browser...\n" COLOR_RESET);
+    if (notices == NULL || notifyPost(notices, "", message) != 0)
+    {
+        printf(COLOR_ERROR "\nNotifications are off.\n" COLOR_RESET);
+        return;
+    }
+    printf(COLOR_SUCCESS "\nMessage queued, WhatsApp Web opens with it shortly...\n" COLOR_RESET);
     printf(COLOR_HILITE "The message is pre-filled with the timetable link.\n" COLOR_RESET);
-    printf(COLOR_HILITE "You can now select the group or contact to send it to.\n" COLOR_RESET);
-
-    system(command);
+    printf(COLOR_HILITE "You can then select the group or contact to send it to.\n" COLOR_RESET);
 
     // Also provide the group invite link as an alternative
     printf(COLOR_HILITE "\nAlternative: Join the MCA group directly:\n" COLOR_RESET);
     printf(COLOR_HILITE "Group Link: %s\n" COLOR_RESET, groupInviteLink);
-
-    char groupCommand[512];
-    snprintf(groupCommand, sizeof(groupCommand), "start \"\" \"%s\"", groupInviteLink);
-    printf(COLOR_HILITE "Opening group invite link...\n" COLOR_RESET);
-    system(groupCommand);
 }
 
 // Save timetable to a custom file
 void saveTimetableAs(const char *filename)
 {
-    FILE *fp;
-    fp = fopen(filename, "w");
-    if (fp == NULL)
+    if (timetableSave(tt, filename) != TT_OK)
     {
         printf(COLOR_ERROR "\nError: Could not create file %s!\n" COLOR_RESET, filename);
         return;
     }
-    // Write header
-    time_t now = time(NULL);
-    fprintf(fp, "================================================================\n");
-    fprintf(fp, "                        TIMETABLE DATA                            \n");
-    fprintf(fp, "                  Saved on: %s", ctime(&now));
-    fprintf(fp, "================================================================\n\n");
-    // Write timetable data for each section
-    char sections[] = {'A', 'B', 'C', 'D'};
-    const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-    for (int s = 0; s < 4; s++)
-    {
-        fprintf(fp, "\nSECTION %c TIMETABLE\n", sections[s]);
-        fprintf(fp, "----------------------------------------------------------------\n");
-        fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %s\n",
-                "Day", "Time", "Code", "Subject Name", "Faculty");
-        fprintf(fp, "----------------------------------------------------------------\n");
-        // For each day
-        for (int d = 0; d < 6; d++)
+    printf(COLOR_SUCCESS "\nTimetable saved successfully to file: %s\n" COLOR_RESET, filename);
+}
+
+// Split a batch line into arguments in place; "double quotes" group words
+int splitBatchArgs(char *line, char *args[], int maxArgs)
+{
+    int count = 0;
+    char *p = line;
+    while (*p && count < maxArgs)
+    {
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0' || *p == '#')
+            break;
+        if (*p == '"')
         {
-            Lecture *temp = head;
-            int hasLecture = 0;
-            while (temp)
-            {
-                if (temp->section == sections[s] && strcmp(temp->day, days[d]) == 0)
-                {
-                    const char *subjectName = getSubjectName(temp->subject);
-                    fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %s\n",
-                            temp->day,
-                            temp->time,
-                            temp->subject,
-                            subjectName,
-                            temp->faculty);
-                    hasLecture = 1;
-                }
-                temp = temp->next;
-            }
-            if (hasLecture)
-            {
-                fprintf(fp, "----------------------------------------------------------------\n");
-            }
+            args[count++] = ++p;
+            while (*p && *p != '"')
+                p++;
+        }
+        else
+        {
+            args[count++] = p;
+            while (*p && !isspace((unsigned char)*p))
+                p++;
         }
+        if (*p)
+            *p++ = '\0';
     }
-    // Write subject legend
-    fprintf(fp, "\n\nSUBJECT LEGEND:\n");
-    fprintf(fp, "----------------------------------------------------------------\n");
-    fprintf(fp, "%-8s | %-40s | %s\n", "Code", "Subject Name", "Type");
-    fprintf(fp, "----------------------------------------------------------------\n");
-    SubjectInfo subjects[50];
-    int subjectCount = 0;
-    getUniqueSubjects(subjects, &subjectCount);
-    for (int i = 0; i < subjectCount; i++)
+    return count;
+}
+
+// Function to switch to the period calendar in a file, result gets the outcome
+int useCalendar(const char *filename, char *result, size_t resultSize)
+{
+    int errorLine;
+    Calendar *calendar = calendarLoad(filename, &errorLine);
+    if (calendar == NULL)
     {
-        fprintf(fp, "%-8s | %-40s | %s\n",
-                subjects[i].code,
-                subjects[i].name,
-                subjects[i].isLab ? "Lab" : "Theory");
+        if (errorLine > 0)
+            snprintf(result, resultSize, "%s line %d: bad or overlapping period", filename, errorLine);
+        else
+            snprintf(result, resultSize, "could not read periods from %s", filename);
+        return 0;
     }
-    fprintf(fp, "----------------------------------------------------------------\n");
-    fprintf(fp, "\n================================================================\n");
-    fprintf(fp, "                          END OF DATA                             \n");
-    fprintf(fp, "================================================================\n");
-    fclose(fp);
-    printf(COLOR_SUCCESS "\nTimetable saved successfully to file: %s\n" COLOR_RESET, filename);
+    if (timetableSetCalendar(tt, calendar) != TT_OK)
+    {
+        calendarDestroy(calendar);
+        snprintf(result, resultSize, "out of memory");
+        return 0;
+    }
+    snprintf(result, resultSize, "up to %d periods a day from %s", calendarMaxPeriods(calendar), filename);
+    return 1;
+}
+
+// Check that every argument of a batch command fits a Lecture field
+int batchArgsFit(char *args[], int argCount)
+{
+    for (int i = 1; i < argCount; i++)
+    {
+        if (strlen(args[i]) >= MAX_LEN)
+            return 0;
+    }
+    return 1;
+}
+
+// Queue an edit into the open batch transaction. Returns -1 for commands that
+// are not queued (reads, load/save), otherwise 1 on success and 0 on error.
+int queueBatchCommand(char *args[], int argCount, char *result, size_t resultSize)
+{
+    const char *cmd = args[0];
+    int status;
+    if (strcmp(cmd, "swap") == 0 && (argCount == 7 || argCount == 8))
+        status = txnSwap(batchTxn, args[1], args[2], args[3], args[4], args[5], args[6],
+                         argCount == 8 ? atoi(args[7]) : 1);
+    else if (strcmp(cmd, "change-section") == 0 && argCount == 5)
+        status = txnMoveSection(batchTxn, args[1], args[2], args[3], args[4]);
+    else if (strcmp(cmd, "assign") == 0 && argCount == 3)
+        status = txnAssignSubject(batchTxn, args[1], args[2]);
+    else if (strcmp(cmd, "assign") == 0 && argCount == 6)
+        status = txnInsertLecture(batchTxn, args[2], args[3], args[4], args[5], args[1]);
+    else if (strcmp(cmd, "room") == 0 && argCount == 5)
+        status = txnSetRoom(batchTxn, args[1], args[2], args[3], args[4]);
+    else
+        return -1;
+
+    if (status != TT_OK)
+    {
+        snprintf(result, resultSize, "%s", timetableStrError(status));
+        return 0;
+    }
+    snprintf(result, resultSize, "queued as edit %d", txnCount(batchTxn));
+    return 1;
+}
+
+// Commit the open batch transaction, describing the outcome in result
+int commitBatchTxn(char *result, size_t resultSize)
+{
+    TxnFailure failure;
+    int count = txnCount(batchTxn);
+    int status = timetableCommit(batchTxn, &failure);
+    batchTxn = NULL;
+    if (status == TT_OK)
+    {
+        snprintf(result, resultSize, "committed %d edit(s)", count);
+        return 1;
+    }
+    if (status == TT_ERR_CONFLICT)
+        snprintf(result, resultSize, "rolled back: %s %s %s %s (%s) clashes with %s %s %s %s (%s)",
+                 failure.lecture.section, failure.lecture.day, failure.lecture.time, failure.lecture.subject,
+                 failure.lecture.faculty, failure.other.section, failure.other.day, failure.other.time,
+                 failure.other.subject, failure.other.faculty);
+    else if (failure.op >= 0)
+        snprintf(result, resultSize, "rolled back: edit %d failed (%s)", failure.op + 1, timetableStrError(status));
+    else
+        snprintf(result, resultSize, "rolled back: %s", timetableStrError(status));
+    return 0;
 }
 
-int main()
+// Run one batch command against the timetable, returns 1 on success.
+// A short human readable result is written into result.
+int runBatchCommand(char *args[], int argCount, char *result, size_t resultSize)
 {
+    const char *cmd = args[0];
+    Lecture lec1, lec2;
+    if (!batchArgsFit(args, argCount))
+    {
+        snprintf(result, resultSize, "argument longer than %d characters", MAX_LEN - 1);
+        return 0;
+    }
+
+    if (strcmp(cmd, "begin") == 0 && argCount == 1)
+    {
+        if (batchTxn != NULL)
+        {
+            snprintf(result, resultSize, "transaction already open");
+            return 0;
+        }
+        batchTxn = timetableBegin(tt);
+        snprintf(result, resultSize, batchTxn ? "transaction started" : "out of memory");
+        return batchTxn != NULL;
+    }
+    if ((strcmp(cmd, "commit") == 0 || strcmp(cmd, "rollback") == 0) && argCount == 1)
+    {
+        if (batchTxn == NULL)
+        {
+            snprintf(result, resultSize, "no open transaction");
+            return 0;
+        }
+        if (cmd[0] == 'c')
+            return commitBatchTxn(result, resultSize);
+        snprintf(result, resultSize, "discarded %d edit(s)", txnCount(batchTxn));
+        timetableRollback(batchTxn);
+        batchTxn = NULL;
+        return 1;
+    }
+    if (batchTxn != NULL)
+    {
+        int queued = queueBatchCommand(args, argCount, result, resultSize);
+        if (queued >= 0)
+            return queued;
+        if (strcmp(cmd, "load") == 0 || strcmp(cmd, "patch") == 0)
+        {
+            snprintf(result, resultSize, "commit or roll back the open transaction first");
+            return 0;
+        }
+    }
+
+    if (strcmp(cmd, "load") == 0 && argCount == 2)
+    {
+        int rejected;
+        int loaded = loadTimetableFile(tt, args[1], &rejected);
+        if (loaded < 0)
+        {
+            snprintf(result, resultSize, "could not load %s: %s", args[1], timetableStrError(loaded));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d lectures from %s (%d rows skipped)", loaded, args[1], rejected);
+        return 1;
+    }
+    if (strcmp(cmd, "calendar") == 0 && argCount == 2)
+        return useCalendar(args[1], result, resultSize);
+    if (strcmp(cmd, "diff") == 0 && (argCount == 4 || argCount == 5))
+    {
+        DiffReport report;
+        double start = monotonicMicros();
+        int status = diffTimetableFiles(args[1], args[2], args[3], argCount == 5 ? args[4] : NULL, &report);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "could not compare %s with %s: %s", args[1], args[2], timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d added, %d removed, %d moved, %d re-staffed, %d room change(s) in %d "
+                 "section(s), %.1f ms, report in %s", report.added, report.removed, report.moved, report.restaffed,
+                 report.rooms, report.sections, (monotonicMicros() - start) / 1000.0, args[3]);
+        return 1;
+    }
+    if (strcmp(cmd, "patch") == 0 && argCount == 2)
+        return applyPatchFile(args[1], result, resultSize);
+    if (strcmp(cmd, "merge") == 0 && argCount == 6)
+    {
+        MergeReport report;
+        double start = monotonicMicros();
+        int status = mergeTimetableFiles(args[1], args[2], args[3], args[4], args[5], &report);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "could not merge into %s: %s", args[4], timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d of ours kept, %d of theirs applied, %d alike, %d conflict(s) in %.1f ms, "
+                 "merged into %s%s%s", report.ours, report.theirs, report.same, report.conflicts,
+                 (monotonicMicros() - start) / 1000.0, args[4], report.conflicts ? ", see " : "",
+                 report.conflicts ? args[5] : "");
+        return report.conflicts == 0;
+    }
+    if (strcmp(cmd, "save") == 0 && argCount == 2)
+    {
+        if (saveTimetableFile(tt, args[1]) != TT_OK)
+        {
+            snprintf(result, resultSize, "could not create %s", args[1]);
+            return 0;
+        }
+        snprintf(result, resultSize, "saved to %s", args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "swap") == 0 && (argCount == 7 || argCount == 8))
+    {
+        int swapTeacher = argCount == 8 ? atoi(args[7]) : 1;
+        if (timetableSwap(tt, args[1], args[2], args[3], args[4], args[5], args[6], swapTeacher) != TT_OK)
+        {
+            int firstMissing = !timetableIsSlotFree(tt, args[1], args[2], args[3]) ? 4 : 1;
+            snprintf(result, resultSize, "no lecture at %s %s %s", args[firstMissing], args[firstMissing + 1], args[firstMissing + 2]);
+            return 0;
+        }
+        timetableGetLecture(tt, args[1], args[2], args[3], &lec1);
+        timetableGetLecture(tt, args[4], args[5], args[6], &lec2);
+        snprintf(result, resultSize, "%s (%s) <-> %s (%s)", lec1.subject, lec1.faculty, lec2.subject, lec2.faculty);
+        return 1;
+    }
+    if (strcmp(cmd, "change-section") == 0 && argCount == 5)
+    {
+        int status = timetableMoveSection(tt, args[1], args[2], args[3], args[4]);
+        if (status == TT_ERR_INVALID)
+        {
+            snprintf(result, resultSize, "invalid section name %s", args[4]);
+            return 0;
+        }
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "no lecture at %s %s %s", args[1], args[2], args[3]);
+            return 0;
+        }
+        snprintf(result, resultSize, "section %s -> %s", args[1], args[4]);
+        return 1;
+    }
+    if (strcmp(cmd, "assign") == 0 && argCount == 3)
+    {
+        int updated = timetableAssignSubject(tt, args[1], args[2]);
+        if (updated == 0)
+        {
+            snprintf(result, resultSize, "no lectures for subject %s", args[1]);
+            return 0;
+        }
+        snprintf(result, resultSize, "%s now teaches %d slot(s) of %s", args[2], updated, args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "assign") == 0 && argCount == 6)
+    {
+        if (!timetableIsSlotFree(tt, args[1], args[2], args[3]))
+        {
+            snprintf(result, resultSize, "slot %s %s already occupied in section %s", args[2], args[3], args[1]);
+            return 0;
+        }
+        int status = timetableInsertLecture(tt, args[2], args[3], args[4], args[5], args[1]);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "%s", status == TT_ERR_INVALID  ? "invalid section or room name"
+                                               : status == TT_ERR_OCCUPIED ? "room is full at that time"
+                                                                           : timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "added %s (%s) to section %s", args[4], args[5], args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "perf-report") == 0 && argCount == 2)
+    {
+        if (!perfEnabled())
+        {
+            snprintf(result, resultSize, "instrumentation is off, rebuild with -DSCHEDULER_PERF");
+            return 0;
+        }
+        if (perfDump(args[1]) != 0)
+        {
+            snprintf(result, resultSize, "could not create %s", args[1]);
+            return 0;
+        }
+        snprintf(result, resultSize, "performance report written to %s", args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "room") == 0 && argCount == 5)
+    {
+        int status = timetableSetRoom(tt, args[1], args[2], args[3], args[4]);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "%s %s %s: %s", args[1], args[2], args[3],
+                     status == TT_ERR_OCCUPIED ? "room is full at that time" : timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "section %s %s %s now in %s", args[1], args[2], args[3], args[4]);
+        return 1;
+    }
+    if (strcmp(cmd, "add-room") == 0 && argCount == 3)
+    {
+        if (timetableAddRoom(tt, args[1], atoi(args[2])) < 0)
+        {
+            snprintf(result, resultSize, "invalid room %s or capacity %s", args[1], args[2]);
+            return 0;
+        }
+        snprintf(result, resultSize, "room %s holds %d section(s)", args[1], atoi(args[2]));
+        return 1;
+    }
+    if (strcmp(cmd, "allocate-rooms") == 0 && (argCount == 1 || (argCount == 2 && strcmp(args[1], "replan") == 0)))
+    {
+        RoomPlan plan;
+        int status = timetableAllocateRooms(tt, argCount == 2, &plan);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "%s", timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d of %d lecture(s) in a room, %d moved, room changes %d -> %d", plan.placed,
+                 plan.lectures, plan.moved, plan.roomChangesBefore, plan.roomChanges);
+        return plan.placed == plan.lectures;
+    }
+    if (strcmp(cmd, "lecture-reminders") == 0 && argCount == 2)
+    {
+        char *end;
+        long lead = strtol(args[1], &end, 10);
+        if (strcmp(args[1], "off") == 0)
+            lead = -1;
+        else if (*end != '\0' || lead < 0 || lead > 24 * 60)
+        {
+            snprintf(result, resultSize, "lead time must be minutes (0 to 1440) or off");
+            return 0;
+        }
+        return setLectureReminders((int)lead, result, resultSize);
+    }
+    if (strcmp(cmd, "reminder-status") == 0 && argCount == 1)
+    {
+        ReminderStats stats = {0, 0, 0}, lectures = {0, 0, 0};
+        if (reminders != NULL)
+            reminderStats(reminders, &stats);
+        if (lectureReminders != NULL)
+            lectureRemindersStats(lectureReminders, &lectures);
+        snprintf(result, resultSize, "%d pending, %lld delivered, %lld failed; lecture reminders %s: %d pending, "
+                 "%lld delivered", stats.pending, stats.delivered, stats.failed, lectureReminders ? "on" : "off",
+                 lectures.pending, lectures.delivered);
+        return 1;
+    }
+    if (strcmp(cmd, "notify-changes") == 0 && argCount == 2 &&
+        (strcmp(args[1], "on") == 0 || strcmp(args[1], "off") == 0))
+        return setChangeNotifications(strcmp(args[1], "on") == 0, result, resultSize);
+    if (strcmp(cmd, "notify-flush") == 0 && argCount == 1)
+    {
+        if (notices == NULL)
+        {
+            snprintf(result, resultSize, "notifications are off");
+            return 0;
+        }
+        NotifyStats stats;
+        notifyStats(notices, &stats);
+        notifyFlush(notices);
+        snprintf(result, resultSize, "sending %d message(s) to %d recipient(s)", stats.pending, stats.recipients);
+        return 1;
+    }
+    if (strcmp(cmd, "notify-status") == 0 && argCount == 1)
+    {
+        NotifyStats stats = {0, 0, 0, 0, 0, 0};
+        if (notices != NULL)
+            notifyStats(notices, &stats);
+        snprintf(result, resultSize, "%d pending for %d recipient(s), %lld posted, %lld coalesced, %lld sent, "
+                 "%lld failed; change notifications %s", stats.pending, stats.recipients, stats.posted,
+                 stats.coalesced, stats.sent, stats.failed, notifiedVersion ? "on" : "off");
+        return 1;
+    }
+    if (strcmp(cmd, "export") == 0 && (argCount == 1 || argCount == 2))
+    {
+        char filename[100];
+        const char *section = argCount == 2 ? args[1] : "";
+        if (section[0] && timetableSectionId(tt, section) < 0)
+        {
+            snprintf(result, resultSize, "unknown section %s", section);
+            return 0;
+        }
+        int status = exportTimetable(section, filename, sizeof(filename));
+        if (status == 0)
+            snprintf(result, resultSize, "could not create %s", filename);
+        else
+            snprintf(result, resultSize, "%s %s (%lld written, %lld reused)", status == 2 ? "unchanged in" : "written to",
+                     filename, exportsWritten, exportsReused);
+        return status != 0;
+    }
+    if (strcmp(cmd, "export-all") == 0 && argCount >= 2 && argCount <= 4)
+    {
+        int format = argCount >= 3 ? exportFormat(args[2]) : EXPORT_TEXT;
+        int threads = argCount == 4 ? atoi(args[3]) : 0;
+        if (format == 0 || threads < 0)
+        {
+            snprintf(result, resultSize, "usage: export-all <directory> [text|csv|jsonl] [threads]");
+            return 0;
+        }
+        ExportReport report;
+        double start = monotonicMicros();
+        int status = timetableExportSections(tt, args[1], format, threads, &report);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "could not export to %s: %s", args[1], timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d sections, %d lectures, %lld bytes to %s/manifest.csv in %.1f ms on %d thread(s)",
+                 report.sections, report.lectures, report.bytes, args[1], (monotonicMicros() - start) / 1000.0,
+                 report.threads);
+        return 1;
+    }
+    if (strcmp(cmd, "term") == 0 && argCount == 3)
+    {
+        if (!setTerm(args[1], args[2]))
+        {
+            snprintf(result, resultSize, "usage: term <YYYY-MM-DD> <YYYY-MM-DD>");
+            return 0;
+        }
+        snprintf(result, resultSize, "term %s to %s", termStart, termEnd);
+        return 1;
+    }
+    if (strcmp(cmd, "ics") == 0 && argCount == 4 && (strcmp(args[1], "section") == 0 || strcmp(args[1], "teacher") == 0))
+    {
+        int isSection = args[1][0] == 's';
+        if (isSection && timetableSectionId(tt, args[2]) < 0)
+        {
+            snprintf(result, resultSize, "unknown section %s", args[2]);
+            return 0;
+        }
+        int events = writeCalendarFile(isSection ? args[2] : NULL, isSection ? NULL : args[2], args[3]);
+        if (events < 0)
+        {
+            snprintf(result, resultSize, "could not write %s: %s", args[3], timetableStrError(events));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d weekly events (%s to %s) in %s", events, termStart, termEnd, args[3]);
+        return 1;
+    }
+    if (strcmp(cmd, "ics-all") == 0 && argCount == 2)
+    {
+        CalendarReport report;
+        double start = monotonicMicros();
+        int status = timetableExportCalendars(tt, args[1], termStart, termEnd, &report);
+        if (status != TT_OK)
+        {
+            snprintf(result, resultSize, "could not export calendars to %s: %s", args[1], timetableStrError(status));
+            return 0;
+        }
+        snprintf(result, resultSize, "%d section and %d teacher calendars, %d events, %lld bytes in %.1f ms",
+                 report.sections, report.teachers, report.events, report.bytes, (monotonicMicros() - start) / 1000.0);
+        return 1;
+    }
+    if (strcmp(cmd, "qr") == 0 && argCount == 3)
+    {
+        QrCode *qr = (QrCode *)malloc(sizeof(QrCode));
+        double start = monotonicMicros();
+        if (qr == NULL || qrEncode(args[1], (int)strlen(args[1]), QR_ECC_MEDIUM, qr) != 0)
+        {
+            free(qr);
+            snprintf(result, resultSize, "%s", qr == NULL ? "out of memory" : "text too long for a QR code");
+            return 0;
+        }
+        double elapsed = monotonicMicros() - start;
+        int status = qrWriteSvg(qr, args[2], 8);
+        if (status == 0)
+            snprintf(result, resultSize, "version %d (%dx%d modules, mask %d) encoded in %.1fus, written to %s",
+                     qr->version, qr->size, qr->size, qr->mask, elapsed, args[2]);
+        else
+            snprintf(result, resultSize, "could not write %s", args[2]);
+        free(qr);
+        return status == 0;
+    }
+    if (strcmp(cmd, "room-report") == 0 && argCount == 2)
+    {
+        FILE *fp = fopen(args[1], "w");
+        if (fp == NULL)
+        {
+            snprintf(result, resultSize, "could not create %s", args[1]);
+            return 0;
+        }
+        int overbooked = writeRoomReport(fp);
+        if (fclose(fp) != 0 || overbooked < 0)
+        {
+            snprintf(result, resultSize, "could not write %s", args[1]);
+            return 0;
+        }
+        snprintf(result, resultSize, "%d room(s), %d overbooked period(s), report written to %s",
+                 timetableRoomCount(tt), overbooked, args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "mem-report") == 0 && argCount == 2)
+    {
+        FILE *fp = fopen(args[1], "w");
+        if (fp == NULL)
+        {
+            snprintf(result, resultSize, "could not create %s", args[1]);
+            return 0;
+        }
+        int status = writeMemoryReport(fp);
+        if (fclose(fp) != 0 || status != 0)
+        {
+            snprintf(result, resultSize, "could not write %s", args[1]);
+            return 0;
+        }
+        MemUsage usage[MEM_SUBSYSTEM_COUNT], total;
+        memUsage(usage, &total);
+        snprintf(result, resultSize, "%lld bytes in use (peak %lld), report written to %s", total.bytes,
+                 total.peakBytes, args[1]);
+        return 1;
+    }
+    if (strcmp(cmd, "query") == 0 && argCount == 4)
+    {
+        if (timetableGetLecture(tt, args[1], args[2], args[3], &lec1) != TT_OK)
+            snprintf(result, resultSize, "Section %s | %s | %s | free", args[1], args[2], args[3]);
+        else
+            snprintf(result, resultSize, "Section %s | %s | %s | %s | %s", lec1.section, lec1.day, lec1.time, lec1.subject, lec1.faculty);
+        return 1;
+    }
+
+    snprintf(result, resultSize, "unknown command or wrong argument count");
+    return 0;
+}
+
+// Non-interactive mode: run every command of a batch file ("-" for stdin).
+// Prints one tab separated status line per command and a summary, no prompts or colours.
+int runBatch(const char *filename)
+{
+    FILE *fp = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: Could not open batch file %s!\n", filename);
+        return 2;
+    }
+
+    char line[1024];
+    char result[512];
+    char *args[16];
+    int lineNo = 0, okCount = 0, errCount = 0;
+    double batchStart = monotonicMicros();
+    TRACE_BEGIN(batchSpan, "batch", "batch");
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        lineNo++;
+        int argCount = splitBatchArgs(line, args, 16);
+        if (argCount == 0)
+            continue;
+
+        double start = monotonicMicros();
+        TRACE_BEGIN(span, "batch", args[0]);
+        TRACE_ARG(span, lineNo);
+        int ok = runBatchCommand(args, argCount, result, sizeof(result));
+        TRACE_END(span);
+        double elapsed = monotonicMicros() - start;
+        syncLectureReminders();
+        syncNotifications();
+
+        if (ok)
+            okCount++;
+        else
+            errCount++;
+        printf("%d\t%s\t%s\t%.1fus\t%s\n", lineNo, ok ? "OK" : "ERR", args[0], elapsed, result);
+    }
+
+    int leftOpen = batchTxn != NULL;
+    if (leftOpen)
+    {
+        printf("# transaction left open at end of batch, %d edit(s) discarded\n", txnCount(batchTxn));
+        timetableRollback(batchTxn);
+        batchTxn = NULL;
+    }
+
+    TRACE_ARG(batchSpan, okCount + errCount);
+    TRACE_END(batchSpan);
+    double total = monotonicMicros() - batchStart;
+    int commandCount = okCount + errCount;
+    printf("# %d command(s): %d ok, %d failed in %.3f ms (%.0f commands/s)\n",
+           commandCount, okCount, errCount, total / 1000.0,
+           total > 0 ? commandCount * 1000000.0 / total : 0.0);
+
+    if (fp != stdin)
+        fclose(fp);
+    return errCount == 0 && !leftOpen ? 0 : 1;
+}
+
+// Options from the command line, NULL when not given
+typedef struct
+{
+    const char *trace;     // --trace <file>: record a timeline of the run in Chrome trace format
+    const char *calendar;  // --calendar <file>: replace the standard periods
+    const char *reminders; // --reminders <sink>: deliver reminders somewhere other than the terminal
+    const char *shareUrl;  // --share-url <base>: where shared timetables are published
+    const char *term;      // --term <start>,<end>: the dates calendar exports run between
+    const char *notify;    // --notify <transport>: send notifications elsewhere, with change notices
+    const char *batch;     // --batch <file>: run commands instead of the menu
+    const char *serve;     // --serve <address> [timetable]: serve clients instead of the menu
+    const char *serveFile;
+} Options;
+
+// Function to print the command line options
+void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--trace <file>] [--calendar <file>] [--reminders <sink>] [--share-url <base>]\n"
+            "       [--term <start>,<end>] [--notify <transport>] [--batch <file> | --serve <address> [timetable]]\n",
+            program);
+}
+
+// Function to find where the value of an option goes, NULL for an unknown option
+const char **optionValue(Options *options, const char *name)
+{
+    const char *names[] = {"--trace", "--calendar", "--reminders", "--share-url",
+                           "--term",  "--notify",   "--batch",     "--serve"};
+    const char **values[] = {&options->trace, &options->calendar, &options->reminders, &options->shareUrl,
+                             &options->term,  &options->notify,   &options->batch,     &options->serve};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+            return values[i];
+    }
+    return NULL;
+}
+
+// Function to read the options, given in any order; returns 0, or -1 on an unknown or
+// repeated option, a missing value or both --batch and --serve
+int parseOptions(int argc, char *argv[], Options *options)
+{
+    memset(options, 0, sizeof(*options));
+    for (int i = 1; i < argc; i += 2)
+    {
+        const char **value = optionValue(options, argv[i]);
+        if (value == NULL || *value != NULL || i + 1 == argc)
+            return -1;
+        *value = argv[i + 1];
+        if (value == &options->serve && i + 2 < argc && strncmp(argv[i + 2], "--", 2) != 0)
+            options->serveFile = argv[++i + 1];
+    }
+    return options->batch != NULL && options->serve != NULL ? -1 : 0;
+}
+
+// Function to stop the background threads, free the timetable and write the trace
+// file, the way every run ends; returns status
+int finishRun(int status)
+{
+    stopReminders();
+    stopNotifications();
+    timetableDestroy(tt);
+    if (atomic_load(&traceOn) && traceFlush() < 0)
+        fprintf(stderr, "Error: Could not write the trace file!\n");
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (parseOptions(argc, argv, &options) != 0)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.trace != NULL)
+    {
+        if (traceOpen(options.trace, TRACE_EVENTS) != 0)
+        {
+            fprintf(stderr, "Error: Could not start tracing to %s!\n", options.trace);
+            return 1;
+        }
+        traceThreadName("main");
+    }
+    tt = timetableCreate();
+    if (tt == NULL)
+    {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+    TRACE_BEGIN(initSpan, "edit", "initialize");
     initializeTimetable();
+    defaultTerm();
+    TRACE_END(initSpan);
+
+    // The options take effect in this order wherever they are on the command line
+    char message[256];
+    if (options.calendar != NULL && !useCalendar(options.calendar, message, sizeof(message)))
+    {
+        fprintf(stderr, "Error: %s!\n", message);
+        return finishRun(1);
+    }
+    if (options.reminders != NULL && !startReminders(options.reminders, message, sizeof(message)))
+    {
+        fprintf(stderr, "Error: %s!\n", message);
+        return finishRun(1);
+    }
+    if (options.shareUrl != NULL)
+        snprintf(shareBaseUrl, sizeof(shareBaseUrl), "%s", options.shareUrl);
+    if (options.term != NULL)
+    {
+        char start[16] = "";
+        const char *comma = strchr(options.term, ',');
+        if (comma != NULL && comma - options.term < (int)sizeof(start))
+            memcpy(start, options.term, comma - options.term);
+        if (comma == NULL || !setTerm(start, comma + 1))
+        {
+            fprintf(stderr, "Error: --term takes <YYYY-MM-DD>,<YYYY-MM-DD>!\n");
+            return finishRun(1);
+        }
+    }
+    if (options.notify != NULL && (!startNotifications(options.notify, message, sizeof(message)) ||
+                                   !setChangeNotifications(1, message, sizeof(message))))
+    {
+        fprintf(stderr, "Error: %s!\n", message);
+        return finishRun(1);
+    }
+
+    if (options.batch != NULL)
+        return finishRun(runBatch(options.batch));
+    if (options.serve != NULL)
+    {
+        int rejected;
+        if (options.serveFile != NULL && loadTimetableFile(tt, options.serveFile, &rejected) < 0)
+        {
+            fprintf(stderr, "Error: Could not open file %s!\n", options.serveFile);
+            return finishRun(1);
+        }
+        return finishRun(runServer(tt, options.serve));
+    }
+    if (reminders == NULL && !startReminders("stdout", message, sizeof(message)))
+        printf(COLOR_ERROR "%s, reminders are off.\n" COLOR_RESET, message);
+    if (notices == NULL && !startNotifications("whatsapp", message, sizeof(message)))
+        printf(COLOR_ERROR "%s, notifications are off.\n" COLOR_RESET, message);
     int choice, subChoice, viewChoice, saveChoice;
-    char section, section1, section2;
-    int dayChoice;
+    char section[SECTION_NAME_LEN], section1[SECTION_NAME_LEN], section2[SECTION_NAME_LEN];
     char filename[100];
     while (1)
     {
+        syncLectureReminders();
+        syncNotifications();
         printf(COLOR_HEADER "\n====== Classroom Scheduler ======\n" COLOR_RESET);
         printf(CLI_COLOR_MENU "1. Display Timetable\n" COLOR_RESET);
         printf(CLI_COLOR_MENU "2. Swap Classes\n" COLOR_RESET);
@@ -2179,7 +2864,9 @@ int main()
         printf(CLI_COLOR_MENU "9. Set Notification/Reminder\n" COLOR_RESET);
         printf(CLI_COLOR_MENU "10. Statistics Dashboard\n" COLOR_RESET);
         printf(CLI_COLOR_MENU "11. Share Timetable via QR Code\n" COLOR_RESET);
-        printf(CLI_COLOR_MENU "12. Exit\n" COLOR_RESET);
+        printf(CLI_COLOR_MENU "12. Performance Report\n" COLOR_RESET);
+        printf(CLI_COLOR_MENU "13. Memory Report\n" COLOR_RESET);
+        printf(CLI_COLOR_MENU "14. Exit\n" COLOR_RESET);
         printf(COLOR_INPUT "Enter choice: " COLOR_RESET);
         scanf("%d", &choice);
         switch (choice)
@@ -2196,9 +2883,7 @@ int main()
             }
             else if (subChoice == 2)
             {
-                printf(COLOR_INPUT "Enter section (A/B/C/D): " COLOR_RESET);
-                scanf(" %c", &section);
-                if (section >= 'A' && section <= 'D')
+                if (readSection(COLOR_INPUT "Enter section", section))
                 {
                     printf("1. Full Week Timetable\n2. Specific Day Timetable\n");
                     printf(COLOR_INPUT "Enter choice: " COLOR_RESET);
@@ -2209,13 +2894,11 @@ int main()
                     }
                     else if (viewChoice == 2)
                     {
-                        printf("Select Day:\n1. Monday\n2. Tuesday\n3. Wednesday\n4. Thursday\n5. Friday\n6. Saturday\n");
-                        printf(COLOR_INPUT "Enter choice (1-6): " COLOR_RESET);
-                        scanf("%d", &dayChoice);
-                        if (dayChoice >= 1 && dayChoice <= 6)
+                        printf("Select Day:\n");
+                        int d = chooseDay();
+                        if (d >= 0)
                         {
-                            const char *days[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
-                            printDayTimetable(section, days[dayChoice - 1]);
+                            printDayTimetable(section, DAY_CODES[d]);
                         }
                         else
                         {
@@ -2241,11 +2924,9 @@ int main()
             swapClasses();
             break;
         case 3:
-            printf(COLOR_INPUT "Enter current section (A/B/C/D): " COLOR_RESET);
-            scanf(" %c", &section1);
-            printf(COLOR_INPUT "Enter new section (A/B/C/D): " COLOR_RESET);
-            scanf(" %c", &section2);
-            if ((section1 >= 'A' && section1 <= 'D') && (section2 >= 'A' && section2 <= 'D'))
+            // The new section may be one no lecture uses yet
+            if (readSection(COLOR_INPUT "Enter current section", section1) &&
+                (readSection(COLOR_INPUT "Enter new section", section2) || section2[0] != '\0'))
             {
                 changeClassSection(section1, section2);
             }
@@ -2264,25 +2945,33 @@ int main()
             printf(COLOR_HILITE "\nSave Timetable Options:\n" COLOR_RESET);
             printf("1. Save Full Timetable (All Sections)\n");
             printf("2. Save Timetable for a Section\n");
+            printf("3. Save Every Section to a Directory\n");
+            printf("4. Save Calendars (.ics) of Every Section and Teacher\n");
             printf(COLOR_INPUT "Enter choice: " COLOR_RESET);
             scanf("%d", &saveChoice);
             if (saveChoice == 1)
             {
-                saveTimetable();
+                saveTimetable(NULL, 0);
             }
             else if (saveChoice == 2)
             {
-                printf(COLOR_INPUT "Enter section (A/B/C/D): " COLOR_RESET);
-                scanf(" %c", &section);
-                if (section >= 'A' && section <= 'D')
+                if (readSection(COLOR_INPUT "Enter section", section))
                 {
-                    displaySaveSectionTimetable(section);
+                    displaySaveSectionTimetable(section, NULL, 0);
                 }
                 else
                 {
                     printf(COLOR_ERROR "Invalid section!\n" COLOR_RESET);
                 }
             }
+            else if (saveChoice == 3)
+            {
+                saveAllSections();
+            }
+            else if (saveChoice == 4)
+            {
+                saveAllCalendars();
+            }
             else
             {
                 printf(COLOR_ERROR "Invalid save choice!\n" COLOR_RESET);
@@ -2297,7 +2986,10 @@ int main()
             searchTimetable();
             break;
         case 9:
-            setNotification();
+            if (reminders != NULL)
+                setNotification();
+            else
+                printf(COLOR_ERROR "Reminders are off.\n" COLOR_RESET);
             break;
         case 10:
             statisticsDashboard();
@@ -2306,8 +2998,14 @@ int main()
             shareTimetableViaQR();
             break;
         case 12:
+            performanceReport();
+            break;
+        case 13:
+            memoryReport();
+            break;
+        case 14:
             printf(COLOR_HEADER "Thank you for using Classroom Scheduler!\n" COLOR_RESET);
-            return 0;
+            return finishRun(0);
         default:
             printf(COLOR_ERROR "Invalid choice. Please try again.\n" COLOR_RESET);
         }
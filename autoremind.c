@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "autoremind.h"
+#include "platform.h"
+
+#define SLOT_EMPTY -1
+#define SLOT_DELETED -2
+
+// The reminder of one lecture slot, found by section, day and time
+typedef struct
+{
+    char section[SECTION_NAME_LEN];
+    int day;
+    char time[MAX_LEN];
+    ReminderId id; // 0 while nothing is queued for it
+    int live;
+    int nextFree;
+} ReminderEntry;
+
+struct LectureReminders
+{
+    Timetable *tt;
+    int lead; // minutes
+    ReminderSink sink;
+    void *ctx;
+    ReminderQueue *queue;
+
+    Mutex lock; // guards everything below; taken before the queue's own lock
+    const TimetableVersion *synced; // version the reminders were built from, pinned
+    const Calendar *calendar;       // and its calendar
+    ReminderEntry *entries;
+    int entryCapacity, entryUsed, freeList;
+    int *slots; // open addressing by key hash: entry index, SLOT_EMPTY or SLOT_DELETED
+    int slotCount; // a power of two, kept at least twice the live and deleted entries
+    int live, deleted;
+};
+
+static unsigned int hashKey(const char *section, int day, const char *time)
+{
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *section; section++)
+        hash = (hash ^ (unsigned char)*section) * 16777619u;
+    hash = (hash ^ (unsigned int)day) * 16777619u;
+    for (; *time; time++)
+        hash = (hash ^ (unsigned char)*time) * 16777619u;
+    return hash;
+}
+
+// Slot holding the entry of a key, or the slot to put it in (the first deleted one
+// on the way, else the empty one that ended the search)
+static int findSlot(const LectureReminders *lr, const char *section, int day, const char *time)
+{
+    unsigned int mask = (unsigned int)lr->slotCount - 1;
+    int reuse = -1;
+    for (unsigned int slot = hashKey(section, day, time) & mask;; slot = (slot + 1) & mask)
+    {
+        int index = lr->slots[slot];
+        if (index == SLOT_EMPTY)
+            return reuse >= 0 ? reuse : (int)slot;
+        if (index == SLOT_DELETED)
+        {
+            if (reuse < 0)
+                reuse = (int)slot;
+            continue;
+        }
+        const ReminderEntry *entry = &lr->entries[index];
+        if (entry->day == day && strcmp(entry->section, section) == 0 && strcmp(entry->time, time) == 0)
+            return (int)slot;
+    }
+}
+
+static int isEntryAt(const LectureReminders *lr, int slot, const char *section, int day, const char *time)
+{
+    int index = lr->slots[slot];
+    if (index < 0)
+        return 0;
+    const ReminderEntry *entry = &lr->entries[index];
+    return entry->day == day && strcmp(entry->section, section) == 0 && strcmp(entry->time, time) == 0;
+}
+
+// Rehash into a table twice the live entries' need, dropping deleted markers
+static int rehash(LectureReminders *lr)
+{
+    int slotCount = 64;
+    while (slotCount < 4 * (lr->live + 1))
+        slotCount *= 2;
+    int *slots = (int *)malloc(sizeof(int) * slotCount);
+    if (slots == NULL)
+        return -1;
+    for (int i = 0; i < slotCount; i++)
+        slots[i] = SLOT_EMPTY;
+    free(lr->slots);
+    lr->slots = slots;
+    lr->slotCount = slotCount;
+    lr->deleted = 0;
+    for (int i = 0; i < lr->entryUsed; i++)
+    {
+        ReminderEntry *entry = &lr->entries[i];
+        if (entry->live)
+            lr->slots[findSlot(lr, entry->section, entry->day, entry->time)] = i;
+    }
+    return 0;
+}
+
+// Next start of a weekly lecture, lead minutes early, after now; -1 if the date is not representable
+static time_t nextOccurrence(int day, int startMinute, int lead, time_t now)
+{
+    struct tm local;
+    if (localTime(&now, &local) == NULL)
+        return -1;
+    int today = (local.tm_wday + 6) % 7; // DAY_CODES start on Monday
+    for (int ahead = (day - today + 7) % 7; ahead <= 14; ahead += 7)
+    {
+        struct tm at = local;
+        at.tm_mday += ahead;
+        at.tm_hour = 0;
+        at.tm_min = startMinute - lead;
+        at.tm_sec = 0;
+        at.tm_isdst = -1;
+        time_t due = mktime(&at);
+        if (due == (time_t)-1)
+            return -1;
+        if (due > now)
+            return due;
+    }
+    return -1;
+}
+
+// Minute of the day a lecture starts, -1 if it needs no reminder
+static int lectureStart(const Calendar *calendar, int day, const Lecture *lec)
+{
+    if (lec->periods == 0 || strcmp(lec->faculty, "-") == 0)
+        return -1;
+    int period = 0;
+    while (!((lec->periods >> period) & 1))
+        period++;
+    return calendarStart(calendar, day, period);
+}
+
+static void reminderText(const LectureReminders *lr, const Lecture *lec, char *text, size_t size)
+{
+    snprintf(text, size, "%.24s with %.60s in %d minutes (Section %s%s%s)", lec->subject, lec->faculty, lr->lead,
+             lec->section, lec->room[0] ? ", " : "", lec->room);
+}
+
+// Queue the next reminder of an entry for its lecture; the entry keeps id 0 if none is due
+static int armEntry(LectureReminders *lr, int index, const Lecture *lec, time_t now)
+{
+    ReminderEntry *entry = &lr->entries[index];
+    entry->id = 0;
+    int start = lectureStart(lr->calendar, entry->day, lec);
+    time_t due = start < 0 ? -1 : nextOccurrence(entry->day, start, lr->lead, now);
+    if (due < 0)
+        return 0;
+    char text[REMINDER_TEXT_LEN];
+    reminderText(lr, lec, text, sizeof(text));
+    entry->id = reminderAdd(lr->queue, due, text, index);
+    return entry->id < 0 ? TT_ERR_NOMEM : 0;
+}
+
+static int addEntry(LectureReminders *lr, const Lecture *lec)
+{
+    int day = dayIndex(lec->day);
+    if (day < 0 || lectureStart(lr->calendar, day, lec) < 0)
+        return 0;
+    if (2 * (lr->live + lr->deleted + 1) > lr->slotCount && rehash(lr) != 0)
+        return TT_ERR_NOMEM;
+    int index = lr->freeList;
+    if (index >= 0)
+        lr->freeList = lr->entries[index].nextFree;
+    else
+    {
+        if (lr->entryUsed == lr->entryCapacity)
+        {
+            int capacity = lr->entryCapacity ? lr->entryCapacity * 2 : 256;
+            ReminderEntry *grown = (ReminderEntry *)realloc(lr->entries, sizeof(ReminderEntry) * capacity);
+            if (grown == NULL)
+                return TT_ERR_NOMEM;
+            lr->entries = grown;
+            lr->entryCapacity = capacity;
+        }
+        index = lr->entryUsed++;
+    }
+    ReminderEntry *entry = &lr->entries[index];
+    snprintf(entry->section, sizeof(entry->section), "%s", lec->section);
+    entry->day = day;
+    snprintf(entry->time, sizeof(entry->time), "%s", lec->time);
+    entry->live = 1;
+    int slot = findSlot(lr, entry->section, day, entry->time);
+    if (lr->slots[slot] == SLOT_DELETED)
+        lr->deleted--;
+    lr->slots[slot] = index;
+    lr->live++;
+    return armEntry(lr, index, lec, time(NULL));
+}
+
+static void removeEntry(LectureReminders *lr, const Lecture *lec)
+{
+    int day = dayIndex(lec->day);
+    if (day < 0 || lr->slotCount == 0)
+        return;
+    int slot = findSlot(lr, lec->section, day, lec->time);
+    if (!isEntryAt(lr, slot, lec->section, day, lec->time))
+        return;
+    int index = lr->slots[slot];
+    ReminderEntry *entry = &lr->entries[index];
+    if (entry->id > 0)
+        reminderCancel(lr->queue, entry->id);
+    entry->live = 0;
+    entry->nextFree = lr->freeList;
+    lr->freeList = index;
+    lr->slots[slot] = SLOT_DELETED;
+    lr->live--;
+    lr->deleted++;
+}
+
+// Cancel every reminder and forget every entry
+static void clearEntries(LectureReminders *lr)
+{
+    for (int i = 0; i < lr->entryUsed; i++)
+    {
+        if (lr->entries[i].live && lr->entries[i].id > 0)
+            reminderCancel(lr->queue, lr->entries[i].id);
+    }
+    lr->entryUsed = 0;
+    lr->freeList = -1;
+    lr->live = 0;
+    lr->deleted = 0;
+    for (int i = 0; i < lr->slotCount; i++)
+        lr->slots[i] = SLOT_EMPTY;
+}
+
+typedef struct
+{
+    LectureReminders *lr;
+    int status;
+    int changed;
+} SyncCtx;
+
+static int addVisitor(const Lecture *lec, void *ctx)
+{
+    SyncCtx *sync = (SyncCtx *)ctx;
+    sync->status = addEntry(sync->lr, lec);
+    sync->changed++;
+    return sync->status != 0;
+}
+
+static int changeVisitor(const Lecture *before, const Lecture *after, void *ctx)
+{
+    SyncCtx *sync = (SyncCtx *)ctx;
+    if (before != NULL)
+        removeEntry(sync->lr, before);
+    if (after != NULL)
+        sync->status = addEntry(sync->lr, after);
+    sync->changed++;
+    return sync->status != 0;
+}
+
+// Runs on the reminder thread: queue the lecture's next week, then deliver the
+// reminder worded for the lecture as it is now. Reminders of lectures that were
+// removed or changed since the last sync are dropped or reworded here.
+static int fireReminder(const Reminder *reminder, void *ctx)
+{
+    LectureReminders *lr = (LectureReminders *)ctx;
+    Reminder current = *reminder;
+    int deliver = 0;
+    mutexLock(&lr->lock);
+    int index = (int)reminder->tag;
+    ReminderEntry *entry = index < lr->entryUsed ? &lr->entries[index] : NULL;
+    Lecture lec;
+    if (entry != NULL && entry->live && entry->id == reminder->id)
+    {
+        entry->id = 0;
+        if (timetableGetLecture(lr->tt, entry->section, DAY_CODES[entry->day], entry->time, &lec) == TT_OK &&
+            lectureStart(lr->calendar, entry->day, &lec) >= 0)
+        {
+            time_t now = time(NULL);
+            armEntry(lr, index, &lec, now > reminder->due ? now : reminder->due);
+            reminderText(lr, &lec, current.text, sizeof(current.text));
+            deliver = 1;
+        }
+    }
+    mutexUnlock(&lr->lock);
+    return deliver ? lr->sink(&current, lr->ctx) : 0;
+}
+
+LectureReminders *lectureRemindersStart(Timetable *tt, int leadMinutes, ReminderSink sink, void *ctx)
+{
+    LectureReminders *lr = (LectureReminders *)calloc(1, sizeof(LectureReminders));
+    if (lr == NULL)
+        return NULL;
+    lr->tt = tt;
+    lr->lead = leadMinutes;
+    lr->sink = sink;
+    lr->ctx = ctx;
+    lr->freeList = -1;
+    mutexInit(&lr->lock);
+    lr->queue = reminderStart(fireReminder, lr);
+    if (lr->queue == NULL || lectureRemindersSync(lr) < 0)
+    {
+        lectureRemindersStop(lr);
+        return NULL;
+    }
+    return lr;
+}
+
+void lectureRemindersStop(LectureReminders *lr)
+{
+    if (lr == NULL)
+        return;
+    reminderStop(lr->queue); // before the lock goes: a delivery in progress takes it
+    if (lr->synced != NULL)
+        timetableUnpin(lr->synced);
+    mutexDestroy(&lr->lock);
+    free(lr->entries);
+    free(lr->slots);
+    free(lr);
+}
+
+int lectureRemindersSync(LectureReminders *lr)
+{
+    mutexLock(&lr->lock);
+    const TimetableVersion *current = timetablePin(lr->tt);
+    const Calendar *calendar = timetableCalendar(lr->tt);
+    SyncCtx sync = {lr, 0, 0};
+    if (lr->synced == NULL || calendar != lr->calendar)
+    {
+        clearEntries(lr);
+        lr->calendar = calendar;
+        versionForEach(current, addVisitor, &sync);
+    }
+    else if (versionId(current) != versionId(lr->synced))
+        versionCompare(lr->synced, current, changeVisitor, &sync);
+    if (lr->synced != NULL)
+        timetableUnpin(lr->synced);
+    lr->synced = current;
+    mutexUnlock(&lr->lock);
+    return sync.status != 0 ? sync.status : sync.changed;
+}
+
+void lectureRemindersStats(LectureReminders *lr, ReminderStats *stats)
+{
+    reminderStats(lr->queue, stats);
+}
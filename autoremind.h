@@ -0,0 +1,29 @@
+// Lecture reminders: a reminder ahead of every lecture of a timetable, every week.
+//
+// Only the next occurrence of each lecture is queued, and when it fires the next
+// week's takes its place, so the queue holds one reminder per lecture however long
+// the program runs. lectureRemindersSync catches up with edits by comparing the
+// published version with the one the reminders were built from (versionCompare):
+// an edit cancels and requeues only the lectures it changed, and shared parts of the
+// two versions are never read. Switching calendars rebuilds every reminder.
+//
+// A reminder reads "TMC203 with Mr. Neeraj in 10 minutes (Section A, LT-402)". Free
+// periods and lectures off the calendar's periods get none.
+#ifndef AUTOREMIND_H
+#define AUTOREMIND_H
+
+#include "scheduler.h"
+#include "reminder.h"
+
+typedef struct LectureReminders LectureReminders;
+
+// Remind leadMinutes before each lecture of tt starts, through sink and ctx, which
+// run on the reminder thread. Returns NULL if out of memory.
+LectureReminders *lectureRemindersStart(Timetable *tt, int leadMinutes, ReminderSink sink, void *ctx);
+void lectureRemindersStop(LectureReminders *reminders);
+// Bring the reminders up to date with the published timetable; returns the number
+// of lectures whose reminders changed, or TT_ERR_NOMEM
+int lectureRemindersSync(LectureReminders *reminders);
+void lectureRemindersStats(LectureReminders *reminders, ReminderStats *stats);
+
+#endif
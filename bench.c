@@ -0,0 +1,500 @@
+// Benchmark for the scheduler library on synthetic timetables.
+//
+// Usage: bench [--sections n] [--lectures n] [--faculty n] [--subjects n] [--rooms n]
+//              [--samples n] [--scans n] [--seed n] [--out file] [--trace file]
+//
+// Generates a timetable with the given number of sections, lectures, teachers
+// and subjects, then times the core operations on it: bulk insert (one
+// transaction), single inserts, slot lookups, swaps, section rendering,
+// teacher search, teacher load analysis, room allocation (into --rooms single
+// section rooms, one per section by default), save, load, writing and reading
+// every lecture as CSV rows (write_rows, read_rows), comparing the reloaded
+// rows with the saved timetable (diff), exporting every
+// section to its own file (export_1_thread, then export_threads with one thread per
+// processor). Search and teacher load
+// run twice: over the column table (the default, search_cold includes building
+// it) and over the lecture rows (the _rows results). A summary table goes
+// to stdout and the full results to a JSON file (bench_results.json by
+// default) so runs can be compared over time. --trace also records a Chrome
+// trace timeline of the run.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+#include "platform.h"
+#include "memstat.h"
+#include "trace.h"
+
+#define MAX_RESULTS 24
+
+typedef struct
+{
+    const char *op;
+    int count;
+    double total; // microseconds
+    double mean, p50, p99, max;
+} Result;
+
+typedef struct
+{
+    int sections, lectures, faculty, subjects;
+    int rooms; // 0 for one per section
+    int samples, scans;
+    unsigned int seed;
+    const char *out;
+    const char *trace; // Chrome trace file, NULL for none
+} Params;
+
+static char sectionNames[MAX_SECTIONS][SECTION_NAME_LEN];
+static Result results[MAX_RESULTS];
+static int resultCount;
+
+// Section names: the letters A to Z first, then S0027, S0028, ...
+static void initSectionNames(int count)
+{
+    for (int s = 0; s < count; s++)
+    {
+        if (s < 26)
+            snprintf(sectionNames[s], SECTION_NAME_LEN, "%c", 'A' + s);
+        else
+            snprintf(sectionNames[s], SECTION_NAME_LEN, "S%04d", s + 1);
+    }
+}
+
+static unsigned int nextRandom(unsigned int *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+static int randomBelow(unsigned int *seed, int n)
+{
+    return (int)(((nextRandom(seed) << 15) | nextRandom(seed)) % (unsigned int)n);
+}
+
+// Label of a period: the calendar's own periods first, then made-up ones
+static void periodTime(const Calendar *calendar, int period, char *time, size_t size)
+{
+    if (period < calendarPeriodCount(calendar, 0))
+        snprintf(time, size, "%s", calendarLabel(calendar, 0, period));
+    else
+        snprintf(time, size, "P%04d", period);
+}
+
+static void facultyName(int teacher, char *name, size_t size)
+{
+    snprintf(name, size, "Faculty %05d", teacher);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p)
+{
+    if (count == 0)
+        return 0.0;
+    int index = (int)(p / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// Record the latencies (microseconds) of count runs of an operation
+static void addResult(const char *op, double *latencies, int count)
+{
+    if (resultCount == MAX_RESULTS)
+        return;
+    Result *result = &results[resultCount++];
+    memset(result, 0, sizeof(*result));
+    result->op = op;
+    result->count = count;
+    for (int i = 0; i < count; i++)
+        result->total += latencies[i];
+    if (count == 0)
+        return;
+    qsort(latencies, count, sizeof(double), compareDoubles);
+    result->mean = result->total / count;
+    result->p50 = percentile(latencies, count, 50);
+    result->p99 = percentile(latencies, count, 99);
+    result->max = latencies[count - 1];
+}
+
+static void addSingleResult(const char *op, double elapsed)
+{
+    addResult(op, &elapsed, 1);
+}
+
+// Teachers are spread so no teacher has two lectures at the same time; sections
+// beyond the number of teachers get free periods at that time instead
+static int generate(Timetable *tt, const Params *params, int periods)
+{
+    TimetableTxn *txn = timetableBegin(tt);
+    if (txn == NULL)
+        return TT_ERR_NOMEM;
+    char time[32], subject[32], faculty[32];
+    int generated = 0;
+    for (int p = 0; p < periods; p++)
+    {
+        periodTime(timetableCalendar(tt), p, time, sizeof(time));
+        for (int d = 0; d < DAY_COUNT; d++)
+        {
+            for (int s = 0; s < params->sections && generated < params->lectures; s++)
+            {
+                int shift = d * periods + p;
+                snprintf(subject, sizeof(subject), "SUB%04d", (s + shift) % params->subjects);
+                if (s < params->faculty)
+                    facultyName((s + shift) % params->faculty, faculty, sizeof(faculty));
+                else
+                    strcpy(faculty, "-");
+                if (txnInsertLecture(txn, DAY_CODES[d], time, subject, faculty, sectionNames[s]) != TT_OK)
+                {
+                    timetableRollback(txn);
+                    return TT_ERR_NOMEM;
+                }
+                generated++;
+            }
+        }
+    }
+    return timetableCommit(txn, NULL);
+}
+
+typedef struct
+{
+    int matches;
+} SearchCount;
+
+static int countMatch(const Lecture *lec, void *ctx)
+{
+    (void)lec;
+    ((SearchCount *)ctx)->matches++;
+    return 0;
+}
+
+static void printResults(void)
+{
+    printf("%-18s %9s %12s %12s %12s %12s\n", "operation", "count", "mean us", "p50 us", "p99 us", "total ms");
+    for (int i = 0; i < resultCount; i++)
+    {
+        Result *r = &results[i];
+        printf("%-18s %9d %12.2f %12.2f %12.2f %12.2f\n", r->op, r->count, r->mean, r->p50, r->p99, r->total / 1000.0);
+    }
+}
+
+static void printMemory(const TimetableMemory *memory, const MemUsage *total)
+{
+    printf("memory: %zu byte lectures, %.1f bytes per lecture in blocks, %lld bytes in use, peak %lld\n",
+           memory->lectureSize, memory->lectures ? (double)memory->lectureBytes / memory->lectures : 0.0,
+           total->bytes, total->peakBytes);
+}
+
+static int writeResults(const Params *params, int lectures, int periods, const TimetableMemory *memory,
+                        const MemUsage *total)
+{
+    FILE *fp = fopen(params->out, "w");
+    if (fp == NULL)
+        return -1;
+    fprintf(fp, "{\n  \"sections\": %d,\n  \"lectures\": %d,\n  \"periods_per_day\": %d,\n"
+                "  \"faculty\": %d,\n  \"subjects\": %d,\n  \"seed\": %u,\n",
+            params->sections, lectures, periods, params->faculty, params->subjects, params->seed);
+    fprintf(fp, "  \"memory\": {\"lecture_size\": %zu, \"lecture_bytes\": %zu, \"index_bytes\": %zu, "
+                "\"bytes_in_use\": %lld, \"peak_bytes\": %lld},\n  \"results\": [\n",
+            memory->lectureSize, memory->lectureBytes, memory->indexBytes, total->bytes, total->peakBytes);
+    for (int i = 0; i < resultCount; i++)
+    {
+        Result *r = &results[i];
+        fprintf(fp, "    {\"op\": \"%s\", \"count\": %d, \"total_us\": %.1f, \"mean_us\": %.3f, "
+                    "\"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+                r->op, r->count, r->total, r->mean, r->p50, r->p99, r->max, i + 1 < resultCount ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+static int parseParams(int argc, char *argv[], Params *params)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *name = argv[i];
+        if (i + 1 == argc)
+            return -1;
+        const char *value = argv[++i];
+        if (strcmp(name, "--sections") == 0)
+            params->sections = atoi(value);
+        else if (strcmp(name, "--lectures") == 0)
+            params->lectures = atoi(value);
+        else if (strcmp(name, "--faculty") == 0)
+            params->faculty = atoi(value);
+        else if (strcmp(name, "--subjects") == 0)
+            params->subjects = atoi(value);
+        else if (strcmp(name, "--rooms") == 0)
+            params->rooms = atoi(value);
+        else if (strcmp(name, "--samples") == 0)
+            params->samples = atoi(value);
+        else if (strcmp(name, "--scans") == 0)
+            params->scans = atoi(value);
+        else if (strcmp(name, "--seed") == 0)
+            params->seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(name, "--out") == 0)
+            params->out = value;
+        else if (strcmp(name, "--trace") == 0)
+            params->trace = value;
+        else
+            return -1;
+    }
+    if (params->sections < 1 || params->lectures < 1 || params->faculty < 1 || params->subjects < 1 ||
+        params->rooms < 0 || params->samples < 1 || params->scans < 1)
+        return -1;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Params params = {64, 20000, 200, 40, 0, 10000, 20, 1, "bench_results.json", NULL};
+    if (parseParams(argc, argv, &params) != 0)
+    {
+        fprintf(stderr, "Usage: %s [--sections n] [--lectures n] [--faculty n] [--subjects n] [--rooms n]\n"
+                        "       [--samples n] [--scans n] [--seed n] [--out file] [--trace file]\n",
+                argv[0]);
+        return 2;
+    }
+    if (params.sections > MAX_SECTIONS)
+    {
+        fprintf(stderr, "Note: a timetable holds at most %d sections\n", MAX_SECTIONS);
+        params.sections = MAX_SECTIONS;
+    }
+    if (params.rooms == 0)
+        params.rooms = params.sections;
+    if (params.rooms > MAX_ROOMS)
+    {
+        fprintf(stderr, "Note: a timetable holds at most %d rooms\n", MAX_ROOMS);
+        params.rooms = MAX_ROOMS;
+    }
+    initSectionNames(params.sections);
+    int periods = (params.lectures + params.sections * DAY_COUNT - 1) / (params.sections * DAY_COUNT);
+    if (params.trace != NULL && traceOpen(params.trace, 1 << 20) != 0)
+    {
+        fprintf(stderr, "Error: Could not start tracing to %s!\n", params.trace);
+        return 1;
+    }
+
+    Timetable *tt = timetableCreate();
+    int maxRuns = params.samples > params.scans ? params.samples : params.scans;
+    double *latencies = (double *)malloc(sizeof(double) * maxRuns);
+    if (tt == NULL || latencies == NULL)
+    {
+        fprintf(stderr, "Error: Out of memory!\n");
+        return 1;
+    }
+    unsigned int seed = params.seed;
+    char time[32], faculty[32];
+    double start;
+    const Calendar *calendar = timetableCalendar(tt);
+    int standardPeriods = calendarPeriodCount(calendar, 0);
+
+    start = monotonicMicros();
+    int status = generate(tt, &params, periods);
+    addSingleResult("bulk_insert", monotonicMicros() - start);
+    if (status != TT_OK)
+    {
+        fprintf(stderr, "Error: Could not generate timetable: %s\n", timetableStrError(status));
+        return 1;
+    }
+    int lectures = timetableCount(tt);
+    printf("%d sections, %d lectures (%d periods/day), %d teachers, %d subjects\n",
+           params.sections, lectures, periods, params.faculty, params.subjects);
+
+    // Lookups on random occupied and free slots
+    for (int i = 0; i < params.samples; i++)
+    {
+        periodTime(calendar, randomBelow(&seed, periods + 1), time, sizeof(time));
+        const char *section = sectionNames[randomBelow(&seed, params.sections)];
+        const char *day = DAY_CODES[randomBelow(&seed, DAY_COUNT)];
+        start = monotonicMicros();
+        timetableIsSlotFree(tt, section, day, time);
+        latencies[i] = monotonicMicros() - start;
+    }
+    addResult("slot_free", latencies, params.samples);
+
+    for (int i = 0; i < params.samples; i++)
+    {
+        const char *section1 = sectionNames[randomBelow(&seed, params.sections)];
+        const char *section2 = sectionNames[randomBelow(&seed, params.sections)];
+        const char *day = DAY_CODES[randomBelow(&seed, DAY_COUNT)];
+        periodTime(calendar, randomBelow(&seed, periods < standardPeriods ? periods : standardPeriods), time, sizeof(time));
+        start = monotonicMicros();
+        timetableSwap(tt, section1, day, time, section2, day, time, 1);
+        latencies[i] = monotonicMicros() - start;
+    }
+    addResult("swap", latencies, params.samples);
+
+    // Single inserts into a period no generated lecture uses
+    periodTime(calendar, periods + 1, time, sizeof(time));
+    for (int i = 0; i < params.samples; i++)
+    {
+        const char *section = sectionNames[randomBelow(&seed, params.sections)];
+        const char *day = DAY_CODES[randomBelow(&seed, DAY_COUNT)];
+        start = monotonicMicros();
+        timetableInsertLecture(tt, day, time, "SUB0000", "-", section);
+        latencies[i] = monotonicMicros() - start;
+    }
+    addResult("insert", latencies, params.samples);
+
+    FILE *sink = tmpfile();
+    int renders = params.sections < params.samples ? params.sections : params.samples;
+    for (int i = 0; sink != NULL && i < renders; i++)
+    {
+        rewind(sink);
+        start = monotonicMicros();
+        timetableWriteSection(tt, sectionNames[i], sink);
+        latencies[i] = monotonicMicros() - start;
+    }
+    if (sink != NULL)
+    {
+        fclose(sink);
+        addResult("render_section", latencies, renders);
+    }
+
+    // The first search after the edits above builds the column table
+    SearchCount cold = {0};
+    start = monotonicMicros();
+    timetableSearch(tt, SEARCH_TEACHER, "no such teacher", countMatch, &cold);
+    addSingleResult("search_cold", monotonicMicros() - start);
+
+    TeacherLoad *loads = (TeacherLoad *)malloc(sizeof(TeacherLoad) * (params.faculty + 1));
+    for (int columnar = 1; columnar >= 0; columnar--)
+    {
+        timetableSetColumnar(tt, columnar);
+        for (int i = 0; i < params.scans; i++)
+        {
+            SearchCount count = {0};
+            facultyName(randomBelow(&seed, params.faculty), faculty, sizeof(faculty));
+            start = monotonicMicros();
+            timetableSearch(tt, SEARCH_TEACHER, faculty, countMatch, &count);
+            latencies[i] = monotonicMicros() - start;
+        }
+        addResult(columnar ? "search" : "search_rows", latencies, params.scans);
+
+        for (int i = 0; loads != NULL && i < params.scans; i++)
+        {
+            start = monotonicMicros();
+            timetableTeacherLoad(tt, loads, params.faculty + 1);
+            latencies[i] = monotonicMicros() - start;
+        }
+        if (loads != NULL)
+            addResult(columnar ? "teacher_load" : "teacher_load_rows", latencies, params.scans);
+    }
+    timetableSetColumnar(tt, 1);
+    free(loads);
+
+    // Rooms for every lecture on the calendar's periods, then the same plan again
+    char room[ROOM_NAME_LEN];
+    for (int r = 0; r < params.rooms; r++)
+    {
+        snprintf(room, sizeof(room), "R%04d", r + 1);
+        timetableAddRoom(tt, room, 1);
+    }
+    RoomPlan plan;
+    start = monotonicMicros();
+    timetableAllocateRooms(tt, 0, &plan);
+    addSingleResult("allocate_rooms", monotonicMicros() - start);
+    printf("rooms: %d of %d lectures placed in %d rooms, %d room changes\n", plan.placed, plan.lectures,
+           params.rooms, plan.roomChanges);
+    start = monotonicMicros();
+    timetableAllocateRooms(tt, 1, &plan);
+    addSingleResult("replan_rooms", monotonicMicros() - start);
+
+    const char *file = "bench_timetable.txt";
+    start = monotonicMicros();
+    status = timetableSave(tt, file);
+    addSingleResult("save", monotonicMicros() - start);
+    start = monotonicMicros();
+    int loaded = status == TT_OK ? timetableLoad(tt, file) : status;
+    addSingleResult("load", monotonicMicros() - start);
+    remove(file);
+    if (loaded != timetableCount(tt) || loaded < lectures)
+        fprintf(stderr, "Warning: load returned %d lectures\n", loaded);
+
+    // All lectures as CSV rows and back
+    const char *rowsFile = "bench_rows.csv";
+    FILE *rows = fopen(rowsFile, "w");
+    int rowCount = TT_ERR_IO;
+    if (rows != NULL)
+    {
+        start = monotonicMicros();
+        rowCount = timetableWriteRows(tt, EXPORT_CSV, rows);
+        fclose(rows);
+        addSingleResult("write_rows", monotonicMicros() - start);
+    }
+    rows = rowCount >= 0 ? fopen(rowsFile, "r") : NULL;
+    if (rows != NULL)
+    {
+        const TimetableVersion *saved = timetablePin(tt);
+        start = monotonicMicros();
+        int read = timetableReadRows(tt, EXPORT_CSV, rows, NULL);
+        addSingleResult("read_rows", monotonicMicros() - start);
+        fclose(rows);
+        if (read != rowCount)
+            fprintf(stderr, "Warning: read %d of %d CSV rows\n", read, rowCount);
+
+        // The reloaded version shares no blocks with the saved one: the diff compares every lecture
+        const TimetableVersion *reloaded = timetablePin(tt);
+        DiffReport diff;
+        start = monotonicMicros();
+        status = timetableDiff(saved, reloaded, NULL, NULL, &diff);
+        addSingleResult("diff", monotonicMicros() - start);
+        if (status != TT_OK || diff.added + diff.removed + diff.moved + diff.restaffed + diff.rooms != 0)
+            fprintf(stderr, "Warning: reloaded rows differ from the saved timetable\n");
+        timetableUnpin(reloaded);
+        timetableUnpin(saved);
+    }
+    remove(rowsFile);
+
+    // Every section to its own file, on one thread and then on one per processor
+    const char *directory = "bench_export";
+    ExportReport report = {0, 0, 0, 0};
+    for (int threads = 1; threads >= 0; threads--)
+    {
+        start = monotonicMicros();
+        status = timetableExportSections(tt, directory, EXPORT_TEXT, threads, &report);
+        addSingleResult(threads ? "export_1_thread" : "export_threads", monotonicMicros() - start);
+        if (status != TT_OK)
+            fprintf(stderr, "Warning: export returned %s\n", timetableStrError(status));
+    }
+    printf("export: %d sections, %lld bytes on %d thread(s)\n", report.sections, report.bytes, report.threads);
+    char path[64];
+    for (int i = 0; i < params.sections; i++)
+    {
+        if (snprintf(path, sizeof(path), "%s/section_%s.txt", directory, sectionNames[i]) < (int)sizeof(path))
+            remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/manifest.csv", directory);
+    remove(path);
+    remove(directory);
+
+    TimetableMemory memory;
+    MemUsage usage[MEM_SUBSYSTEM_COUNT], total;
+    timetableMemory(tt, &memory);
+    memUsage(usage, &total);
+
+    printResults();
+    printMemory(&memory, &total);
+    if (writeResults(&params, lectures, periods, &memory, &total) != 0)
+    {
+        fprintf(stderr, "Error: Could not write %s!\n", params.out);
+        return 1;
+    }
+    printf("Results written to %s\n", params.out);
+    if (params.trace != NULL)
+    {
+        int events = traceFlush();
+        if (events < 0)
+            fprintf(stderr, "Error: Could not write %s!\n", params.trace);
+        else
+            printf("Trace with %d events written to %s\n", events, params.trace);
+    }
+
+    free(latencies);
+    timetableDestroy(tt);
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+#include "memstat.h"
+
+#define LABEL_SLOTS 1024 // open addressing, never more than MAX_CALENDAR_LABELS used
+
+struct Calendar
+{
+    int periodCount[DAY_COUNT];
+    int maxPeriods;
+    short labelOf[DAY_COUNT][MAX_PERIODS]; // label id of each period
+    short start[DAY_COUNT][MAX_PERIODS];   // minutes after midnight
+    short end[DAY_COUNT][MAX_PERIODS];
+    signed char periodOf[DAY_COUNT][MAX_CALENDAR_LABELS]; // label id -> period, -1 if not that day
+    signed char startsAt[DAY_COUNT][MAX_CALENDAR_LABELS]; // "8:00" of "8:00-8:55" -> period starting there
+    signed char endsAt[DAY_COUNT][MAX_CALENDAR_LABELS];   // "8:55" of "8:00-8:55" -> period ending there
+    int labelCount;
+    char labels[MAX_CALENDAR_LABELS][PERIOD_LABEL_LEN];
+    short labelSlots[LABEL_SLOTS]; // hash of label -> label id + 1
+};
+
+// A period as read, before it is placed on its days
+typedef struct
+{
+    char label[PERIOD_LABEL_LEN];
+    int start, end;
+    int days; // bit d set for DAY_CODES[d]
+} PeriodSpec;
+
+static const PeriodSpec DEFAULT_PERIODS[] = {
+    {"8:00-8:55", 480, 535, 0x3f},
+    {"8:55-9:50", 535, 590, 0x3f},
+    {"10:10-11:05", 610, 665, 0x3f},
+    {"11:05-12:00", 665, 720, 0x3f},
+    {"12:00-12:55", 720, 775, 0x3f},
+    {"2:10-3:05", 850, 905, 0x3f},
+    {"3:05-4:00", 905, 960, 0x3f},
+    {"4:00-4:55", 960, 1015, 0x3f},
+    {"4:55-5:50", 1015, 1070, 0x3f}};
+
+static unsigned int hashLabel(const char *label)
+{
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *label; label++)
+        hash = (hash ^ (unsigned char)*label) * 16777619u;
+    return hash;
+}
+
+static int findLabel(const Calendar *calendar, const char *label)
+{
+    for (unsigned int slot = hashLabel(label) % LABEL_SLOTS;; slot = (slot + 1) % LABEL_SLOTS)
+    {
+        int id = calendar->labelSlots[slot] - 1;
+        if (id < 0 || strcmp(calendar->labels[id], label) == 0)
+            return id;
+    }
+}
+
+static int addLabel(Calendar *calendar, const char *label)
+{
+    int id = findLabel(calendar, label);
+    if (id >= 0)
+        return id;
+    if (calendar->labelCount == MAX_CALENDAR_LABELS)
+        return -1;
+    unsigned int slot = hashLabel(label) % LABEL_SLOTS;
+    while (calendar->labelSlots[slot] != 0)
+        slot = (slot + 1) % LABEL_SLOTS;
+    id = calendar->labelCount++;
+    strcpy(calendar->labels[id], label);
+    calendar->labelSlots[slot] = (short)(id + 1);
+    return id;
+}
+
+// Register the two halves of a "start-end" label, so blocks spanning several
+// periods resolve; returns -1 when the label table is full
+static int addLabelHalves(Calendar *calendar, int day, int period, const char *label)
+{
+    const char *dash = strchr(label, '-');
+    if (dash == NULL)
+        return 0;
+    char start[PERIOD_LABEL_LEN];
+    memcpy(start, label, dash - label);
+    start[dash - label] = '\0';
+    int startId = addLabel(calendar, start), endId = addLabel(calendar, dash + 1);
+    if (startId < 0 || endId < 0)
+        return -1;
+    calendar->startsAt[day][startId] = (signed char)period;
+    calendar->endsAt[day][endId] = (signed char)period;
+    return 0;
+}
+
+static int compareSpecStart(const void *a, const void *b)
+{
+    return ((const PeriodSpec *)a)->start - ((const PeriodSpec *)b)->start;
+}
+
+// Compile the periods into lookup tables; returns the index of the offending
+// spec, or -1 when every period fits
+static int compileCalendar(Calendar *calendar, const PeriodSpec *specs, int count, PeriodSpec *scratch)
+{
+    memset(calendar->periodOf, -1, sizeof(calendar->periodOf));
+    memset(calendar->startsAt, -1, sizeof(calendar->startsAt));
+    memset(calendar->endsAt, -1, sizeof(calendar->endsAt));
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        int n = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (specs[i].days & (1 << d))
+                scratch[n++] = specs[i];
+        }
+        qsort(scratch, n, sizeof(PeriodSpec), compareSpecStart);
+        for (int p = 0; p < n; p++)
+        {
+            int label = addLabel(calendar, scratch[p].label);
+            if (p == MAX_PERIODS || label < 0 || calendar->periodOf[d][label] >= 0 ||
+                (p > 0 && scratch[p].start < scratch[p - 1].end) || addLabelHalves(calendar, d, p, scratch[p].label) < 0)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    if (strcmp(specs[i].label, scratch[p].label) == 0 && specs[i].start == scratch[p].start)
+                        return i;
+                }
+                return count - 1;
+            }
+            calendar->labelOf[d][p] = (short)label;
+            calendar->start[d][p] = (short)scratch[p].start;
+            calendar->end[d][p] = (short)scratch[p].end;
+            calendar->periodOf[d][label] = (signed char)p;
+        }
+        calendar->periodCount[d] = n;
+        if (n > calendar->maxPeriods)
+            calendar->maxPeriods = n;
+    }
+    return -1;
+}
+
+static Calendar *buildCalendar(const PeriodSpec *specs, int count, int *badSpec)
+{
+    Calendar *calendar = (Calendar *)memCalloc(MEM_STRINGS, 1, sizeof(Calendar));
+    PeriodSpec *scratch = (PeriodSpec *)malloc(sizeof(PeriodSpec) * (count > 0 ? count : 1));
+    *badSpec = -1;
+    if (calendar != NULL && scratch != NULL)
+        *badSpec = compileCalendar(calendar, specs, count, scratch);
+    free(scratch);
+    if (calendar == NULL || scratch == NULL || *badSpec >= 0)
+    {
+        calendarDestroy(calendar);
+        return NULL;
+    }
+    return calendar;
+}
+
+Calendar *calendarCreateDefault(void)
+{
+    int badSpec;
+    return buildCalendar(DEFAULT_PERIODS, sizeof(DEFAULT_PERIODS) / sizeof(DEFAULT_PERIODS[0]), &badSpec);
+}
+
+// Minutes after midnight of "HH:MM", -1 if malformed
+static int parseClock(const char *text)
+{
+    int hours, minutes;
+    char extra;
+    if (sscanf(text, "%d:%d%c", &hours, &minutes, &extra) != 2 || hours < 0 || hours > 23 || minutes < 0 ||
+        minutes > 59)
+        return -1;
+    return hours * 60 + minutes;
+}
+
+// Day mask of a "MON,TUE" list, 0 if it names an unknown day
+static int parseDays(char *list)
+{
+    int days = 0;
+    for (char *day = strtok(list, ","); day != NULL; day = strtok(NULL, ","))
+    {
+        int d = dayIndex(day);
+        if (d < 0)
+            return 0;
+        days |= 1 << d;
+    }
+    return days;
+}
+
+Calendar *calendarLoad(const char *filename, int *errorLine)
+{
+    *errorLine = 0;
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return NULL;
+
+    PeriodSpec *specs = NULL;
+    int *specLines = NULL;
+    int count = 0, capacity = 0, lineNo = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp))
+    {
+        lineNo++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+            *comment = '\0';
+        char label[64], start[16], end[16], days[64] = "";
+        int fields = sscanf(line, "%63s %15s %15s %63s", label, start, end, days);
+        if (fields <= 0)
+            continue;
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 32;
+            PeriodSpec *grown = (PeriodSpec *)realloc(specs, sizeof(PeriodSpec) * capacity);
+            int *grownLines = (int *)realloc(specLines, sizeof(int) * capacity);
+            if (grown != NULL)
+                specs = grown;
+            if (grownLines != NULL)
+                specLines = grownLines;
+            if (grown == NULL || grownLines == NULL)
+                break;
+        }
+        PeriodSpec *spec = &specs[count];
+        spec->start = fields >= 3 ? parseClock(start) : -1;
+        spec->end = fields >= 3 ? parseClock(end) : -1;
+        spec->days = fields == 4 ? parseDays(days) : (1 << DAY_COUNT) - 1;
+        if (strlen(label) >= PERIOD_LABEL_LEN || spec->start < 0 || spec->end <= spec->start || spec->days == 0)
+        {
+            *errorLine = lineNo;
+            break;
+        }
+        strcpy(spec->label, label);
+        specLines[count++] = lineNo;
+    }
+    int readError = ferror(fp) || (count == capacity && !feof(fp));
+    fclose(fp);
+
+    Calendar *calendar = NULL;
+    if (*errorLine == 0 && !readError && count > 0)
+    {
+        int badSpec;
+        calendar = buildCalendar(specs, count, &badSpec);
+        if (badSpec >= 0)
+            *errorLine = specLines[badSpec];
+    }
+    free(specs);
+    free(specLines);
+    return calendar;
+}
+
+void calendarDestroy(Calendar *calendar)
+{
+    memFree(MEM_STRINGS, calendar, sizeof(Calendar));
+}
+
+int calendarPeriodCount(const Calendar *calendar, int day)
+{
+    return day >= 0 && day < DAY_COUNT ? calendar->periodCount[day] : 0;
+}
+
+int calendarMaxPeriods(const Calendar *calendar)
+{
+    return calendar->maxPeriods;
+}
+
+const char *calendarLabel(const Calendar *calendar, int day, int period)
+{
+    return calendar->labels[calendar->labelOf[day][period]];
+}
+
+int calendarStart(const Calendar *calendar, int day, int period)
+{
+    return calendar->start[day][period];
+}
+
+int calendarEnd(const Calendar *calendar, int day, int period)
+{
+    return calendar->end[day][period];
+}
+
+int calendarPeriodIndex(const Calendar *calendar, int day, const char *label)
+{
+    if (day < 0 || day >= DAY_COUNT)
+        return -1;
+    int id = findLabel(calendar, label);
+    return id < 0 ? -1 : calendar->periodOf[day][id];
+}
+
+unsigned int calendarPeriodMask(const Calendar *calendar, int day, const char *time)
+{
+    int period = calendarPeriodIndex(calendar, day, time);
+    if (period >= 0)
+        return 1u << period;
+    const char *dash = strchr(time, '-');
+    if (day < 0 || day >= DAY_COUNT || dash == NULL || dash - time >= PERIOD_LABEL_LEN)
+        return 0;
+    char start[PERIOD_LABEL_LEN];
+    memcpy(start, time, dash - time);
+    start[dash - time] = '\0';
+    int startId = findLabel(calendar, start), endId = findLabel(calendar, dash + 1);
+    int first = startId < 0 ? -1 : calendar->startsAt[day][startId];
+    int last = endId < 0 ? -1 : calendar->endsAt[day][endId];
+    if (first < 0 || last < first)
+        return 0;
+    return ((2u << last) - 1) & ~((1u << first) - 1);
+}
@@ -0,0 +1,48 @@
+// Period calendar: the teaching periods of each weekday.
+//
+// A calendar lists, for each of the DAY_COUNT weekdays, the periods lectures can
+// be booked into: the label stored in Lecture.time (such as "8:00-8:55") and the
+// start and end time in minutes after midnight. It is compiled into flat tables, so a period's label,
+// times and its index within the day, or the index of a label, resolve in O(1).
+// Calendars are immutable once built.
+//
+// Calendar files have one period per line, '#' starts a comment:
+//
+//   <label> <HH:MM start> <HH:MM end> [DAY,DAY,...]
+//
+// A period without a day list applies to every day. Periods of a day are
+// ordered by start time and may not overlap.
+//
+// A lecture may also span several consecutive periods, such as a lab booked as
+// "8:00-9:50" over "8:00-8:55" and "8:55-9:50": its time names the start of the
+// first period and the end of the last. calendarPeriodMask turns either form into
+// the bits of the periods it covers, so occupancy tests are a single AND.
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#define MAX_PERIODS 32 // per day, so a day's periods fit in a 32-bit mask
+#define MAX_CALENDAR_LABELS 512 // period labels and their start and end halves
+#define PERIOD_LABEL_LEN 24
+
+typedef struct Calendar Calendar;
+
+// The nine standard periods on every day
+Calendar *calendarCreateDefault(void);
+// Parse a calendar file; on failure returns NULL with *errorLine set to the line
+// at fault (0 when the file could not be read or holds no periods)
+Calendar *calendarLoad(const char *filename, int *errorLine);
+void calendarDestroy(Calendar *calendar);
+
+int calendarPeriodCount(const Calendar *calendar, int day);
+// Most periods on any day, the width occupancy masks need
+int calendarMaxPeriods(const Calendar *calendar);
+const char *calendarLabel(const Calendar *calendar, int day, int period);
+int calendarStart(const Calendar *calendar, int day, int period);
+int calendarEnd(const Calendar *calendar, int day, int period);
+// Index of the period with this label on a day, -1 if the day has no such period
+int calendarPeriodIndex(const Calendar *calendar, int day, const char *label);
+// Periods a lecture time covers on a day, bit p for period p: one bit for a
+// period label, a run of bits for a block; 0 if the time matches neither
+unsigned int calendarPeriodMask(const Calendar *calendar, int day, const char *time);
+
+#endif
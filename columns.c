@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <string.h>
+#include "columns.h"
+#include "memstat.h"
+#include "trace.h"
+
+static unsigned int hashString(const char *str)
+{
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *str; str++)
+        hash = (hash ^ (unsigned char)*str) * 16777619u;
+    return hash;
+}
+
+// Values hold up to half the slot count, so the table never gets more than half full
+static int columnAlloc(StringColumn *column, int slotCount)
+{
+    column->slots = (int *)memCalloc(MEM_COLUMNS, slotCount, sizeof(int));
+    column->values = (const char **)memAlloc(MEM_COLUMNS, sizeof(char *) * (slotCount / 2));
+    column->slotCount = slotCount;
+    return column->slots != NULL && column->values != NULL ? 0 : -1;
+}
+
+// Empty column with room for slotCount / 2 strings before it grows
+int columnInit(StringColumn *column, int slotCount)
+{
+    memset(column, 0, sizeof(*column));
+    return columnAlloc(column, slotCount);
+}
+
+void columnRelease(StringColumn *column)
+{
+    memFree(MEM_COLUMNS, column->slots, sizeof(int) * column->slotCount);
+    memFree(MEM_COLUMNS, (void *)column->values, sizeof(char *) * (column->slotCount / 2));
+}
+
+int columnFind(const StringColumn *column, const char *value)
+{
+    unsigned int mask = (unsigned int)column->slotCount - 1;
+    for (unsigned int slot = hashString(value) & mask;; slot = (slot + 1) & mask)
+    {
+        int id = column->slots[slot] - 1;
+        if (id < 0 || strcmp(column->values[id], value) == 0)
+            return id;
+    }
+}
+
+static int columnGrow(StringColumn *column)
+{
+    StringColumn grown = {column->count, 0, NULL, NULL};
+    if (columnAlloc(&grown, column->slotCount * 2) != 0)
+    {
+        columnRelease(&grown);
+        return -1;
+    }
+    memcpy((void *)grown.values, column->values, sizeof(char *) * column->count);
+    unsigned int mask = (unsigned int)grown.slotCount - 1;
+    for (int id = 0; id < column->count; id++)
+    {
+        unsigned int slot = hashString(column->values[id]) & mask;
+        while (grown.slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        grown.slots[slot] = id + 1;
+    }
+    columnRelease(column);
+    *column = grown;
+    return 0;
+}
+
+// Id of value, adding it if new; -1 if out of memory. The string is not copied.
+int columnIntern(StringColumn *column, const char *value)
+{
+    unsigned int mask = (unsigned int)column->slotCount - 1;
+    unsigned int slot = hashString(value) & mask;
+    for (; column->slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        int id = column->slots[slot] - 1;
+        if (strcmp(column->values[id], value) == 0)
+            return id;
+    }
+    if (column->count + 1 >= column->slotCount / 2)
+    {
+        if (columnGrow(column) != 0)
+            return -1;
+        return columnIntern(column, value);
+    }
+    column->values[column->count] = value;
+    column->slots[slot] = column->count + 1;
+    return column->count++;
+}
+
+void columnsFree(LectureColumns *columns)
+{
+    if (columns == NULL)
+        return;
+    size_t rows = columns->rows > 0 ? (size_t)columns->rows : 1;
+    memFree(MEM_COLUMNS, columns->section, sizeof(unsigned short) * rows);
+    memFree(MEM_COLUMNS, columns->day, rows);
+    memFree(MEM_COLUMNS, columns->time, sizeof(int) * rows);
+    memFree(MEM_COLUMNS, columns->subject, sizeof(int) * rows);
+    memFree(MEM_COLUMNS, columns->faculty, sizeof(int) * rows);
+    memFree(MEM_COLUMNS, (void *)columns->lecture, sizeof(Lecture *) * rows);
+    memFree(MEM_COLUMNS, columns->facultyPeriods, sizeof(unsigned int) * (DAY_COUNT * columns->faculties.count + 1));
+    columnRelease(&columns->times);
+    columnRelease(&columns->subjects);
+    columnRelease(&columns->faculties);
+    memFree(MEM_COLUMNS, columns, sizeof(LectureColumns));
+}
+
+// One pass over the version in section, day and time order
+static LectureColumns *buildColumns(const TimetableVersion *version)
+{
+    LectureColumns *columns = (LectureColumns *)memCalloc(MEM_COLUMNS, 1, sizeof(LectureColumns));
+    if (columns == NULL)
+        return NULL;
+    size_t rows = version->count > 0 ? (size_t)version->count : 1;
+    columns->rows = (int)rows;
+    columns->section = (unsigned short *)memAlloc(MEM_COLUMNS, sizeof(unsigned short) * rows);
+    columns->day = (unsigned char *)memAlloc(MEM_COLUMNS, rows);
+    columns->time = (int *)memAlloc(MEM_COLUMNS, sizeof(int) * rows);
+    columns->subject = (int *)memAlloc(MEM_COLUMNS, sizeof(int) * rows);
+    columns->faculty = (int *)memAlloc(MEM_COLUMNS, sizeof(int) * rows);
+    columns->lecture = (const Lecture **)memAlloc(MEM_COLUMNS, sizeof(Lecture *) * rows);
+    int failed = columnInit(&columns->times, 64) | columnInit(&columns->subjects, 64) |
+                 columnInit(&columns->faculties, 256);
+    if (failed || columns->section == NULL || columns->day == NULL || columns->time == NULL ||
+        columns->subject == NULL || columns->faculty == NULL || columns->lecture == NULL)
+    {
+        columnsFree(columns);
+        return NULL;
+    }
+
+    int row = 0;
+    for (int c = 0; c < version->chunkCount; c++)
+    {
+        const SectionChunk *chunk = version->chunks[c];
+        for (int i = 0; chunk != NULL && i < CHUNK_SECTIONS; i++)
+        {
+            const SectionDays *section = chunk->sections[i];
+            for (int d = 0; section != NULL && d < DAY_COUNT; d++)
+            {
+                const Block *block = section->days[d];
+                for (int k = 0; block != NULL && k < block->count; k++, row++)
+                {
+                    const Lecture *lec = &block->lectures[k];
+                    columns->section[row] = (unsigned short)(c * CHUNK_SECTIONS + i);
+                    columns->day[row] = (unsigned char)d;
+                    columns->time[row] = columnIntern(&columns->times, lec->time);
+                    columns->subject[row] = columnIntern(&columns->subjects, lec->subject);
+                    columns->faculty[row] = columnIntern(&columns->faculties, lec->faculty);
+                    columns->lecture[row] = lec;
+                    if (columns->time[row] < 0 || columns->subject[row] < 0 || columns->faculty[row] < 0)
+                    {
+                        columnsFree(columns);
+                        return NULL;
+                    }
+                }
+            }
+        }
+    }
+    columns->rows = row;
+
+    // Occupancy mask per teacher and day, so availability is one lookup and an AND
+    columns->facultyPeriods = (unsigned int *)memCalloc(MEM_COLUMNS, (size_t)DAY_COUNT * columns->faculties.count + 1,
+                                                        sizeof(unsigned int));
+    if (columns->facultyPeriods == NULL)
+    {
+        columnsFree(columns);
+        return NULL;
+    }
+    for (int r = 0; r < row; r++)
+        columns->facultyPeriods[columns->faculty[r] * DAY_COUNT + columns->day[r]] |= columns->lecture[r]->periods;
+    return columns;
+}
+
+const LectureColumns *versionColumns(const TimetableVersion *version)
+{
+    TimetableVersion *v = (TimetableVersion *)version;
+    LectureColumns *columns = atomic_load_explicit(&v->columns, memory_order_acquire);
+    if (columns != NULL)
+        return columns;
+
+    TRACE_BEGIN(span, "query", "build columns");
+    TRACE_ARG(span, version->count);
+    columns = buildColumns(version);
+    TRACE_END(span);
+    if (columns == NULL)
+        return NULL;
+    // Readers of the same version may build at once; the first table published wins
+    LectureColumns *expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(&v->columns, &expected, columns, memory_order_acq_rel,
+                                                 memory_order_acquire))
+    {
+        columnsFree(columns);
+        return expected;
+    }
+    return columns;
+}
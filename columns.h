@@ -0,0 +1,48 @@
+// Structure-of-arrays view of a timetable version, internal to the scheduler library.
+//
+// The analytics scans (search, teacher load, statistics) only test one or two
+// fields per lecture, but a Lecture is four 100 byte strings. A column table
+// stores each lecture as a row of small integers instead: section id, day, and
+// interned ids for time, subject and teacher, each in its own contiguous array.
+// Strings are compared once per distinct value and the scans then run over the
+// id columns. A table is built on first use for a published version, which
+// never changes, and is freed with it. Row ids are stable for that version.
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "version.h"
+
+// Distinct strings of one column, ids in order of first appearance
+typedef struct
+{
+    int count;
+    int slotCount;       // hash slots, a power of two
+    int *slots;          // id + 1, or 0 for an empty slot
+    const char **values; // id -> string inside the version's lectures
+} StringColumn;
+
+struct LectureColumns
+{
+    int rows;
+    unsigned short *section; // section id
+    unsigned char *day;
+    int *time;    // interned ids
+    int *subject;
+    int *faculty;
+    const Lecture **lecture; // row -> the lecture in the version
+    StringColumn times, subjects, faculties;
+    unsigned int *facultyPeriods; // faculty id * DAY_COUNT + day -> periods the teacher is booked
+};
+
+// Column table of a published version, built on first use; NULL if out of memory
+const LectureColumns *versionColumns(const TimetableVersion *version);
+void columnsFree(LectureColumns *columns);
+// String columns also serve as small interning tables for the scans themselves.
+// They keep pointers to the strings, which must outlive the column.
+int columnInit(StringColumn *column, int slotCount);
+int columnIntern(StringColumn *column, const char *value);
+// Id of a string in a column, -1 if it is not there
+int columnFind(const StringColumn *column, const char *value);
+void columnRelease(StringColumn *column);
+
+#endif
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+#include "memstat.h"
+#include "trace.h"
+
+// A difference found in the section being compared
+typedef struct
+{
+    int kind; // DIFF_, 0 for an addition that became part of a move
+    const Lecture *before;
+    const Lecture *after;
+} Change;
+
+typedef struct
+{
+    Change *changes; // of one section, in day and time order
+    int count, capacity;
+    int failed;
+    DiffVisitor visit;
+    void *ctx;
+    DiffReport *report;
+    int stopped;
+} DiffState;
+
+static int addChange(DiffState *state, int kind, const Lecture *before, const Lecture *after)
+{
+    if (state->count == state->capacity)
+    {
+        int capacity = state->capacity ? state->capacity * 2 : 64;
+        Change *changes = (Change *)memRealloc(MEM_JOURNAL, state->changes, sizeof(Change) * state->capacity,
+                                               sizeof(Change) * capacity);
+        if (changes == NULL)
+        {
+            state->failed = 1;
+            return 1;
+        }
+        state->changes = changes;
+        state->capacity = capacity;
+    }
+    Change *change = &state->changes[state->count++];
+    change->kind = kind;
+    change->before = before;
+    change->after = after;
+    return 0;
+}
+
+static int sameClass(const Lecture *a, const Lecture *b)
+{
+    return strcmp(a->subject, b->subject) == 0 && strcmp(a->faculty, b->faculty) == 0;
+}
+
+static void countChange(DiffReport *report, int kind)
+{
+    switch (kind)
+    {
+    case DIFF_ADDED:
+        report->added++;
+        break;
+    case DIFF_REMOVED:
+        report->removed++;
+        break;
+    case DIFF_MOVED:
+        report->moved++;
+        break;
+    case DIFF_RESTAFFED:
+        report->restaffed++;
+        break;
+    case DIFF_ROOM:
+        report->rooms++;
+        break;
+    }
+}
+
+// Report the buffered changes of one section. A removal and an addition of the same
+// subject and teacher are one lecture that moved; the pairing looks only within the
+// section, so it costs at most the square of one section's week.
+static void flushSection(DiffState *state)
+{
+    for (int i = 0; i < state->count; i++)
+    {
+        Change *removed = &state->changes[i];
+        if (removed->kind != DIFF_REMOVED)
+            continue;
+        for (int j = 0; j < state->count; j++)
+        {
+            Change *added = &state->changes[j];
+            if (added->kind == DIFF_ADDED && sameClass(removed->before, added->after))
+            {
+                removed->kind = DIFF_MOVED;
+                removed->after = added->after;
+                added->kind = 0;
+                break;
+            }
+        }
+    }
+
+    int reported = 0;
+    for (int i = 0; i < state->count && !state->stopped; i++)
+    {
+        const Change *change = &state->changes[i];
+        if (change->kind == 0)
+            continue;
+        reported = 1;
+        if (state->report != NULL)
+            countChange(state->report, change->kind);
+        if (state->visit != NULL && state->visit(change->kind, change->before, change->after, state->ctx))
+            state->stopped = 1;
+    }
+    if (reported && state->report != NULL)
+        state->report->sections++;
+    state->count = 0;
+}
+
+// versionCompare walks the versions section by section, so a section's changes
+// are all buffered before the next section's first one arrives
+static int collectChange(const Lecture *before, const Lecture *after, void *ctx)
+{
+    DiffState *state = (DiffState *)ctx;
+    const Lecture *lec = before != NULL ? before : after;
+    if (state->count > 0)
+    {
+        const Change *last = &state->changes[state->count - 1];
+        const Lecture *previous = last->before != NULL ? last->before : last->after;
+        if (strcmp(previous->section, lec->section) != 0)
+            flushSection(state);
+        if (state->stopped)
+            return 1;
+    }
+    // The same slot: the subject stayed and its teacher or room changed
+    if (before != NULL && after != NULL && strcmp(before->subject, after->subject) == 0)
+        return addChange(state, strcmp(before->faculty, after->faculty) != 0 ? DIFF_RESTAFFED : DIFF_ROOM, before,
+                         after);
+    if (before != NULL && addChange(state, DIFF_REMOVED, before, NULL))
+        return 1;
+    return after != NULL ? addChange(state, DIFF_ADDED, NULL, after) : 0;
+}
+
+// Compare two versions of one timetable: versionCompare pairs the lectures of each
+// (section, day, time) key by walking the sorted day blocks side by side, so two
+// full timetables are compared in one linear pass and shared blocks are skipped.
+int timetableDiff(const TimetableVersion *before, const TimetableVersion *after, DiffVisitor visit, void *ctx,
+                  DiffReport *report)
+{
+    TRACE_BEGIN(span, "query", "diff");
+    DiffState state = {NULL, 0, 0, 0, visit, ctx, report, 0};
+    if (report != NULL)
+        memset(report, 0, sizeof(*report));
+    int status = versionCompare(before, after, collectChange, &state);
+    if (status >= 0 && !state.failed && !state.stopped)
+        flushSection(&state);
+    memFree(MEM_JOURNAL, state.changes, sizeof(Change) * state.capacity);
+    TRACE_ARG(span, status);
+    TRACE_END(span);
+    if (status < 0)
+        return status;
+    if (state.failed)
+        return TT_ERR_NOMEM;
+    return TT_OK;
+}
+
+static void writeCsvField(FILE *fp, const char *field, int last)
+{
+    if (strpbrk(field, ",\"\r\n") == NULL)
+        fputs(field, fp);
+    else
+    {
+        fputc('"', fp);
+        for (const char *c = field; *c; c++)
+        {
+            if (*c == '"')
+                fputc('"', fp);
+            fputc(*c, fp);
+        }
+        fputc('"', fp);
+    }
+    fputc(last ? '\n' : ',', fp);
+}
+
+static void writePatchLine(FILE *fp, char op, const Lecture *lec)
+{
+    char opField[2] = {op, '\0'};
+    writeCsvField(fp, opField, 0);
+    writeCsvField(fp, lec->section, 0);
+    writeCsvField(fp, lec->day, 0);
+    writeCsvField(fp, lec->time, 0);
+    writeCsvField(fp, lec->subject, 0);
+    writeCsvField(fp, lec->faculty, 0);
+    writeCsvField(fp, lec->room, 1);
+}
+
+static int writePatchChange(int kind, const Lecture *before, const Lecture *after, void *ctx)
+{
+    FILE *fp = (FILE *)ctx;
+    (void)kind;
+    if (before != NULL)
+        writePatchLine(fp, '-', before);
+    if (after != NULL)
+        writePatchLine(fp, '+', after);
+    return ferror(fp);
+}
+
+int timetableWritePatch(const TimetableVersion *before, const TimetableVersion *after, FILE *fp, DiffReport *report)
+{
+    fputs("op,section,day,time,code,faculty,room\n", fp);
+    int status = timetableDiff(before, after, writePatchChange, fp, report);
+    if (status == TT_OK && ferror(fp))
+        status = TT_ERR_IO;
+    return status;
+}
@@ -0,0 +1,769 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "scheduler.h"
+#include "version.h"
+#include "columns.h"
+#include "platform.h"
+#include "memstat.h"
+#include "trace.h"
+
+#define EXPORT_MAX_THREADS 64
+#define EXPORT_BUFFER_SIZE (64 * 1024) // starting size of a thread's output buffer, grown as needed
+#define EXPORT_PATH_LEN 1024
+
+// Output of one section, formatted in memory before it is written
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    int failed; // out of memory; the text is incomplete
+} OutBuffer;
+
+typedef struct
+{
+    int lectures;
+    long long bytes;
+    int status;
+} SectionResult;
+
+// Shared by the threads of one export; each claims the next section id in turn
+typedef struct
+{
+    const TimetableVersion *version;
+    const char *directory;
+    int format;
+    int sectionCount;
+    atomic_int next;
+    atomic_int failed; // set once any section fails, so the others stop claiming
+    SectionResult *results; // by section id
+} ExportJob;
+
+static int reserve(OutBuffer *out, size_t extra)
+{
+    if (out->failed)
+        return -1;
+    if (out->length + extra + 1 <= out->capacity)
+        return 0;
+    size_t capacity = out->capacity ? out->capacity : EXPORT_BUFFER_SIZE;
+    while (capacity < out->length + extra + 1)
+        capacity *= 2;
+    char *grown = (char *)memRealloc(MEM_BUFFERS, out->data, out->capacity, capacity);
+    if (grown == NULL)
+    {
+        out->failed = 1;
+        return -1;
+    }
+    out->data = grown;
+    out->capacity = capacity;
+    return 0;
+}
+
+static void append(OutBuffer *out, const char *text, size_t length)
+{
+    if (reserve(out, length) != 0)
+        return;
+    memcpy(out->data + out->length, text, length);
+    out->length += length;
+}
+
+static void appendf(OutBuffer *out, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    char line[512];
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0)
+        return;
+    if ((size_t)length < sizeof(line))
+    {
+        append(out, line, (size_t)length);
+        return;
+    }
+    if (reserve(out, (size_t)length) != 0)
+        return;
+    va_start(args, format);
+    vsnprintf(out->data + out->length, (size_t)length + 1, format, args);
+    va_end(args);
+    out->length += (size_t)length;
+}
+
+// A CSV field, quoted when it holds a comma, quote or line break
+static void appendCsvField(OutBuffer *out, const char *field, int last)
+{
+    if (strpbrk(field, ",\"\r\n") == NULL)
+        append(out, field, strlen(field));
+    else
+    {
+        append(out, "\"", 1);
+        for (const char *c = field; *c; c++)
+        {
+            if (*c == '"')
+                append(out, "\"\"", 2);
+            else
+                append(out, c, 1);
+        }
+        append(out, "\"", 1);
+    }
+    append(out, last ? "\n" : ",", 1);
+}
+
+// A JSON string member, escaped where JSON requires it
+static void appendJsonField(OutBuffer *out, const char *key, const char *value, int last)
+{
+    append(out, "\"", 1);
+    append(out, key, strlen(key));
+    append(out, "\":\"", 3);
+    const char *run = value;
+    for (const char *c = value;; c++)
+    {
+        unsigned char ch = (unsigned char)*c;
+        if (ch >= 0x20 && ch != '"' && ch != '\\')
+            continue;
+        append(out, run, (size_t)(c - run));
+        if (ch == '\0')
+            break;
+        if (ch == '"' || ch == '\\')
+        {
+            char escaped[2] = {'\\', (char)ch};
+            append(out, escaped, 2);
+        }
+        else
+            appendf(out, "\\u%04x", ch);
+        run = c + 1;
+    }
+    append(out, last ? "\"}\n" : "\",", last ? 3 : 2);
+}
+
+static void appendCsvHeader(OutBuffer *out)
+{
+    append(out, "section,day,time,code,subject,faculty,room\n", 43);
+}
+
+// The rows of a section, in the layout of timetableWriteSection, as CSV (without
+// the header) or as JSON lines; returns the number of lectures
+static int formatSection(const TimetableVersion *version, int sectionId, int format, OutBuffer *out)
+{
+    const char *name = version->sections->names[sectionId];
+    if (format == EXPORT_TEXT)
+        appendf(out, "==============================\n  SECTION %s TIMETABLE\n==============================\n", name);
+    int lectures = 0;
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        const Block *block = versionBlock(version, sectionId, d);
+        int count = block ? block->count : 0;
+        for (int i = 0; i < count; i++)
+        {
+            const Lecture *lec = &block->lectures[i];
+            if (format == EXPORT_CSV)
+            {
+                appendCsvField(out, name, 0);
+                appendCsvField(out, lec->day, 0);
+                appendCsvField(out, lec->time, 0);
+                appendCsvField(out, lec->subject, 0);
+                appendCsvField(out, getSubjectName(lec->subject), 0);
+                appendCsvField(out, lec->faculty, 0);
+                appendCsvField(out, lec->room, 1);
+            }
+            else if (format == EXPORT_JSONL)
+            {
+                append(out, "{", 1);
+                appendJsonField(out, "section", name, 0);
+                appendJsonField(out, "day", lec->day, 0);
+                appendJsonField(out, "time", lec->time, 0);
+                appendJsonField(out, "code", lec->subject, 0);
+                appendJsonField(out, "subject", getSubjectName(lec->subject), 0);
+                appendJsonField(out, "faculty", lec->faculty, 0);
+                appendJsonField(out, "room", lec->room, 1);
+            }
+            else
+                appendf(out, "%-5s | %-13s | %-8s | %-40s | %-25s | %s\n", lec->day, lec->time, lec->subject,
+                        getSubjectName(lec->subject), lec->faculty, lec->room);
+        }
+        if (count > 0 && format == EXPORT_TEXT)
+            append(out, "----------------------------------------------\n", 47);
+        lectures += count;
+    }
+    return lectures;
+}
+
+// section_<name>.<ext>, with characters a file name cannot hold replaced
+static void sectionFileName(const char *section, int format, char *name, size_t size)
+{
+    snprintf(name, size, "section_%s.%s", section, format == EXPORT_CSV ? "csv" : format == EXPORT_JSONL ? "jsonl" : "txt");
+    for (char *c = name; *c; c++)
+    {
+        if (strchr("/\\:*?\"<>", *c) != NULL)
+            *c = '_';
+    }
+}
+
+static int filePath(const char *directory, const char *name, char *path, size_t size)
+{
+    int length = snprintf(path, size, "%s/%s", directory, name);
+    return length < 0 || (size_t)length >= size ? TT_ERR_INVALID : TT_OK;
+}
+
+// Write a buffer as the whole content of a file, in one call
+static int writeFile(const char *path, const OutBuffer *out)
+{
+    if (out->failed)
+        return TT_ERR_NOMEM;
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    setvbuf(fp, NULL, _IONBF, 0); // the buffer is the file, stdio would only copy it
+    int status = fwrite(out->data, 1, out->length, fp) == out->length ? TT_OK : TT_ERR_IO;
+    if (fclose(fp) != 0)
+        status = TT_ERR_IO;
+    return status;
+}
+
+static void exportWorker(void *arg)
+{
+    ExportJob *job = (ExportJob *)arg;
+    OutBuffer out = {NULL, 0, 0, 0};
+    char name[SECTION_NAME_LEN + 16], path[EXPORT_PATH_LEN];
+    for (;;)
+    {
+        int sid = atomic_fetch_add(&job->next, 1);
+        if (sid >= job->sectionCount || atomic_load(&job->failed))
+            break;
+        SectionResult *result = &job->results[sid];
+        out.length = 0;
+        if (job->format == EXPORT_CSV)
+            appendCsvHeader(&out);
+        result->lectures = formatSection(job->version, sid, job->format, &out);
+        sectionFileName(job->version->sections->names[sid], job->format, name, sizeof(name));
+        result->status = filePath(job->directory, name, path, sizeof(path));
+        if (result->status == TT_OK)
+            result->status = writeFile(path, &out);
+        result->bytes = (long long)out.length;
+        if (result->status != TT_OK)
+            atomic_store(&job->failed, 1);
+    }
+    memFree(MEM_BUFFERS, out.data, out.capacity);
+}
+
+static int writeManifest(const ExportJob *job, long long *bytes)
+{
+    OutBuffer out = {NULL, 0, 0, 0};
+    char name[SECTION_NAME_LEN + 16], path[EXPORT_PATH_LEN];
+    append(&out, "section,file,lectures,bytes,hash\n", 33);
+    for (int sid = 0; sid < job->sectionCount; sid++)
+    {
+        const char *section = job->version->sections->names[sid];
+        sectionFileName(section, job->format, name, sizeof(name));
+        appendCsvField(&out, section, 0);
+        appendCsvField(&out, name, 0);
+        appendf(&out, "%d,%lld,%016llx\n", job->results[sid].lectures, job->results[sid].bytes,
+                versionSectionHash(job->version, sid));
+    }
+    int status = filePath(job->directory, "manifest.csv", path, sizeof(path));
+    if (status == TT_OK)
+        status = writeFile(path, &out);
+    *bytes = (long long)out.length;
+    memFree(MEM_BUFFERS, out.data, out.capacity);
+    return status;
+}
+
+int timetableExportSections(Timetable *tt, const char *directory, int format, int threads, ExportReport *report)
+{
+    memset(report, 0, sizeof(*report));
+    if (format != EXPORT_TEXT && format != EXPORT_CSV && format != EXPORT_JSONL)
+        return TT_ERR_INVALID;
+    if (makeDirectory(directory) != 0)
+        return TT_ERR_IO;
+
+    TRACE_BEGIN(span, "io", "export sections");
+    ExportJob job;
+    job.version = timetablePin(tt);
+    job.directory = directory;
+    job.format = format;
+    job.sectionCount = atomic_load(&job.version->sections->count);
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+    job.results = (SectionResult *)memCalloc(MEM_BUFFERS, job.sectionCount ? job.sectionCount : 1,
+                                             sizeof(SectionResult));
+    if (job.results == NULL)
+    {
+        timetableUnpin(job.version);
+        TRACE_END(span);
+        return TT_ERR_NOMEM;
+    }
+
+    // The calling thread is one of the workers
+    if (threads <= 0)
+        threads = cpuCount();
+    if (threads > EXPORT_MAX_THREADS)
+        threads = EXPORT_MAX_THREADS;
+    if (threads > job.sectionCount)
+        threads = job.sectionCount > 0 ? job.sectionCount : 1;
+    Thread workers[EXPORT_MAX_THREADS];
+    int started = 0;
+    while (started < threads - 1 && threadStart(&workers[started], exportWorker, &job) == 0)
+        started++;
+    exportWorker(&job);
+    for (int i = 0; i < started; i++)
+        threadJoin(workers[i]);
+    report->threads = started + 1;
+    TRACE_ARG(span, report->threads);
+
+    int status = TT_OK;
+    for (int sid = 0; sid < job.sectionCount; sid++)
+    {
+        const SectionResult *result = &job.results[sid];
+        if (result->status != TT_OK && status == TT_OK)
+            status = result->status;
+        report->lectures += result->lectures;
+        report->bytes += result->bytes;
+    }
+    if (status == TT_OK)
+    {
+        long long manifestBytes = 0;
+        status = writeManifest(&job, &manifestBytes);
+        report->bytes += manifestBytes;
+        report->sections = job.sectionCount;
+    }
+    memFree(MEM_BUFFERS, job.results, sizeof(SectionResult) * (job.sectionCount ? job.sectionCount : 1));
+    timetableUnpin(job.version);
+    TRACE_END(span);
+    return status;
+}
+
+int timetableWriteRows(Timetable *tt, int format, FILE *fp)
+{
+    if (format != EXPORT_CSV && format != EXPORT_JSONL)
+        return TT_ERR_INVALID;
+    TRACE_BEGIN(span, "io", "write rows");
+    const TimetableVersion *version = timetablePin(tt);
+    int sectionCount = atomic_load(&version->sections->count);
+    OutBuffer out = {NULL, 0, 0, 0};
+    if (format == EXPORT_CSV)
+        appendCsvHeader(&out);
+    int lectures = 0, status = TT_OK;
+    for (int sid = 0; sid < sectionCount && status == TT_OK; sid++)
+    {
+        lectures += formatSection(version, sid, format, &out);
+        // A section is at most a few hundred rows, so the buffer never grows much
+        // past this; the stream gets one large write per buffer full
+        if (out.failed)
+            status = TT_ERR_NOMEM;
+        else if (out.length >= EXPORT_BUFFER_SIZE / 2 || sid + 1 == sectionCount)
+        {
+            if (fwrite(out.data, 1, out.length, fp) != out.length)
+                status = TT_ERR_IO;
+            out.length = 0;
+        }
+    }
+    if (status == TT_OK && out.length > 0 && fwrite(out.data, 1, out.length, fp) != out.length)
+        status = TT_ERR_IO;
+    memFree(MEM_BUFFERS, out.data, out.capacity);
+    timetableUnpin(version);
+    TRACE_ARG(span, lectures);
+    TRACE_END(span);
+    return status == TT_OK ? lectures : status;
+}
+
+// Dates of a term, worked out once for all the events
+typedef struct
+{
+    const Calendar *calendar;
+    char first[DAY_COUNT][9]; // YYYYMMDD of each weekday's first day in the term, "" if it has none
+    char until[16];           // last day of the term, YYYYMMDDT235959
+    char stamp[17];           // DTSTAMP, now in UTC
+    char id[9];               // first day of the term, so the UIDs of two terms differ
+} IcsTerm;
+
+// A YYYY-MM-DD date at noon, so adding days never crosses a daylight saving change
+static int parseDate(const char *text, struct tm *date)
+{
+    int year, month, day;
+    char extra;
+    if (sscanf(text, "%4d-%2d-%2d%c", &year, &month, &day, &extra) != 3)
+        return -1;
+    memset(date, 0, sizeof(*date));
+    date->tm_year = year - 1900;
+    date->tm_mon = month - 1;
+    date->tm_mday = day;
+    date->tm_hour = 12;
+    date->tm_isdst = -1;
+    // mktime normalizes out of range fields, so a changed day means an invalid date
+    if (mktime(date) == (time_t)-1 || date->tm_mday != day || date->tm_mon != month - 1)
+        return -1;
+    return 0;
+}
+
+static int icsTermInit(IcsTerm *term, const Calendar *calendar, const char *termStart, const char *termEnd)
+{
+    struct tm first, last;
+    if (parseDate(termStart, &first) != 0 || parseDate(termEnd, &last) != 0)
+        return TT_ERR_INVALID;
+    time_t lastDay = mktime(&last);
+    if (difftime(lastDay, mktime(&first)) < 0)
+        return TT_ERR_INVALID;
+    term->calendar = calendar;
+    strftime(term->id, sizeof(term->id), "%Y%m%d", &first);
+    strftime(term->until, sizeof(term->until), "%Y%m%dT235959", &last);
+    int weekday = (first.tm_wday + 6) % 7; // DAY_CODES start on Monday
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        struct tm date = first;
+        date.tm_mday += (d - weekday + 7) % 7;
+        time_t day = mktime(&date);
+        term->first[d][0] = '\0';
+        if (day != (time_t)-1 && difftime(day, lastDay) <= 0)
+            strftime(term->first[d], sizeof(term->first[d]), "%Y%m%d", &date);
+    }
+    time_t now = time(NULL);
+    struct tm utc;
+    if (utcTime(&now, &utc) == NULL)
+        return TT_ERR_INVALID;
+    strftime(term->stamp, sizeof(term->stamp), "%Y%m%dT%H%M%SZ", &utc);
+    return TT_OK;
+}
+
+// One content line, folded after 75 octets without splitting a UTF-8 character
+static void appendIcsLine(OutBuffer *out, const char *line, size_t length)
+{
+    size_t limit = 75;
+    while (length > limit)
+    {
+        size_t cut = limit;
+        while (cut > 1 && ((unsigned char)line[cut] & 0xc0) == 0x80)
+            cut--;
+        append(out, line, cut);
+        append(out, "\r\n ", 3);
+        line += cut;
+        length -= cut;
+        limit = 74; // the space that starts a continuation counts
+    }
+    append(out, line, length);
+    append(out, "\r\n", 2);
+}
+
+// A property with a text value, escaped for iCalendar
+static void appendIcsText(OutBuffer *out, const char *name, const char *value)
+{
+    char line[4 * MAX_LEN + 64];
+    size_t length = (size_t)snprintf(line, sizeof(line), "%s:", name);
+    for (const char *c = value; *c != '\0' && length + 2 < sizeof(line); c++)
+    {
+        if (*c == '\n')
+        {
+            line[length++] = '\\';
+            line[length++] = 'n';
+            continue;
+        }
+        if (*c == '\\' || *c == ';' || *c == ',')
+            line[length++] = '\\';
+        line[length++] = *c;
+    }
+    appendIcsLine(out, line, length);
+}
+
+static void appendIcsHeader(OutBuffer *out, const char *name)
+{
+    append(out, "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Classroom Scheduler//Timetable//EN\r\nCALSCALE:GREGORIAN\r\n", 96);
+    appendIcsText(out, "X-WR-CALNAME", name);
+}
+
+static void appendIcsFooter(OutBuffer *out)
+{
+    append(out, "END:VCALENDAR\r\n", 15);
+}
+
+// A lecture as one weekly event from its first day in the term to the term's end:
+// a single RRULE instead of an event per week. owner keeps the UIDs of one
+// calendar apart. Returns 0 for a lecture off the period calendar or on a
+// weekday the term does not reach.
+static int appendEvent(OutBuffer *out, const IcsTerm *term, const Lecture *lec, int day, const char *owner,
+                       const char *description)
+{
+    if (lec->periods == 0 || term->first[day][0] == '\0')
+        return 0;
+    int firstPeriod = 0, lastPeriod = 31;
+    while (!((lec->periods >> firstPeriod) & 1))
+        firstPeriod++;
+    while (!((lec->periods >> lastPeriod) & 1))
+        lastPeriod--;
+    int start = calendarStart(term->calendar, day, firstPeriod);
+    int end = calendarEnd(term->calendar, day, lastPeriod);
+    if (start < 0 || end < 0)
+        return 0;
+    char line[2 * MAX_LEN + 64], text[3 * MAX_LEN];
+    append(out, "BEGIN:VEVENT\r\n", 14);
+    int length = snprintf(line, sizeof(line), "UID:%s-%s-%s-%02d%02d@classroom-scheduler", term->id, owner,
+                          DAY_CODES[day], start / 60, start % 60);
+    appendIcsLine(out, line, (size_t)length);
+    appendf(out, "DTSTAMP:%s\r\nDTSTART:%sT%02d%02d00\r\nDTEND:%sT%02d%02d00\r\nRRULE:FREQ=WEEKLY;UNTIL=%s\r\n",
+            term->stamp, term->first[day], start / 60, start % 60, term->first[day], end / 60, end % 60, term->until);
+    snprintf(text, sizeof(text), "%s %s", lec->subject, getSubjectName(lec->subject));
+    appendIcsText(out, "SUMMARY", text);
+    if (lec->room[0] != '\0')
+        appendIcsText(out, "LOCATION", lec->room);
+    appendIcsText(out, "DESCRIPTION", description);
+    append(out, "END:VEVENT\r\n", 12);
+    return 1;
+}
+
+// An event of a section's calendar, described by its section and teacher
+static int appendSectionEvent(OutBuffer *out, const IcsTerm *term, const Lecture *lec, int day)
+{
+    char text[3 * MAX_LEN];
+    snprintf(text, sizeof(text), "Section %s%s%s", lec->section, isTeacher(lec->faculty) ? ", " : "",
+             isTeacher(lec->faculty) ? lec->faculty : "");
+    return appendEvent(out, term, lec, day, lec->section, text);
+}
+
+// Characters other than letters, digits and '-' become '_', from start up to end
+static void replaceUnsafe(char *start, const char *end)
+{
+    for (char *c = start; c < end; c++)
+    {
+        if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '-'))
+            *c = '_';
+    }
+}
+
+// A lecture of a teacher's calendar
+typedef struct
+{
+    const Lecture *lec;
+    int day;
+    int teacher; // id in the faculty column
+    int order;   // in section order
+} TeacherLecture;
+
+// The first period a lecture takes, as a mask of one bit
+static unsigned int firstPeriod(const Lecture *lec)
+{
+    return lec->periods & (~lec->periods + 1);
+}
+
+// By teacher, day and first period, then in section order
+static int compareTeacherLectures(const void *a, const void *b)
+{
+    const TeacherLecture *x = (const TeacherLecture *)a, *y = (const TeacherLecture *)b;
+    if (x->teacher != y->teacher)
+        return x->teacher - y->teacher;
+    if (x->day != y->day)
+        return x->day - y->day;
+    unsigned int p = firstPeriod(x->lec), q = firstPeriod(y->lec);
+    if (p != q)
+        return p < q ? -1 : 1;
+    return x->order - y->order;
+}
+
+// Events of one teacher's lectures sorted by compareTeacherLectures. The sections
+// a teacher takes together, as one combined lecture, get one event listing them
+// all rather than overlapping copies. Returns the events written.
+static int appendTeacherEvents(OutBuffer *out, const IcsTerm *term, const TeacherLecture *list, int count)
+{
+    char owner[MAX_LEN + 16], text[3 * MAX_LEN];
+    int events = 0, run;
+    for (int i = 0; i < count; i += run)
+    {
+        run = 1;
+        while (i + run < count && list[i + run].day == list[i].day &&
+               firstPeriod(list[i + run].lec) == firstPeriod(list[i].lec))
+            run++;
+        size_t length = (size_t)snprintf(text, sizeof(text), "Section%s ", run > 1 ? "s" : "");
+        for (int k = 0; k < run && length < sizeof(text); k++)
+            length += (size_t)snprintf(text + length, sizeof(text) - length, "%s%s", k > 0 ? ", " : "",
+                                       list[i + k].lec->section);
+        snprintf(owner, sizeof(owner), "teacher-%s", list[i].lec->faculty);
+        replaceUnsafe(owner, owner + strlen(owner));
+        events += appendEvent(out, term, list[i].lec, list[i].day, owner, text);
+    }
+    return events;
+}
+
+// <prefix>_<name>.ics, with characters other than letters, digits, '-' and '_' replaced
+static void calendarFileName(const char *prefix, const char *owner, char *name, size_t size)
+{
+    snprintf(name, size, "%s_%s.ics", prefix, owner);
+    replaceUnsafe(name + strlen(prefix) + 1, name + strlen(name) - 4);
+}
+
+// A teacher's calendar of a pinned version; returns the events written or TT_ERR_NOMEM
+static int appendTeacherCalendar(OutBuffer *out, const IcsTerm *term, const TimetableVersion *version,
+                                 const char *teacher)
+{
+    int sectionCount = atomic_load(&version->sections->count);
+    TeacherLecture *list = NULL;
+    int count = 0;
+    // Count the teacher's lectures, then gather them
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            list = (TeacherLecture *)memAlloc(MEM_BUFFERS, sizeof(TeacherLecture) * (count ? count : 1));
+            if (list == NULL)
+                return TT_ERR_NOMEM;
+            count = 0;
+        }
+        for (int sid = 0; sid < sectionCount; sid++)
+        {
+            for (int d = 0; d < DAY_COUNT; d++)
+            {
+                const Block *block = versionBlock(version, sid, d);
+                for (int i = 0; block != NULL && i < block->count; i++)
+                {
+                    const Lecture *lec = &block->lectures[i];
+                    if (lec->periods == 0 || strcmp(lec->faculty, teacher) != 0)
+                        continue;
+                    if (list != NULL)
+                        list[count] = (TeacherLecture){lec, d, 0, count};
+                    count++;
+                }
+            }
+        }
+    }
+    qsort(list, count, sizeof(TeacherLecture), compareTeacherLectures);
+    int events = appendTeacherEvents(out, term, list, count);
+    memFree(MEM_BUFFERS, list, sizeof(TeacherLecture) * (count ? count : 1));
+    return events;
+}
+
+// Write out what a calendar has so far: the first time to a new file, later appended
+static int flushCalendar(const char *directory, const char *name, OutBuffer *out, int *started)
+{
+    char path[EXPORT_PATH_LEN];
+    if (out->failed)
+        return TT_ERR_NOMEM;
+    if (filePath(directory, name, path, sizeof(path)) != TT_OK)
+        return TT_ERR_INVALID;
+    FILE *fp = fopen(path, *started ? "ab" : "wb");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    int status = fwrite(out->data, 1, out->length, fp) == out->length ? TT_OK : TT_ERR_IO;
+    if (fclose(fp) != 0)
+        status = TT_ERR_IO;
+    *started = 1;
+    out->length = 0;
+    return status;
+}
+
+int timetableWriteCalendar(Timetable *tt, const char *section, const char *teacher, const char *termStart,
+                           const char *termEnd, FILE *fp)
+{
+    IcsTerm term;
+    int status = icsTermInit(&term, timetableCalendar(tt), termStart, termEnd);
+    if (status != TT_OK || (section == NULL) == (teacher == NULL))
+        return TT_ERR_INVALID;
+    const TimetableVersion *version = timetablePin(tt);
+    OutBuffer out = {NULL, 0, 0, 0};
+    char name[MAX_LEN + 32];
+    snprintf(name, sizeof(name), section != NULL ? "Section %s timetable" : "%s timetable", section != NULL ? section : teacher);
+    appendIcsHeader(&out, name);
+    int events = 0;
+    if (teacher != NULL)
+    {
+        events = appendTeacherCalendar(&out, &term, version, teacher);
+        if (events < 0)
+            status = events;
+    }
+    else
+    {
+        int sid = sectionTableFind(version->sections, section);
+        for (int d = 0; sid >= 0 && d < DAY_COUNT; d++)
+        {
+            const Block *block = versionBlock(version, sid, d);
+            for (int i = 0; block != NULL && i < block->count; i++)
+                events += appendSectionEvent(&out, &term, &block->lectures[i], d);
+        }
+    }
+    appendIcsFooter(&out);
+    if (status == TT_OK && (out.failed || fwrite(out.data, 1, out.length, fp) != out.length))
+        status = out.failed ? TT_ERR_NOMEM : TT_ERR_IO;
+    memFree(MEM_BUFFERS, out.data, out.capacity);
+    timetableUnpin(version);
+    return status == TT_OK ? events : status;
+}
+
+int timetableExportCalendars(Timetable *tt, const char *directory, const char *termStart, const char *termEnd,
+                             CalendarReport *report)
+{
+    memset(report, 0, sizeof(*report));
+    IcsTerm term;
+    if (icsTermInit(&term, timetableCalendar(tt), termStart, termEnd) != TT_OK)
+        return TT_ERR_INVALID;
+    if (makeDirectory(directory) != 0)
+        return TT_ERR_IO;
+
+    TRACE_BEGIN(span, "io", "export calendars");
+    const TimetableVersion *version = timetablePin(tt);
+    const LectureColumns *columns = versionColumns(version);
+    int rowCount = columns != NULL ? columns->rows : 0;
+    TeacherLecture *taught = columns != NULL ? (TeacherLecture *)memAlloc(MEM_BUFFERS, sizeof(TeacherLecture) *
+                                                                                       (rowCount ? rowCount : 1))
+                                             : NULL;
+    if (taught == NULL)
+    {
+        timetableUnpin(version);
+        TRACE_END(span);
+        return TT_ERR_NOMEM;
+    }
+
+    // One pass over the rows, which run section by section: a section's calendar is
+    // written when the section ends, and the teachers' lectures are gathered on the
+    // way, so that a combined lecture becomes one event of its teacher's calendar
+    int sectionCount = atomic_load(&version->sections->count);
+    OutBuffer out = {NULL, 0, 0, 0};
+    char name[MAX_LEN + 32];
+    int status = TT_OK, row = 0, taughtCount = 0;
+    for (int sid = 0; sid < sectionCount && status == TT_OK; sid++)
+    {
+        const char *sectionName = version->sections->names[sid];
+        out.length = 0;
+        snprintf(name, sizeof(name), "Section %s timetable", sectionName);
+        appendIcsHeader(&out, name);
+        for (; row < columns->rows && columns->section[row] == sid; row++)
+        {
+            if (!appendSectionEvent(&out, &term, columns->lecture[row], columns->day[row]))
+                continue;
+            report->events++;
+            if (!isTeacher(columns->faculties.values[columns->faculty[row]]))
+                continue;
+            taught[taughtCount++] =
+                (TeacherLecture){columns->lecture[row], columns->day[row], columns->faculty[row], row};
+        }
+        appendIcsFooter(&out);
+        int started = 0;
+        calendarFileName("section", sectionName, name, sizeof(name));
+        report->bytes += (long long)out.length;
+        status = flushCalendar(directory, name, &out, &started);
+        report->sections++;
+    }
+
+    // Then every teacher's calendar in turn, from their lectures sorted together
+    qsort(taught, taughtCount, sizeof(TeacherLecture), compareTeacherLectures);
+    for (int i = 0, run; i < taughtCount && status == TT_OK; i += run)
+    {
+        run = 1;
+        while (i + run < taughtCount && taught[i + run].teacher == taught[i].teacher)
+            run++;
+        const char *faculty = columns->faculties.values[taught[i].teacher];
+        out.length = 0;
+        snprintf(name, sizeof(name), "%s timetable", faculty);
+        appendIcsHeader(&out, name);
+        appendTeacherEvents(&out, &term, taught + i, run);
+        appendIcsFooter(&out);
+        int started = 0;
+        calendarFileName("teacher", faculty, name, sizeof(name));
+        report->bytes += (long long)out.length;
+        status = flushCalendar(directory, name, &out, &started);
+        report->teachers++;
+    }
+    memFree(MEM_BUFFERS, taught, sizeof(TeacherLecture) * (rowCount ? rowCount : 1));
+    memFree(MEM_BUFFERS, out.data, out.capacity);
+    timetableUnpin(version);
+    TRACE_ARG(span, report->events);
+    TRACE_END(span);
+    return status;
+}
@@ -0,0 +1,165 @@
+// Load generator for the query server (ClassroomSchedular --serve).
+//
+// Usage: loadgen <address> [connections] [requests per connection] [write %]
+//
+// Every connection runs on its own thread and sends requests back to back,
+// mixing section, day, slot, teacher and free-slot queries (plus SWAP edits
+// when a write percentage is given). Prints requests per second and latency
+// percentiles over all requests.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "net.h"
+#include "platform.h"
+
+typedef struct
+{
+    const char *address;
+    int requests;
+    int writePercent;
+    unsigned int seed;
+    double *latencies; // microseconds, one per request
+    int completed;
+    int errors;
+} Worker;
+
+static const char *const QUERIES[] = {
+    "SECTION A",
+    "DAY B WED",
+    "SLOT C THU 11:05-12:00",
+    "TEACHER Neeraj",
+    "FREE D FRI",
+    "DAY A MON",
+    "SLOT A TUE 10:10-11:05",
+};
+#define QUERY_COUNT ((int)(sizeof(QUERIES) / sizeof(QUERIES[0])))
+
+static unsigned int nextRandom(unsigned int *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+static void runWorker(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    Socket sock = netConnect(worker->address);
+    if (sock == INVALID_SOCK)
+    {
+        worker->errors = worker->requests;
+        return;
+    }
+
+    NetReader reader;
+    char line[NET_LINE_MAX];
+    netReaderInit(&reader, sock);
+    for (int i = 0; i < worker->requests; i++)
+    {
+        const char *request = (int)(nextRandom(&worker->seed) % 100) < worker->writePercent
+                                  ? "SWAP A MON 8:00-8:55 A MON 8:55-9:50 1"
+                                  : QUERIES[nextRandom(&worker->seed) % QUERY_COUNT];
+        char message[NET_LINE_MAX];
+        int len = snprintf(message, sizeof(message), "%s\n", request);
+
+        double start = monotonicMicros();
+        if (netSendAll(sock, message, (size_t)len) != 0 || netReadLine(&reader, line, sizeof(line)) < 0)
+        {
+            worker->errors += worker->requests - i;
+            break;
+        }
+        int lines = 0;
+        if (strncmp(line, "OK ", 3) == 0)
+            lines = atoi(line + 3);
+        else
+            worker->errors++;
+        for (int j = 0; j < lines; j++)
+            netReadLine(&reader, line, sizeof(line));
+        worker->latencies[worker->completed++] = monotonicMicros() - start;
+    }
+    netSendAll(sock, "QUIT\n", 5);
+    netClose(sock);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p)
+{
+    if (count == 0)
+        return 0.0;
+    int index = (int)(p / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <address> [connections] [requests per connection] [write %%]\n", argv[0]);
+        return 2;
+    }
+    int connections = argc > 2 ? atoi(argv[2]) : 8;
+    int requests = argc > 3 ? atoi(argv[3]) : 10000;
+    int writePercent = argc > 4 ? atoi(argv[4]) : 0;
+    if (connections < 1 || requests < 1 || netInit() != 0)
+    {
+        fprintf(stderr, "Invalid arguments.\n");
+        return 2;
+    }
+
+    Worker *workers = (Worker *)calloc(connections, sizeof(Worker));
+    Thread *threads = (Thread *)calloc(connections, sizeof(Thread));
+    if (workers == NULL || threads == NULL)
+        return 1;
+
+    double start = monotonicMicros();
+    for (int i = 0; i < connections; i++)
+    {
+        workers[i].address = argv[1];
+        workers[i].requests = requests;
+        workers[i].writePercent = writePercent;
+        workers[i].seed = 7919u * (i + 1);
+        workers[i].latencies = (double *)malloc(sizeof(double) * requests);
+        if (workers[i].latencies == NULL || threadStart(&threads[i], runWorker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "Could not start connection %d.\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < connections; i++)
+        threadJoin(threads[i]);
+    double elapsed = monotonicMicros() - start;
+
+    // Merge every worker's latencies for the percentiles
+    int total = 0, errors = 0;
+    for (int i = 0; i < connections; i++)
+    {
+        total += workers[i].completed;
+        errors += workers[i].errors;
+    }
+    double *all = (double *)malloc(sizeof(double) * (total > 0 ? total : 1));
+    if (all == NULL)
+        return 1;
+    int n = 0;
+    for (int i = 0; i < connections; i++)
+    {
+        memcpy(all + n, workers[i].latencies, sizeof(double) * workers[i].completed);
+        n += workers[i].completed;
+        free(workers[i].latencies);
+    }
+    qsort(all, total, sizeof(double), compareDoubles);
+
+    printf("connections: %d, requests: %d, errors: %d, writes: %d%%\n", connections, total, errors, writePercent);
+    printf("elapsed: %.3f s, throughput: %.0f requests/s\n", elapsed / 1e6, total / (elapsed / 1e6));
+    printf("latency us: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           percentile(all, total, 50), percentile(all, total, 90), percentile(all, total, 99),
+           total > 0 ? all[total - 1] : 0.0);
+
+    free(all);
+    free(workers);
+    free(threads);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "memstat.h"
+
+static const char *const MEM_SUBSYSTEM_NAMES[MEM_SUBSYSTEM_COUNT] = {
+    "lectures", "indexes", "string tables", "journal", "render buffers", "column tables"};
+
+typedef struct
+{
+    atomic_llong bytes;
+    atomic_llong objects;
+    atomic_llong peak;
+} MemCounter;
+
+// One counter per subsystem plus the total, which has its own peak
+static MemCounter counters[MEM_SUBSYSTEM_COUNT + 1];
+
+static void raisePeak(MemCounter *counter, long long now)
+{
+    long long peak = atomic_load_explicit(&counter->peak, memory_order_relaxed);
+    while (now > peak &&
+           !atomic_compare_exchange_weak_explicit(&counter->peak, &peak, now, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+void memAccount(int subsystem, long long bytes, long long objects)
+{
+    MemCounter *counter = &counters[subsystem];
+    MemCounter *total = &counters[MEM_SUBSYSTEM_COUNT];
+    atomic_fetch_add_explicit(&counter->objects, objects, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total->objects, objects, memory_order_relaxed);
+    long long now = atomic_fetch_add_explicit(&counter->bytes, bytes, memory_order_relaxed) + bytes;
+    long long all = atomic_fetch_add_explicit(&total->bytes, bytes, memory_order_relaxed) + bytes;
+    if (bytes > 0)
+    {
+        raisePeak(counter, now);
+        raisePeak(total, all);
+    }
+}
+
+void *memAlloc(int subsystem, size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr != NULL)
+        memAccount(subsystem, (long long)size, 1);
+    return ptr;
+}
+
+void *memCalloc(int subsystem, size_t count, size_t size)
+{
+    void *ptr = calloc(count, size);
+    if (ptr != NULL)
+        memAccount(subsystem, (long long)(count * size), 1);
+    return ptr;
+}
+
+void *memRealloc(int subsystem, void *ptr, size_t oldSize, size_t newSize)
+{
+    void *resized = realloc(ptr, newSize);
+    if (resized != NULL)
+        memAccount(subsystem, (long long)newSize - (long long)(ptr != NULL ? oldSize : 0), ptr == NULL);
+    return resized;
+}
+
+void memFree(int subsystem, void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return;
+    free(ptr);
+    memAccount(subsystem, -(long long)size, -1);
+}
+
+static void readCounter(MemCounter *counter, const char *name, MemUsage *usage)
+{
+    usage->name = name;
+    usage->bytes = atomic_load_explicit(&counter->bytes, memory_order_relaxed);
+    usage->objects = atomic_load_explicit(&counter->objects, memory_order_relaxed);
+    usage->peakBytes = atomic_load_explicit(&counter->peak, memory_order_relaxed);
+}
+
+void memUsage(MemUsage usage[MEM_SUBSYSTEM_COUNT], MemUsage *total)
+{
+    for (int s = 0; s < MEM_SUBSYSTEM_COUNT; s++)
+        readCounter(&counters[s], MEM_SUBSYSTEM_NAMES[s], &usage[s]);
+    readCounter(&counters[MEM_SUBSYSTEM_COUNT], "total", total);
+}
+
+void memResetPeaks(void)
+{
+    for (int s = 0; s <= MEM_SUBSYSTEM_COUNT; s++)
+        atomic_store_explicit(&counters[s].peak, atomic_load(&counters[s].bytes), memory_order_relaxed);
+}
+
+int memWriteReport(FILE *fp)
+{
+    MemUsage usage[MEM_SUBSYSTEM_COUNT], total;
+    memUsage(usage, &total);
+    fprintf(fp, "MEMORY REPORT\n");
+    fprintf(fp, "%-15s %14s %10s %14s\n", "Subsystem", "Bytes", "Objects", "Peak bytes");
+    for (int s = 0; s < MEM_SUBSYSTEM_COUNT; s++)
+        fprintf(fp, "%-15s %14lld %10lld %14lld\n", usage[s].name, usage[s].bytes, usage[s].objects, usage[s].peakBytes);
+    fprintf(fp, "%-15s %14lld %10lld %14lld\n", total.name, total.bytes, total.objects, total.peakBytes);
+    return ferror(fp) ? -1 : 0;
+}
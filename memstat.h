@@ -0,0 +1,44 @@
+// Memory accounting for the scheduler library.
+//
+// Every heap allocation the library makes goes through memAlloc and friends with
+// the subsystem it belongs to, so the bytes and object counts currently held by
+// each subsystem, and their peaks, can be reported at any time. Counters are
+// process wide (all timetables together) and updated with relaxed atomics.
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Subsystems
+#define MEM_LECTURES 0 // lecture blocks of every version
+#define MEM_INDEX 1    // version headers, section chunks and day tables
+#define MEM_STRINGS 2  // section tables and period calendars
+#define MEM_JOURNAL 3  // undo stacks, transaction queues and validation scratch
+#define MEM_BUFFERS 4  // server reply buffers and other render output
+#define MEM_COLUMNS 5  // column tables built for analytics scans
+#define MEM_SUBSYSTEM_COUNT 6
+
+typedef struct
+{
+    const char *name;
+    long long bytes;
+    long long objects;
+    long long peakBytes;
+} MemUsage;
+
+void *memAlloc(int subsystem, size_t size);
+void *memCalloc(int subsystem, size_t count, size_t size);
+// Resize a block allocated with memAlloc; oldSize is what it was allocated with
+void *memRealloc(int subsystem, void *ptr, size_t oldSize, size_t newSize);
+void memFree(int subsystem, void *ptr, size_t size);
+// Book bytes and objects of memory that is part of a larger allocation
+void memAccount(int subsystem, long long bytes, long long objects);
+
+// Current usage of each subsystem; total gets the sum and the overall peak
+void memUsage(MemUsage usage[MEM_SUBSYSTEM_COUNT], MemUsage *total);
+// Start the peaks again from the current usage
+void memResetPeaks(void);
+int memWriteReport(FILE *fp);
+
+#endif
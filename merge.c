@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include <string.h>
+#include "merge.h"
+#include "columns.h"
+#include "memstat.h"
+
+// A slot one side changed
+typedef struct
+{
+    int sectionId;
+    int day;
+    const Lecture *before; // NULL if the slot was free in the base
+    const Lecture *after;  // NULL if the side freed it
+    int match;             // theirs: index of our change to the same slot, -1 if we left it alone
+    int shared;            // ours: they made the same change
+    int nextTeacher;       // ours: next new lecture of the same teacher and day, -1 at the end
+    int nextSection;       // ours: next new lecture of the same section and day
+} SideChange;
+
+typedef struct
+{
+    SideChange *changes; // in section id, day and time order, as versionCompare visits them
+    int count, capacity;
+    int failed;
+    const SectionTable *sections;
+} ChangeList;
+
+// Periods our new lectures take, by teacher and day and by section and day, each
+// with the chain of the lectures that took them
+typedef struct
+{
+    StringColumn teachers;
+    unsigned int *teacherPeriods; // teacher id * DAY_COUNT + day
+    int *teacherFirst;            // first lecture of the chain, -1 if none
+    size_t teacherSlots;
+    unsigned int *sectionPeriods; // section id * DAY_COUNT + day
+    int *sectionFirst;
+    size_t sectionSlots;
+} Occupancy;
+
+static int collectSide(const Lecture *before, const Lecture *after, void *ctx)
+{
+    ChangeList *list = (ChangeList *)ctx;
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        SideChange *changes = (SideChange *)memRealloc(MEM_JOURNAL, list->changes,
+                                                       sizeof(SideChange) * list->capacity,
+                                                       sizeof(SideChange) * capacity);
+        if (changes == NULL)
+        {
+            list->failed = 1;
+            return 1;
+        }
+        list->changes = changes;
+        list->capacity = capacity;
+    }
+    const Lecture *lec = before != NULL ? before : after;
+    SideChange *change = &list->changes[list->count++];
+    change->sectionId = sectionTableFind(list->sections, lec->section);
+    change->day = dayIndex(lec->day);
+    change->before = before;
+    change->after = after;
+    change->match = -1;
+    change->shared = 0;
+    change->nextTeacher = -1;
+    change->nextSection = -1;
+    return 0;
+}
+
+static void freeChanges(ChangeList *list)
+{
+    memFree(MEM_JOURNAL, list->changes, sizeof(SideChange) * list->capacity);
+}
+
+static int compareSlots(const SideChange *a, const SideChange *b)
+{
+    if (a->sectionId != b->sectionId)
+        return a->sectionId - b->sectionId;
+    if (a->day != b->day)
+        return a->day - b->day;
+    const Lecture *x = a->before != NULL ? a->before : a->after;
+    const Lecture *y = b->before != NULL ? b->before : b->after;
+    return strcmp(x->time, y->time);
+}
+
+// Lectures at times off the calendar take no periods; they overlap at the same time
+static int overlaps(const Lecture *a, const Lecture *b)
+{
+    if (a->periods != 0 || b->periods != 0)
+        return (a->periods & b->periods) != 0;
+    return strcmp(a->time, b->time) == 0;
+}
+
+// One teacher teaching a subject to several sections in one room is a combined
+// lecture, not a double booking
+static int sameClass(const Lecture *a, const Lecture *b)
+{
+    return strcmp(a->subject, b->subject) == 0 && strcmp(a->faculty, b->faculty) == 0 &&
+           strcmp(a->room, b->room) == 0;
+}
+
+static int sameContents(const Lecture *a, const Lecture *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return sameClass(a, b);
+}
+
+// Pair the changes both sides made to the same slot; both lists are in slot order
+static void matchSlots(ChangeList *ours, ChangeList *theirs)
+{
+    for (int i = 0, j = 0; i < ours->count && j < theirs->count;)
+    {
+        int order = compareSlots(&ours->changes[i], &theirs->changes[j]);
+        if (order == 0)
+        {
+            theirs->changes[j].match = i;
+            ours->changes[i].shared = sameContents(ours->changes[i].after, theirs->changes[j].after);
+        }
+        i += order <= 0;
+        j += order >= 0;
+    }
+}
+
+static void freeOccupancy(Occupancy *occupancy)
+{
+    columnRelease(&occupancy->teachers);
+    memFree(MEM_JOURNAL, occupancy->teacherPeriods, sizeof(unsigned int) * occupancy->teacherSlots);
+    memFree(MEM_JOURNAL, occupancy->teacherFirst, sizeof(int) * occupancy->teacherSlots);
+    memFree(MEM_JOURNAL, occupancy->sectionPeriods, sizeof(unsigned int) * occupancy->sectionSlots);
+    memFree(MEM_JOURNAL, occupancy->sectionFirst, sizeof(int) * occupancy->sectionSlots);
+}
+
+// Record the lectures only we put in, the ones their lectures could clash with
+static int buildOccupancy(Occupancy *occupancy, ChangeList *ours, int sectionCount)
+{
+    memset(occupancy, 0, sizeof(*occupancy));
+    occupancy->teacherSlots = (size_t)(ours->count + 1) * DAY_COUNT; // at most one teacher per lecture
+    occupancy->sectionSlots = (size_t)(sectionCount + 1) * DAY_COUNT;
+    occupancy->teacherPeriods = (unsigned int *)memCalloc(MEM_JOURNAL, occupancy->teacherSlots, sizeof(unsigned int));
+    occupancy->teacherFirst = (int *)memAlloc(MEM_JOURNAL, sizeof(int) * occupancy->teacherSlots);
+    occupancy->sectionPeriods = (unsigned int *)memCalloc(MEM_JOURNAL, occupancy->sectionSlots, sizeof(unsigned int));
+    occupancy->sectionFirst = (int *)memAlloc(MEM_JOURNAL, sizeof(int) * occupancy->sectionSlots);
+    if (columnInit(&occupancy->teachers, 64) != 0 || occupancy->teacherPeriods == NULL ||
+        occupancy->teacherFirst == NULL || occupancy->sectionPeriods == NULL || occupancy->sectionFirst == NULL)
+        return TT_ERR_NOMEM;
+    memset(occupancy->teacherFirst, 0xff, sizeof(int) * occupancy->teacherSlots);
+    memset(occupancy->sectionFirst, 0xff, sizeof(int) * occupancy->sectionSlots);
+
+    for (int i = 0; i < ours->count; i++)
+    {
+        SideChange *change = &ours->changes[i];
+        const Lecture *lec = change->after;
+        if (lec == NULL || change->shared || change->day < 0)
+            continue;
+        size_t slot = (size_t)change->sectionId * DAY_COUNT + change->day;
+        occupancy->sectionPeriods[slot] |= lec->periods;
+        change->nextSection = occupancy->sectionFirst[slot];
+        occupancy->sectionFirst[slot] = i;
+        if (!isTeacher(lec->faculty))
+            continue;
+        int teacher = columnIntern(&occupancy->teachers, lec->faculty);
+        if (teacher < 0)
+            return TT_ERR_NOMEM;
+        slot = (size_t)teacher * DAY_COUNT + change->day;
+        occupancy->teacherPeriods[slot] |= lec->periods;
+        change->nextTeacher = occupancy->teacherFirst[slot];
+        occupancy->teacherFirst[slot] = i;
+    }
+    return TT_OK;
+}
+
+// Our new lecture a lecture of theirs clashes with, or NULL. The masks rule out
+// almost every lecture; only a hit, or a lecture off the calendar, walks the short
+// chain of that teacher's or section's day. kind gets the MERGE_ kind of the clash.
+static const Lecture *findClash(const Occupancy *occupancy, const ChangeList *ours, const SideChange *change,
+                                int *kind)
+{
+    const Lecture *lec = change->after;
+    if (lec == NULL || change->day < 0)
+        return NULL;
+    size_t slot = (size_t)change->sectionId * DAY_COUNT + change->day;
+    if ((occupancy->sectionPeriods[slot] & lec->periods) || lec->periods == 0)
+    {
+        for (int i = occupancy->sectionFirst[slot]; i >= 0; i = ours->changes[i].nextSection)
+        {
+            if (overlaps(ours->changes[i].after, lec))
+            {
+                *kind = MERGE_SLOT;
+                return ours->changes[i].after;
+            }
+        }
+    }
+    int teacher = isTeacher(lec->faculty) ? columnFind(&occupancy->teachers, lec->faculty) : -1;
+    slot = (size_t)teacher * DAY_COUNT + change->day;
+    if (teacher >= 0 && ((occupancy->teacherPeriods[slot] & lec->periods) || lec->periods == 0))
+    {
+        for (int i = occupancy->teacherFirst[slot]; i >= 0; i = ours->changes[i].nextTeacher)
+        {
+            if (overlaps(ours->changes[i].after, lec) && !sameClass(ours->changes[i].after, lec))
+            {
+                *kind = MERGE_TEACHER;
+                return ours->changes[i].after;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int addStep(MergePlan *plan, const SideChange *change)
+{
+    if (plan->count == plan->capacity)
+    {
+        int capacity = plan->capacity ? plan->capacity * 2 : 64;
+        MergeStep *steps = (MergeStep *)memRealloc(MEM_JOURNAL, plan->steps, sizeof(MergeStep) * plan->capacity,
+                                                   sizeof(MergeStep) * capacity);
+        if (steps == NULL)
+            return TT_ERR_NOMEM;
+        plan->steps = steps;
+        plan->capacity = capacity;
+    }
+    MergeStep *step = &plan->steps[plan->count++];
+    step->sectionId = change->sectionId;
+    step->day = change->day;
+    step->before = change->before;
+    step->after = change->after;
+    return TT_OK;
+}
+
+int planMerge(const TimetableVersion *base, const TimetableVersion *ours, const TimetableVersion *theirs,
+              MergeVisitor visit, void *ctx, MergePlan *plan, MergeReport *report)
+{
+    MergeReport counts = {0, 0, 0, 0};
+    memset(plan, 0, sizeof(*plan));
+    if (report != NULL)
+        *report = counts;
+    if (ours->sections != base->sections || theirs->sections != base->sections)
+        return TT_ERR_INVALID;
+
+    ChangeList mine = {NULL, 0, 0, 0, base->sections}, other = {NULL, 0, 0, 0, base->sections};
+    versionCompare(base, ours, collectSide, &mine);
+    if (!mine.failed)
+        versionCompare(base, theirs, collectSide, &other);
+    int status = mine.failed || other.failed ? TT_ERR_NOMEM : TT_OK;
+    Occupancy occupancy;
+    memset(&occupancy, 0, sizeof(occupancy));
+    if (status == TT_OK)
+    {
+        matchSlots(&mine, &other);
+        status = buildOccupancy(&occupancy, &mine, atomic_load(&base->sections->count));
+    }
+
+    int reporting = visit != NULL;
+    for (int j = 0; j < other.count && status == TT_OK; j++)
+    {
+        const SideChange *change = &other.changes[j];
+        int kind = 0;
+        const Lecture *clash = NULL;
+        if (change->match >= 0)
+        {
+            const SideChange *own = &mine.changes[change->match];
+            if (own->shared)
+            {
+                counts.same++;
+                continue;
+            }
+            kind = MERGE_SLOT;
+            clash = own->after;
+        }
+        else
+            clash = findClash(&occupancy, &mine, change, &kind);
+
+        if (kind == 0)
+        {
+            status = addStep(plan, change);
+            counts.theirs++;
+            continue;
+        }
+        counts.conflicts++;
+        if (reporting && visit(kind, change->before, clash, change->after, ctx))
+            reporting = 0;
+    }
+    for (int i = 0; i < mine.count; i++)
+        counts.ours += !mine.changes[i].shared;
+
+    freeOccupancy(&occupancy);
+    freeChanges(&mine);
+    freeChanges(&other);
+    if (report != NULL)
+        *report = counts;
+    return status;
+}
+
+void mergePlanFree(MergePlan *plan)
+{
+    memFree(MEM_JOURNAL, plan->steps, sizeof(MergeStep) * plan->capacity);
+    memset(plan, 0, sizeof(*plan));
+}
@@ -0,0 +1,45 @@
+// Three-way merge, internal to the scheduler library.
+//
+// Both sides' changes to the common base are found with versionCompare, one
+// change per (section, day, time) slot in the same order, and walked side by side.
+// A slot only one side changed takes that side's change; a slot both changed the
+// same way is taken once; a slot they changed differently is a conflict and keeps
+// our lecture. Their lectures are then checked against our new ones with
+// occupancy masks per teacher and day and per section and day: one that would
+// double-book a teacher or a section's periods next to one of ours is a conflict
+// as well and is left out; a teacher taking the same subject in the same room for
+// several sections is one combined lecture, not a double booking. Clashes either
+// side already had are theirs to keep.
+// Everything is linear in the number of changes, and the compare is linear in the
+// lectures of the blocks the versions do not share.
+#ifndef MERGE_H
+#define MERGE_H
+
+#include "version.h"
+
+// One of their changes to apply to our version: before is the lecture of the base
+// to take out of the slot (NULL if it was free), after the one to put in (NULL to
+// leave it free). Both point into the base and their version.
+typedef struct
+{
+    int sectionId;
+    int day;
+    const Lecture *before;
+    const Lecture *after;
+} MergeStep;
+
+typedef struct
+{
+    MergeStep *steps;
+    int count, capacity;
+} MergePlan;
+
+// Plan merging theirs into ours, which must share the base's section table.
+// Conflicts are passed to visit as they are found and counted in report. Returns
+// TT_OK, TT_ERR_INVALID for versions of different timetables or TT_ERR_NOMEM; the
+// plan is to be freed with mergePlanFree either way.
+int planMerge(const TimetableVersion *base, const TimetableVersion *ours, const TimetableVersion *theirs,
+              MergeVisitor visit, void *ctx, MergePlan *plan, MergeReport *report);
+void mergePlanFree(MergePlan *plan);
+
+#endif
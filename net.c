@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "net.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+int netInit(void)
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0 ? 0 : -1;
+#else
+    return 0;
+#endif
+}
+
+// Parse "port" or "host:port" into a loopback TCP address
+static int tcpAddress(const char *address, struct sockaddr_in *addr)
+{
+    const char *port = strrchr(address, ':');
+    port = port ? port + 1 : address;
+    int portNumber = atoi(port);
+    if (portNumber <= 0 || portNumber > 65535)
+        return -1;
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons((unsigned short)portNumber);
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return 0;
+}
+
+#ifndef _WIN32
+static int unixAddress(const char *address, struct sockaddr_un *addr)
+{
+    const char *path = address + strlen("unix:");
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+#endif
+
+static int isUnixAddress(const char *address)
+{
+    return strncmp(address, "unix:", 5) == 0;
+}
+
+// Requests and replies are small, so turn off Nagle to keep latency low
+static void setNoDelay(Socket sock)
+{
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&one, sizeof(one));
+}
+
+Socket netListen(const char *address)
+{
+    Socket sock;
+    if (isUnixAddress(address))
+    {
+#ifdef _WIN32
+        return INVALID_SOCK;
+#else
+        struct sockaddr_un addr;
+        if (unixAddress(address, &addr) != 0)
+            return INVALID_SOCK;
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock == INVALID_SOCK)
+            return INVALID_SOCK;
+        unlink(addr.sun_path);
+        if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            netClose(sock);
+            return INVALID_SOCK;
+        }
+#endif
+    }
+    else
+    {
+        struct sockaddr_in addr;
+        if (tcpAddress(address, &addr) != 0)
+            return INVALID_SOCK;
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock == INVALID_SOCK)
+            return INVALID_SOCK;
+        int one = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one));
+        if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            netClose(sock);
+            return INVALID_SOCK;
+        }
+    }
+    if (listen(sock, 128) != 0)
+    {
+        netClose(sock);
+        return INVALID_SOCK;
+    }
+    return sock;
+}
+
+Socket netConnect(const char *address)
+{
+    Socket sock;
+    if (isUnixAddress(address))
+    {
+#ifdef _WIN32
+        return INVALID_SOCK;
+#else
+        struct sockaddr_un addr;
+        if (unixAddress(address, &addr) != 0)
+            return INVALID_SOCK;
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock == INVALID_SOCK)
+            return INVALID_SOCK;
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            netClose(sock);
+            return INVALID_SOCK;
+        }
+#endif
+    }
+    else
+    {
+        struct sockaddr_in addr;
+        if (tcpAddress(address, &addr) != 0)
+            return INVALID_SOCK;
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock == INVALID_SOCK)
+            return INVALID_SOCK;
+        if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            netClose(sock);
+            return INVALID_SOCK;
+        }
+        setNoDelay(sock);
+    }
+    return sock;
+}
+
+Socket netAccept(Socket listener)
+{
+    Socket sock = accept(listener, NULL, NULL);
+    if (sock != INVALID_SOCK)
+        setNoDelay(sock); // harmless failure on unix sockets
+    return sock;
+}
+
+// Returns 0 once every byte is sent, -1 if the peer went away
+int netSendAll(Socket sock, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+#ifdef _WIN32
+        int sent = send(sock, data, (int)len, 0);
+#else
+        ssize_t sent = send(sock, data, len, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0)
+            return -1;
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return 0;
+}
+
+void netClose(Socket sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+void netReaderInit(NetReader *reader, Socket sock)
+{
+    reader->sock = sock;
+    reader->start = reader->end = 0;
+}
+
+// Read one line without its line ending; returns its length or -1 at end of stream.
+// Lines longer than max are truncated.
+int netReadLine(NetReader *reader, char *line, size_t max)
+{
+    size_t len = 0;
+    for (;;)
+    {
+        while (reader->start < reader->end)
+        {
+            char c = reader->buf[reader->start++];
+            if (c == '\n')
+            {
+                if (len > 0 && line[len - 1] == '\r')
+                    len--;
+                line[len] = '\0';
+                return (int)len;
+            }
+            if (len + 1 < max)
+                line[len++] = c;
+        }
+        int got = (int)recv(reader->sock, reader->buf, sizeof(reader->buf), 0);
+        if (got <= 0)
+        {
+            line[len] = '\0';
+            return len > 0 ? (int)len : -1;
+        }
+        reader->start = 0;
+        reader->end = (size_t)got;
+    }
+}
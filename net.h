@@ -0,0 +1,37 @@
+// Loopback networking helpers for the query server and its load generator.
+// Addresses are either "unix:/path/to/socket" (POSIX only) or a TCP port,
+// optionally written as "127.0.0.1:port"; servers only ever bind to loopback.
+#ifndef NET_H
+#define NET_H
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET Socket;
+#define INVALID_SOCK INVALID_SOCKET
+#else
+typedef int Socket;
+#define INVALID_SOCK (-1)
+#endif
+
+#define NET_LINE_MAX 1024
+
+// Buffered line reader over a connected socket
+typedef struct
+{
+    Socket sock;
+    char buf[8192];
+    size_t start, end;
+} NetReader;
+
+int netInit(void);
+Socket netListen(const char *address);
+Socket netConnect(const char *address);
+Socket netAccept(Socket listener);
+int netSendAll(Socket sock, const char *data, size_t len);
+void netClose(Socket sock);
+void netReaderInit(NetReader *reader, Socket sock);
+int netReadLine(NetReader *reader, char *line, size_t max);
+
+#endif
@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "notify.h"
+#include "platform.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+// The messages pending for one recipient
+typedef struct
+{
+    char recipient[NOTIFY_RECIPIENT_LEN];
+    char body[NOTIFY_BODY_LEN];
+    int length;
+    int starts[NOTIFY_MAX_MESSAGES]; // where each message begins in body
+    int messages;
+    int previous; // the recipient's earlier, full batch of this round, or -1
+} Batch;
+
+// Batches by recipient. The thread swaps the pending table for an empty one and
+// sends the full one with the lock released, so posting goes on meanwhile.
+typedef struct
+{
+    Batch *batches;
+    int count, capacity;
+    int *slots; // open addressing by recipient hash: index of their latest batch or -1
+    int slotCount; // a power of two, kept at least twice count
+    int recipients;
+    int messages;
+    double oldest; // monotonicMicros of the first message
+} BatchTable;
+
+struct NotifyQueue
+{
+    Mutex lock;
+    CondVar wake; // signalled on the first message, a full table, a flush or stop
+    Thread thread;
+    int stopping;
+    int flushing;
+
+    BatchTable tables[2];
+    BatchTable *pending; // posted to
+    BatchTable *sending; // owned by the thread while it delivers
+    long delay;
+    int maxPending;
+
+    NotifyTransport transport;
+    void *ctx;
+    long long posted, coalesced, sent, failed;
+};
+
+static unsigned int hashRecipient(const char *recipient)
+{
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *recipient; recipient++)
+        hash = (hash ^ (unsigned char)*recipient) * 16777619u;
+    return hash;
+}
+
+// Slot holding the batch of recipient, or the empty slot to put it in
+static int findSlot(const BatchTable *table, const char *recipient)
+{
+    unsigned int mask = (unsigned int)table->slotCount - 1;
+    for (unsigned int slot = hashRecipient(recipient) & mask;; slot = (slot + 1) & mask)
+    {
+        int index = table->slots[slot];
+        if (index < 0 || strcmp(table->batches[index].recipient, recipient) == 0)
+            return (int)slot;
+    }
+}
+
+static int rehash(BatchTable *table)
+{
+    int slotCount = table->slotCount ? table->slotCount * 2 : 64;
+    int *slots = (int *)malloc(sizeof(int) * slotCount);
+    if (slots == NULL)
+        return -1;
+    for (int i = 0; i < slotCount; i++)
+        slots[i] = -1;
+    free(table->slots);
+    table->slots = slots;
+    table->slotCount = slotCount;
+    for (int i = 0; i < table->count; i++)
+        table->slots[findSlot(table, table->batches[i].recipient)] = i;
+    return 0;
+}
+
+// The latest batch of recipient, added if they have none yet or followUp is set
+// (batches go out in the order they were added); NULL if out of memory
+static Batch *batchFor(BatchTable *table, const char *recipient, int followUp)
+{
+    if (2 * (table->count + 1) > table->slotCount && rehash(table) != 0)
+        return NULL;
+    int slot = findSlot(table, recipient);
+    if (table->slots[slot] >= 0 && !followUp)
+        return &table->batches[table->slots[slot]];
+    if (table->count == table->capacity)
+    {
+        int capacity = table->capacity ? table->capacity * 2 : 16;
+        Batch *grown = (Batch *)realloc(table->batches, sizeof(Batch) * capacity);
+        if (grown == NULL)
+            return NULL;
+        table->batches = grown;
+        table->capacity = capacity;
+    }
+    Batch *batch = &table->batches[table->count];
+    snprintf(batch->recipient, sizeof(batch->recipient), "%s", recipient);
+    batch->length = 0;
+    batch->messages = 0;
+    batch->previous = table->slots[slot];
+    table->recipients += batch->previous < 0;
+    table->slots[slot] = table->count++;
+    return batch;
+}
+
+// Whether text is pending in a batch or the recipient's earlier ones
+static int hasMessage(const BatchTable *table, const Batch *batch, const char *text, int length)
+{
+    for (;; batch = &table->batches[batch->previous])
+    {
+        for (int i = 0; i < batch->messages; i++)
+        {
+            int end = i + 1 < batch->messages ? batch->starts[i + 1] - 1 : batch->length;
+            if (end - batch->starts[i] == length && memcmp(batch->body + batch->starts[i], text, (size_t)length) == 0)
+                return 1;
+        }
+        if (batch->previous < 0)
+            return 0;
+    }
+}
+
+// Forget every batch, keeping the memory for the next round
+static void clearTable(BatchTable *table)
+{
+    for (int i = 0; i < table->slotCount; i++)
+        table->slots[i] = -1;
+    table->count = 0;
+    table->recipients = 0;
+    table->messages = 0;
+}
+
+static void freeTable(BatchTable *table)
+{
+    free(table->batches);
+    free(table->slots);
+}
+
+static void notifyThread(void *arg)
+{
+    NotifyQueue *queue = (NotifyQueue *)arg;
+    mutexLock(&queue->lock);
+    for (;;)
+    {
+        BatchTable *pending = queue->pending;
+        if (pending->messages == 0)
+        {
+            if (queue->stopping)
+                break;
+            condWait(&queue->wake, &queue->lock, -1);
+            continue;
+        }
+        if (!queue->stopping && !queue->flushing && pending->messages < queue->maxPending)
+        {
+            double waited = (monotonicMicros() - pending->oldest) / 1000.0;
+            if (waited < queue->delay)
+            {
+                condWait(&queue->wake, &queue->lock, (long)(queue->delay - waited) + 1);
+                continue;
+            }
+        }
+        queue->flushing = 0;
+        queue->pending = queue->sending;
+        queue->sending = pending;
+        NotifyTransport transport = queue->transport;
+        void *ctx = queue->ctx;
+        mutexUnlock(&queue->lock);
+
+        int sent = 0, failed = 0;
+        for (int i = 0; i < pending->count; i++)
+        {
+            const Batch *batch = &pending->batches[i];
+            Notification note = {batch->recipient, batch->body, batch->messages};
+            if (transport(&note, ctx) == 0)
+                sent++;
+            else
+                failed++;
+        }
+        clearTable(pending);
+
+        mutexLock(&queue->lock);
+        queue->sent += sent;
+        queue->failed += failed;
+    }
+    mutexUnlock(&queue->lock);
+}
+
+NotifyQueue *notifyStart(NotifyTransport transport, void *ctx, long delayMillis, int maxPending)
+{
+    NotifyQueue *queue = (NotifyQueue *)calloc(1, sizeof(NotifyQueue));
+    if (queue == NULL)
+        return NULL;
+    mutexInit(&queue->lock);
+    condInit(&queue->wake);
+    queue->pending = &queue->tables[0];
+    queue->sending = &queue->tables[1];
+    queue->delay = delayMillis;
+    queue->maxPending = maxPending > 0 ? maxPending : 1;
+    queue->transport = transport;
+    queue->ctx = ctx;
+    if (threadStart(&queue->thread, notifyThread, queue) != 0)
+    {
+        condDestroy(&queue->wake);
+        mutexDestroy(&queue->lock);
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void notifyStop(NotifyQueue *queue)
+{
+    if (queue == NULL)
+        return;
+    mutexLock(&queue->lock);
+    queue->stopping = 1;
+    condSignal(&queue->wake);
+    mutexUnlock(&queue->lock);
+    threadJoin(queue->thread);
+    condDestroy(&queue->wake);
+    mutexDestroy(&queue->lock);
+    freeTable(&queue->tables[0]);
+    freeTable(&queue->tables[1]);
+    free(queue);
+}
+
+int notifyPost(NotifyQueue *queue, const char *recipient, const char *text)
+{
+    char to[NOTIFY_RECIPIENT_LEN];
+    snprintf(to, sizeof(to), "%s", recipient);
+    int length = (int)strlen(text);
+    if (length >= NOTIFY_BODY_LEN)
+        length = NOTIFY_BODY_LEN - 1;
+    mutexLock(&queue->lock);
+    BatchTable *pending = queue->pending;
+    Batch *batch = batchFor(pending, to, 0);
+    int repeat = batch != NULL && hasMessage(pending, batch, text, length);
+    if (batch != NULL && !repeat &&
+        (batch->messages == NOTIFY_MAX_MESSAGES || batch->length + (batch->messages > 0) + length >= NOTIFY_BODY_LEN))
+        batch = batchFor(pending, to, 1);
+    if (batch == NULL)
+    {
+        mutexUnlock(&queue->lock);
+        return -1;
+    }
+    queue->posted++;
+    if (repeat)
+        queue->coalesced++;
+    else
+    {
+        if (batch->messages > 0)
+            batch->body[batch->length++] = '\n';
+        batch->starts[batch->messages++] = batch->length;
+        memcpy(batch->body + batch->length, text, (size_t)length);
+        batch->length += length;
+        batch->body[batch->length] = '\0';
+        if (pending->messages++ == 0)
+        {
+            pending->oldest = monotonicMicros();
+            condSignal(&queue->wake); // start the delay
+        }
+        else if (pending->messages == queue->maxPending)
+            condSignal(&queue->wake);
+    }
+    mutexUnlock(&queue->lock);
+    return 0;
+}
+
+void notifyFlush(NotifyQueue *queue)
+{
+    mutexLock(&queue->lock);
+    if (queue->pending->messages > 0)
+    {
+        queue->flushing = 1;
+        condSignal(&queue->wake);
+    }
+    mutexUnlock(&queue->lock);
+}
+
+void notifyStats(NotifyQueue *queue, NotifyStats *stats)
+{
+    mutexLock(&queue->lock);
+    stats->pending = queue->pending->messages;
+    stats->recipients = queue->pending->recipients;
+    stats->posted = queue->posted;
+    stats->coalesced = queue->coalesced;
+    stats->sent = queue->sent;
+    stats->failed = queue->failed;
+    mutexUnlock(&queue->lock);
+}
+
+int notifyStdoutTransport(const Notification *note, void *ctx)
+{
+    (void)ctx;
+    printf("\n[Notification to %s, %d message(s)]\n%s\n", note->recipient[0] ? note->recipient : "everyone",
+           note->messages, note->body);
+    return fflush(stdout) == 0 ? 0 : -1;
+}
+
+int notifyFileTransport(const Notification *note, void *ctx)
+{
+    FILE *fp = (FILE *)ctx;
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm local;
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localTime(&now, &local));
+    const char *recipient = note->recipient[0] ? note->recipient : "*";
+    for (const char *line = note->body; *line;)
+    {
+        const char *next = strchr(line, '\n');
+        int length = next ? (int)(next - line) : (int)strlen(line);
+        if (fprintf(fp, "%s\t%s\t%.*s\n", stamp, recipient, length, line) < 0)
+            return -1;
+        line += length + (next != NULL);
+    }
+    return fflush(fp) == 0 ? 0 : -1;
+}
+
+int notifyCommandTransport(const Notification *note, void *ctx)
+{
+    const char *command = (const char *)ctx;
+#ifdef _WIN32
+    // cmd.exe has no way to pass an argument untouched; keep quotes and newlines out of it
+    char recipient[NOTIFY_RECIPIENT_LEN + 2], body[NOTIFY_BODY_LEN + 2];
+    const char *from[] = {note->recipient, note->body};
+    char *to[] = {recipient, body};
+    for (int i = 0; i < 2; i++)
+    {
+        size_t len = 0;
+        to[i][len++] = '"';
+        for (const char *c = from[i]; *c; c++)
+            to[i][len++] = *c == '"' ? '\'' : *c == '\n' ? ' ' : *c;
+        to[i][len++] = '"';
+        to[i][len] = '\0';
+    }
+    return _spawnlp(_P_WAIT, "cmd.exe", "cmd.exe", "/c", command, recipient, body, NULL) == 0 ? 0 : -1;
+#else
+    // Recipient and body go in as $1 and $2, so the shell only ever parses the configured command
+    char script[512];
+    snprintf(script, sizeof(script), "%s \"$1\" \"$2\"", command);
+    char *argv[] = {"sh", "-c", script, "sh", (char *)note->recipient, (char *)note->body, NULL};
+    pid_t pid;
+    int status;
+    if (posix_spawnp(&pid, "sh", NULL, NULL, argv, environ) != 0 || waitpid(pid, &status, 0) < 0)
+        return -1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+#endif
+}
+
+int notifyOpenUrl(const char *url)
+{
+#ifdef _WIN32
+    char quoted[8192];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", url);
+    return _spawnlp(_P_WAIT, "cmd.exe", "cmd.exe", "/c", "start", "\"\"", quoted, NULL) == 0 ? 0 : -1;
+#else
+#ifdef __APPLE__
+    char *argv[] = {"open", (char *)url, NULL};
+#else
+    char *argv[] = {"xdg-open", (char *)url, NULL};
+#endif
+    pid_t pid;
+    int status;
+    if (posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ) != 0 || waitpid(pid, &status, 0) < 0)
+        return -1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+#endif
+}
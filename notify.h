@@ -0,0 +1,65 @@
+// Outbound notifications: messages to people, collected and sent in batches by a
+// background thread.
+//
+// notifyPost only appends the text to its recipient's pending batch, so callers
+// never wait for a transport: an edit that tells twenty teachers about a change
+// takes the queue's lock twenty times and returns. The thread sends a recipient's
+// batch as one notification, its messages a line apart and repeats sent once
+// (messages past NOTIFY_MAX_MESSAGES or NOTIFY_BODY_LEN start a follow-up one),
+// when the oldest pending message is delayMillis old, when maxPending messages are
+// waiting or on notifyFlush. A bulk reshuffle within that window costs one
+// notification per recipient instead of one per change. Transports run on the
+// notification thread, one notification at a time, with the queue unlocked.
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdio.h>
+
+#define NOTIFY_RECIPIENT_LEN 64
+#define NOTIFY_BODY_LEN 2048   // a message that does not fit starts a follow-up notification
+#define NOTIFY_MAX_MESSAGES 64 // and so does a message past this many
+
+typedef struct NotifyQueue NotifyQueue;
+
+typedef struct
+{
+    const char *recipient; // as posted; "" for "anyone", for the transport to ask
+    const char *body;      // the messages, separated by newlines
+    int messages;          // messages in body
+} Notification;
+
+typedef struct
+{
+    int pending;         // messages waiting
+    int recipients;      // recipients they are for
+    long long posted;    // messages accepted, repeats included
+    long long coalesced; // repeats of a pending message, not sent again
+    long long sent;      // notifications delivered
+    long long failed;    // notifications the transport reported as failed
+} NotifyStats;
+
+// Delivers one recipient's batch, returns 0 on success
+typedef int (*NotifyTransport)(const Notification *note, void *ctx);
+
+// Built-in transports. Stdout ignores ctx; the file transport appends the batch to
+// the FILE * in ctx; the command transport runs the command line in ctx with the
+// recipient and the body as two extra arguments, never parsed by the shell.
+int notifyStdoutTransport(const Notification *note, void *ctx);
+int notifyFileTransport(const Notification *note, void *ctx);
+int notifyCommandTransport(const Notification *note, void *ctx);
+// Open url with the desktop's handler (start, open or xdg-open), for transports
+// that hand notifications to a web client; returns 0 if the launcher succeeded
+int notifyOpenUrl(const char *url);
+
+// Start a queue and its thread, NULL if either could not be created
+NotifyQueue *notifyStart(NotifyTransport transport, void *ctx, long delayMillis, int maxPending);
+// Send what is pending, then stop the thread and free the queue
+void notifyStop(NotifyQueue *queue);
+// Queue text for recipient; returns 0, or -1 if out of memory. Recipients are cut
+// to NOTIFY_RECIPIENT_LEN - 1 characters and texts to NOTIFY_BODY_LEN - 1.
+int notifyPost(NotifyQueue *queue, const char *recipient, const char *text);
+// Send every pending batch now, without waiting for it to go
+void notifyFlush(NotifyQueue *queue);
+void notifyStats(NotifyQueue *queue, NotifyStats *stats);
+
+#endif
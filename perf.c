@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include "perf.h"
+
+PERF_THREAD_LOCAL PerfThread *perfSelf;
+
+static const char *const PERF_OP_NAMES[PERF_OP_COUNT] = {
+    "lookup", "insert", "swap", "move", "assign", "undo",
+    "commit", "search", "teacher load", "statistics", "save", "load"};
+
+// Counter blocks of running threads, blocks handed back by exited threads and
+// the counts those threads recorded. Registration is rare, a spinlock will do.
+static atomic_flag perfLock = ATOMIC_FLAG_INIT;
+static PerfThread *activeThreads;
+static PerfThread *freeBlocks;
+static PerfThread retired;
+
+static void lockPerf(void)
+{
+    while (atomic_flag_test_and_set_explicit(&perfLock, memory_order_acquire))
+        sleepMillis(0);
+}
+
+static void unlockPerf(void)
+{
+    atomic_flag_clear_explicit(&perfLock, memory_order_release);
+}
+
+static void clearBlock(PerfThread *block)
+{
+    for (int op = 0; op < PERF_OP_COUNT; op++)
+    {
+        atomic_store_explicit(&block->calls[op], 0, memory_order_relaxed);
+        atomic_store_explicit(&block->ticks[op], 0, memory_order_relaxed);
+        for (int b = 0; b < PERF_BUCKETS; b++)
+            atomic_store_explicit(&block->buckets[op][b], 0, memory_order_relaxed);
+    }
+}
+
+// Add src's counters to dest (dest is not being recorded into)
+static void addBlock(PerfThread *dest, PerfThread *src)
+{
+    for (int op = 0; op < PERF_OP_COUNT; op++)
+    {
+        PERF_ADD(dest->calls[op], atomic_load_explicit(&src->calls[op], memory_order_relaxed));
+        PERF_ADD(dest->ticks[op], atomic_load_explicit(&src->ticks[op], memory_order_relaxed));
+        for (int b = 0; b < PERF_BUCKETS; b++)
+            PERF_ADD(dest->buckets[op][b], atomic_load_explicit(&src->buckets[op][b], memory_order_relaxed));
+    }
+}
+
+PerfThread *perfThreadRegister(void)
+{
+    lockPerf();
+    PerfThread *block = freeBlocks;
+    if (block != NULL)
+        freeBlocks = block->next;
+    else
+        block = (PerfThread *)calloc(1, sizeof(PerfThread));
+    if (block != NULL)
+    {
+        block->next = activeThreads;
+        activeThreads = block;
+    }
+    unlockPerf();
+    perfSelf = block;
+    return block;
+}
+
+void perfThreadExit(void)
+{
+    PerfThread *self = perfSelf;
+    if (self == NULL)
+        return;
+    lockPerf();
+    addBlock(&retired, self);
+    clearBlock(self);
+    for (PerfThread **link = &activeThreads; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == self)
+        {
+            *link = self->next;
+            break;
+        }
+    }
+    self->next = freeBlocks;
+    freeBlocks = self;
+    unlockPerf();
+    perfSelf = NULL;
+}
+
+int perfEnabled(void)
+{
+#ifdef SCHEDULER_PERF
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void perfReset(void)
+{
+    lockPerf();
+    clearBlock(&retired);
+    for (PerfThread *block = activeThreads; block != NULL; block = block->next)
+        clearBlock(block);
+    unlockPerf();
+}
+
+// Cycle counter ticks per microsecond, measured once
+static double ticksPerMicro(void)
+{
+    static double rate;
+    if (rate == 0.0)
+    {
+        double startMicros = monotonicMicros();
+        unsigned long long startTicks = perfTicks();
+        sleepMillis(20);
+        rate = (double)(perfTicks() - startTicks) / (monotonicMicros() - startMicros);
+        if (rate <= 0.0)
+            rate = 1.0;
+    }
+    return rate;
+}
+
+// Upper bound (in microseconds) of the bucket holding the given fraction of calls
+static double histogramPercentile(const unsigned long long *buckets, unsigned long long calls, double fraction, double rate)
+{
+    unsigned long long target = (unsigned long long)(calls * fraction + 0.5), seen = 0;
+    for (int b = 0; b < PERF_BUCKETS; b++)
+    {
+        seen += buckets[b];
+        if (seen >= target && seen > 0)
+            return (double)(1ULL << b) / rate;
+    }
+    return 0.0;
+}
+
+int perfWriteReport(FILE *fp)
+{
+    PerfThread total;
+    memset(&total, 0, sizeof(total));
+    lockPerf();
+    addBlock(&total, &retired);
+    for (PerfThread *block = activeThreads; block != NULL; block = block->next)
+        addBlock(&total, block);
+    unlockPerf();
+    double rate = ticksPerMicro();
+
+    fprintf(fp, "PERFORMANCE REPORT (percentiles are histogram bucket bounds)\n");
+    fprintf(fp, "%-13s %10s %12s %10s %10s %10s\n", "Operation", "Calls", "Total ms", "Mean us", "p50 us", "p99 us");
+    for (int op = 0; op < PERF_OP_COUNT; op++)
+    {
+        unsigned long long calls = atomic_load(&total.calls[op]);
+        if (calls == 0)
+            continue;
+        unsigned long long buckets[PERF_BUCKETS];
+        for (int b = 0; b < PERF_BUCKETS; b++)
+            buckets[b] = atomic_load(&total.buckets[op][b]);
+        double micros = (double)atomic_load(&total.ticks[op]) / rate;
+        fprintf(fp, "%-13s %10llu %12.3f %10.3f %10.3f %10.3f\n", PERF_OP_NAMES[op], calls, micros / 1000.0,
+                micros / calls, histogramPercentile(buckets, calls, 0.5, rate),
+                histogramPercentile(buckets, calls, 0.99, rate));
+    }
+
+    fprintf(fp, "\nLATENCY HISTOGRAMS (calls below each bound in us)\n");
+    for (int op = 0; op < PERF_OP_COUNT; op++)
+    {
+        if (atomic_load(&total.calls[op]) == 0)
+            continue;
+        fprintf(fp, "%-13s", PERF_OP_NAMES[op]);
+        for (int b = 0; b < PERF_BUCKETS; b++)
+        {
+            unsigned long long count = atomic_load(&total.buckets[op][b]);
+            if (count > 0)
+                fprintf(fp, " <%.3g:%llu", (double)(1ULL << b) / rate, count);
+        }
+        fprintf(fp, "\n");
+    }
+    return ferror(fp) ? -1 : 0;
+}
+
+int perfDump(const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return -1;
+    int status = perfWriteReport(fp);
+    if (fclose(fp) != 0)
+        status = -1;
+    return status;
+}
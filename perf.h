@@ -0,0 +1,99 @@
+// Hot-path instrumentation for the scheduler library.
+//
+// Build with -DSCHEDULER_PERF to record, for every core operation, the number of
+// calls, the total time and a histogram of latencies in power-of-two buckets.
+// Without it PERF_START/PERF_STOP compile to nothing. Counters live in a block
+// owned by the calling thread, so recording is two cycle-counter reads and a few
+// uncontended stores; reports add the blocks of all threads together.
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "platform.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PERF_THREAD_LOCAL __declspec(thread)
+static inline unsigned long long perfTicks(void) { return __rdtsc(); }
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PERF_THREAD_LOCAL _Thread_local
+static inline unsigned long long perfTicks(void) { return __rdtsc(); }
+#else
+#define PERF_THREAD_LOCAL _Thread_local
+static inline unsigned long long perfTicks(void) { return (unsigned long long)(monotonicMicros() * 1000.0); }
+#endif
+
+// Instrumented operations
+#define PERF_LOOKUP 0
+#define PERF_INSERT 1
+#define PERF_SWAP 2
+#define PERF_MOVE 3
+#define PERF_ASSIGN 4
+#define PERF_UNDO 5
+#define PERF_COMMIT 6
+#define PERF_SEARCH 7
+#define PERF_TEACHER_LOAD 8
+#define PERF_STATISTICS 9
+#define PERF_SAVE 10
+#define PERF_LOAD 11
+#define PERF_OP_COUNT 12
+
+#define PERF_BUCKETS 48 // bucket b holds latencies below 2^b ticks
+
+typedef struct PerfThread
+{
+    atomic_ullong calls[PERF_OP_COUNT];
+    atomic_ullong ticks[PERF_OP_COUNT];
+    atomic_ullong buckets[PERF_OP_COUNT][PERF_BUCKETS];
+    struct PerfThread *next;
+} PerfThread;
+
+extern PERF_THREAD_LOCAL PerfThread *perfSelf;
+PerfThread *perfThreadRegister(void);
+
+// Only the owning thread writes its counters, so a relaxed load and store is enough
+#define PERF_ADD(counter, value) \
+    atomic_store_explicit(&(counter), atomic_load_explicit(&(counter), memory_order_relaxed) + (value), memory_order_relaxed)
+
+static inline int perfBucket(unsigned long long ticks)
+{
+#if defined(__GNUC__)
+    int bucket = ticks != 0 ? 64 - __builtin_clzll(ticks) : 0;
+#else
+    int bucket = 0;
+    for (; ticks != 0; ticks >>= 1)
+        bucket++;
+#endif
+    return bucket < PERF_BUCKETS ? bucket : PERF_BUCKETS - 1;
+}
+
+static inline void perfRecord(int op, unsigned long long ticks)
+{
+    PerfThread *self = perfSelf != NULL ? perfSelf : perfThreadRegister();
+    if (self == NULL)
+        return;
+    PERF_ADD(self->calls[op], 1);
+    PERF_ADD(self->ticks[op], ticks);
+    PERF_ADD(self->buckets[op][perfBucket(ticks)], 1);
+}
+
+#ifdef SCHEDULER_PERF
+#define PERF_START(name) unsigned long long name = perfTicks()
+#define PERF_STOP(op, name) perfRecord(op, perfTicks() - (name))
+#else
+#define PERF_START(name) ((void)0)
+#define PERF_STOP(op, name) ((void)0)
+#endif
+
+// 1 when the library was built with SCHEDULER_PERF
+int perfEnabled(void);
+// Hand the calling thread's counters back before the thread exits
+void perfThreadExit(void);
+void perfReset(void);
+// Human readable report: per operation calls, total, mean, p50/p99 and a histogram
+int perfWriteReport(FILE *fp);
+int perfDump(const char *filename);
+
+#endif
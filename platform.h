@@ -0,0 +1,227 @@
+// Small portability layer shared by the scheduler library and its clients:
+// reader/writer locks, mutexes, condition variables, threads and a monotonic clock
+// for Windows and POSIX.
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+typedef SRWLOCK RWLock;
+typedef CRITICAL_SECTION Mutex;
+
+static inline void rwlockInit(RWLock *lock) { InitializeSRWLock(lock); }
+static inline void rwlockDestroy(RWLock *lock) { (void)lock; }
+static inline void rwlockRead(RWLock *lock) { AcquireSRWLockShared(lock); }
+static inline void rwlockReadUnlock(RWLock *lock) { ReleaseSRWLockShared(lock); }
+static inline void rwlockWrite(RWLock *lock) { AcquireSRWLockExclusive(lock); }
+static inline void rwlockWriteUnlock(RWLock *lock) { ReleaseSRWLockExclusive(lock); }
+
+static inline void mutexInit(Mutex *m) { InitializeCriticalSection(m); }
+static inline void mutexDestroy(Mutex *m) { DeleteCriticalSection(m); }
+static inline void mutexLock(Mutex *m) { EnterCriticalSection(m); }
+static inline void mutexUnlock(Mutex *m) { LeaveCriticalSection(m); }
+#else
+typedef pthread_rwlock_t RWLock;
+typedef pthread_mutex_t Mutex;
+
+static inline void rwlockInit(RWLock *lock) { pthread_rwlock_init(lock, NULL); }
+static inline void rwlockDestroy(RWLock *lock) { pthread_rwlock_destroy(lock); }
+static inline void rwlockRead(RWLock *lock) { pthread_rwlock_rdlock(lock); }
+static inline void rwlockReadUnlock(RWLock *lock) { pthread_rwlock_unlock(lock); }
+static inline void rwlockWrite(RWLock *lock) { pthread_rwlock_wrlock(lock); }
+static inline void rwlockWriteUnlock(RWLock *lock) { pthread_rwlock_unlock(lock); }
+
+static inline void mutexInit(Mutex *m) { pthread_mutex_init(m, NULL); }
+static inline void mutexDestroy(Mutex *m) { pthread_mutex_destroy(m); }
+static inline void mutexLock(Mutex *m) { pthread_mutex_lock(m); }
+static inline void mutexUnlock(Mutex *m) { pthread_mutex_unlock(m); }
+#endif
+
+// Condition variables, used with a Mutex. condWait releases the mutex while it waits
+// and holds it again on return; it returns on a signal, after millis milliseconds
+// (never when millis is negative) or spuriously, so callers recheck their condition.
+#ifdef _WIN32
+typedef CONDITION_VARIABLE CondVar;
+
+static inline void condInit(CondVar *cond) { InitializeConditionVariable(cond); }
+static inline void condDestroy(CondVar *cond) { (void)cond; }
+static inline void condSignal(CondVar *cond) { WakeConditionVariable(cond); }
+static inline void condWait(CondVar *cond, Mutex *m, long millis)
+{
+    SleepConditionVariableCS(cond, m, millis < 0 ? INFINITE : (DWORD)millis);
+}
+#else
+typedef pthread_cond_t CondVar;
+
+static inline void condInit(CondVar *cond) { pthread_cond_init(cond, NULL); }
+static inline void condDestroy(CondVar *cond) { pthread_cond_destroy(cond); }
+static inline void condSignal(CondVar *cond) { pthread_cond_signal(cond); }
+static inline void condWait(CondVar *cond, Mutex *m, long millis)
+{
+    if (millis < 0)
+    {
+        pthread_cond_wait(cond, m);
+        return;
+    }
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += millis / 1000;
+    until.tv_nsec += (millis % 1000) * 1000000L;
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(cond, m, &until);
+}
+#endif
+
+// Threads: fn runs on a new thread with arg, threads are joined or detached by the caller
+typedef void (*ThreadFunc)(void *arg);
+
+typedef struct
+{
+    ThreadFunc fn;
+    void *arg;
+} ThreadStartArgs;
+
+#ifdef _WIN32
+typedef HANDLE Thread;
+
+static inline DWORD WINAPI threadTrampoline(LPVOID param)
+{
+    ThreadStartArgs start = *(ThreadStartArgs *)param;
+    free(param);
+    start.fn(start.arg);
+    return 0;
+}
+#else
+typedef pthread_t Thread;
+
+static inline void *threadTrampoline(void *param)
+{
+    ThreadStartArgs start = *(ThreadStartArgs *)param;
+    free(param);
+    start.fn(start.arg);
+    return NULL;
+}
+#endif
+
+// Returns 0 on success
+static inline int threadStart(Thread *thread, ThreadFunc fn, void *arg)
+{
+    ThreadStartArgs *start = (ThreadStartArgs *)malloc(sizeof(ThreadStartArgs));
+    if (start == NULL)
+        return -1;
+    start->fn = fn;
+    start->arg = arg;
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, threadTrampoline, start, 0, NULL);
+    if (*thread == NULL)
+#else
+    if (pthread_create(thread, NULL, threadTrampoline, start) != 0)
+#endif
+    {
+        free(start);
+        return -1;
+    }
+    return 0;
+}
+
+static inline void threadJoin(Thread thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static inline void threadDetach(Thread thread)
+{
+#ifdef _WIN32
+    CloseHandle(thread);
+#else
+    pthread_detach(thread);
+#endif
+}
+
+static inline void sleepMillis(int millis)
+{
+#ifdef _WIN32
+    Sleep(millis);
+#else
+    usleep(millis * 1000);
+#endif
+}
+
+// Processors online, at least 1
+static inline int cpuCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+// Create a directory; returns 0 if it was created or already exists
+static inline int makeDirectory(const char *path)
+{
+#ifdef _WIN32
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS ? 0 : -1;
+#else
+    return mkdir(path, 0777) == 0 || errno == EEXIST ? 0 : -1;
+#endif
+}
+
+// Thread-safe localtime: fills out and returns it
+static inline struct tm *localTime(const time_t *when, struct tm *out)
+{
+#ifdef _WIN32
+    return localtime_s(out, when) == 0 ? out : NULL;
+#else
+    return localtime_r(when, out);
+#endif
+}
+
+// Thread-safe gmtime: fills out and returns it
+static inline struct tm *utcTime(const time_t *when, struct tm *out)
+{
+#ifdef _WIN32
+    return gmtime_s(out, when) == 0 ? out : NULL;
+#else
+    return gmtime_r(when, out);
+#endif
+}
+
+// Monotonic clock in microseconds (used for timing, never for wall-clock dates)
+static inline double monotonicMicros(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+#endif
+}
+
+#endif
@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qrcode.h"
+
+#define MAX_CODEWORDS 3706 // raw codewords of version 40
+#define MAX_BLOCK_ECC 30
+
+// Error correction codewords per block and number of blocks, by level and version
+static const signed char ECC_PER_BLOCK[4][41] = {
+    {-1, 7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28,
+     28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26,
+     26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28},
+    {-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30,
+     28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+    {-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28,
+     30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},
+};
+static const signed char BLOCKS[4][41] = {
+    {-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8,
+     8, 9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},
+    {-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5, 5, 8, 9, 9, 10, 10, 11, 13, 14, 16,
+     17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49},
+    {-1, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8, 8, 10, 12, 16, 12, 17, 16, 18, 21, 20,
+     23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68},
+    {-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25,
+     25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81},
+};
+static const int FORMAT_ECC_BITS[4] = {1, 0, 3, 2}; // L, M, Q, H as the format field writes them
+
+// Modules left for data and error correction once the function patterns are drawn
+static int rawDataModules(int version)
+{
+    int modules = (16 * version + 128) * version + 64;
+    if (version >= 2)
+    {
+        int align = version / 7 + 2;
+        modules -= (25 * align - 10) * align - 55;
+        if (version >= 7)
+            modules -= 36;
+    }
+    return modules;
+}
+
+static int dataCodewords(int version, QrEcc ecc)
+{
+    return rawDataModules(version) / 8 - ECC_PER_BLOCK[ecc][version] * BLOCKS[ecc][version];
+}
+
+// GF(256) with the QR polynomial x^8 + x^4 + x^3 + x^2 + 1
+static unsigned char gfMultiply(unsigned char x, unsigned char y)
+{
+    int z = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+    }
+    return (unsigned char)z;
+}
+
+// Generator polynomial of degree n, leading 1 left out, highest power first
+static void rsDivisor(int n, unsigned char divisor[])
+{
+    memset(divisor, 0, (size_t)n);
+    divisor[n - 1] = 1;
+    unsigned char root = 1;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            divisor[j] = gfMultiply(divisor[j], root);
+            if (j + 1 < n)
+                divisor[j] ^= divisor[j + 1];
+        }
+        root = gfMultiply(root, 0x02);
+    }
+}
+
+static void rsRemainder(const unsigned char data[], int length, const unsigned char divisor[], int n,
+                        unsigned char remainder[])
+{
+    memset(remainder, 0, (size_t)n);
+    for (int i = 0; i < length; i++)
+    {
+        unsigned char factor = data[i] ^ remainder[0];
+        memmove(remainder, remainder + 1, (size_t)n - 1);
+        remainder[n - 1] = 0;
+        for (int j = 0; j < n; j++)
+            remainder[j] ^= gfMultiply(divisor[j], factor);
+    }
+}
+
+// Data codewords into the interleaved sequence of data and error correction codewords
+static int addEcc(const unsigned char data[], int version, QrEcc ecc, unsigned char out[])
+{
+    int blocks = BLOCKS[ecc][version], blockEcc = ECC_PER_BLOCK[ecc][version];
+    int raw = rawDataModules(version) / 8;
+    int shortBlocks = blocks - raw % blocks, shortLength = raw / blocks;
+    unsigned char divisor[MAX_BLOCK_ECC], remainder[MAX_BLOCK_ECC];
+    rsDivisor(blockEcc, divisor);
+    // Codeword j of every block in turn; the short blocks come first and have no
+    // last data codeword, so that column holds only the long blocks
+    int shortData = shortLength - blockEcc, dataTotal = dataCodewords(version, ecc);
+    int start = 0, length = 0;
+    for (int i = 0; i < blocks; i++)
+    {
+        int dataLength = shortData + (i < shortBlocks ? 0 : 1);
+        rsRemainder(data + start, dataLength, divisor, blockEcc, remainder);
+        for (int j = 0; j < dataLength; j++)
+            out[j * blocks + i - (j == shortData ? shortBlocks : 0)] = data[start + j];
+        for (int j = 0; j < blockEcc; j++)
+            out[dataTotal + j * blocks + i] = remainder[j];
+        start += dataLength;
+        length += dataLength + blockEcc;
+    }
+    return length;
+}
+
+typedef struct
+{
+    QrCode *qr;
+    unsigned char function[QR_MAX_SIZE * QR_MAX_SIZE]; // modules data may not use
+} Canvas;
+
+static void setFunction(Canvas *canvas, int x, int y, int dark)
+{
+    int at = y * canvas->qr->size + x;
+    canvas->qr->modules[at] = (unsigned char)dark;
+    canvas->function[at] = 1;
+}
+
+// Finder pattern with its separator, centred on x, y
+static void drawFinder(Canvas *canvas, int x, int y)
+{
+    int size = canvas->qr->size;
+    for (int dy = -4; dy <= 4; dy++)
+    {
+        for (int dx = -4; dx <= 4; dx++)
+        {
+            int distance = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+            if (x + dx >= 0 && x + dx < size && y + dy >= 0 && y + dy < size)
+                setFunction(canvas, x + dx, y + dy, distance != 2 && distance != 4);
+        }
+    }
+}
+
+static void drawAlignment(Canvas *canvas, int x, int y)
+{
+    for (int dy = -2; dy <= 2; dy++)
+    {
+        for (int dx = -2; dx <= 2; dx++)
+            setFunction(canvas, x + dx, y + dy, (abs(dx) > abs(dy) ? abs(dx) : abs(dy)) != 1);
+    }
+}
+
+// Both copies of the 15-bit format field (level and mask, BCH coded), plus the
+// module that is always dark
+static void drawFormat(Canvas *canvas, int mask)
+{
+    QrCode *qr = canvas->qr;
+    int data = FORMAT_ECC_BITS[qr->ecc] << 3 | mask;
+    int remainder = data;
+    for (int i = 0; i < 10; i++)
+        remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    int bits = (data << 10 | remainder) ^ 0x5412;
+    for (int i = 0; i <= 5; i++)
+        setFunction(canvas, 8, i, (bits >> i) & 1);
+    setFunction(canvas, 8, 7, (bits >> 6) & 1);
+    setFunction(canvas, 8, 8, (bits >> 7) & 1);
+    setFunction(canvas, 7, 8, (bits >> 8) & 1);
+    for (int i = 9; i < 15; i++)
+        setFunction(canvas, 14 - i, 8, (bits >> i) & 1);
+    for (int i = 0; i < 8; i++)
+        setFunction(canvas, qr->size - 1 - i, 8, (bits >> i) & 1);
+    for (int i = 8; i < 15; i++)
+        setFunction(canvas, 8, qr->size - 15 + i, (bits >> i) & 1);
+    setFunction(canvas, 8, qr->size - 8, 1);
+}
+
+// Finder, timing and alignment patterns and the version field; the format field
+// is reserved here and written once the mask is known
+static void drawFunctionPatterns(Canvas *canvas)
+{
+    QrCode *qr = canvas->qr;
+    int size = qr->size;
+    for (int i = 0; i < size; i++)
+    {
+        setFunction(canvas, 6, i, i % 2 == 0);
+        setFunction(canvas, i, 6, i % 2 == 0);
+    }
+    drawFinder(canvas, 3, 3);
+    drawFinder(canvas, size - 4, 3);
+    drawFinder(canvas, 3, size - 4);
+
+    if (qr->version > 1)
+    {
+        int count = qr->version / 7 + 2;
+        int step = qr->version == 32 ? 26 : (qr->version * 4 + count * 2 + 1) / (count * 2 - 2) * 2;
+        int positions[7];
+        positions[0] = 6;
+        for (int i = count - 1, position = size - 7; i >= 1; i--, position -= step)
+            positions[i] = position;
+        for (int i = 0; i < count; i++)
+        {
+            for (int j = 0; j < count; j++)
+            {
+                int onFinder = (i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0);
+                if (!onFinder)
+                    drawAlignment(canvas, positions[i], positions[j]);
+            }
+        }
+    }
+
+    drawFormat(canvas, 0);
+    if (qr->version >= 7)
+    {
+        int remainder = qr->version;
+        for (int i = 0; i < 12; i++)
+            remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+        long bits = (long)qr->version << 12 | remainder;
+        for (int i = 0; i < 18; i++)
+        {
+            int a = size - 11 + i % 3, b = i / 3;
+            setFunction(canvas, a, b, (bits >> i) & 1);
+            setFunction(canvas, b, a, (bits >> i) & 1);
+        }
+    }
+}
+
+// Codewords into the free modules, two columns at a time from the bottom right,
+// up and down in turn
+static void drawCodewords(Canvas *canvas, const unsigned char codewords[], int count)
+{
+    QrCode *qr = canvas->qr;
+    int size = qr->size, bit = 0;
+    for (int right = size - 1; right >= 1; right -= 2)
+    {
+        if (right == 6)
+            right = 5; // skip the vertical timing pattern
+        for (int vertical = 0; vertical < size; vertical++)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                int x = right - j;
+                int upward = ((right + 1) & 2) == 0;
+                int y = upward ? size - 1 - vertical : vertical;
+                if (!canvas->function[y * size + x] && bit < count * 8)
+                {
+                    qr->modules[y * size + x] = (codewords[bit >> 3] >> (7 - (bit & 7))) & 1;
+                    bit++;
+                }
+            }
+        }
+    }
+}
+
+static int maskBit(int mask, int x, int y)
+{
+    switch (mask)
+    {
+    case 0:
+        return (x + y) % 2 == 0;
+    case 1:
+        return y % 2 == 0;
+    case 2:
+        return x % 3 == 0;
+    case 3:
+        return (x + y) % 3 == 0;
+    case 4:
+        return (x / 3 + y / 2) % 2 == 0;
+    case 5:
+        return x * y % 2 + x * y % 3 == 0;
+    case 6:
+        return (x * y % 2 + x * y % 3) % 2 == 0;
+    default:
+        return ((x + y) % 2 + x * y % 3) % 2 == 0;
+    }
+}
+
+// Flip the data modules under a mask; applying it twice undoes it
+static void applyMask(Canvas *canvas, int mask)
+{
+    int size = canvas->qr->size;
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            if (!canvas->function[y * size + x])
+                canvas->qr->modules[y * size + x] ^= (unsigned char)maskBit(mask, x, y);
+        }
+    }
+}
+
+// Penalty of one row or column: runs of five or more alike, and 1:1:3:1:1 finder
+// lookalikes with four light modules on either side (light beyond the edge)
+static long linePenalty(const QrCode *qr, int index, int vertical)
+{
+    static const unsigned char FINDER[7] = {1, 0, 1, 1, 1, 0, 1};
+    int size = qr->size;
+    long penalty = 0;
+    int run = 0, previous = -1;
+    for (int i = 0; i < size; i++)
+    {
+        int dark = vertical ? qr->modules[i * size + index] : qr->modules[index * size + i];
+        if (dark == previous)
+            run++;
+        else
+        {
+            if (run >= 5)
+                penalty += 3 + run - 5;
+            run = 1;
+            previous = dark;
+        }
+        if (i + 7 > size)
+            continue;
+        int match = 1;
+        for (int k = 0; k < 7 && match; k++)
+        {
+            int at = i + k;
+            match = (vertical ? qr->modules[at * size + index] : qr->modules[index * size + at]) == FINDER[k];
+        }
+        if (!match)
+            continue;
+        int lightBefore = 1, lightAfter = 1;
+        for (int k = 1; k <= 4; k++)
+        {
+            int before = i - k, after = i + 6 + k;
+            if (before >= 0 && (vertical ? qr->modules[before * size + index] : qr->modules[index * size + before]))
+                lightBefore = 0;
+            if (after < size && (vertical ? qr->modules[after * size + index] : qr->modules[index * size + after]))
+                lightAfter = 0;
+        }
+        penalty += 40 * (lightBefore + lightAfter);
+    }
+    if (run >= 5)
+        penalty += 3 + run - 5;
+    return penalty;
+}
+
+static long penaltyScore(const QrCode *qr)
+{
+    int size = qr->size;
+    long penalty = 0;
+    int dark = 0;
+    for (int i = 0; i < size; i++)
+        penalty += linePenalty(qr, i, 0) + linePenalty(qr, i, 1);
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            const unsigned char *at = &qr->modules[y * size + x];
+            dark += *at;
+            if (x + 1 < size && y + 1 < size && at[0] == at[1] && at[0] == at[size] && at[0] == at[size + 1])
+                penalty += 3;
+        }
+    }
+    int total = size * size;
+    int deviation = abs(dark * 100 - total * 50); // from half dark, in hundredths of a module
+    penalty += 10 * (deviation / (total * 5));
+    return penalty;
+}
+
+int qrEncode(const void *data, int length, QrEcc ecc, QrCode *qr)
+{
+    int version = 1;
+    for (;; version++)
+    {
+        if (version > 40)
+            return -1;
+        int headerBits = 4 + (version < 10 ? 8 : 16);
+        if (length < (version < 10 ? 256 : 65536) && headerBits + 8 * length <= dataCodewords(version, ecc) * 8)
+            break;
+    }
+
+    // Byte mode segment, terminator, bit padding, then alternating pad codewords
+    int capacity = dataCodewords(version, ecc);
+    unsigned char codewords[MAX_CODEWORDS];
+    memset(codewords, 0, sizeof(codewords));
+    long bit = 0;
+#define PUT_BITS(value, count)                                                  \
+    for (int b_ = (count) - 1; b_ >= 0; b_--, bit++)                            \
+        codewords[bit >> 3] |= (unsigned char)((((value) >> b_) & 1) << (7 - (bit & 7)))
+    PUT_BITS(0x4, 4);
+    PUT_BITS(length, version < 10 ? 8 : 16);
+    for (int i = 0; i < length; i++)
+        PUT_BITS(((const unsigned char *)data)[i], 8);
+    int terminator = capacity * 8 - bit < 4 ? (int)(capacity * 8 - bit) : 4;
+    PUT_BITS(0, terminator);
+#undef PUT_BITS
+    int used = (int)((bit + 7) / 8);
+    for (int i = used, pad = 0xEC; i < capacity; i++, pad ^= 0xEC ^ 0x11)
+        codewords[i] = (unsigned char)pad;
+
+    unsigned char all[MAX_CODEWORDS];
+    int count = addEcc(codewords, version, ecc, all);
+
+    Canvas *canvas = (Canvas *)calloc(1, sizeof(Canvas));
+    if (canvas == NULL)
+        return -1;
+    canvas->qr = qr;
+    qr->version = version;
+    qr->size = 17 + 4 * version;
+    qr->ecc = ecc;
+    memset(qr->modules, 0, sizeof(qr->modules));
+    drawFunctionPatterns(canvas);
+    drawCodewords(canvas, all, count);
+
+    long best = -1;
+    for (int mask = 0; mask < 8; mask++)
+    {
+        applyMask(canvas, mask);
+        drawFormat(canvas, mask);
+        long penalty = penaltyScore(qr);
+        if (best < 0 || penalty < best)
+        {
+            best = penalty;
+            qr->mask = mask;
+        }
+        applyMask(canvas, mask);
+    }
+    applyMask(canvas, qr->mask);
+    drawFormat(canvas, qr->mask);
+    free(canvas);
+    return 0;
+}
+
+int qrModule(const QrCode *qr, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= qr->size || y >= qr->size)
+        return 0;
+    return qr->modules[y * qr->size + x];
+}
+
+void qrPrint(const QrCode *qr, FILE *fp)
+{
+    // Indexed by top and bottom module: none, lower, upper, full block
+    static const char *const HALVES[4] = {" ", "\xE2\x96\x84", "\xE2\x96\x80", "\xE2\x96\x88"};
+    for (int y = -QR_QUIET_ZONE; y < qr->size + QR_QUIET_ZONE; y += 2)
+    {
+        fputs("\033[30;47m", fp);
+        for (int x = -QR_QUIET_ZONE; x < qr->size + QR_QUIET_ZONE; x++)
+            fputs(HALVES[qrModule(qr, x, y) << 1 | qrModule(qr, x, y + 1)], fp);
+        fputs("\033[0m\n", fp);
+    }
+}
+
+int qrWriteSvg(const QrCode *qr, const char *filename, int moduleSize)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return -1;
+    int side = qr->size + 2 * QR_QUIET_ZONE;
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\" "
+                "shape-rendering=\"crispEdges\">\n<rect width=\"100%%\" height=\"100%%\" fill=\"#fff\"/>\n<path d=\"",
+            side * moduleSize, side * moduleSize, side, side);
+    for (int y = 0; y < qr->size; y++)
+    {
+        for (int x = 0; x < qr->size; x++)
+        {
+            // One path step per run of dark modules in a row
+            if (!qrModule(qr, x, y) || qrModule(qr, x - 1, y))
+                continue;
+            int run = 1;
+            while (qrModule(qr, x + run, y))
+                run++;
+            fprintf(fp, "M%d %dh%dv1h-%dz", x + QR_QUIET_ZONE, y + QR_QUIET_ZONE, run, run);
+        }
+    }
+    fputs("\" fill=\"#000\"/>\n</svg>\n", fp);
+    int failed = ferror(fp);
+    return fclose(fp) == 0 && !failed ? 0 : -1;
+}
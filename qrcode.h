@@ -0,0 +1,46 @@
+// QR codes (ISO/IEC 18004) encoded in-process, for sharing links without a web
+// service.
+//
+// Text is encoded in byte mode into the smallest version (1 to 40) that holds it at
+// the requested error correction level: Reed-Solomon codewords over GF(256) per
+// block, interleaved, placed in the zigzag order and masked with whichever of the
+// eight masks scores the lowest penalty. A link of a hundred characters encodes in
+// well under a millisecond.
+#ifndef QRCODE_H
+#define QRCODE_H
+
+#include <stdio.h>
+
+#define QR_MAX_SIZE 177 // modules per side of a version 40 code
+#define QR_QUIET_ZONE 4 // light modules around the code when it is drawn
+
+typedef enum
+{
+    QR_ECC_LOW,      // recovers about 7% of the codewords
+    QR_ECC_MEDIUM,   // 15%
+    QR_ECC_QUARTILE, // 25%
+    QR_ECC_HIGH      // 30%
+} QrEcc;
+
+typedef struct
+{
+    int version;
+    int size; // modules per side, 17 + 4 * version
+    QrEcc ecc;
+    int mask;
+    unsigned char modules[QR_MAX_SIZE * QR_MAX_SIZE]; // row by row, 1 for dark
+} QrCode;
+
+// Encode length bytes of data into qr; returns 0, or -1 if they do not fit a
+// version 40 code at that level
+int qrEncode(const void *data, int length, QrEcc ecc, QrCode *qr);
+// 1 if the module at column x, row y is dark; 0 outside the code
+int qrModule(const QrCode *qr, int x, int y);
+// Draw the code with half blocks, two rows per line, black on white whatever the
+// terminal's colours
+void qrPrint(const QrCode *qr, FILE *fp);
+// Write the code as an SVG image with moduleSize pixels per module; returns 0, or
+// -1 if the file could not be written
+int qrWriteSvg(const QrCode *qr, const char *filename, int moduleSize);
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reminder.h"
+#include "platform.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+#define MAX_WAIT_MILLIS 60000 // look at the clock again at least this often, in case it is set
+
+// A reminder slot; free slots are chained through nextFree
+typedef struct
+{
+    time_t due;
+    unsigned long long seq; // reminders due at the same time fire in the order added
+    unsigned int generation; // bumped when the slot is freed, so stale ids do not match
+    int heapIndex;           // position in the heap, -1 when the slot is free
+    int nextFree;
+    long long tag;
+    char text[REMINDER_TEXT_LEN];
+} ReminderNode;
+
+struct ReminderQueue
+{
+    Mutex lock;
+    CondVar wake; // signalled when an earlier reminder arrives or the queue stops
+    Thread thread;
+    int stopping;
+
+    ReminderNode *nodes;
+    int capacity; // slots in nodes and heap
+    int used;     // slots ever handed out, the rest of nodes is untouched
+    int freeList; // first free slot, -1 if none
+    int *heap;    // slot indexes, the earliest due first
+    int count;
+    unsigned long long nextSeq;
+
+    ReminderSink sink;
+    void *ctx;
+    long long delivered, failed;
+};
+
+static ReminderId makeId(const ReminderQueue *queue, int slot)
+{
+    return ((ReminderId)queue->nodes[slot].generation << 32) | (ReminderId)slot;
+}
+
+static int earlier(const ReminderQueue *queue, int a, int b)
+{
+    const ReminderNode *x = &queue->nodes[queue->heap[a]], *y = &queue->nodes[queue->heap[b]];
+    return x->due != y->due ? x->due < y->due : x->seq < y->seq;
+}
+
+static void heapSwap(ReminderQueue *queue, int a, int b)
+{
+    int slot = queue->heap[a];
+    queue->heap[a] = queue->heap[b];
+    queue->heap[b] = slot;
+    queue->nodes[queue->heap[a]].heapIndex = a;
+    queue->nodes[queue->heap[b]].heapIndex = b;
+}
+
+static void siftUp(ReminderQueue *queue, int i)
+{
+    while (i > 0 && earlier(queue, i, (i - 1) / 2))
+    {
+        heapSwap(queue, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void siftDown(ReminderQueue *queue, int i)
+{
+    for (;;)
+    {
+        int first = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < queue->count && earlier(queue, left, first))
+            first = left;
+        if (right < queue->count && earlier(queue, right, first))
+            first = right;
+        if (first == i)
+            return;
+        heapSwap(queue, i, first);
+        i = first;
+    }
+}
+
+// Take the reminder at heap position i out of the heap and free its slot
+static void removeAt(ReminderQueue *queue, int i)
+{
+    int slot = queue->heap[i];
+    queue->count--;
+    if (i != queue->count)
+    {
+        heapSwap(queue, i, queue->count);
+        siftDown(queue, i);
+        siftUp(queue, i);
+    }
+    ReminderNode *node = &queue->nodes[slot];
+    node->heapIndex = -1;
+    node->generation++;
+    node->nextFree = queue->freeList;
+    queue->freeList = slot;
+}
+
+static int grow(ReminderQueue *queue)
+{
+    int capacity = queue->capacity ? queue->capacity * 2 : 64;
+    ReminderNode *nodes = (ReminderNode *)realloc(queue->nodes, sizeof(ReminderNode) * capacity);
+    if (nodes != NULL)
+        queue->nodes = nodes;
+    int *heap = (int *)realloc(queue->heap, sizeof(int) * capacity);
+    if (heap != NULL)
+        queue->heap = heap;
+    if (nodes == NULL || heap == NULL)
+        return -1;
+    queue->capacity = capacity;
+    return 0;
+}
+
+static void reminderThread(void *arg)
+{
+    ReminderQueue *queue = (ReminderQueue *)arg;
+    mutexLock(&queue->lock);
+    while (!queue->stopping)
+    {
+        if (queue->count == 0)
+        {
+            condWait(&queue->wake, &queue->lock, -1);
+            continue;
+        }
+        ReminderNode *next = &queue->nodes[queue->heap[0]];
+        time_t now = time(NULL);
+        if (next->due > now)
+        {
+            double wait = difftime(next->due, now) * 1000.0;
+            condWait(&queue->wake, &queue->lock, wait < MAX_WAIT_MILLIS ? (long)wait : MAX_WAIT_MILLIS);
+            continue;
+        }
+        Reminder reminder;
+        reminder.id = makeId(queue, queue->heap[0]);
+        reminder.due = next->due;
+        reminder.tag = next->tag;
+        strcpy(reminder.text, next->text);
+        removeAt(queue, 0);
+        ReminderSink sink = queue->sink;
+        void *ctx = queue->ctx;
+        mutexUnlock(&queue->lock);
+        int status = sink(&reminder, ctx);
+        mutexLock(&queue->lock);
+        if (status == 0)
+            queue->delivered++;
+        else
+            queue->failed++;
+    }
+    mutexUnlock(&queue->lock);
+}
+
+ReminderQueue *reminderStart(ReminderSink sink, void *ctx)
+{
+    ReminderQueue *queue = (ReminderQueue *)calloc(1, sizeof(ReminderQueue));
+    if (queue == NULL)
+        return NULL;
+    mutexInit(&queue->lock);
+    condInit(&queue->wake);
+    queue->freeList = -1;
+    queue->sink = sink;
+    queue->ctx = ctx;
+    if (threadStart(&queue->thread, reminderThread, queue) != 0)
+    {
+        condDestroy(&queue->wake);
+        mutexDestroy(&queue->lock);
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void reminderStop(ReminderQueue *queue)
+{
+    if (queue == NULL)
+        return;
+    mutexLock(&queue->lock);
+    queue->stopping = 1;
+    condSignal(&queue->wake);
+    mutexUnlock(&queue->lock);
+    threadJoin(queue->thread);
+    condDestroy(&queue->wake);
+    mutexDestroy(&queue->lock);
+    free(queue->nodes);
+    free(queue->heap);
+    free(queue);
+}
+
+ReminderId reminderAdd(ReminderQueue *queue, time_t due, const char *text, long long tag)
+{
+    mutexLock(&queue->lock);
+    if (queue->freeList < 0 && queue->used == queue->capacity && grow(queue) != 0)
+    {
+        mutexUnlock(&queue->lock);
+        return -1;
+    }
+    int slot;
+    if (queue->freeList >= 0)
+    {
+        slot = queue->freeList;
+        queue->freeList = queue->nodes[slot].nextFree;
+    }
+    else
+    {
+        slot = queue->used++;
+        queue->nodes[slot].generation = 1;
+    }
+    ReminderNode *node = &queue->nodes[slot];
+    node->due = due;
+    node->seq = queue->nextSeq++;
+    node->tag = tag;
+    snprintf(node->text, sizeof(node->text), "%s", text);
+    node->heapIndex = queue->count;
+    queue->heap[queue->count++] = slot;
+    siftUp(queue, node->heapIndex);
+    if (node->heapIndex == 0)
+        condSignal(&queue->wake); // the thread may be sleeping until a later reminder
+    ReminderId id = makeId(queue, slot);
+    mutexUnlock(&queue->lock);
+    return id;
+}
+
+int reminderCancel(ReminderQueue *queue, ReminderId id)
+{
+    int slot = (int)(id & 0xffffffff);
+    unsigned int generation = (unsigned int)(id >> 32);
+    int status = -1;
+    mutexLock(&queue->lock);
+    if (id > 0 && slot < queue->used && queue->nodes[slot].generation == generation &&
+        queue->nodes[slot].heapIndex >= 0)
+    {
+        removeAt(queue, queue->nodes[slot].heapIndex);
+        status = 0;
+    }
+    mutexUnlock(&queue->lock);
+    return status;
+}
+
+void reminderStats(ReminderQueue *queue, ReminderStats *stats)
+{
+    mutexLock(&queue->lock);
+    stats->pending = queue->count;
+    stats->delivered = queue->delivered;
+    stats->failed = queue->failed;
+    mutexUnlock(&queue->lock);
+}
+
+int reminderStdoutSink(const Reminder *reminder, void *ctx)
+{
+    (void)ctx;
+    char clock[16];
+    struct tm due;
+    strftime(clock, sizeof(clock), "%H:%M", localTime(&reminder->due, &due));
+    printf("\n[Reminder %s] %s\n", clock, reminder->text);
+    return fflush(stdout) == 0 ? 0 : -1;
+}
+
+int reminderFileSink(const Reminder *reminder, void *ctx)
+{
+    FILE *fp = (FILE *)ctx;
+    char stamp[32];
+    struct tm due;
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localTime(&reminder->due, &due));
+    if (fprintf(fp, "%s\t%s\n", stamp, reminder->text) < 0)
+        return -1;
+    return fflush(fp) == 0 ? 0 : -1;
+}
+
+int reminderCommandSink(const Reminder *reminder, void *ctx)
+{
+    const char *command = (const char *)ctx;
+#ifdef _WIN32
+    // cmd.exe has no way to pass an argument untouched; keep quotes out of it
+    char text[REMINDER_TEXT_LEN + 2];
+    size_t len = 0;
+    text[len++] = '"';
+    for (const char *c = reminder->text; *c; c++)
+        text[len++] = *c == '"' ? '\'' : *c;
+    text[len++] = '"';
+    text[len] = '\0';
+    return _spawnlp(_P_WAIT, "cmd.exe", "cmd.exe", "/c", command, text, NULL) == 0 ? 0 : -1;
+#else
+    // The text goes in as $1, so the shell only ever parses the configured command
+    char script[512];
+    snprintf(script, sizeof(script), "%s \"$1\"", command);
+    char *argv[] = {"sh", "-c", script, "sh", (char *)reminder->text, NULL};
+    pid_t pid;
+    int status;
+    if (posix_spawnp(&pid, "sh", NULL, NULL, argv, environ) != 0 || waitpid(pid, &status, 0) < 0)
+        return -1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+#endif
+}
@@ -0,0 +1,57 @@
+// Reminders: short messages delivered at a wall-clock time by a background thread.
+//
+// Pending reminders sit in a binary min-heap ordered by due time, so adding or
+// cancelling one is O(log n) however many are waiting. The reminder thread sleeps
+// until the earliest is due or an earlier one is added, then hands each due
+// reminder to the queue's sink with the lock released: callers never wait for a
+// delivery and sinks may add or cancel reminders themselves. Sinks run on the
+// reminder thread, one reminder at a time.
+#ifndef REMINDER_H
+#define REMINDER_H
+
+#include <stdio.h>
+#include <time.h>
+
+#define REMINDER_TEXT_LEN 160
+
+typedef struct ReminderQueue ReminderQueue;
+typedef long long ReminderId; // positive; an id is never reused by the same queue
+
+typedef struct
+{
+    ReminderId id;
+    time_t due;
+    long long tag; // the caller's, passed through untouched
+    char text[REMINDER_TEXT_LEN];
+} Reminder;
+
+typedef struct
+{
+    int pending;
+    long long delivered;
+    long long failed; // deliveries the sink reported as failed
+} ReminderStats;
+
+// Delivers one reminder, returns 0 on success
+typedef int (*ReminderSink)(const Reminder *reminder, void *ctx);
+
+// Built-in sinks. Stdout ignores ctx; the file sink appends a line to the FILE *
+// in ctx; the command sink runs the command line in ctx with the text as one
+// extra argument (through the shell, the text itself is never interpreted).
+int reminderStdoutSink(const Reminder *reminder, void *ctx);
+int reminderFileSink(const Reminder *reminder, void *ctx);
+int reminderCommandSink(const Reminder *reminder, void *ctx);
+
+// Start a queue and its thread, NULL if either could not be created
+ReminderQueue *reminderStart(ReminderSink sink, void *ctx);
+// Stop the thread and free the queue; pending reminders are dropped. A delivery in
+// progress finishes first.
+void reminderStop(ReminderQueue *queue);
+// Queue text for due (a time already past fires at once); returns its id, or -1 if
+// out of memory. Longer texts are cut to REMINDER_TEXT_LEN - 1 characters.
+ReminderId reminderAdd(ReminderQueue *queue, time_t due, const char *text, long long tag);
+// Returns 0 if the reminder was pending, -1 if it already fired or was cancelled
+int reminderCancel(ReminderQueue *queue, ReminderId id);
+void reminderStats(ReminderQueue *queue, ReminderStats *stats);
+
+#endif
@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+#include "roomplan.h"
+#include "memstat.h"
+
+// A lecture of the day being planned
+typedef struct
+{
+    const Lecture *lec;
+    int sectionId;
+    int index;   // position in its day block
+    int first;   // first period it occupies
+    int length;  // periods it occupies
+    int room;    // its room before planning, -1 for none
+    int planned; // its room after planning
+    int fixed;   // keeps its room: not replanning and it has one
+    int lab;     // a lab session, which needs a lab
+} DayItem;
+
+// Lectures placed together, items[start] to items[start + size - 1]
+typedef struct
+{
+    int start;
+    int size;
+    int first;  // first period
+    int length; // periods
+} Meeting;
+
+typedef struct
+{
+    const TimetableVersion *version;
+    int roomCount;
+    int sectionCount;
+    int capacity[MAX_ROOMS];
+    int homeCount[MAX_ROOMS];                   // sections whose home room it is
+    signed char kind[MAX_ROOMS];                // 1 lab, 0 classroom, -1 not used yet
+    unsigned char load[MAX_ROOMS][MAX_PERIODS]; // lectures booked per period of the day
+    int *home;                                  // section id -> home room, -1 if none
+    int *last;                                  // section id -> room of its previous lecture today
+    DayItem *items;
+    Meeting *meetings;
+} Planner;
+
+// Free periods ("-" in the faculty field) hold no class, and lectures off the
+// calendar's periods cannot be booked
+static int needsRoom(const Lecture *lec)
+{
+    return lec->periods != 0 && strcmp(lec->faculty, "-") != 0;
+}
+
+// Only a teacher can hold several sections at once; lab groups ("Sec. A") are not teachers
+static int sameMeeting(const DayItem *a, const DayItem *b)
+{
+    return !a->fixed && !b->fixed && isTeacher(a->lec->faculty) && strcmp(a->lec->time, b->lec->time) == 0 &&
+           strcmp(a->lec->subject, b->lec->subject) == 0 && strcmp(a->lec->faculty, b->lec->faculty) == 0;
+}
+
+// By first period, then so the lectures of a combined lecture are adjacent
+static int compareItems(const void *a, const void *b)
+{
+    const DayItem *x = (const DayItem *)a, *y = (const DayItem *)b;
+    int order = x->first - y->first;
+    if (order == 0)
+        order = strcmp(x->lec->time, y->lec->time);
+    if (order == 0)
+        order = strcmp(x->lec->subject, y->lec->subject);
+    if (order == 0)
+        order = strcmp(x->lec->faculty, y->lec->faculty);
+    if (order == 0)
+        order = x->sectionId - y->sectionId;
+    return order;
+}
+
+// Back into block order, to follow each section through its day
+static int compareBlockOrder(const void *a, const void *b)
+{
+    const DayItem *x = (const DayItem *)a, *y = (const DayItem *)b;
+    return x->sectionId != y->sectionId ? x->sectionId - y->sectionId : x->index - y->index;
+}
+
+// Earlier start first; at the same start the larger and then the longer meeting,
+// which have the fewest rooms to choose from
+static int compareMeetings(const void *a, const void *b)
+{
+    const Meeting *x = (const Meeting *)a, *y = (const Meeting *)b;
+    if (x->first != y->first)
+        return x->first - y->first;
+    if (x->size != y->size)
+        return y->size - x->size;
+    if (x->length != y->length)
+        return y->length - x->length;
+    return x->start - y->start;
+}
+
+static int fits(const Planner *planner, int room, int lab, unsigned int periods, int size)
+{
+    if (room < 0 || planner->capacity[room] < size || (planner->kind[room] >= 0 && planner->kind[room] != lab))
+        return 0;
+    for (int p = 0; periods != 0; p++, periods >>= 1)
+    {
+        if ((periods & 1) && planner->load[room][p] + size > planner->capacity[room])
+            return 0;
+    }
+    return 1;
+}
+
+static void book(Planner *planner, int room, unsigned int periods, int size)
+{
+    for (int p = 0; periods != 0; p++, periods >>= 1)
+    {
+        if (periods & 1)
+            planner->load[room][p] += (unsigned char)size;
+    }
+}
+
+// Pick a room for a meeting, -1 if none has space
+static int chooseRoom(const Planner *planner, const Meeting *meeting)
+{
+    const DayItem *items = &planner->items[meeting->start];
+    unsigned int periods = items[0].lec->periods;
+    int lab = items[0].lab;
+    for (int i = 0; i < meeting->size; i++)
+    {
+        if (fits(planner, planner->last[items[i].sectionId], lab, periods, meeting->size))
+            return planner->last[items[i].sectionId];
+    }
+    for (int i = 0; i < meeting->size; i++)
+    {
+        if (fits(planner, planner->home[items[i].sectionId], lab, periods, meeting->size))
+            return planner->home[items[i].sectionId];
+    }
+    int best = -1;
+    for (int r = 0; r < planner->roomCount; r++)
+    {
+        if (!fits(planner, r, lab, periods, meeting->size))
+            continue;
+        if (best < 0 || planner->capacity[r] < planner->capacity[best] ||
+            (planner->capacity[r] == planner->capacity[best] && planner->homeCount[r] < planner->homeCount[best]))
+            best = r;
+    }
+    return best;
+}
+
+// Consecutive lectures of a section on a day in different rooms; items are in block order
+static int countRoomChanges(const DayItem *items, int count, int planned)
+{
+    int changes = 0;
+    for (int i = 1; i < count; i++)
+    {
+        int before = planned ? items[i - 1].planned : items[i - 1].room;
+        int after = planned ? items[i].planned : items[i].room;
+        if (items[i].sectionId == items[i - 1].sectionId && before >= 0 && after >= 0 && before != after)
+            changes++;
+    }
+    return changes;
+}
+
+static int roomOf(const Planner *planner, const Lecture *lec)
+{
+    int room = lec->room[0] ? roomTableFind(planner->version->roomTable, lec->room) : -1;
+    return room < planner->roomCount ? room : -1;
+}
+
+// The room each section spends most periods of the week in, and whether each room
+// is a lab: the kind of session it held most periods of
+static void surveyRooms(Planner *planner)
+{
+    int periods[MAX_ROOMS], labPeriods[MAX_ROOMS] = {0}, classPeriods[MAX_ROOMS] = {0};
+    for (int sid = 0; sid < planner->sectionCount; sid++)
+    {
+        memset(periods, 0, sizeof(int) * planner->roomCount);
+        int home = -1;
+        for (int d = 0; d < DAY_COUNT; d++)
+        {
+            const Block *block = versionBlock(planner->version, sid, d);
+            for (int i = 0; block != NULL && i < block->count; i++)
+            {
+                int room = roomOf(planner, &block->lectures[i]);
+                if (room < 0)
+                    continue;
+                int *kindPeriods = subjectIsLab(block->lectures[i].subject) ? labPeriods : classPeriods;
+                for (unsigned int mask = block->lectures[i].periods; mask != 0; mask &= mask - 1)
+                {
+                    periods[room]++;
+                    kindPeriods[room]++;
+                }
+                if (home < 0 || periods[room] > periods[home])
+                    home = room;
+            }
+        }
+        planner->home[sid] = home;
+        if (home >= 0)
+            planner->homeCount[home]++;
+    }
+    for (int r = 0; r < planner->roomCount; r++)
+        planner->kind[r] = labPeriods[r] + classPeriods[r] == 0 ? -1 : labPeriods[r] > classPeriods[r];
+}
+
+// Collect the day's lectures that need a room; fixed ones, and rooms held by
+// lectures that need none, are booked right away
+static int collectDay(Planner *planner, int day, int replan)
+{
+    int count = 0;
+    for (int sid = 0; sid < planner->sectionCount; sid++)
+    {
+        const Block *block = versionBlock(planner->version, sid, day);
+        for (int i = 0; block != NULL && i < block->count; i++)
+        {
+            const Lecture *lec = &block->lectures[i];
+            int room = roomOf(planner, lec);
+            if (!needsRoom(lec))
+            {
+                if (room >= 0)
+                    book(planner, room, lec->periods, 1);
+                continue;
+            }
+            DayItem *item = &planner->items[count++];
+            item->lec = lec;
+            item->sectionId = sid;
+            item->index = i;
+            item->first = 0;
+            while (!((lec->periods >> item->first) & 1))
+                item->first++;
+            item->length = 0;
+            for (unsigned int mask = lec->periods; mask != 0; mask &= mask - 1)
+                item->length++;
+            item->room = room;
+            item->lab = subjectIsLab(lec->subject);
+            item->fixed = !replan && item->room >= 0;
+            item->planned = item->fixed ? item->room : -1;
+            if (item->fixed)
+                book(planner, item->room, lec->periods, 1);
+        }
+    }
+    return count;
+}
+
+static int planDay(Planner *planner, int day, int replan, RoomMove moves[], int moveCount, RoomPlan *plan)
+{
+    memset(planner->load, 0, sizeof(planner->load));
+    for (int sid = 0; sid < planner->sectionCount; sid++)
+        planner->last[sid] = -1;
+    int count = collectDay(planner, day, replan);
+    qsort(planner->items, count, sizeof(DayItem), compareItems);
+
+    int meetingCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0 && sameMeeting(&planner->items[i - 1], &planner->items[i]))
+            planner->meetings[meetingCount - 1].size++;
+        else
+            planner->meetings[meetingCount++] = (Meeting){i, 1, planner->items[i].first, planner->items[i].length};
+    }
+    qsort(planner->meetings, meetingCount, sizeof(Meeting), compareMeetings);
+
+    for (int m = 0; m < meetingCount; m++)
+    {
+        Meeting *meeting = &planner->meetings[m];
+        DayItem *items = &planner->items[meeting->start];
+        int room = items[0].fixed ? items[0].room : chooseRoom(planner, meeting);
+        if (room >= 0 && !items[0].fixed)
+        {
+            book(planner, room, items[0].lec->periods, meeting->size);
+            if (planner->kind[room] < 0)
+                planner->kind[room] = (signed char)items[0].lab;
+        }
+        for (int i = 0; i < meeting->size; i++)
+        {
+            int sid = items[i].sectionId;
+            items[i].planned = room;
+            if (room < 0)
+                continue;
+            planner->last[sid] = room;
+            if (planner->home[sid] < 0 && !items[i].lab)
+            {
+                planner->home[sid] = room;
+                planner->homeCount[room]++;
+            }
+        }
+    }
+
+    qsort(planner->items, count, sizeof(DayItem), compareBlockOrder);
+    plan->lectures += count;
+    plan->roomChangesBefore += countRoomChanges(planner->items, count, 0);
+    plan->roomChanges += countRoomChanges(planner->items, count, 1);
+    for (int i = 0; i < count; i++)
+    {
+        DayItem *item = &planner->items[i];
+        if (item->planned >= 0)
+            plan->placed++;
+        if (item->planned != item->room)
+            moves[moveCount++] = (RoomMove){item->sectionId, day, item->index, item->planned};
+    }
+    return moveCount;
+}
+
+int planRooms(const TimetableVersion *version, int replan, RoomMove moves[], RoomPlan *plan)
+{
+    memset(plan, 0, sizeof(*plan));
+    int sectionCount = atomic_load(&version->sections->count);
+    int maxItems = version->count;
+    Planner *planner = (Planner *)memCalloc(MEM_JOURNAL, 1, sizeof(Planner));
+    int *sectionRooms = (int *)memAlloc(MEM_JOURNAL, sizeof(int) * 2 * (sectionCount + 1));
+    DayItem *items = (DayItem *)memAlloc(MEM_JOURNAL, sizeof(DayItem) * (maxItems + 1));
+    Meeting *meetings = (Meeting *)memAlloc(MEM_JOURNAL, sizeof(Meeting) * (maxItems + 1));
+    int moveCount = TT_ERR_NOMEM;
+    if (planner != NULL && sectionRooms != NULL && items != NULL && meetings != NULL)
+    {
+        planner->version = version;
+        planner->sectionCount = sectionCount;
+        planner->roomCount = atomic_load(&version->roomTable->count);
+        for (int r = 0; r < planner->roomCount; r++)
+            planner->capacity[r] = atomic_load(&version->roomTable->capacity[r]);
+        planner->home = sectionRooms;
+        planner->last = sectionRooms + sectionCount + 1;
+        planner->items = items;
+        planner->meetings = meetings;
+        surveyRooms(planner);
+        moveCount = 0;
+        for (int d = 0; d < DAY_COUNT; d++)
+            moveCount = planDay(planner, d, replan, moves, moveCount, plan);
+    }
+    memFree(MEM_JOURNAL, meetings, sizeof(Meeting) * (maxItems + 1));
+    memFree(MEM_JOURNAL, items, sizeof(DayItem) * (maxItems + 1));
+    memFree(MEM_JOURNAL, sectionRooms, sizeof(int) * 2 * (sectionCount + 1));
+    memFree(MEM_JOURNAL, planner, sizeof(Planner));
+    return moveCount;
+}
@@ -0,0 +1,37 @@
+// Room allocation, internal to the scheduler library.
+//
+// Rooms are planned one day at a time. A lecture occupies a run of consecutive
+// periods, so a day's lectures are intervals and giving them rooms is colouring an
+// interval graph, where a room of capacity c offers c colours. Lectures are placed
+// in order of their first period against a per-period load of every room, so a
+// room is free again as soon as the periods of its earlier lectures end. As with
+// the greedy colouring of interval graphs, a lecture then only goes without a room
+// when all places are taken at its first period.
+//
+// Among the rooms with space a lecture goes, in order of preference, to the room
+// its section had for its previous lecture of the day, to the section's home room
+// (where it spent most periods of the week before planning, or the first room it
+// is given), and otherwise to the smallest room that holds it, which keeps large
+// rooms free for combined lectures. A combined lecture, one teacher teaching the
+// same subject to several sections at once, is placed as a whole in one room.
+#ifndef ROOMPLAN_H
+#define ROOMPLAN_H
+
+#include "version.h"
+
+// A lecture whose room the plan changes
+typedef struct
+{
+    int sectionId;
+    int day;
+    int index;  // position in the section's day block
+    int roomId; // -1 to leave it without a room
+} RoomMove;
+
+// Plan rooms for the lectures of a version: every lecture when replan is set,
+// otherwise only those without a room, around the existing bookings. Fills plan
+// and returns the number of moves stored in moves, which has room for one per
+// lecture of the version, or TT_ERR_NOMEM.
+int planRooms(const TimetableVersion *version, int replan, RoomMove moves[], RoomPlan *plan);
+
+#endif
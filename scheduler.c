@@ -0,0 +1,2653 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+#include "scheduler.h"
+#include "version.h"
+#include "columns.h"
+#include "roomplan.h"
+#include "merge.h"
+#include "platform.h"
+#include "perf.h"
+#include "memstat.h"
+#include "trace.h"
+
+#define UNDO_DEPTH 100
+#define ROW_LINE_LEN 2048 // longest CSV or JSON line timetableReadRows accepts
+
+typedef struct RetiredCalendar
+{
+    Calendar *calendar;
+    struct RetiredCalendar *next;
+} RetiredCalendar;
+
+// An undoable edit; undoing it restores only the slots that differ between the two
+typedef struct
+{
+    TimetableVersion *before;
+    TimetableVersion *after;
+} UndoEntry;
+
+struct Timetable
+{
+    TimetableVersion *current; // the published version
+    SectionTable sections;
+    RoomTable rooms;
+    TeacherTable teachers;
+    unsigned long nextId;
+
+    // Stack for undo: the versions before and after each undoable edit
+    UndoEntry undo[UNDO_DEPTH];
+    int top;
+
+    Mutex writerLock; // serializes edits, held from draft to publish
+    RWLock lock;      // held only to pin or replace current
+
+    atomic_int columnar; // analytics scan column tables instead of lecture rows
+
+    _Atomic(Calendar *) calendar;
+    RetiredCalendar *retired; // replaced calendars, readers may still hold them
+};
+
+const char *const DAY_CODES[DAY_COUNT] = {"MON", "TUE", "WED", "THU", "FRI", "SAT"};
+const char *const DAY_NAMES[DAY_COUNT] = {"MONDAY", "TUESDAY", "WEDNESDAY", "THURSDAY", "FRIDAY", "SATURDAY"};
+
+static const SubjectInfo curriculum[] = {
+    {"TMC201", "Advanced Database Management Systems", 0},
+    {"TMC202", "Advanced Java Programming", 0},
+    {"TMC203", "Data Structures", 0},
+    {"TMC215", "DSE-II: Human-Computer Interaction", 0},
+    {"TMC221", "GE-I: Research Methodology", 0},
+    {"XMC201", "Career Skills-II", 0},
+    {"PMC201", "ADBMS Laboratory", 1},
+    {"PMC202", "Advanced Java Programming Lab", 1},
+    {"PMC203", "Data Structures Laboratory", 1},
+    {"GP201", "General Proficiency", 0},
+    {"PBL", "PROJECT BASED LEARNING", 0}};
+static const int CURRICULUM_SIZE = sizeof(curriculum) / sizeof(curriculum[0]);
+
+// Copy a string into a Lecture field, truncating instead of overflowing
+static void copyField(char *dest, const char *src)
+{
+    size_t len = strlen(src);
+    if (len >= MAX_LEN)
+        len = MAX_LEN - 1;
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+// Lab groups stand in the faculty field under their section's name ("Sec. A"),
+// they are not teachers
+static int isStudentGroup(const char *faculty)
+{
+    return strncmp(faculty, "Sec. ", 5) == 0;
+}
+
+// Free periods ("-"), lab groups and empty faculty fields are not teachers
+int isTeacher(const char *faculty)
+{
+    return faculty[0] != '\0' && strcmp(faculty, "-") != 0 && !isStudentGroup(faculty);
+}
+
+// Split the room off a legacy faculty such as "Sec. A (Lab 7)" when the lecture
+// names no room of its own
+static void splitLegacyRoom(Lecture *lec)
+{
+    size_t len = strlen(lec->faculty);
+    char *open = strrchr(lec->faculty, '(');
+    if (lec->room[0] != '\0' || len == 0 || lec->faculty[len - 1] != ')' || open == NULL || open == lec->faculty ||
+        open[-1] != ' ')
+        return;
+    size_t roomLen = lec->faculty + len - 1 - (open + 1);
+    if (roomLen == 0 || roomLen >= ROOM_NAME_LEN)
+        return;
+    memcpy(lec->room, open + 1, roomLen);
+    lec->room[roomLen] = '\0';
+    open[-1] = '\0';
+}
+
+// Copy a section name; one too long to be registered becomes "", which sectionTableAdd rejects
+static void copySection(char *dest, const char *src)
+{
+    size_t len = strlen(src);
+    if (len >= SECTION_NAME_LEN)
+        len = 0;
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+static void makeLecture(Lecture *lec, const char *day, const char *time, const char *subject, const char *faculty,
+                        const char *section)
+{
+    copyField(lec->day, day);
+    copyField(lec->time, time);
+    copyField(lec->subject, subject);
+    copyField(lec->faculty, faculty);
+    copySection(lec->section, section);
+    lec->room[0] = '\0';
+    lec->periods = 0;
+}
+
+// Periods of the current calendar a lecture time covers; the caller holds the writer lock
+static unsigned int lecturePeriods(Timetable *tt, int day, const char *time)
+{
+    return calendarPeriodMask(timetableCalendar(tt), day, time);
+}
+
+// Replace the published version; the previous one is returned to the caller
+static TimetableVersion *publish(Timetable *tt, TimetableVersion *version)
+{
+    rwlockWrite(&tt->lock);
+    TimetableVersion *old = tt->current;
+    tt->current = version;
+    rwlockWriteUnlock(&tt->lock);
+    return old;
+}
+
+static void releaseUndo(UndoEntry *entry)
+{
+    versionRelease(entry->before);
+    versionRelease(entry->after);
+}
+
+static void clearUndo(Timetable *tt)
+{
+    while (tt->top >= 0)
+        releaseUndo(&tt->undo[tt->top--]);
+}
+
+static void pushUndo(Timetable *tt, TimetableVersion *before, TimetableVersion *after)
+{
+    // Drop the oldest edit when the stack is full
+    if (tt->top == UNDO_DEPTH - 1)
+    {
+        releaseUndo(&tt->undo[0]);
+        memmove(&tt->undo[0], &tt->undo[1], sizeof(tt->undo[0]) * (UNDO_DEPTH - 1));
+        tt->top--;
+    }
+    versionRetain(after);
+    tt->top++;
+    tt->undo[tt->top].before = before;
+    tt->undo[tt->top].after = after;
+}
+
+// Start an edit: take the writer lock and return a draft of the current version
+static TimetableVersion *beginEdit(Timetable *tt)
+{
+    mutexLock(&tt->writerLock);
+    TimetableVersion *draft = versionCreateDraft(tt->current, ++tt->nextId);
+    if (draft == NULL)
+        mutexUnlock(&tt->writerLock);
+    return draft;
+}
+
+// Publish a finished draft, keeping the version it replaces for undo when asked
+static void commitEdit(Timetable *tt, TimetableVersion *draft, int undoable)
+{
+    TimetableVersion *old = publish(tt, draft);
+    if (undoable)
+        pushUndo(tt, old, draft);
+    else
+        versionRelease(old);
+    mutexUnlock(&tt->writerLock);
+}
+
+static void abortEdit(Timetable *tt, TimetableVersion *draft)
+{
+    versionRelease(draft);
+    mutexUnlock(&tt->writerLock);
+}
+
+// Index of a lecture at a slot in a version's day block, or -1
+static int findSlot(const TimetableVersion *version, int sectionId, int day, const char *time)
+{
+    return findInBlock(versionBlock(version, sectionId, day), time);
+}
+
+// The room goes with the subject: a lab moves with its lab
+static void swapContents(Lecture *lec1, Lecture *lec2, int swapTeacher)
+{
+    char tmp[MAX_LEN];
+    if (lec1 == lec2)
+        return;
+    strcpy(tmp, lec1->subject);
+    strcpy(lec1->subject, lec2->subject);
+    strcpy(lec2->subject, tmp);
+    strcpy(tmp, lec1->room);
+    strcpy(lec1->room, lec2->room);
+    strcpy(lec2->room, tmp);
+    if (swapTeacher)
+    {
+        strcpy(tmp, lec1->faculty);
+        strcpy(lec1->faculty, lec2->faculty);
+        strcpy(lec2->faculty, tmp);
+    }
+}
+
+#define NAME_TABLE_BYTES (sizeof(SectionTable) + sizeof(RoomTable) + sizeof(TeacherTable))
+
+Timetable *timetableCreate(void)
+{
+    Timetable *tt = (Timetable *)memCalloc(MEM_JOURNAL, 1, sizeof(Timetable));
+    if (tt == NULL)
+        return NULL;
+    // The handle is mostly undo stack; book its section, room and teacher tables separately
+    memAccount(MEM_JOURNAL, -(long long)NAME_TABLE_BYTES, 0);
+    memAccount(MEM_STRINGS, NAME_TABLE_BYTES, 1);
+    sectionTableInit(&tt->sections);
+    roomTableInit(&tt->rooms);
+    teacherTableInit(&tt->teachers);
+    Calendar *calendar = calendarCreateDefault();
+    tt->current = calendar != NULL ? versionCreateEmpty(&tt->sections, &tt->rooms, &tt->teachers, ++tt->nextId) : NULL;
+    if (tt->current == NULL)
+    {
+        calendarDestroy(calendar);
+        memAccount(MEM_STRINGS, -(long long)NAME_TABLE_BYTES, -1);
+        memAccount(MEM_JOURNAL, NAME_TABLE_BYTES, 0);
+        memFree(MEM_JOURNAL, tt, sizeof(Timetable));
+        return NULL;
+    }
+    tt->top = -1;
+    atomic_init(&tt->columnar, 1);
+    atomic_init(&tt->calendar, calendar);
+    mutexInit(&tt->writerLock);
+    rwlockInit(&tt->lock);
+    return tt;
+}
+
+void timetableDestroy(Timetable *tt)
+{
+    if (tt == NULL)
+        return;
+    clearUndo(tt);
+    versionRelease(tt->current);
+    mutexDestroy(&tt->writerLock);
+    rwlockDestroy(&tt->lock);
+    calendarDestroy(atomic_load(&tt->calendar));
+    while (tt->retired != NULL)
+    {
+        RetiredCalendar *next = tt->retired->next;
+        calendarDestroy(tt->retired->calendar);
+        memFree(MEM_STRINGS, tt->retired, sizeof(RetiredCalendar));
+        tt->retired = next;
+    }
+    memAccount(MEM_STRINGS, -(long long)NAME_TABLE_BYTES, -1);
+    memAccount(MEM_JOURNAL, NAME_TABLE_BYTES, 0);
+    memFree(MEM_JOURNAL, tt, sizeof(Timetable));
+}
+
+void timetableClear(Timetable *tt)
+{
+    mutexLock(&tt->writerLock);
+    TimetableVersion *empty = versionCreateEmpty(&tt->sections, &tt->rooms, &tt->teachers, ++tt->nextId);
+    if (empty != NULL)
+    {
+        versionRelease(publish(tt, empty));
+        clearUndo(tt);
+    }
+    mutexUnlock(&tt->writerLock);
+}
+
+const TimetableVersion *timetablePin(Timetable *tt)
+{
+    rwlockRead(&tt->lock);
+    TimetableVersion *version = tt->current;
+    versionRetain(version);
+    rwlockReadUnlock(&tt->lock);
+    return version;
+}
+
+void timetableUnpin(const TimetableVersion *version)
+{
+    versionRelease(version);
+}
+
+// Commit the draft when the edit succeeded, otherwise throw it away; returns status
+static int finishEdit(Timetable *tt, TimetableVersion *draft, int status, int undoable)
+{
+    if (status == TT_OK)
+        commitEdit(tt, draft, undoable);
+    else
+        abortEdit(tt, draft);
+    return status;
+}
+
+// checkRoom rejects a lecture its room cannot take right away; transactions leave
+// that to validation, as rooms may be freed by a later edit of the batch
+static int applyInsert(Timetable *tt, TimetableVersion *draft, const Lecture *lec, int checkRoom)
+{
+    int d = dayIndex(lec->day);
+    if (d < 0)
+        return TT_ERR_INVALID;
+    int sid = sectionTableAdd(&tt->sections, lec->section);
+    if (sid < 0)
+        return TT_ERR_INVALID;
+    Lecture placed = *lec;
+    placed.periods = lecturePeriods(tt, d, lec->time);
+    splitLegacyRoom(&placed);
+    if (placed.room[0] != '\0')
+    {
+        int roomId = roomTableAdd(&tt->rooms, placed.room, 1);
+        if (roomId < 0)
+            return TT_ERR_INVALID;
+        if (checkRoom && !versionRoomFits(draft, roomId, d, placed.periods))
+            return TT_ERR_OCCUPIED;
+    }
+    return draftInsert(draft, sid, d, &placed);
+}
+
+// Swap two lectures of a draft, moving their room bookings along with them
+static int swapBooked(TimetableVersion *draft, Lecture *a, int dayA, Lecture *b, int dayB, int swapTeacher)
+{
+    if (draftBook(draft, a, dayA, -1) != TT_OK || draftBook(draft, b, dayB, -1) != TT_OK)
+        return TT_ERR_NOMEM;
+    swapContents(a, b, swapTeacher);
+    if (draftBook(draft, a, dayA, 1) != TT_OK || draftBook(draft, b, dayB, 1) != TT_OK)
+        return TT_ERR_NOMEM;
+    return TT_OK;
+}
+
+static int applySwap(Timetable *tt, TimetableVersion *draft, const char *section1, const char *day1,
+                     const char *time1, const char *section2, const char *day2, const char *time2, int swapTeacher)
+{
+    int sid1 = sectionTableFind(&tt->sections, section1), d1 = dayIndex(day1);
+    int sid2 = sectionTableFind(&tt->sections, section2), d2 = dayIndex(day2);
+    if (findSlot(draft, sid1, d1, time1) < 0 || findSlot(draft, sid2, d2, time2) < 0)
+        return TT_ERR_NOT_FOUND;
+    Lecture *a = draftFind(draft, sid1, d1, time1);
+    Lecture *b = draftFind(draft, sid2, d2, time2);
+    if (a == NULL || b == NULL)
+        return TT_ERR_NOMEM;
+    return swapBooked(draft, a, d1, b, d2, swapTeacher);
+}
+
+static int applyMove(Timetable *tt, TimetableVersion *draft, const char *oldSection, const char *day, const char *time,
+                     const char *newSection)
+{
+    int d = dayIndex(day);
+    Lecture lec;
+    int status = draftRemove(draft, sectionTableFind(&tt->sections, oldSection), d, time, &lec);
+    if (status != TT_OK)
+        return status;
+    int sid = sectionTableAdd(&tt->sections, newSection);
+    copySection(lec.section, newSection);
+    return sid < 0 ? TT_ERR_INVALID : draftInsert(draft, sid, d, &lec);
+}
+
+// Put the lecture at a slot into a room ("" to release it), registering a new room
+static int applySetRoom(Timetable *tt, TimetableVersion *draft, const char *section, const char *day, const char *time,
+                        const char *room, int checkRoom)
+{
+    int d = dayIndex(day);
+    int sid = sectionTableFind(&tt->sections, section);
+    if (findSlot(draft, sid, d, time) < 0)
+        return TT_ERR_NOT_FOUND;
+    int roomId = room[0] != '\0' ? roomTableAdd(&tt->rooms, room, 1) : -1;
+    if (room[0] != '\0' && roomId < 0)
+        return TT_ERR_INVALID;
+    Lecture *lec = draftFind(draft, sid, d, time);
+    if (lec == NULL || draftBook(draft, lec, d, -1) != TT_OK)
+        return TT_ERR_NOMEM;
+    if (checkRoom && roomId >= 0 && !versionRoomFits(draft, roomId, d, lec->periods))
+        return TT_ERR_OCCUPIED;
+    strcpy(lec->room, room);
+    return draftBook(draft, lec, d, 1);
+}
+
+// Returns the number of slots updated or TT_ERR_NOMEM
+static int applyAssign(Timetable *tt, TimetableVersion *draft, const char *subject, const char *teacherName)
+{
+    int updated = 0;
+    int sectionCount = atomic_load(&tt->sections.count);
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        for (int d = 0; d < DAY_COUNT; d++)
+        {
+            const Block *shared = versionBlock(draft, sid, d);
+            int matches = 0;
+            for (int i = 0; shared != NULL && i < shared->count && !matches; i++)
+                matches = strcmp(shared->lectures[i].subject, subject) == 0;
+            if (!matches)
+                continue; // leave blocks without the subject shared
+
+            Block *block = draftBlock(draft, sid, d);
+            if (block == NULL)
+                return TT_ERR_NOMEM;
+            for (int i = 0; i < block->count; i++)
+            {
+                Lecture *lec = &block->lectures[i];
+                if (strcmp(lec->subject, subject) != 0)
+                    continue;
+                if (draftBook(draft, lec, d, -1) != TT_OK)
+                    return TT_ERR_NOMEM;
+                copyField(lec->faculty, teacherName);
+                if (draftBook(draft, lec, d, 1) != TT_OK)
+                    return TT_ERR_NOMEM;
+                updated++;
+            }
+        }
+    }
+    return updated;
+}
+
+// Register a section without giving it lectures, returns its id or TT_ERR_INVALID
+int timetableAddSection(Timetable *tt, const char *section)
+{
+    mutexLock(&tt->writerLock);
+    int id = sectionTableAdd(&tt->sections, section);
+    mutexUnlock(&tt->writerLock);
+    return id >= 0 ? id : TT_ERR_INVALID;
+}
+
+int timetableSectionCount(Timetable *tt)
+{
+    return atomic_load(&tt->sections.count);
+}
+
+const char *timetableSectionName(Timetable *tt, int sectionId)
+{
+    return sectionId >= 0 && sectionId < timetableSectionCount(tt) ? tt->sections.names[sectionId] : NULL;
+}
+
+int timetableSectionId(Timetable *tt, const char *section)
+{
+    return sectionTableFind(&tt->sections, section);
+}
+
+// Register a room or change its capacity, returns its id or TT_ERR_INVALID
+int timetableAddRoom(Timetable *tt, const char *room, int capacity)
+{
+    if (capacity < 1)
+        return TT_ERR_INVALID;
+    mutexLock(&tt->writerLock);
+    int id = roomTableAdd(&tt->rooms, room, capacity);
+    if (id >= 0)
+        atomic_store(&tt->rooms.capacity[id], capacity);
+    mutexUnlock(&tt->writerLock);
+    return id >= 0 ? id : TT_ERR_INVALID;
+}
+
+int timetableRoomCount(Timetable *tt)
+{
+    return atomic_load(&tt->rooms.count);
+}
+
+const char *timetableRoomName(Timetable *tt, int roomId)
+{
+    return roomId >= 0 && roomId < timetableRoomCount(tt) ? tt->rooms.names[roomId] : NULL;
+}
+
+int timetableRoomId(Timetable *tt, const char *room)
+{
+    return roomTableFind(&tt->rooms, room);
+}
+
+int timetableRoomCapacity(Timetable *tt, int roomId)
+{
+    return roomId >= 0 && roomId < timetableRoomCount(tt) ? atomic_load(&tt->rooms.capacity[roomId]) : 0;
+}
+
+// Insert a new lecture
+int timetableInsertLecture(Timetable *tt, const char *day, const char *time, const char *subject,
+                           const char *faculty, const char *section)
+{
+    Lecture lec;
+    makeLecture(&lec, day, time, subject, faculty, section);
+    if (dayIndex(day) < 0)
+        return TT_ERR_INVALID;
+    PERF_START(start);
+    TimetableVersion *draft = beginEdit(tt);
+    int status = draft == NULL ? TT_ERR_NOMEM : finishEdit(tt, draft, applyInsert(tt, draft, &lec, 1), 0);
+    PERF_STOP(PERF_INSERT, start);
+    return status;
+}
+
+// Exchange the subjects (and optionally teachers) of two lectures
+int timetableSwap(Timetable *tt, const char *section1, const char *day1, const char *time1,
+                  const char *section2, const char *day2, const char *time2, int swapTeacher)
+{
+    PERF_START(start);
+    TimetableVersion *draft = beginEdit(tt);
+    int status = draft == NULL ? TT_ERR_NOMEM
+                               : finishEdit(tt, draft, applySwap(tt, draft, section1, day1, time1, section2, day2, time2, swapTeacher), 1);
+    PERF_STOP(PERF_SWAP, start);
+    return status;
+}
+
+// Move the lecture at day/time from one section to another
+int timetableMoveSection(Timetable *tt, const char *oldSection, const char *day, const char *time,
+                         const char *newSection)
+{
+    PERF_START(start);
+    TimetableVersion *draft = beginEdit(tt);
+    int status = draft == NULL ? TT_ERR_NOMEM : finishEdit(tt, draft, applyMove(tt, draft, oldSection, day, time, newSection), 1);
+    PERF_STOP(PERF_MOVE, start);
+    return status;
+}
+
+// Book the lecture at a slot into a room, or release its room with ""
+int timetableSetRoom(Timetable *tt, const char *section, const char *day, const char *time, const char *room)
+{
+    if (strlen(room) >= ROOM_NAME_LEN)
+        return TT_ERR_INVALID;
+    TimetableVersion *draft = beginEdit(tt);
+    return draft == NULL ? TT_ERR_NOMEM : finishEdit(tt, draft, applySetRoom(tt, draft, section, day, time, room, 1), 1);
+}
+
+// Give every lecture of a subject to a teacher, returns the number of slots updated
+int timetableAssignSubject(Timetable *tt, const char *subject, const char *teacherName)
+{
+    PERF_START(start);
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+        return 0;
+    int updated = applyAssign(tt, draft, subject, teacherName);
+    finishEdit(tt, draft, updated > 0 ? TT_OK : TT_ERR_NOT_FOUND, 1);
+    PERF_STOP(PERF_ASSIGN, start);
+    return updated > 0 ? updated : 0;
+}
+
+// Mark teacher unavailable in a section: swap their first lecture with another
+// teacher's lecture at a different time, or turn it into a free period.
+// Returns 1 if swapped, 0 if marked free, TT_ERR_NOT_FOUND if they have no lecture there.
+int timetableMarkUnavailable(Timetable *tt, const char *faculty, const char *section)
+{
+    int sid = sectionTableFind(&tt->sections, section);
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+        return TT_ERR_NOMEM;
+
+    // Locate the teacher's first lecture and a candidate not using the same teacher
+    int day = -1, index = -1, candDay = -1, candIndex = -1;
+    for (int d = 0; d < DAY_COUNT && index < 0; d++)
+    {
+        const Block *block = versionBlock(draft, sid, d);
+        for (int i = 0; block != NULL && i < block->count; i++)
+        {
+            if (strcmp(block->lectures[i].faculty, faculty) == 0)
+            {
+                day = d;
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index < 0)
+    {
+        abortEdit(tt, draft);
+        return TT_ERR_NOT_FOUND;
+    }
+    const char *time = versionBlock(draft, sid, day)->lectures[index].time;
+    for (int d = 0; d < DAY_COUNT && candIndex < 0; d++)
+    {
+        const Block *block = versionBlock(draft, sid, d);
+        for (int i = 0; block != NULL && i < block->count; i++)
+        {
+            const Lecture *cand = &block->lectures[i];
+            if (strcmp(cand->faculty, faculty) != 0 && strcmp(cand->time, time) != 0)
+            {
+                candDay = d;
+                candIndex = i;
+                break;
+            }
+        }
+    }
+
+    Block *block = draftBlock(draft, sid, day);
+    Block *candBlock = candIndex < 0 ? NULL : draftBlock(draft, sid, candDay);
+    if (block == NULL || (candIndex >= 0 && candBlock == NULL))
+    {
+        abortEdit(tt, draft);
+        return TT_ERR_NOMEM;
+    }
+    Lecture *lec = &block->lectures[index];
+    int status;
+    if (candBlock != NULL)
+        status = swapBooked(draft, lec, day, &candBlock->lectures[candIndex], candDay, 1) == TT_OK ? 1 : TT_ERR_NOMEM;
+    else
+    {
+        status = draftBook(draft, lec, day, -1) == TT_OK ? 0 : TT_ERR_NOMEM;
+        strcpy(lec->subject, "Free Period");
+        strcpy(lec->faculty, "-");
+        lec->room[0] = '\0';
+    }
+    if (status == TT_ERR_NOMEM)
+    {
+        abortEdit(tt, draft);
+        return status;
+    }
+    commitEdit(tt, draft, 1);
+    return status;
+}
+
+// Plan rooms (see roomplan.h) and write them back as one undoable edit
+int timetableAllocateRooms(Timetable *tt, int replan, RoomPlan *plan)
+{
+    memset(plan, 0, sizeof(*plan));
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+        return TT_ERR_NOMEM;
+    TRACE_BEGIN(span, "edit", "allocate rooms");
+    size_t movesSize = sizeof(RoomMove) * (draft->count + 1);
+    RoomMove *moves = (RoomMove *)memAlloc(MEM_JOURNAL, movesSize);
+    int count = moves != NULL ? planRooms(draft, replan, moves, plan) : TT_ERR_NOMEM;
+    int status = count < 0 ? count : TT_OK;
+    for (int i = 0; i < count && status == TT_OK; i++)
+    {
+        const RoomMove *move = &moves[i];
+        Block *block = draftBlock(draft, move->sectionId, move->day);
+        Lecture *lec = block != NULL ? &block->lectures[move->index] : NULL;
+        if (lec == NULL || draftBook(draft, lec, move->day, -1) != TT_OK)
+        {
+            status = TT_ERR_NOMEM;
+            break;
+        }
+        strcpy(lec->room, move->roomId >= 0 ? tt->rooms.names[move->roomId] : "");
+        status = draftBook(draft, lec, move->day, 1);
+    }
+    memFree(MEM_JOURNAL, moves, movesSize);
+    plan->moved = count > 0 ? count : 0;
+    TRACE_ARG(span, plan->moved);
+    TRACE_END(span);
+    if (status == TT_OK && count == 0)
+    {
+        abortEdit(tt, draft); // nothing to change, keep the undo history as it is
+        return TT_OK;
+    }
+    return finishEdit(tt, draft, status, 1);
+}
+
+typedef struct
+{
+    TimetableVersion *draft;
+    Lecture *restored; // first lecture brought back, when asked for
+    int status;
+} UndoState;
+
+// Put a slot of the undone edit back the way it was before the edit; whatever a
+// later edit left in that slot gives way
+static int restoreSlot(const Lecture *edited, const Lecture *original, void *ctx)
+{
+    UndoState *state = (UndoState *)ctx;
+    const Lecture *lec = original != NULL ? original : edited;
+    int sid = sectionTableFind(state->draft->sections, lec->section);
+    int d = dayIndex(lec->day);
+    if (draftFind(state->draft, sid, d, lec->time) != NULL)
+        state->status = draftRemove(state->draft, sid, d, lec->time, NULL);
+    if (state->status == TT_OK && original != NULL)
+    {
+        state->status = draftInsert(state->draft, sid, d, original);
+        if (state->restored != NULL && state->restored->section[0] == '\0')
+            *state->restored = *original;
+    }
+    return state->status != TT_OK;
+}
+
+// Undo the last undoable edit: the slots it changed get their earlier lectures
+// back, while edits published since, undoable or not, stay in place. The first
+// restored lecture is copied to restored when given.
+int timetableUndo(Timetable *tt, Lecture *restored)
+{
+    PERF_START(start);
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+        return TT_ERR_NOMEM;
+    if (tt->top == -1)
+    {
+        abortEdit(tt, draft);
+        return TT_ERR_EMPTY;
+    }
+    if (restored != NULL)
+        memset(restored, 0, sizeof(*restored));
+    UndoState state = {draft, restored, TT_OK};
+    UndoEntry *entry = &tt->undo[tt->top];
+    versionCompare(entry->after, entry->before, restoreSlot, &state);
+    if (state.status == TT_OK)
+    {
+        releaseUndo(entry);
+        tt->top--;
+    }
+    int status = finishEdit(tt, draft, state.status, 0);
+    PERF_STOP(PERF_UNDO, start);
+    return status;
+}
+
+#define TXN_INSERT 1
+#define TXN_SWAP 2
+#define TXN_MOVE 3
+#define TXN_ASSIGN 4
+#define TXN_ROOM 5
+#define TXN_REMOVE 6
+
+// A queued edit. first holds the slot (or subject and teacher for an assignment),
+// second the other slot of a swap, the target section of a move, the room, or the
+// lecture a removal expects to find.
+typedef struct
+{
+    int kind;
+    Lecture first;
+    Lecture second;
+    int swapTeacher;
+    int expect; // TXN_REMOVE: fail unless the lecture removed matches second
+    int line;   // line of the patch row it came from
+} TxnOp;
+
+struct TimetableTxn
+{
+    Timetable *tt;
+    TxnOp *ops;
+    int count, capacity;
+};
+
+TimetableTxn *timetableBegin(Timetable *tt)
+{
+    TimetableTxn *txn = (TimetableTxn *)memCalloc(MEM_JOURNAL, 1, sizeof(TimetableTxn));
+    if (txn != NULL)
+        txn->tt = tt;
+    return txn;
+}
+
+void timetableRollback(TimetableTxn *txn)
+{
+    if (txn == NULL)
+        return;
+    memFree(MEM_JOURNAL, txn->ops, sizeof(TxnOp) * txn->capacity);
+    memFree(MEM_JOURNAL, txn, sizeof(TimetableTxn));
+}
+
+int txnCount(const TimetableTxn *txn)
+{
+    return txn->count;
+}
+
+static TxnOp *queueOp(TimetableTxn *txn, int kind)
+{
+    if (txn->count == txn->capacity)
+    {
+        int capacity = txn->capacity ? txn->capacity * 2 : 16;
+        TxnOp *ops = (TxnOp *)memRealloc(MEM_JOURNAL, txn->ops, sizeof(TxnOp) * txn->capacity, sizeof(TxnOp) * capacity);
+        if (ops == NULL)
+            return NULL;
+        txn->ops = ops;
+        txn->capacity = capacity;
+    }
+    TxnOp *op = &txn->ops[txn->count++];
+    memset(op, 0, sizeof(*op));
+    op->kind = kind;
+    return op;
+}
+
+int txnInsertLecture(TimetableTxn *txn, const char *day, const char *time, const char *subject,
+                     const char *faculty, const char *section)
+{
+    if (dayIndex(day) < 0)
+        return TT_ERR_INVALID;
+    TxnOp *op = queueOp(txn, TXN_INSERT);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, day, time, subject, faculty, section);
+    return TT_OK;
+}
+
+int txnSwap(TimetableTxn *txn, const char *section1, const char *day1, const char *time1,
+            const char *section2, const char *day2, const char *time2, int swapTeacher)
+{
+    TxnOp *op = queueOp(txn, TXN_SWAP);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, day1, time1, "", "", section1);
+    makeLecture(&op->second, day2, time2, "", "", section2);
+    op->swapTeacher = swapTeacher;
+    return TT_OK;
+}
+
+int txnMoveSection(TimetableTxn *txn, const char *oldSection, const char *day, const char *time,
+                   const char *newSection)
+{
+    TxnOp *op = queueOp(txn, TXN_MOVE);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, day, time, "", "", oldSection);
+    copySection(op->second.section, newSection);
+    return TT_OK;
+}
+
+int txnSetRoom(TimetableTxn *txn, const char *section, const char *day, const char *time, const char *room)
+{
+    if (strlen(room) >= ROOM_NAME_LEN)
+        return TT_ERR_INVALID;
+    TxnOp *op = queueOp(txn, TXN_ROOM);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, day, time, "", "", section);
+    strcpy(op->second.room, room);
+    return TT_OK;
+}
+
+int txnRemoveLecture(TimetableTxn *txn, const char *section, const char *day, const char *time)
+{
+    TxnOp *op = queueOp(txn, TXN_REMOVE);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, day, time, "", "", section);
+    return TT_OK;
+}
+
+int txnAssignSubject(TimetableTxn *txn, const char *subject, const char *teacherName)
+{
+    TxnOp *op = queueOp(txn, TXN_ASSIGN);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    makeLecture(&op->first, "", "", subject, teacherName, "");
+    return TT_OK;
+}
+
+static int applyRemove(Timetable *tt, TimetableVersion *draft, const TxnOp *op)
+{
+    Lecture removed;
+    const Lecture *a = &op->first, *expected = &op->second;
+    int status = draftRemove(draft, sectionTableFind(&tt->sections, a->section), dayIndex(a->day), a->time, &removed);
+    if (status == TT_OK && op->expect &&
+        (strcmp(removed.subject, expected->subject) != 0 || strcmp(removed.faculty, expected->faculty) != 0 ||
+         strcmp(removed.room, expected->room) != 0))
+        return TT_ERR_NOT_FOUND;
+    return status;
+}
+
+static int applyOp(Timetable *tt, TimetableVersion *draft, const TxnOp *op)
+{
+    const Lecture *a = &op->first, *b = &op->second;
+    switch (op->kind)
+    {
+    case TXN_INSERT:
+        return applyInsert(tt, draft, a, 0);
+    case TXN_SWAP:
+        return applySwap(tt, draft, a->section, a->day, a->time, b->section, b->day, b->time, op->swapTeacher);
+    case TXN_MOVE:
+        return applyMove(tt, draft, a->section, a->day, a->time, b->section);
+    case TXN_ROOM:
+        return applySetRoom(tt, draft, a->section, a->day, a->time, b->room, 0);
+    case TXN_REMOVE:
+        return applyRemove(tt, draft, op);
+    case TXN_ASSIGN:
+    {
+        int updated = applyAssign(tt, draft, a->subject, a->faculty);
+        return updated > 0 ? TT_OK : updated == 0 ? TT_ERR_NOT_FOUND : updated;
+    }
+    }
+    return TT_ERR_INVALID;
+}
+
+// A period the occupancy masks cannot check: a lecture whose time is not in the
+// calendar is checked by its time string (period 0), a teacher past MAX_TEACHERS
+// by scanning every section at each of its periods.
+typedef struct
+{
+    int day;
+    unsigned int period; // a single period bit, or 0
+    const char *time;
+    int room; // room id of the lecture, -1 if it books none
+} TouchedSlot;
+
+typedef struct
+{
+    TouchedSlot *slots;
+    int count, capacity;
+    int failed;
+    const RoomTable *rooms;
+} SlotList;
+
+static int addTouchedSlot(SlotList *list, const Lecture *lec, unsigned int period)
+{
+    if (list->count == list->capacity)
+    {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        TouchedSlot *slots = (TouchedSlot *)memRealloc(MEM_JOURNAL, list->slots, sizeof(TouchedSlot) * list->capacity,
+                                                       sizeof(TouchedSlot) * capacity);
+        if (slots == NULL)
+        {
+            list->failed = 1;
+            return 1;
+        }
+        list->slots = slots;
+        list->capacity = capacity;
+    }
+    TouchedSlot *slot = &list->slots[list->count++];
+    slot->day = dayIndex(lec->day);
+    slot->period = period;
+    slot->time = lec->time;
+    slot->room = period != 0 && lec->room[0] != '\0' ? roomTableFind(list->rooms, lec->room) : -1;
+    return 0;
+}
+
+static int compareTouchedSlots(const void *a, const void *b)
+{
+    const TouchedSlot *x = (const TouchedSlot *)a, *y = (const TouchedSlot *)b;
+    if (x->day != y->day)
+        return x->day - y->day;
+    if (x->period != y->period)
+        return x->period < y->period ? -1 : 1;
+    if (x->room != y->room)
+        return x->room - y->room;
+    return x->period != 0 ? 0 : strcmp(x->time, y->time);
+}
+
+static int atSlot(const Lecture *lec, const TouchedSlot *slot)
+{
+    return slot->period != 0 ? (lec->periods & slot->period) != 0 : strcmp(lec->time, slot->time) == 0;
+}
+
+// Lectures of one section's day block at a slot, in block order. The busy mask
+// rules most blocks out without looking at their lectures; a time string slot is
+// the run of equal times found by binary search.
+static int blockAtSlot(const Block *block, const TouchedSlot *slot, const Lecture **out)
+{
+    if (block == NULL || (slot->period != 0 && !(block->busy & slot->period)))
+        return 0;
+    int count = 0;
+    for (int i = slot->period != 0 ? 0 : findInBlock(block, slot->time); i >= 0 && i < block->count; i++)
+    {
+        if (atSlot(&block->lectures[i], slot))
+        {
+            if (out != NULL)
+                out[count] = &block->lectures[i];
+            count++;
+        }
+        else if (slot->period == 0)
+            break;
+    }
+    return count;
+}
+
+// By teacher, then so the lectures of a combined lecture are adjacent
+static int compareBooking(const void *a, const void *b)
+{
+    const Lecture *x = *(const Lecture *const *)a, *y = *(const Lecture *const *)b;
+    int order = strcmp(x->faculty, y->faculty);
+    if (order == 0)
+        order = strcmp(x->subject, y->subject);
+    if (order == 0)
+        order = strcmp(x->room, y->room);
+    return order;
+}
+
+// A combined lecture, one teacher teaching a subject to several sections in one
+// room, books the teacher once
+static int sameBooking(const Lecture *a, const Lecture *b)
+{
+    return strcmp(a->faculty, b->faculty) == 0 && strcmp(a->subject, b->subject) == 0 &&
+           strcmp(a->room, b->room) == 0;
+}
+
+// Bookings of the teacher of list[0] in a list sorted by compareBooking; run gets
+// the number of that teacher's lectures
+static int teacherBookings(const Lecture **list, int count, int *run)
+{
+    int bookings = 1;
+    *run = 1;
+    while (*run < count && strcmp(list[*run]->faculty, list[0]->faculty) == 0)
+    {
+        bookings += !sameBooking(list[*run], list[*run - 1]);
+        (*run)++;
+    }
+    return bookings;
+}
+
+// Teachers' lectures of a version at one slot across all sections, sorted by
+// compareBooking. Free periods and lab groups are not teachers. Returns the count.
+static int teachersAtSlot(const TimetableVersion *version, int sectionCount, const TouchedSlot *slot,
+                          const Lecture **out)
+{
+    int count = 0;
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        int found = blockAtSlot(versionBlock(version, sid, slot->day), slot, out + count), kept = 0;
+        for (int i = 0; i < found; i++)
+        {
+            const Lecture *lec = out[count + i];
+            if (isTeacher(lec->faculty))
+                out[count + kept++] = lec;
+        }
+        count += kept;
+    }
+    qsort(out, count, sizeof(out[0]), compareBooking);
+    return count;
+}
+
+// Lectures of a version in a slot's room and period, across all sections
+static int roomAtSlot(const TimetableVersion *version, int sectionCount, const TouchedSlot *slot,
+                      const Lecture **out)
+{
+    const char *room = version->roomTable->names[slot->room];
+    int count = 0;
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        int found = blockAtSlot(versionBlock(version, sid, slot->day), slot, out + count), kept = 0;
+        for (int i = 0; i < found; i++)
+        {
+            if (strcmp(out[count + i]->room, room) == 0)
+                out[count + kept++] = out[count + i];
+        }
+        count += kept;
+    }
+    return count;
+}
+
+// Number of lectures at a slot in one section's day block
+static int sectionAtSlot(const TimetableVersion *version, int sectionId, const TouchedSlot *slot)
+{
+    return blockAtSlot(versionBlock(version, sectionId, slot->day), slot, NULL);
+}
+
+static void reportConflict(TxnFailure *failure, const Lecture *lecture, const Lecture *other)
+{
+    if (failure != NULL)
+    {
+        failure->lecture = *lecture;
+        failure->other = *other;
+    }
+}
+
+// Check one slot a transaction wrote to: no section and no teacher may be booked
+// there more often, and no room beyond its capacity, than before the transaction
+// (clashes already present are kept). A combined lecture is one booking of its teacher.
+// scratch has room for two lectures per section and slot. Returns 1 on a conflict.
+static int checkSlot(const TimetableVersion *base, const TimetableVersion *draft, int sectionCount,
+                     const TouchedSlot *slot, const Lecture **scratch, int scratchSize, TxnFailure *failure)
+{
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        int booked = sectionAtSlot(draft, sid, slot);
+        if (booked > 1 && booked > sectionAtSlot(base, sid, slot))
+        {
+            blockAtSlot(versionBlock(draft, sid, slot->day), slot, scratch);
+            reportConflict(failure, scratch[1], scratch[0]);
+            return 1;
+        }
+    }
+
+    // The room's booking count is kept per period, so only a clash is searched for
+    if (slot->room >= 0)
+    {
+        int booked = versionRoomBookings(draft, slot->room, slot->day, slot->period);
+        int capacity = atomic_load(&draft->roomTable->capacity[slot->room]);
+        if (booked > capacity && booked > versionRoomBookings(base, slot->room, slot->day, slot->period))
+        {
+            int found = roomAtSlot(draft, sectionCount, slot, scratch);
+            reportConflict(failure, scratch[found - 1], scratch[0]);
+            return 1;
+        }
+    }
+
+    const Lecture **after = scratch, **before = scratch + scratchSize / 2;
+    int afterCount = teachersAtSlot(draft, sectionCount, slot, after);
+    int beforeCount = teachersAtSlot(base, sectionCount, slot, before);
+    for (int i = 0, j = 0; i < afterCount;)
+    {
+        int run, previousRun;
+        int booked = teacherBookings(after + i, afterCount - i, &run);
+        if (booked > 1)
+        {
+            while (j < beforeCount && strcmp(before[j]->faculty, after[i]->faculty) < 0)
+                j++;
+            int previous = j < beforeCount && strcmp(before[j]->faculty, after[i]->faculty) == 0
+                               ? teacherBookings(before + j, beforeCount - j, &previousRun)
+                               : 0;
+            if (booked > previous)
+            {
+                int other = 1;
+                while (sameBooking(after[i + other], after[i]))
+                    other++;
+                reportConflict(failure, after[i + other], after[i]);
+                return 1;
+            }
+        }
+        i += run;
+    }
+    return 0;
+}
+
+// Check the slots the masks could not, scanning every section at each of them
+// once however many edits touched it
+static int checkScannedSlots(const TimetableVersion *base, const TimetableVersion *draft, SlotList *touched,
+                             TxnFailure *failure)
+{
+    qsort(touched->slots, touched->count, sizeof(TouchedSlot), compareTouchedSlots);
+    int unique = 0;
+    for (int i = 0; i < touched->count; i++)
+    {
+        if (unique == 0 || compareTouchedSlots(&touched->slots[i], &touched->slots[unique - 1]) != 0)
+            touched->slots[unique++] = touched->slots[i];
+    }
+    touched->count = unique;
+
+    // Lectures at one slot: at most the block run of each section, counted per version
+    int sectionCount = atomic_load(&draft->sections->count);
+    int scratchSize = 0;
+    for (int i = 0; i < touched->count; i++)
+    {
+        int needed = 0;
+        for (int sid = 0; sid < sectionCount; sid++)
+        {
+            int a = sectionAtSlot(draft, sid, &touched->slots[i]);
+            int b = sectionAtSlot(base, sid, &touched->slots[i]);
+            needed += a > b ? a : b;
+        }
+        if (2 * needed > scratchSize)
+            scratchSize = 2 * needed;
+    }
+    size_t scratchBytes = sizeof(Lecture *) * (scratchSize > 0 ? scratchSize : 1);
+    const Lecture **scratch = (const Lecture **)memAlloc(MEM_JOURNAL, scratchBytes);
+    int status = scratch == NULL ? TT_ERR_NOMEM : TT_OK;
+    for (int i = 0; i < touched->count && status == TT_OK; i++)
+    {
+        if (checkSlot(base, draft, sectionCount, &touched->slots[i], scratch, scratchSize, failure))
+            status = TT_ERR_CONFLICT;
+    }
+    memFree(MEM_JOURNAL, (void *)scratch, scratchBytes);
+    return status;
+}
+
+typedef struct
+{
+    const TimetableVersion *base;
+    const TimetableVersion *draft;
+    SlotList scanned; // slots left to checkScannedSlots
+    TxnFailure *failure;
+    int conflict;
+} DraftCheck;
+
+// Another lecture of a version at a period, in the same room (byRoom) or for the
+// same teacher but not part of the same combined lecture. Only looked for once the
+// occupancy masks found a clash, to report it.
+static const Lecture *findClash(const TimetableVersion *version, const Lecture *lec, int day, unsigned int period,
+                                int byRoom)
+{
+    int sectionCount = atomic_load(&version->sections->count);
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        const Block *block = versionBlock(version, sid, day);
+        for (int i = 0; block != NULL && (block->busy & period) && i < block->count; i++)
+        {
+            const Lecture *other = &block->lectures[i];
+            if (other == lec || !(other->periods & period))
+                continue;
+            if (byRoom ? strcmp(other->room, lec->room) == 0
+                       : strcmp(other->faculty, lec->faculty) == 0 && !sameBooking(other, lec))
+                return other;
+        }
+    }
+    return lec; // not reached while the masks agree with the lectures
+}
+
+// Check a lecture a transaction wrote against the occupancy the draft keeps: its
+// section, its room and its teacher may not be booked more often at any of its
+// periods than before the transaction (clashes already present are kept), a room
+// not beyond its capacity. Each period is a lookup, whatever the timetable's size.
+static int checkWritten(const Lecture *before, const Lecture *after, void *ctx)
+{
+    DraftCheck *check = (DraftCheck *)ctx;
+    (void)before;
+    if (after == NULL)
+        return 0; // removing a lecture cannot create a clash
+    if (after->periods == 0)
+        return addTouchedSlot(&check->scanned, after, 0);
+
+    const TimetableVersion *base = check->base, *draft = check->draft;
+    int d = dayIndex(after->day);
+    int sid = sectionTableFind(draft->sections, after->section);
+    const Block *block = versionBlock(draft, sid, d), *was = versionBlock(base, sid, d);
+    unsigned int doubled = block->doubled & after->periods & ~(was != NULL ? was->doubled : 0);
+    if (doubled != 0)
+    {
+        for (int i = 0; i < block->count; i++)
+        {
+            const Lecture *other = &block->lectures[i];
+            if (other != after && (other->periods & doubled))
+            {
+                reportConflict(check->failure, after, other);
+                break;
+            }
+        }
+        check->conflict = 1;
+        return 1;
+    }
+
+    int roomId = after->room[0] != '\0' ? roomTableFind(draft->roomTable, after->room) : -1;
+    int capacity = roomId >= 0 ? atomic_load(&draft->roomTable->capacity[roomId]) : 0;
+    int teacherId = isTeacher(after->faculty) ? teacherTableFind(draft->teacherTable, after->faculty) : -1;
+    for (unsigned int rest = after->periods; rest != 0; rest &= rest - 1)
+    {
+        unsigned int period = rest & -rest;
+        int booked = versionRoomBookings(draft, roomId, d, period);
+        if (booked > capacity && booked > versionRoomBookings(base, roomId, d, period))
+        {
+            reportConflict(check->failure, after, findClash(draft, after, d, period, 1));
+            check->conflict = 1;
+            return 1;
+        }
+        if (teacherId < 0 && isTeacher(after->faculty))
+        {
+            if (addTouchedSlot(&check->scanned, after, period))
+                return 1;
+            continue;
+        }
+        booked = versionTeacherBookings(draft, teacherId, d, period);
+        if (booked > 1 && booked > versionTeacherBookings(base, teacherId, d, period))
+        {
+            reportConflict(check->failure, after, findClash(draft, after, d, period, 0));
+            check->conflict = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Validate a draft against the version it replaces. versionCompare skips every
+// part of the timetable the batch left alone, and each lecture it wrote is checked
+// against the section, room and teacher occupancy the draft already keeps.
+static int validateDraft(const TimetableVersion *base, const TimetableVersion *draft, TxnFailure *failure)
+{
+    DraftCheck check = {base, draft, {NULL, 0, 0, 0, draft->roomTable}, failure, 0};
+    versionCompare(base, draft, checkWritten, &check);
+    int status = TT_OK;
+    if (check.scanned.failed)
+        status = TT_ERR_NOMEM;
+    else if (check.conflict)
+        status = TT_ERR_CONFLICT;
+    else if (check.scanned.count > 0)
+        status = checkScannedSlots(base, draft, &check.scanned, failure);
+    memFree(MEM_JOURNAL, check.scanned.slots, sizeof(TouchedSlot) * check.scanned.capacity);
+    return status;
+}
+
+// Apply every queued edit to a draft of the current version, validate the result
+// once and publish it as a single undoable edit. On any failure nothing changes.
+// The transaction is freed either way.
+static int applyTxn(TimetableTxn *txn, int validate, TxnFailure *failure)
+{
+    Timetable *tt = txn->tt;
+    PERF_START(start);
+    TRACE_BEGIN(span, "edit", "commit");
+    TRACE_ARG(span, txn->count);
+    if (failure != NULL)
+    {
+        memset(failure, 0, sizeof(*failure));
+        failure->op = -1;
+    }
+
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+    {
+        TRACE_END(span);
+        return TT_ERR_NOMEM;
+    }
+    TRACE_BEGIN(applySpan, "edit", "apply");
+    TRACE_ARG(applySpan, txn->count);
+    int status = TT_OK;
+    for (int i = 0; i < txn->count && status == TT_OK; i++)
+    {
+        status = applyOp(tt, draft, &txn->ops[i]);
+        if (status != TT_OK && failure != NULL)
+            failure->op = i;
+    }
+    TRACE_END(applySpan);
+
+    if (status == TT_OK && validate)
+    {
+        TRACE_BEGIN(validateSpan, "edit", "validate");
+        status = validateDraft(tt->current, draft, failure);
+        TRACE_END(validateSpan);
+    }
+
+    finishEdit(tt, draft, status, 1);
+    PERF_STOP(PERF_COMMIT, start);
+    TRACE_END(span);
+    return status;
+}
+
+int timetableCommit(TimetableTxn *txn, TxnFailure *failure)
+{
+    int status = applyTxn(txn, 1, failure);
+    timetableRollback(txn);
+    return status;
+}
+
+int timetableCount(Timetable *tt)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    int count = versionCount(version);
+    timetableUnpin(version);
+    return count;
+}
+
+// Copy the lecture holding a slot into out (when given), TT_ERR_NOT_FOUND if the
+// slot is free. A period inside a block finds the block, as timetableIsSlotFree does.
+int timetableGetLecture(Timetable *tt, const char *section, const char *day, const char *time, Lecture *out)
+{
+    PERF_START(start);
+    int d = dayIndex(day);
+    unsigned int periods = calendarPeriodMask(timetableCalendar(tt), d, time);
+    const TimetableVersion *version = timetablePin(tt);
+    const Lecture *lec = versionSlot(version, section, d, time, periods);
+    if (lec != NULL && out != NULL)
+        *out = *lec;
+    timetableUnpin(version);
+    PERF_STOP(PERF_LOOKUP, start);
+    return lec != NULL ? TT_OK : TT_ERR_NOT_FOUND;
+}
+
+// Function to check if time slot is available: nothing booked at that time and,
+// for a calendar period or block, none of its periods taken by another lecture
+int timetableIsSlotFree(Timetable *tt, const char *section, const char *day, const char *time)
+{
+    PERF_START(start);
+    int d = dayIndex(day);
+    unsigned int periods = calendarPeriodMask(timetableCalendar(tt), d, time);
+    const TimetableVersion *version = timetablePin(tt);
+    const Block *block = versionBlock(version, sectionTableFind(&tt->sections, section), d);
+    int isFree = block == NULL || (!(block->busy & periods) && findInBlock(block, time) < 0);
+    timetableUnpin(version);
+    PERF_STOP(PERF_LOOKUP, start);
+    return isFree;
+}
+
+unsigned int timetableSectionPeriods(Timetable *tt, const char *section, const char *day)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    unsigned int periods = versionDayPeriods(version, section, dayIndex(day));
+    timetableUnpin(version);
+    return periods;
+}
+
+int timetableIsRoomFree(Timetable *tt, const char *room, const char *day, const char *time)
+{
+    int d = dayIndex(day);
+    unsigned int periods = calendarPeriodMask(timetableCalendar(tt), d, time);
+    const TimetableVersion *version = timetablePin(tt);
+    int fits = versionRoomFits(version, roomTableFind(&tt->rooms, room), d, periods);
+    timetableUnpin(version);
+    return fits;
+}
+
+// Weekly figures of every room from its occupancy masks and booking counts
+int timetableRoomUsage(Timetable *tt, RoomUsage usage[], int max)
+{
+    const Calendar *calendar = timetableCalendar(tt);
+    int weekPeriods = 0;
+    for (int d = 0; d < DAY_COUNT; d++)
+        weekPeriods += calendarPeriodCount(calendar, d);
+
+    const TimetableVersion *version = timetablePin(tt);
+    int roomCount = timetableRoomCount(tt);
+    if (roomCount > max)
+        roomCount = max;
+    for (int r = 0; r < roomCount; r++)
+    {
+        RoomUsage *room = &usage[r];
+        memset(room, 0, sizeof(*room));
+        strcpy(room->name, tt->rooms.names[r]);
+        room->capacity = atomic_load(&tt->rooms.capacity[r]);
+        room->availablePeriods = weekPeriods;
+        const RoomWeek *week = r < version->roomCount ? version->rooms[r] : NULL;
+        for (int d = 0; week != NULL && d < DAY_COUNT; d++)
+        {
+            for (int p = 0; p < MAX_PERIODS; p++)
+            {
+                if (!(week->busy[d] & (1u << p)))
+                    continue;
+                room->bookedPeriods++;
+                room->bookings += week->bookings[d][p];
+                if (week->bookings[d][p] > room->capacity)
+                    room->overbookedPeriods++;
+            }
+        }
+    }
+    timetableUnpin(version);
+    return roomCount;
+}
+
+// Copy a section's lectures on one day into out, sorted by time; returns the count
+int timetableCollectDay(Timetable *tt, const char *section, const char *day, Lecture out[], int max)
+{
+    PERF_START(start);
+    const TimetableVersion *version = timetablePin(tt);
+    const Lecture *lectures;
+    int count = versionDay(version, section, dayIndex(day), &lectures);
+    if (count > max)
+        count = max;
+    if (count > 0)
+        memcpy(out, lectures, sizeof(Lecture) * count);
+    timetableUnpin(version);
+    PERF_STOP(PERF_LOOKUP, start);
+    return count;
+}
+
+int timetableHasSection(Timetable *tt, const char *section)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    const Lecture *lectures;
+    int found = 0;
+    for (int d = 0; d < DAY_COUNT && !found; d++)
+        found = versionDay(version, section, d, &lectures) > 0;
+    timetableUnpin(version);
+    return found;
+}
+
+// Visit every lecture, returns the number visited
+int timetableForEach(Timetable *tt, LectureVisitor visit, void *ctx)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    int visited = versionForEach(version, visit, ctx);
+    timetableUnpin(version);
+    return visited;
+}
+
+typedef struct
+{
+    int field;
+    const char *query;
+    LectureVisitor visit;
+    void *ctx;
+    int found;
+} SearchCtx;
+
+static int searchVisitor(const Lecture *lec, void *ctx)
+{
+    SearchCtx *search = (SearchCtx *)ctx;
+    const char *query = search->query;
+    if ((search->field == SEARCH_TEACHER && strcasestr_portable(lec->faculty, query)) ||
+        (search->field == SEARCH_SUBJECT && (strcasestr_portable(lec->subject, query) || strcasestr_portable(getSubjectName(lec->subject), query))) ||
+        (search->field == SEARCH_TIME && strcasestr_portable(lec->time, query)))
+    {
+        search->found++;
+        return search->visit(lec, search->ctx);
+    }
+    return 0;
+}
+
+// Column table for an analytics scan of a pinned version, NULL to scan lecture rows
+static const LectureColumns *scanColumns(Timetable *tt, const TimetableVersion *version)
+{
+    return atomic_load_explicit(&tt->columnar, memory_order_relaxed) ? versionColumns(version) : NULL;
+}
+
+void timetableSetColumnar(Timetable *tt, int enabled)
+{
+    atomic_store(&tt->columnar, enabled != 0);
+}
+
+typedef struct
+{
+    const char *faculty;
+    int day;
+    unsigned int periods;
+} TeacherPeriodsCtx;
+
+static int teacherPeriodsVisitor(const Lecture *lec, void *ctx)
+{
+    TeacherPeriodsCtx *teacher = (TeacherPeriodsCtx *)ctx;
+    if (dayIndex(lec->day) == teacher->day && strcmp(lec->faculty, teacher->faculty) == 0)
+        teacher->periods |= lec->periods;
+    return 0;
+}
+
+// Periods a teacher is booked on a day in any section: one lookup in the column
+// table's mask per teacher and day, or a row scan when columns are off
+unsigned int timetableTeacherPeriods(Timetable *tt, const char *faculty, const char *day)
+{
+    TeacherPeriodsCtx teacher = {faculty, dayIndex(day), 0};
+    if (teacher.day < 0)
+        return 0;
+    const TimetableVersion *version = timetablePin(tt);
+    const LectureColumns *columns = scanColumns(tt, version);
+    if (columns != NULL)
+    {
+        int id = columnFind(&columns->faculties, faculty);
+        teacher.periods = id < 0 ? 0 : columns->facultyPeriods[id * DAY_COUNT + teacher.day];
+    }
+    else
+        versionForEach(version, teacherPeriodsVisitor, &teacher);
+    timetableUnpin(version);
+    return teacher.periods;
+}
+
+const Calendar *timetableCalendar(Timetable *tt)
+{
+    return atomic_load_explicit(&tt->calendar, memory_order_acquire);
+}
+
+// Recompute every lecture's periods for a calendar; only blocks whose masks
+// change are copied into the draft
+static int retimeDraft(TimetableVersion *draft, const Calendar *calendar)
+{
+    int sectionCount = atomic_load(&draft->sections->count);
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        for (int d = 0; d < DAY_COUNT; d++)
+        {
+            const Block *shared = versionBlock(draft, sid, d);
+            int changed = 0;
+            for (int i = 0; shared != NULL && i < shared->count && !changed; i++)
+                changed = shared->lectures[i].periods != calendarPeriodMask(calendar, d, shared->lectures[i].time);
+            if (!changed)
+                continue;
+
+            Block *block = draftBlock(draft, sid, d);
+            if (block == NULL)
+                return TT_ERR_NOMEM;
+            for (int i = 0; i < block->count; i++)
+            {
+                Lecture *lec = &block->lectures[i];
+                if (draftBook(draft, lec, d, -1) != TT_OK)
+                    return TT_ERR_NOMEM;
+                lec->periods = calendarPeriodMask(calendar, d, lec->time);
+                if (draftBook(draft, lec, d, 1) != TT_OK)
+                    return TT_ERR_NOMEM;
+            }
+            blockUpdateBusy(block);
+        }
+    }
+    return TT_OK;
+}
+
+// Switch calendars and publish the timetable with its lectures mapped onto the new
+// periods. Versions on the undo stack carry masks of the old calendar, so the
+// history is dropped.
+int timetableSetCalendar(Timetable *tt, Calendar *calendar)
+{
+    RetiredCalendar *retired = (RetiredCalendar *)memAlloc(MEM_STRINGS, sizeof(RetiredCalendar));
+    if (retired == NULL)
+        return TT_ERR_NOMEM;
+    TimetableVersion *draft = beginEdit(tt);
+    int status = draft == NULL ? TT_ERR_NOMEM : retimeDraft(draft, calendar);
+    if (status != TT_OK)
+    {
+        if (draft != NULL)
+            abortEdit(tt, draft);
+        memFree(MEM_STRINGS, retired, sizeof(RetiredCalendar));
+        return status;
+    }
+    retired->calendar = atomic_exchange_explicit(&tt->calendar, calendar, memory_order_acq_rel);
+    retired->next = tt->retired;
+    tt->retired = retired;
+    clearUndo(tt);
+    commitEdit(tt, draft, 0);
+    return TT_OK;
+}
+
+// Match the query once per distinct value of the searched column, then visit
+// the rows whose id matched
+static int searchColumns(const LectureColumns *columns, SearchCtx *search)
+{
+    const StringColumn *values = search->field == SEARCH_TEACHER ? &columns->faculties
+                                 : search->field == SEARCH_SUBJECT ? &columns->subjects
+                                                                   : &columns->times;
+    const int *ids = search->field == SEARCH_TEACHER ? columns->faculty
+                     : search->field == SEARCH_SUBJECT ? columns->subject
+                                                       : columns->time;
+    size_t matchBytes = values->count > 0 ? (size_t)values->count : 1;
+    unsigned char *match = (unsigned char *)memAlloc(MEM_COLUMNS, matchBytes);
+    if (match == NULL)
+        return -1;
+    int any = 0;
+    for (int id = 0; id < values->count; id++)
+    {
+        const char *value = values->values[id];
+        match[id] = strcasestr_portable(value, search->query) != NULL ||
+                    (search->field == SEARCH_SUBJECT && strcasestr_portable(getSubjectName(value), search->query));
+        any |= match[id];
+    }
+    for (int row = 0; any && row < columns->rows; row++)
+    {
+        if (!match[ids[row]])
+            continue;
+        search->found++;
+        if (search->visit(columns->lecture[row], search->ctx))
+            break;
+    }
+    memFree(MEM_COLUMNS, match, matchBytes);
+    return 0;
+}
+
+// Visit lectures whose teacher, subject (code or name) or time contains query, returns matches
+int timetableSearch(Timetable *tt, int field, const char *query, LectureVisitor visit, void *ctx)
+{
+    PERF_START(start);
+    TRACE_BEGIN(span, "query", "search");
+    SearchCtx search = {field, query, visit, ctx, 0};
+    const TimetableVersion *version = timetablePin(tt);
+    const LectureColumns *columns = scanColumns(tt, version);
+    if (columns == NULL || searchColumns(columns, &search) != 0)
+        versionForEach(version, searchVisitor, &search);
+    timetableUnpin(version);
+    TRACE_ARG(span, search.found);
+    TRACE_END(span);
+    PERF_STOP(PERF_SEARCH, start);
+    return search.found;
+}
+
+typedef struct
+{
+    const char *subject;
+    TimeSlot *slots;
+    int count, max;
+} SubjectSlotsCtx;
+
+static int subjectSlotVisitor(const Lecture *lec, void *ctx)
+{
+    SubjectSlotsCtx *find = (SubjectSlotsCtx *)ctx;
+    if (strcmp(lec->subject, find->subject) != 0)
+        return 0;
+    TimeSlot *slot = &find->slots[find->count++];
+    snprintf(slot->day, sizeof(slot->day), "%.3s", lec->day);
+    copyField(slot->time, lec->time);
+    strcpy(slot->section, lec->section);
+    return find->count == find->max;
+}
+
+// Function to find existing time slots for a subject
+int timetableFindSubjectSlots(Timetable *tt, const char *subject, TimeSlot slots[], int max)
+{
+    SubjectSlotsCtx find = {subject, slots, 0, max};
+    if (max <= 0)
+        return 0;
+    const TimetableVersion *version = timetablePin(tt);
+    const LectureColumns *columns = scanColumns(tt, version);
+    if (columns == NULL)
+    {
+        versionForEach(version, subjectSlotVisitor, &find);
+    }
+    else
+    {
+        int id = columnFind(&columns->subjects, subject);
+        for (int row = 0; id >= 0 && row < columns->rows; row++)
+        {
+            if (columns->subject[row] == id && subjectSlotVisitor(columns->lecture[row], &find))
+                break;
+        }
+    }
+    timetableUnpin(version);
+    return find.count;
+}
+
+// Function to normalize teacher names
+static void normalizeTeacherName(char *name)
+{
+    // Convert "Mr. Neeraj" and "Mr. Neeraj Panwar" to "Mr. Neeraj Panwar"
+    if (strcmp(name, "Mr. Neeraj") == 0)
+    {
+        strcpy(name, "Mr. Neeraj Panwar");
+    }
+}
+
+typedef struct
+{
+    TeacherLoad *loads;
+    int count, max;
+    const SectionTable *sections;
+} TeacherLoadCtx;
+
+static void startTeacherLoad(TeacherLoad *load, const char *name)
+{
+    strcpy(load->name, name);
+    load->lectureCount = 0;
+    load->sectionCount = 0;
+    memset(load->sections, 0, sizeof(load->sections));
+}
+
+// Count a lecture and the section it is in
+static void countTeacherLecture(TeacherLoad *load, int sectionId)
+{
+    load->lectureCount++;
+    if (!TEACHES_SECTION(load, sectionId))
+    {
+        load->sections[sectionId / 8] |= (unsigned char)(1 << (sectionId % 8));
+        load->sectionCount++;
+    }
+}
+
+static int teacherLoadVisitor(const Lecture *lec, void *ctx)
+{
+    TeacherLoadCtx *load = (TeacherLoadCtx *)ctx;
+    TeacherLoad *loads = load->loads;
+    if (!isTeacher(lec->faculty))
+        return 0; // Skip free periods and labs
+
+    char normalizedName[MAX_LEN];
+    strcpy(normalizedName, lec->faculty);
+    normalizeTeacherName(normalizedName);
+
+    int i = 0;
+    while (i < load->count && strcmp(loads[i].name, normalizedName) != 0)
+        i++;
+    if (i == load->count)
+    {
+        if (load->count == load->max)
+            return 0;
+        startTeacherLoad(&loads[i], normalizedName);
+        load->count++;
+    }
+    countTeacherLecture(&loads[i], sectionTableFind(load->sections, lec->section));
+    return 0;
+}
+
+// Teacher load from the column table: each distinct teacher string is classified
+// and normalized once, then the rows only index per-teacher counters. Teachers
+// get their entries in order of first appearance, as in the row scan.
+static int teacherLoadColumns(const LectureColumns *columns, TeacherLoad loads[], int max)
+{
+    const StringColumn *faculties = &columns->faculties;
+    size_t teacherBytes = sizeof(int) * (faculties->count > 0 ? faculties->count : 1);
+    int *teacherOf = (int *)memAlloc(MEM_COLUMNS, teacherBytes);
+    StringColumn names; // normalized names, pointing into loads
+    if (teacherOf == NULL || columnInit(&names, 256) != 0)
+    {
+        memFree(MEM_COLUMNS, teacherOf, teacherBytes);
+        columnRelease(&names);
+        return -1;
+    }
+
+    int count = 0, status = 0;
+    for (int f = 0; f < faculties->count && status == 0; f++)
+    {
+        const char *name = faculties->values[f];
+        teacherOf[f] = -1;
+        if (!isTeacher(name))
+            continue;
+        char normalizedName[MAX_LEN];
+        strcpy(normalizedName, name);
+        normalizeTeacherName(normalizedName);
+        int id = columnFind(&names, normalizedName);
+        if (id < 0 && count < max)
+        {
+            startTeacherLoad(&loads[count], normalizedName);
+            id = columnIntern(&names, loads[count].name);
+            status = id < 0 ? -1 : 0;
+            count++;
+        }
+        teacherOf[f] = id;
+    }
+    for (int row = 0; row < columns->rows && status == 0; row++)
+    {
+        int teacher = teacherOf[columns->faculty[row]];
+        if (teacher >= 0)
+            countTeacherLecture(&loads[teacher], columns->section[row]);
+    }
+    memFree(MEM_COLUMNS, teacherOf, teacherBytes);
+    columnRelease(&names);
+    return status == 0 ? count : -1;
+}
+
+typedef struct
+{
+    int lectureCount;
+    int index;
+} LoadOrder;
+
+// Lecture count descending; equal counts keep their order
+static int compareLoadOrder(const void *a, const void *b)
+{
+    const LoadOrder *x = (const LoadOrder *)a, *y = (const LoadOrder *)b;
+    if (x->lectureCount != y->lectureCount)
+        return y->lectureCount - x->lectureCount;
+    return x->index - y->index;
+}
+
+// Weekly load of every teacher (labs and free periods excluded), sorted by
+// lecture count descending. Returns the number of teachers written to loads, or
+// TT_ERR_NOMEM if they could not be sorted.
+int timetableTeacherLoad(Timetable *tt, TeacherLoad loads[], int max)
+{
+    PERF_START(start);
+    TRACE_BEGIN(span, "query", "teacher load");
+    const TimetableVersion *version = timetablePin(tt);
+    const LectureColumns *columns = scanColumns(tt, version);
+    int teacherCount = columns != NULL ? teacherLoadColumns(columns, loads, max) : -1;
+    if (teacherCount < 0)
+    {
+        TeacherLoadCtx load = {loads, 0, max, version->sections};
+        versionForEach(version, teacherLoadVisitor, &load);
+        teacherCount = load.count;
+    }
+    timetableUnpin(version);
+
+    // Sort teachers by lecture count (descending)
+    size_t orderBytes = (sizeof(LoadOrder) + sizeof(TeacherLoad)) * (teacherCount > 0 ? teacherCount : 1);
+    LoadOrder *order = (LoadOrder *)memAlloc(MEM_COLUMNS, orderBytes);
+    if (order == NULL)
+        teacherCount = TT_ERR_NOMEM;
+    else
+    {
+        TeacherLoad *sorted = (TeacherLoad *)(order + teacherCount);
+        for (int i = 0; i < teacherCount; i++)
+        {
+            order[i].lectureCount = loads[i].lectureCount;
+            order[i].index = i;
+        }
+        qsort(order, teacherCount, sizeof(LoadOrder), compareLoadOrder);
+        for (int i = 0; i < teacherCount; i++)
+            sorted[i] = loads[order[i].index];
+        memcpy(loads, sorted, sizeof(TeacherLoad) * teacherCount);
+        memFree(MEM_COLUMNS, order, orderBytes);
+    }
+    TRACE_ARG(span, teacherCount);
+    TRACE_END(span);
+    PERF_STOP(PERF_TEACHER_LOAD, start);
+    return teacherCount;
+}
+
+// Loads of every teacher in a heap array of *bytes. Every teacher with a lecture on
+// the calendar is in the teacher table, so its count is enough unless lectures off
+// the calendar add teachers; then the array is doubled until they all fit.
+static int allTeacherLoads(Timetable *tt, TeacherLoad **loads, size_t *bytes)
+{
+    int max = atomic_load(&tt->teachers.count) + 1;
+    for (;;)
+    {
+        *bytes = sizeof(TeacherLoad) * max;
+        *loads = (TeacherLoad *)memAlloc(MEM_COLUMNS, *bytes);
+        if (*loads == NULL)
+            return TT_ERR_NOMEM;
+        int count = timetableTeacherLoad(tt, *loads, max);
+        if (count >= 0 && count < max)
+            return count;
+        memFree(MEM_COLUMNS, *loads, *bytes);
+        *loads = NULL;
+        if (count < 0)
+            return count;
+        max *= 2;
+    }
+}
+
+// Figures for the statistics dashboard; TT_ERR_NOMEM if the teacher loads could
+// not be counted
+int timetableStatistics(Timetable *tt, TimetableStats *stats, SectionStats sections[], int max)
+{
+    PERF_START(start);
+    TRACE_BEGIN(span, "query", "statistics");
+    TeacherLoad *loads;
+    size_t loadBytes;
+    int teacherCount = allTeacherLoads(tt, &loads, &loadBytes);
+    if (teacherCount < 0)
+    {
+        TRACE_END(span);
+        return teacherCount;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (teacherCount > 0)
+        stats->mostLoaded = loads[0];
+    else
+        strcpy(stats->mostLoaded.name, "N/A");
+    memFree(MEM_COLUMNS, loads, loadBytes);
+
+    const TimetableVersion *version = timetablePin(tt);
+    int sectionCount = atomic_load(&version->sections->count);
+    if (sectionCount > max)
+        sectionCount = max;
+    for (int s = 0; s < sectionCount; s++)
+    {
+        memset(&sections[s], 0, sizeof(sections[s]));
+        for (int d = 0; d < DAY_COUNT; d++)
+        {
+            const Block *block = versionBlock(version, s, d);
+            int count = block ? block->count : 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (strcmp(block->lectures[i].faculty, "-") == 0)
+                    sections[s].freePeriods++;
+            }
+
+            // Busiest day for each section
+            if (count > sections[s].busiestDayLectures)
+            {
+                sections[s].busiestDayLectures = count;
+                sections[s].busiestDay = d;
+            }
+        }
+    }
+    timetableUnpin(version);
+    TRACE_END(span);
+    PERF_STOP(PERF_STATISTICS, start);
+    return sectionCount;
+}
+
+// Split the heap held by the timetable between the published version and the
+// versions only the undo stack still references
+void timetableMemory(Timetable *tt, TimetableMemory *memory)
+{
+    memset(memory, 0, sizeof(*memory));
+    memory->lectureSize = sizeof(Lecture);
+
+    // The undo stack only changes under the writer lock
+    mutexLock(&tt->writerLock);
+    const TimetableVersion *held[2 * UNDO_DEPTH + 1];
+    int heldCount = 0;
+    held[heldCount++] = tt->current;
+    for (int i = tt->top; i >= 0; i--)
+    {
+        held[heldCount++] = tt->undo[i].after;
+        held[heldCount++] = tt->undo[i].before;
+    }
+
+    VersionMemory usage = {0, 0, 0};
+    versionMemory(held[0], NULL, 0, &usage);
+    memory->lectures = versionCount(held[0]);
+    memory->lectureBytes = usage.lectureBytes;
+    memory->indexBytes = usage.indexBytes;
+    memory->blocks = usage.blocks;
+
+    // Newest first, each version is charged only for what no newer one holds
+    VersionMemory history = {0, 0, 0};
+    for (int i = 1; i < heldCount; i++)
+        versionMemory(held[i], held, i, &history);
+    memory->undoVersions = tt->top + 1;
+    memory->undoLectureBytes = history.lectureBytes;
+    memory->undoIndexBytes = history.indexBytes;
+    mutexUnlock(&tt->writerLock);
+}
+
+static void writeSectionRows(const TimetableVersion *version, int sectionId, FILE *fp, const char *separator)
+{
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        const Block *block = versionBlock(version, sectionId, d);
+        int count = block ? block->count : 0;
+        for (int i = 0; i < count; i++)
+        {
+            const Lecture *lec = &block->lectures[i];
+            fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %-25s | %s\n",
+                    lec->day,
+                    lec->time,
+                    lec->subject,
+                    getSubjectName(lec->subject),
+                    lec->faculty,
+                    lec->room);
+        }
+        if (count > 0)
+        {
+            fprintf(fp, "%s\n", separator);
+        }
+    }
+}
+
+// Write the full timetable (all sections plus subject legend) to an open file
+int timetableWrite(Timetable *tt, FILE *fp)
+{
+    time_t now = time(NULL);
+
+    // Write header
+    fprintf(fp, "================================================================\n");
+    fprintf(fp, "                        TIMETABLE DATA                            \n");
+    fprintf(fp, "                  Saved on: %s", ctime(&now));
+    fprintf(fp, "================================================================\n\n");
+
+    // Rooms with their capacities, so a reload books them the same way
+    int roomCount = timetableRoomCount(tt);
+    for (int r = 0; r < roomCount; r++)
+        fprintf(fp, "ROOM %d %s\n", timetableRoomCapacity(tt, r), timetableRoomName(tt, r));
+
+    // Write timetable data for every registered section, all from one version
+    TRACE_BEGIN(span, "io", "render");
+    const TimetableVersion *version = timetablePin(tt);
+    TRACE_ARG(span, versionCount(version));
+    int sectionCount = atomic_load(&version->sections->count);
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        fprintf(fp, "\nSECTION %s TIMETABLE\n", version->sections->names[sid]);
+        fprintf(fp, "----------------------------------------------------------------\n");
+        fprintf(fp, "%-5s | %-13s | %-8s | %-40s | %-25s | %s\n",
+                "Day", "Time", "Code", "Subject Name", "Faculty", "Room");
+        fprintf(fp, "----------------------------------------------------------------\n");
+        writeSectionRows(version, sid, fp, "----------------------------------------------------------------");
+    }
+    timetableUnpin(version);
+    TRACE_END(span);
+
+    // Write subject legend
+    fprintf(fp, "\n\nSUBJECT LEGEND:\n");
+    fprintf(fp, "----------------------------------------------------------------\n");
+    fprintf(fp, "%-8s | %-40s | %s\n", "Code", "Subject Name", "Type");
+    fprintf(fp, "----------------------------------------------------------------\n");
+    for (int i = 0; i < CURRICULUM_SIZE; i++)
+    {
+        fprintf(fp, "%-8s | %-40s | %s\n",
+                curriculum[i].code,
+                curriculum[i].name,
+                curriculum[i].isLab ? "Lab" : "Theory");
+    }
+    fprintf(fp, "----------------------------------------------------------------\n");
+
+    fprintf(fp, "\n================================================================\n");
+    fprintf(fp, "                          END OF DATA                             \n");
+    fprintf(fp, "================================================================\n");
+    return ferror(fp) ? TT_ERR_IO : TT_OK;
+}
+
+// Write a single section in the short per-section file layout
+int timetableWriteSection(Timetable *tt, const char *section, FILE *fp)
+{
+    fprintf(fp, "==============================\n");
+    fprintf(fp, "  SECTION %s TIMETABLE\n", section);
+    fprintf(fp, "==============================\n");
+    const TimetableVersion *version = timetablePin(tt);
+    writeSectionRows(version, sectionTableFind(version->sections, section), fp, "----------------------------------------------");
+    timetableUnpin(version);
+    return ferror(fp) ? TT_ERR_IO : TT_OK;
+}
+
+unsigned long long timetableSectionHash(Timetable *tt, const char *section)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    int sid = sectionTableFind(version->sections, section);
+    unsigned long long hash = sid >= 0 ? versionSectionHash(version, sid) : 0;
+    timetableUnpin(version);
+    return hash;
+}
+
+// Sections in id order with their names, then the rooms with their capacities
+unsigned long long timetableContentHash(Timetable *tt)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    const TimetableVersion *version = timetablePin(tt);
+    int sectionCount = atomic_load(&version->sections->count);
+    for (int sid = 0; sid < sectionCount; sid++)
+    {
+        for (const char *c = version->sections->names[sid]; *c; c++)
+            hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+        hash = (hash ^ versionSectionHash(version, sid)) * 1099511628211ull;
+    }
+    timetableUnpin(version);
+    int roomCount = timetableRoomCount(tt);
+    for (int r = 0; r < roomCount; r++)
+    {
+        for (const char *c = timetableRoomName(tt, r); *c; c++)
+            hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+        hash = (hash ^ (unsigned long long)timetableRoomCapacity(tt, r)) * 1099511628211ull;
+    }
+    return hash + (hash == 0);
+}
+
+int timetableSave(Timetable *tt, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return TT_ERR_IO;
+    PERF_START(start);
+    TRACE_BEGIN(span, "io", "save");
+    int status = timetableWrite(tt, fp);
+    if (fclose(fp) != 0)
+        status = TT_ERR_IO;
+    TRACE_END(span);
+    PERF_STOP(PERF_SAVE, start);
+    return status;
+}
+
+// Add one lecture read from a file to the version being loaded, registering its
+// room; returns 1, 0 for a row naming no known day or -1 if out of memory
+static int loadRow(Timetable *tt, TimetableVersion *draft, int sid, const char *day, const char *time,
+                   const char *subject, const char *faculty, const char *room)
+{
+    int d = dayIndex(day);
+    if (d < 0)
+        return 0;
+    Lecture lec;
+    makeLecture(&lec, day, time, subject, faculty, draft->sections->names[sid]);
+    lec.periods = lecturePeriods(tt, d, time);
+    if (strlen(room) < ROOM_NAME_LEN)
+        strcpy(lec.room, room);
+    splitLegacyRoom(&lec);
+    if (lec.room[0] != '\0' && roomTableAdd(&tt->rooms, lec.room, 1) < 0)
+        lec.room[0] = '\0';
+    return draftInsert(draft, sid, d, &lec) == TT_OK ? 1 : -1;
+}
+
+// Replace the timetable with the contents of a saved file, returns lectures read.
+// The file is parsed into a fresh version that is published only once complete,
+// so readers never see a half-loaded timetable.
+int timetableLoad(Timetable *tt, const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return TT_ERR_IO;
+
+    PERF_START(start);
+    TRACE_BEGIN(span, "io", "load");
+    mutexLock(&tt->writerLock);
+    TimetableVersion *loadedVersion = versionCreateEmpty(&tt->sections, &tt->rooms, &tt->teachers, ++tt->nextId);
+    if (loadedVersion == NULL)
+    {
+        mutexUnlock(&tt->writerLock);
+        fclose(fp);
+        TRACE_END(span);
+        return TT_ERR_NOMEM;
+    }
+
+    // Parsing and building the version's blocks happen line by line in one pass
+    TRACE_BEGIN(parseSpan, "io", "parse and index");
+    int loaded = 0;
+    char line[256];
+    char day[10], time[20], subject[50], faculty[50], room[64];
+    char section[64] = "";
+
+    // Skip header until we find a section
+    while (fgets(line, sizeof(line), fp))
+    {
+        int capacity;
+        if (strncmp(line, "ROOM ", 5) == 0 && sscanf(line + 5, "%d %63[^\n]", &capacity, room) == 2)
+        {
+            trim(room);
+            int roomId = capacity > 0 ? roomTableAdd(&tt->rooms, room, capacity) : -1;
+            if (roomId >= 0)
+                atomic_store(&tt->rooms.capacity[roomId], capacity);
+            continue;
+        }
+        if (strncmp(line, "SECTION", 7) != 0)
+            continue;
+        if (sscanf(line + 7, " %63s", section) != 1)
+            continue;
+        int sid = sectionTableAdd(&tt->sections, section);
+
+        // Skip header lines
+        fgets(line, sizeof(line), fp); // separator
+        fgets(line, sizeof(line), fp); // column headers
+        fgets(line, sizeof(line), fp); // separator
+
+        // Read lectures
+        while (fgets(line, sizeof(line), fp) && strlen(line) > 2)
+        {
+            // Skip the separator printed after each day, stop at the next section
+            if (strstr(line, "---") != NULL)
+                continue;
+            if (strstr(line, "SECTION") != NULL)
+                break;
+
+            // Day | Time | Code | Subject Name | Faculty | Room (the name is rebuilt from
+            // the code); files from before rooms end at the faculty
+            room[0] = '\0';
+            if (sscanf(line, "%9s | %19[^|] | %49[^|] | %*[^|] | %49[^|\n] | %63[^\n]", day, time, subject, faculty,
+                       room) < 4)
+                continue;
+            trim(time);
+            trim(subject);
+            trim(faculty);
+            trim(room);
+            int added = sid < 0 ? 0 : loadRow(tt, loadedVersion, sid, day, time, subject, faculty, room);
+            if (added < 0)
+            {
+                versionRelease(loadedVersion);
+                mutexUnlock(&tt->writerLock);
+                fclose(fp);
+                TRACE_END(parseSpan);
+                TRACE_END(span);
+                return TT_ERR_NOMEM;
+            }
+            loaded += added;
+        }
+    }
+    fclose(fp);
+    TRACE_ARG(parseSpan, loaded);
+    TRACE_END(parseSpan);
+
+    TRACE_BEGIN(publishSpan, "edit", "publish");
+    versionRelease(publish(tt, loadedVersion));
+    clearUndo(tt);
+    mutexUnlock(&tt->writerLock);
+    TRACE_END(publishSpan);
+    TRACE_ARG(span, loaded);
+    TRACE_END(span);
+    PERF_STOP(PERF_LOAD, start);
+    return loaded;
+}
+
+// Split a CSV record in place; fields[] point into line, quotes removed. Returns
+// the number of fields (at most max), -1 for an unterminated quote.
+static int splitCsv(char *line, char *fields[], int max)
+{
+    line[strcspn(line, "\r\n")] = '\0';
+    int count = 0;
+    char *in = line;
+    for (;;)
+    {
+        char *out = in;
+        if (count < max)
+            fields[count] = out;
+        count++;
+        if (*in == '"')
+        {
+            for (in++;; in++)
+            {
+                if (*in == '\0')
+                    return -1;
+                if (*in == '"' && in[1] != '"')
+                    break;
+                if (*in == '"')
+                    in++;
+                *out++ = *in;
+            }
+            in++;
+        }
+        while (*in != ',' && *in != '\0')
+            *out++ = *in++;
+        int last = *in == '\0';
+        *out = '\0';
+        if (last)
+            return count < max ? count : max;
+        in++;
+    }
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c = (char)(c | 0x20);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// Decode the JSON string starting after its opening quote in place; returns the
+// character after the closing quote, NULL if malformed
+static char *decodeJsonString(char *in, char **value)
+{
+    char *out = in;
+    *value = out;
+    for (; *in != '"'; in++)
+    {
+        if (*in == '\0')
+            return NULL;
+        if (*in != '\\')
+        {
+            *out++ = *in;
+            continue;
+        }
+        in++;
+        const char *plain = strchr("\"\\/bfnrt", *in);
+        if (plain != NULL && *in != '\0')
+        {
+            *out++ = "\"\\/\b\f\n\r\t"[plain - "\"\\/bfnrt"];
+            continue;
+        }
+        if (*in != 'u')
+            return NULL;
+        unsigned int code = 0;
+        for (int i = 1; i <= 4; i++)
+        {
+            int digit = hexDigit(in[i]);
+            if (digit < 0)
+                return NULL;
+            code = code * 16 + (unsigned int)digit;
+        }
+        in += 4;
+        // Only the Basic Multilingual Plane; a surrogate half becomes U+FFFD
+        if (code >= 0xd800 && code <= 0xdfff)
+            code = 0xfffd;
+        if (code < 0x80)
+            *out++ = (char)code;
+        else if (code < 0x800)
+        {
+            *out++ = (char)(0xc0 | code >> 6);
+            *out++ = (char)(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            *out++ = (char)(0xe0 | code >> 12);
+            *out++ = (char)(0x80 | (code >> 6 & 0x3f));
+            *out++ = (char)(0x80 | (code & 0x3f));
+        }
+    }
+    *out = '\0';
+    return in + 1;
+}
+
+static char *skipSpace(char *in)
+{
+    while (*in == ' ' || *in == '\t' || *in == '\r' || *in == '\n')
+        in++;
+    return in;
+}
+
+// Parse a flat JSON object in place, setting values[i] to the string value of
+// keys[i] ("" when the key is missing or not a string); other keys are ignored. Returns 0,
+// or -1 if the line is not such an object.
+static int parseJsonObject(char *line, const char *const keys[], char *values[], int count)
+{
+    static char empty[] = "";
+    for (int i = 0; i < count; i++)
+        values[i] = empty;
+    char *in = skipSpace(line);
+    if (*in++ != '{')
+        return -1;
+    in = skipSpace(in);
+    if (*in == '}')
+        return 0;
+    for (;;)
+    {
+        char *key, *value = empty;
+        if (*in != '"' || (in = decodeJsonString(in + 1, &key)) == NULL)
+            return -1;
+        in = skipSpace(in);
+        if (*in++ != ':')
+            return -1;
+        in = skipSpace(in);
+        if (*in == '"')
+        {
+            if ((in = decodeJsonString(in + 1, &value)) == NULL)
+                return -1;
+        }
+        else
+        {
+            // null, a number or a boolean: not a string, so the key counts as missing
+            size_t length = strcspn(in, ",} \t\r\n");
+            if (length == 0 || *in == '{' || *in == '[')
+                return -1;
+            in += length;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(key, keys[i]) == 0)
+                values[i] = value;
+        }
+        in = skipSpace(in);
+        if (*in == '}')
+            return 0;
+        if (*in++ != ',')
+            return -1;
+        in = skipSpace(in);
+    }
+}
+
+int timetableReadRows(Timetable *tt, int format, FILE *fp, int *rejected)
+{
+    static const char *const keys[] = {"section", "day", "time", "code", "faculty", "room"};
+    if (rejected != NULL)
+        *rejected = 0;
+    if (format != EXPORT_CSV && format != EXPORT_JSONL)
+        return TT_ERR_INVALID;
+
+    PERF_START(start);
+    TRACE_BEGIN(span, "io", "read rows");
+    mutexLock(&tt->writerLock);
+    TimetableVersion *loadedVersion = versionCreateEmpty(&tt->sections, &tt->rooms, &tt->teachers, ++tt->nextId);
+    if (loadedVersion == NULL)
+    {
+        mutexUnlock(&tt->writerLock);
+        TRACE_END(span);
+        return TT_ERR_NOMEM;
+    }
+
+    // One record per line, parsed in place: memory stays the same however long the file
+    int loaded = 0, skipped = 0, first = 1;
+    char line[ROW_LINE_LEN];
+    char *fields[7];
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strchr(line, '\n') == NULL && !feof(fp))
+        {
+            // Longer than any row that was written; drop the rest of it
+            int c;
+            while ((c = fgetc(fp)) != '\n' && c != EOF)
+                ;
+            skipped++;
+            continue;
+        }
+        if (line[strspn(line, " \t\r\n")] == '\0')
+            continue;
+        int ok;
+        if (format == EXPORT_CSV)
+        {
+            // section,day,time,code,subject,faculty,room; the subject name is rebuilt from the code
+            int count = splitCsv(line, fields, 7);
+            if (first && count > 0 && strcmp(fields[0], "section") == 0)
+            {
+                first = 0;
+                continue;
+            }
+            ok = count >= 6;
+            if (ok)
+            {
+                fields[4] = fields[5];
+                fields[5] = count == 7 ? fields[6] : "";
+            }
+        }
+        else
+            ok = parseJsonObject(line, keys, fields, 6) == 0;
+        first = 0;
+        int sid = ok ? sectionTableAdd(&tt->sections, fields[0]) : -1;
+        int added = sid < 0 ? 0 : loadRow(tt, loadedVersion, sid, fields[1], fields[2], fields[3], fields[4], fields[5]);
+        if (added < 0)
+        {
+            versionRelease(loadedVersion);
+            mutexUnlock(&tt->writerLock);
+            TRACE_END(span);
+            return TT_ERR_NOMEM;
+        }
+        loaded += added;
+        skipped += !added;
+    }
+    if (ferror(fp))
+    {
+        versionRelease(loadedVersion);
+        mutexUnlock(&tt->writerLock);
+        TRACE_END(span);
+        return TT_ERR_IO;
+    }
+
+    versionRelease(publish(tt, loadedVersion));
+    clearUndo(tt);
+    mutexUnlock(&tt->writerLock);
+    if (rejected != NULL)
+        *rejected = skipped;
+    TRACE_ARG(span, loaded);
+    TRACE_END(span);
+    PERF_STOP(PERF_LOAD, start);
+    return loaded;
+}
+
+// Queue one patch row: a removal on txn, an addition on adds. Returns TT_OK or a status.
+static int queuePatchRow(TimetableTxn *txn, TimetableTxn *adds, char *fields[], int count, int line)
+{
+    int remove = strcmp(fields[0], "-") == 0;
+    if ((!remove && strcmp(fields[0], "+") != 0) || count < 6 || dayIndex(fields[2]) < 0 ||
+        (count == 7 && strlen(fields[6]) >= ROOM_NAME_LEN))
+        return TT_ERR_INVALID;
+    TxnOp *op = queueOp(remove ? txn : adds, remove ? TXN_REMOVE : TXN_INSERT);
+    if (op == NULL)
+        return TT_ERR_NOMEM;
+    Lecture *lec = remove ? &op->second : &op->first;
+    makeLecture(lec, fields[2], fields[3], fields[4], fields[5], fields[1]);
+    strcpy(lec->room, count == 7 ? fields[6] : "");
+    if (remove)
+    {
+        makeLecture(&op->first, fields[2], fields[3], "", "", fields[1]);
+        op->expect = 1;
+    }
+    op->line = line;
+    return TT_OK;
+}
+
+int timetableApplyPatch(Timetable *tt, FILE *fp, TxnFailure *failure)
+{
+    if (failure != NULL)
+    {
+        memset(failure, 0, sizeof(*failure));
+        failure->op = -1;
+    }
+    TimetableTxn *txn = timetableBegin(tt), *adds = timetableBegin(tt);
+    int status = txn != NULL && adds != NULL ? TT_OK : TT_ERR_NOMEM;
+    int line = -1;
+    char text[ROW_LINE_LEN];
+    char *fields[7];
+    while (status == TT_OK && fgets(text, sizeof(text), fp))
+    {
+        line++;
+        if (strchr(text, '\n') == NULL && !feof(fp))
+            status = TT_ERR_INVALID;
+        else if (text[strspn(text, " \t\r\n")] != '\0')
+        {
+            int count = splitCsv(text, fields, 7);
+            if (count < 1)
+                status = TT_ERR_INVALID;
+            else if (line > 0 || strcmp(fields[0], "op") != 0)
+                status = queuePatchRow(txn, adds, fields, count, line);
+        }
+    }
+    if (status == TT_OK && ferror(fp))
+        status = TT_ERR_IO;
+
+    // Every removal names a lecture of the older version, so they all go first
+    for (int i = 0; status == TT_OK && i < adds->count; i++)
+    {
+        TxnOp *op = queueOp(txn, TXN_INSERT);
+        if (op == NULL)
+            status = TT_ERR_NOMEM;
+        else
+            *op = adds->ops[i];
+    }
+    timetableRollback(adds);
+    if (status != TT_OK)
+    {
+        if (failure != NULL && line >= 0 && status != TT_ERR_NOMEM && status != TT_ERR_IO)
+            failure->op = line;
+        timetableRollback(txn);
+        return status;
+    }
+
+    // Not validated: the result is the newer timetable, clashes and all, as loading it would be
+    int count = txn->count;
+    status = count > 0 ? applyTxn(txn, 0, failure) : TT_OK;
+    if (failure != NULL && failure->op >= 0)
+        failure->op = txn->ops[failure->op].line;
+    timetableRollback(txn);
+    return status == TT_OK ? count : status;
+}
+
+// Plan against a draft of our version, then make their steps on it. A step's slot
+// is one we left alone, so its base lecture is still the one there at that time.
+int timetableMerge(Timetable *tt, const TimetableVersion *base, const TimetableVersion *theirs, MergeVisitor visit,
+                   void *ctx, MergeReport *report)
+{
+    TimetableVersion *draft = beginEdit(tt);
+    if (draft == NULL)
+        return TT_ERR_NOMEM;
+    TRACE_BEGIN(span, "edit", "merge");
+    MergePlan plan;
+    int status = planMerge(base, draft, theirs, visit, ctx, &plan, report);
+    for (int i = 0; i < plan.count && status == TT_OK; i++)
+    {
+        const MergeStep *step = &plan.steps[i];
+        if (step->before != NULL)
+            status = draftRemove(draft, step->sectionId, step->day, step->before->time, NULL);
+        if (step->after != NULL && status == TT_OK)
+            status = draftInsert(draft, step->sectionId, step->day, step->after);
+    }
+    TRACE_ARG(span, plan.count);
+    TRACE_END(span);
+    int changed = plan.count > 0;
+    mergePlanFree(&plan);
+    if (status == TT_OK && !changed)
+    {
+        abortEdit(tt, draft); // nothing of theirs to take, keep the undo history as it is
+        return TT_OK;
+    }
+    return finishEdit(tt, draft, status, 1);
+}
+
+// Function to get subject name from code; returns the code itself for unknown subjects
+const char *getSubjectName(const char *subjectCode)
+{
+    for (int i = 0; i < CURRICULUM_SIZE; i++)
+    {
+        if (strcmp(curriculum[i].code, subjectCode) == 0)
+            return curriculum[i].name;
+    }
+    return subjectCode;
+}
+
+// Whether the curriculum runs a subject as a lab, 0 for subjects it does not list
+int subjectIsLab(const char *subjectCode)
+{
+    for (int i = 0; i < CURRICULUM_SIZE; i++)
+    {
+        if (strcmp(curriculum[i].code, subjectCode) == 0)
+            return curriculum[i].isLab;
+    }
+    return 0;
+}
+
+// Function to get unique subjects from the curriculum
+void getUniqueSubjects(SubjectInfo subjects[], int *count)
+{
+    for (*count = 0; *count < CURRICULUM_SIZE; (*count)++)
+        subjects[*count] = curriculum[*count];
+}
+
+// Index of a day code (MON..SAT) or -1
+int dayIndex(const char *day)
+{
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        if (strcmp(DAY_CODES[d], day) == 0)
+            return d;
+    }
+    return -1;
+}
+
+const char *timetableStrError(int status)
+{
+    switch (status)
+    {
+    case TT_OK:
+        return "ok";
+    case TT_ERR_NOT_FOUND:
+        return "no lecture at that slot";
+    case TT_ERR_OCCUPIED:
+        return "slot already occupied";
+    case TT_ERR_IO:
+        return "file error";
+    case TT_ERR_NOMEM:
+        return "out of memory";
+    case TT_ERR_INVALID:
+        return "invalid argument";
+    case TT_ERR_EMPTY:
+        return "nothing to undo";
+    case TT_ERR_CONFLICT:
+        return "conflicts with another lecture";
+    }
+    return "unknown error";
+}
+
+// Helper: case-insensitive substring search (portable strcasestr)
+char *strcasestr_portable(const char *haystack, const char *needle)
+{
+    if (!*needle)
+        return (char *)haystack;
+    for (; *haystack; haystack++)
+    {
+        const char *h = haystack, *n = needle;
+        while (*h && *n && tolower((unsigned char)*h) == tolower((unsigned char)*n))
+        {
+            h++;
+            n++;
+        }
+        if (!*n)
+            return (char *)haystack;
+    }
+    return NULL;
+}
+
+// Function to trim whitespace from a string (in place)
+void trim(char *str)
+{
+    char *start = str;
+    while (isspace((unsigned char)*start))
+        start++;
+
+    size_t len = strlen(start);
+    while (len > 0 && isspace((unsigned char)start[len - 1]))
+        len--;
+
+    memmove(str, start, len);
+    str[len] = '\0';
+}
@@ -0,0 +1,407 @@
+// Classroom Scheduler core library.
+//
+// All timetable state lives behind an opaque Timetable handle, so a program can
+// hold several timetables at once. The timetable is a chain of immutable,
+// copy-on-write versions: every edit builds a new version that shares all the
+// unchanged parts with the previous one and then publishes it in one step.
+// Writers are serialized; readers pin the current version and never wait for
+// them. Visitor callbacks run on a pinned version and may call other read
+// functions, but must not call write functions of the same timetable.
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdio.h>
+#include "calendar.h"
+
+#define MAX_LEN 100
+#define DAY_COUNT 6
+#define MAX_SECTIONS 1024
+#define SECTION_NAME_LEN 16 // section names such as "A" or "MCA2-B", without spaces or '|'
+#define MAX_ROOMS 256
+#define ROOM_NAME_LEN 16 // room names such as "LT-402" or "Lab 7", without '|'
+#define MAX_DAY_LECTURES MAX_PERIODS
+
+// Status codes returned by the write and lookup functions
+#define TT_OK 0
+#define TT_ERR_NOT_FOUND -1
+#define TT_ERR_OCCUPIED -2
+#define TT_ERR_IO -3
+#define TT_ERR_NOMEM -4
+#define TT_ERR_INVALID -5
+#define TT_ERR_EMPTY -6
+#define TT_ERR_CONFLICT -7
+
+typedef struct Lecture
+{
+    char day[MAX_LEN];
+    char time[MAX_LEN];
+    char subject[MAX_LEN];
+    char faculty[MAX_LEN];
+    char section[SECTION_NAME_LEN];
+    char room[ROOM_NAME_LEN]; // "" when no room is booked
+    unsigned int periods;     // periods of its day it occupies (see calendarPeriodMask), set by the library
+} Lecture;
+
+// Structure to store teacher workload
+typedef struct
+{
+    char name[MAX_LEN];
+    int lectureCount;
+    unsigned char sections[MAX_SECTIONS / 8]; // bit per section id they teach
+    int sectionCount;
+} TeacherLoad;
+
+#define TEACHES_SECTION(load, sectionId) (((load)->sections[(sectionId) / 8] >> ((sectionId) % 8)) & 1)
+
+// Structure to store subject information
+typedef struct
+{
+    char code[MAX_LEN];
+    char name[MAX_LEN];
+    int isLab;
+} SubjectInfo;
+
+// Structure to store time slot information
+typedef struct
+{
+    char day[4];
+    char time[MAX_LEN];
+    char section[SECTION_NAME_LEN];
+} TimeSlot;
+
+// Summary figures shown by the statistics dashboard
+typedef struct
+{
+    TeacherLoad mostLoaded; // lectureCount is 0 when there are no teachers
+} TimetableStats;
+
+// Per-section figures of the dashboard, indexed by section id
+typedef struct
+{
+    int busiestDay;
+    int busiestDayLectures;
+    int freePeriods;
+} SectionStats;
+
+// Utilisation of one room over the week, from timetableRoomUsage
+typedef struct
+{
+    char name[ROOM_NAME_LEN];
+    int capacity;          // sections it holds at once
+    int bookedPeriods;     // periods with at least one lecture
+    int availablePeriods;  // periods of the calendar's week
+    int bookings;          // lecture-periods, a two period lab counts twice
+    int overbookedPeriods; // periods holding more lectures than the capacity
+} RoomUsage;
+
+// Outcome of timetableAllocateRooms
+typedef struct
+{
+    int lectures;          // lectures that need a room: on the calendar's periods and not free periods
+    int placed;            // of them, the ones in a room after the pass
+    int moved;             // lectures the pass gave another room
+    int roomChangesBefore; // times a section moves room between lectures of a day, before the pass
+    int roomChanges;       // and after it
+} RoomPlan;
+
+// Heap held by one timetable, split between the published version and undo history.
+// Nodes shared by several versions are counted once, with the newest version holding them.
+typedef struct
+{
+    int lectures;            // lectures in the published version
+    size_t lectureSize;      // sizeof(Lecture)
+    size_t lectureBytes;     // lecture blocks of the published version, with spare capacity
+    size_t indexBytes;       // its version header, section chunks and day tables
+    long blocks;             // its lecture blocks (one per section and day)
+    int undoVersions;        // edits on the undo stack
+    size_t undoLectureBytes; // blocks kept alive only by undo history
+    size_t undoIndexBytes;   // index nodes kept alive only by undo history
+} TimetableMemory;
+
+// File formats of timetableExportSections and the row readers and writers
+#define EXPORT_TEXT 1  // the layout of timetableWriteSection
+#define EXPORT_CSV 2   // one lecture per row: section,day,time,code,subject,faculty,room
+#define EXPORT_JSONL 3 // one lecture per line as a JSON object with the same keys
+
+// Outcome of timetableExportSections
+typedef struct
+{
+    int sections;    // files written, one per section
+    int lectures;    // lectures in them
+    long long bytes; // bytes written, the manifest included
+    int threads;     // threads that formatted and wrote them
+} ExportReport;
+
+// Outcome of timetableExportCalendars
+typedef struct
+{
+    int sections;    // section calendars written
+    int teachers;    // teacher calendars written
+    int events;      // weekly events, one per lecture on the term's weekdays
+    long long bytes; // bytes written
+} CalendarReport;
+
+// Kinds of change timetableDiff reports
+#define DIFF_ADDED 1     // a lecture only the newer version has
+#define DIFF_REMOVED 2   // a lecture only the older version has
+#define DIFF_MOVED 3     // the same subject and teacher in another slot of the section
+#define DIFF_RESTAFFED 4 // the same slot and subject with another teacher (and maybe room)
+#define DIFF_ROOM 5      // the same slot, subject and teacher in another room
+
+// Outcome of timetableDiff, changes counted by kind
+typedef struct
+{
+    int added;
+    int removed;
+    int moved;
+    int restaffed;
+    int rooms;
+    int sections; // sections with at least one change
+} DiffReport;
+
+// Kinds of conflict timetableMerge reports
+#define MERGE_SLOT 1    // both sides changed a slot differently, or their lecture overlaps our new one
+#define MERGE_TEACHER 2 // their lecture would double-book a teacher with our new one
+
+// Outcome of timetableMerge, counted in slots
+typedef struct
+{
+    int ours;      // slots we changed, all kept
+    int theirs;    // slots only they changed, their change applied
+    int same;      // slots both sides changed the same way
+    int conflicts; // slots they changed that conflict with our changes, left as ours
+} MergeReport;
+
+// Fields searchTimetable can match on
+#define SEARCH_TEACHER 1
+#define SEARCH_SUBJECT 2
+#define SEARCH_TIME 3
+
+// Why a transaction did not commit
+typedef struct
+{
+    int op;          // index of the queued edit that failed, -1 if every edit applied
+    Lecture lecture; // TT_ERR_CONFLICT: the changed lecture that double-books a slot
+    Lecture other;   // and the lecture it clashes with (same section, teacher or room)
+} TxnFailure;
+
+typedef struct Timetable Timetable;
+typedef struct TimetableVersion TimetableVersion;
+typedef struct TimetableTxn TimetableTxn;
+
+// Called once per lecture by the iteration functions, return non-zero to stop early
+typedef int (*LectureVisitor)(const Lecture *lec, void *ctx);
+
+// Called once per difference by versionCompare: before is NULL for an added
+// lecture, after is NULL for a removed one. Return non-zero to stop early.
+typedef int (*LectureChangeVisitor)(const Lecture *before, const Lecture *after, void *ctx);
+
+// Called once per change by timetableDiff with a DIFF_ kind: before is NULL for an
+// added lecture, after is NULL for a removed one. Return non-zero to stop early.
+typedef int (*DiffVisitor)(int kind, const Lecture *before, const Lecture *after, void *ctx);
+
+// Called once per conflict by timetableMerge with a MERGE_ kind: base is the slot's
+// lecture in the common version, ours the lecture of ours it conflicts with and
+// theirs what they put in the slot, each NULL for a free slot. Return non-zero to
+// stop being called; the merge goes on.
+typedef int (*MergeVisitor)(int kind, const Lecture *base, const Lecture *ours, const Lecture *theirs, void *ctx);
+
+extern const char *const DAY_CODES[DAY_COUNT];
+extern const char *const DAY_NAMES[DAY_COUNT];
+
+// Lifetime
+Timetable *timetableCreate(void);
+void timetableDestroy(Timetable *tt);
+void timetableClear(Timetable *tt);
+
+// Sections: every section name gets a compact id, in order of first use, the first
+// time a lecture or timetableAddSection names it. Ids and names never change for the
+// life of the timetable, so per-section arrays can be indexed by id and sized by
+// timetableSectionCount; a returned name stays valid until the timetable is destroyed.
+int timetableAddSection(Timetable *tt, const char *section);
+int timetableSectionCount(Timetable *tt);
+const char *timetableSectionName(Timetable *tt, int sectionId);
+// Id of a section name, -1 if it was never used
+int timetableSectionId(Timetable *tt, const char *section);
+
+// Rooms and labs. A lecture's room is named in Lecture.room; lectures given a
+// legacy faculty such as "Sec. A (Lab 7)" have the room split off it on insert
+// and load. A room's capacity is the number of sections it holds at once (two for
+// a lecture theatre shared by a combined lecture). Naming an unknown room
+// registers it with capacity 1; inserts that would overfill a room fail with
+// TT_ERR_OCCUPIED.
+int timetableAddRoom(Timetable *tt, const char *room, int capacity);
+int timetableRoomCount(Timetable *tt);
+const char *timetableRoomName(Timetable *tt, int roomId);
+int timetableRoomId(Timetable *tt, const char *room);
+int timetableRoomCapacity(Timetable *tt, int roomId);
+// Whether a room can take a lecture at day/time, a constant time mask test
+int timetableIsRoomFree(Timetable *tt, const char *room, const char *day, const char *time);
+// Fills usage for the first max rooms, returns how many were filled
+int timetableRoomUsage(Timetable *tt, RoomUsage usage[], int max);
+// Give lectures rooms within the capacities, keeping each section in as few rooms
+// a day as possible and combined lectures together (see roomplan.h). With replan
+// every lecture is planned afresh, otherwise only those without a room are, around
+// the rooms already booked. The assignments are written back as one undoable edit;
+// a lecture no room has space for is left without one.
+int timetableAllocateRooms(Timetable *tt, int replan, RoomPlan *plan);
+
+// Writes
+int timetableInsertLecture(Timetable *tt, const char *day, const char *time, const char *subject,
+                           const char *faculty, const char *section);
+int timetableSwap(Timetable *tt, const char *section1, const char *day1, const char *time1,
+                  const char *section2, const char *day2, const char *time2, int swapTeacher);
+int timetableMoveSection(Timetable *tt, const char *oldSection, const char *day, const char *time,
+                         const char *newSection);
+int timetableAssignSubject(Timetable *tt, const char *subject, const char *teacherName);
+int timetableSetRoom(Timetable *tt, const char *section, const char *day, const char *time, const char *room);
+int timetableMarkUnavailable(Timetable *tt, const char *faculty, const char *section);
+int timetableUndo(Timetable *tt, Lecture *restored);
+
+// Transactions: queue edits, then apply them all or none. Commit replays the queue on
+// the current timetable, checks once that no changed lecture double-books its section
+// slot or its teacher or overfills its room, and publishes the result as a single
+// undoable edit. Commit and rollback both free the transaction.
+TimetableTxn *timetableBegin(Timetable *tt);
+int txnInsertLecture(TimetableTxn *txn, const char *day, const char *time, const char *subject,
+                     const char *faculty, const char *section);
+int txnSwap(TimetableTxn *txn, const char *section1, const char *day1, const char *time1,
+            const char *section2, const char *day2, const char *time2, int swapTeacher);
+int txnMoveSection(TimetableTxn *txn, const char *oldSection, const char *day, const char *time,
+                   const char *newSection);
+int txnAssignSubject(TimetableTxn *txn, const char *subject, const char *teacherName);
+int txnSetRoom(TimetableTxn *txn, const char *section, const char *day, const char *time, const char *room);
+int txnRemoveLecture(TimetableTxn *txn, const char *section, const char *day, const char *time);
+int txnCount(const TimetableTxn *txn);
+int timetableCommit(TimetableTxn *txn, TxnFailure *failure);
+void timetableRollback(TimetableTxn *txn);
+
+// Reads (thread-safe, results are copied out)
+int timetableCount(Timetable *tt);
+int timetableGetLecture(Timetable *tt, const char *section, const char *day, const char *time, Lecture *out);
+// A slot is free when no lecture of the section is at that time or overlaps its periods
+int timetableIsSlotFree(Timetable *tt, const char *section, const char *day, const char *time);
+// Occupancy masks of a day, bit p set when period p is taken by a lecture or a block
+unsigned int timetableSectionPeriods(Timetable *tt, const char *section, const char *day);
+unsigned int timetableTeacherPeriods(Timetable *tt, const char *faculty, const char *day);
+int timetableCollectDay(Timetable *tt, const char *section, const char *day, Lecture out[], int max);
+int timetableHasSection(Timetable *tt, const char *section);
+int timetableForEach(Timetable *tt, LectureVisitor visit, void *ctx);
+int timetableSearch(Timetable *tt, int field, const char *query, LectureVisitor visit, void *ctx);
+int timetableFindSubjectSlots(Timetable *tt, const char *subject, TimeSlot slots[], int max);
+int timetableTeacherLoad(Timetable *tt, TeacherLoad loads[], int max);
+// Fills sections[id] for the first max section ids, returns how many were filled
+// or TT_ERR_NOMEM
+int timetableStatistics(Timetable *tt, TimetableStats *stats, SectionStats sections[], int max);
+void timetableMemory(Timetable *tt, TimetableMemory *memory);
+// Search, subject slots and teacher load scan a per-version column table (the
+// default); pass 0 to scan the lecture rows instead
+void timetableSetColumnar(Timetable *tt, int enabled);
+
+// Period calendar: which periods each day has. A timetable starts with the default
+// calendar; setting another takes ownership of it and maps every lecture onto the
+// new periods, which also clears the undo history. A returned calendar stays valid
+// until the timetable is destroyed, even after it is replaced.
+const Calendar *timetableCalendar(Timetable *tt);
+int timetableSetCalendar(Timetable *tt, Calendar *calendar);
+
+// Versions: a pinned version never changes and stays valid until unpinned,
+// whatever edits are published meanwhile
+const TimetableVersion *timetablePin(Timetable *tt);
+void timetableUnpin(const TimetableVersion *version);
+unsigned long versionId(const TimetableVersion *version);
+int versionCount(const TimetableVersion *version);
+int versionDay(const TimetableVersion *version, const char *section, int day, const Lecture **lectures);
+unsigned int versionDayPeriods(const TimetableVersion *version, const char *section, int day);
+// The lecture holding a slot: the one starting at time, otherwise the one taking
+// any of periods (time's calendar mask), so a period inside a block finds the
+// block. NULL if the slot is free.
+const Lecture *versionSlot(const TimetableVersion *version, const char *section, int day, const char *time,
+                           unsigned int periods);
+int versionForEach(const TimetableVersion *version, LectureVisitor visit, void *ctx);
+int versionCompare(const TimetableVersion *before, const TimetableVersion *after,
+                   LectureChangeVisitor visit, void *ctx);
+// Changes between two versions of one timetable, section by section in section id,
+// day and time order, classified by kind. To compare two files, load them one
+// after the other into the same timetable and pin the version after each load.
+// Lectures are matched by (section, day, time) in one linear pass; a removal and
+// an addition of the same subject and teacher within a section are reported as
+// one move. Returns TT_OK, or TT_ERR_INVALID for versions of different timetables.
+int timetableDiff(const TimetableVersion *before, const TimetableVersion *after, DiffVisitor visit, void *ctx,
+                  DiffReport *report);
+// Write the changes as a patch: CSV rows op,section,day,time,code,faculty,room
+// under a header, "-" for a lecture of the older version to take out and "+" for
+// one of the newer version to put in. A move or a change of teacher or room is a
+// "-" and a "+" row.
+int timetableWritePatch(const TimetableVersion *before, const TimetableVersion *after, FILE *fp,
+                        DiffReport *report);
+// Apply a patch to the timetable as one undoable edit: every "-" lecture must be in
+// place as written, and the removals are applied before the additions whatever the
+// order of the rows. Like a load, the result is not checked for clashes, so a patch
+// reproduces the newer timetable exactly. Returns the number of rows applied; on
+// failure nothing changes and failure->op is the line of the failing row, counted from 0.
+int timetableApplyPatch(Timetable *tt, FILE *fp, TxnFailure *failure);
+// Three-way merge: the timetable is our edited copy of base, and theirs another
+// edit of base (both versions of this timetable, for files loaded into it one
+// after the other). Every change only they made is applied to ours as one undoable
+// edit. A slot both sides changed differently, or a lecture of theirs that would
+// double-book a teacher or a section's periods next to one of our new lectures, is
+// a conflict: it is passed to visit and keeps our version. Clashes either side
+// already had are not conflicts. Linear in the lectures the versions do not share.
+int timetableMerge(Timetable *tt, const TimetableVersion *base, const TimetableVersion *theirs, MergeVisitor visit,
+                   void *ctx, MergeReport *report);
+
+// Persistence
+int timetableWrite(Timetable *tt, FILE *fp);
+int timetableWriteSection(Timetable *tt, const char *section, FILE *fp);
+int timetableSave(Timetable *tt, const char *filename);
+int timetableLoad(Timetable *tt, const char *filename);
+// Content hashes of what timetableWriteSection and timetableWrite print, apart from
+// the date stamp: equal hashes mean an earlier export is still current. Days an edit
+// did not touch keep their hash from earlier calls, so rehashing after an edit
+// costs only the days it changed. 0 for a section never used.
+unsigned long long timetableSectionHash(Timetable *tt, const char *section);
+unsigned long long timetableContentHash(Timetable *tt);
+// Write every section of one version to its own file in directory (created if
+// missing), section_<name>.txt or .csv, then manifest.csv listing each section's
+// file, lectures, bytes and content hash. Sections are formatted into memory on
+// threads (0 for one per processor), each file is written with a single call and
+// the manifest last, so an export that fails midway leaves no manifest.
+int timetableExportSections(Timetable *tt, const char *directory, int format, int threads, ExportReport *report);
+// Stream every lecture as CSV (with a header row) or JSON lines, section by
+// section from one version, through a buffer the size of one section; returns the
+// number of lectures written or TT_ERR_IO.
+int timetableWriteRows(Timetable *tt, int format, FILE *fp);
+// Replace the timetable with the lectures of a CSV or JSON lines stream, read one
+// line at a time: like timetableLoad, the result is published in one step and the
+// undo history cleared. The subject name is rebuilt from the code; unknown keys and
+// columns past the room are ignored. Returns the lectures loaded; rejected (if not
+// NULL) gets the number of lines that were not lectures.
+int timetableReadRows(Timetable *tt, int format, FILE *fp, int *rejected);
+// iCalendar (.ics): every lecture is one event repeating weekly (RRULE) from its
+// first day in the term to the term's last day, so the file size does not depend
+// on the term's length. termStart and termEnd are YYYY-MM-DD; times are local.
+// timetableWriteCalendar writes the calendar of one section or one teacher (the
+// other NULL) and returns the events written. timetableExportCalendars writes
+// section_<name>.ics for every section and teacher_<name>.ics for every teacher
+// into directory in one pass over the lectures. In a teacher's calendar a combined
+// lecture (several sections at one start) is one event listing its sections.
+// Free periods and lab groups in the faculty field get no calendar of their own.
+int timetableWriteCalendar(Timetable *tt, const char *section, const char *teacher, const char *termStart,
+                           const char *termEnd, FILE *fp);
+int timetableExportCalendars(Timetable *tt, const char *directory, const char *termStart, const char *termEnd,
+                             CalendarReport *report);
+
+// Curriculum and helpers (no timetable state, always safe to call)
+const char *getSubjectName(const char *subjectCode);
+int subjectIsLab(const char *subjectCode);
+void getUniqueSubjects(SubjectInfo subjects[], int *count);
+int dayIndex(const char *day);
+// Whether a faculty field names a teacher: not empty, not a free period ("-") and
+// not a lab group standing in for one ("Sec. A")
+int isTeacher(const char *faculty);
+const char *timetableStrError(int status);
+char *strcasestr_portable(const char *haystack, const char *needle);
+void trim(char *str);
+
+#endif
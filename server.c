@@ -0,0 +1,418 @@
+// Query server.
+//
+// Protocol: one request per line, one reply per request. A reply starts with
+// "OK <n>" followed by n data lines, or a single "ERR <message>" line.
+// Lecture lines are "section|day|time|subject|faculty".
+//
+//   PING                                     -> OK 0
+//   SECTION <s>                              -> the section's week
+//   DAY <s> <day>                            -> one day of a section
+//   SLOT <s> <day> <time>                    -> the lecture in a slot (OK 0 if free)
+//   TEACHER <name>                           -> lectures whose teacher contains name
+//   FREE <s> <day>                           -> free calendar periods (blocks take all they span), one per line
+//   SWAP <s> <day> <time> <s> <day> <time> [0|1]
+//   MOVE <s> <day> <time> <new section>
+//   ASSIGN <subject> <teacher>               -> edits, applied by a single writer
+//   TRACE                                    -> write the trace file (OK 1, events written)
+//   QUIT
+//
+// Readers never take a lock. They answer from a pinned, immutable timetable
+// version published through an atomic pointer. Each connection owns a reader
+// slot that records the epoch it entered its read section in; after publishing a
+// new version the writer waits until no slot is still in an older epoch and only
+// then unpins the previous one. Publishing costs one pin: versions share every
+// part of the timetable an edit did not touch.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include "server.h"
+#include "net.h"
+#include "platform.h"
+#include "perf.h"
+#include "memstat.h"
+#include "trace.h"
+
+#define MAX_CLIENTS 256
+
+typedef struct
+{
+    Timetable *tt;
+    _Atomic(const TimetableVersion *) current;
+    atomic_ullong epoch;
+    atomic_ullong readerEpoch[MAX_CLIENTS]; // 0 while the slot is outside a read section
+    atomic_int slotUsed[MAX_CLIENTS];
+    Mutex writerLock; // held from an edit until its version is published, see publishVersion
+} Server;
+
+typedef struct
+{
+    Server *server;
+    Socket sock;
+    int slot;
+} Connection;
+
+// Growable reply buffer, sent in one go
+typedef struct
+{
+    char *data;
+    size_t len, cap;
+    int lines;
+} Reply;
+
+static void replyAppend(Reply *reply, const char *fmt, ...)
+{
+    for (;;)
+    {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(reply->data + reply->len, reply->cap - reply->len, fmt, args);
+        va_end(args);
+        if (n < 0)
+            return;
+        if ((size_t)n < reply->cap - reply->len)
+        {
+            reply->len += (size_t)n;
+            return;
+        }
+        size_t cap = reply->cap * 2 + (size_t)n;
+        char *data = (char *)memRealloc(MEM_BUFFERS, reply->data, reply->cap, cap);
+        if (data == NULL)
+            return;
+        reply->data = data;
+        reply->cap = cap;
+    }
+}
+
+static void replyLecture(Reply *reply, const Lecture *lec)
+{
+    replyAppend(reply, "%s|%s|%s|%s|%s\n", lec->section, lec->day, lec->time, lec->subject, lec->faculty);
+    reply->lines++;
+}
+
+static void replyDay(Reply *reply, const TimetableVersion *version, const char *section, int day)
+{
+    const Lecture *lectures;
+    int count = versionDay(version, section, day, &lectures);
+    for (int i = 0; i < count; i++)
+        replyLecture(reply, &lectures[i]);
+}
+
+typedef struct
+{
+    Reply *reply;
+    const char *name;
+} TeacherCtx;
+
+static int replyTeacher(const Lecture *lec, void *ctx)
+{
+    TeacherCtx *teacher = (TeacherCtx *)ctx;
+    if (strcasestr_portable(lec->faculty, teacher->name))
+        replyLecture(teacher->reply, lec);
+    return 0;
+}
+
+static const TimetableVersion *readBegin(Server *server, int slot)
+{
+    atomic_store(&server->readerEpoch[slot], atomic_load(&server->epoch));
+    return atomic_load(&server->current);
+}
+
+static void readEnd(Server *server, int slot)
+{
+    atomic_store(&server->readerEpoch[slot], 0);
+}
+
+// Publish the timetable's new version after an edit. Called with writerLock held:
+// the timetable serializes the edits themselves, but two connections could still
+// publish out of order, the slower one pinning an older version after the other
+// published a newer one and leaving readers on it. Holding the lock from the edit
+// through publishing also keeps the grace periods from overlapping.
+static void publishVersion(Server *server)
+{
+    const TimetableVersion *old = atomic_exchange(&server->current, timetablePin(server->tt));
+    unsigned long long epoch = atomic_fetch_add(&server->epoch, 1) + 1;
+
+    // Grace period: wait for readers that may still hold the old version
+    TRACE_BEGIN(span, "server", "grace period");
+    for (int slot = 0; slot < MAX_CLIENTS; slot++)
+    {
+        for (;;)
+        {
+            unsigned long long seen = atomic_load(&server->readerEpoch[slot]);
+            if (seen == 0 || seen >= epoch)
+                break;
+            sleepMillis(0);
+        }
+    }
+    TRACE_END(span);
+    timetableUnpin(old);
+}
+
+// Answer a read-only request from a version; returns 0 for unknown requests
+static int answerQuery(const TimetableVersion *version, const Calendar *calendar, char *args[], int argCount,
+                       const char *rest, Reply *reply)
+{
+    const char *cmd = args[0];
+
+    if (strcmp(cmd, "PING") == 0)
+        return 1;
+    if (strcmp(cmd, "SECTION") == 0 && argCount == 2)
+    {
+        for (int d = 0; d < DAY_COUNT; d++)
+            replyDay(reply, version, args[1], d);
+        return 1;
+    }
+    if (strcmp(cmd, "DAY") == 0 && argCount == 3)
+    {
+        int d = dayIndex(args[2]);
+        if (d >= 0)
+            replyDay(reply, version, args[1], d);
+        return 1;
+    }
+    if (strcmp(cmd, "SLOT") == 0 && argCount == 4)
+    {
+        int d = dayIndex(args[2]);
+        const Lecture *lec = versionSlot(version, args[1], d, args[3], calendarPeriodMask(calendar, d, args[3]));
+        if (lec != NULL)
+            replyLecture(reply, lec);
+        return 1;
+    }
+    if (strcmp(cmd, "FREE") == 0 && argCount == 3)
+    {
+        int d = dayIndex(args[2]);
+        if (d < 0)
+            return 1;
+        unsigned int busy = versionDayPeriods(version, args[1], d);
+        for (int p = 0; p < calendarPeriodCount(calendar, d); p++)
+        {
+            if (!(busy & (1u << p)))
+            {
+                replyAppend(reply, "%s\n", calendarLabel(calendar, d, p));
+                reply->lines++;
+            }
+        }
+        return 1;
+    }
+    if (strcmp(cmd, "TEACHER") == 0 && rest != NULL)
+    {
+        TeacherCtx teacher = {reply, rest};
+        versionForEach(version, replyTeacher, &teacher);
+        return 1;
+    }
+    return 0;
+}
+
+// Apply an edit; returns 0 for unknown requests, otherwise writes an error into
+// message (empty on success)
+static int applyEdit(Server *server, char *args[], int argCount, const char *rest, Reply *reply, char *message, size_t size)
+{
+    const char *cmd = args[0];
+    int status;
+    message[0] = '\0';
+
+    if (strcmp(cmd, "SWAP") == 0 && (argCount == 7 || argCount == 8))
+    {
+        mutexLock(&server->writerLock);
+        status = timetableSwap(server->tt, args[1], args[2], args[3], args[4], args[5], args[6],
+                               argCount == 8 ? atoi(args[7]) : 1);
+    }
+    else if (strcmp(cmd, "MOVE") == 0 && argCount == 5)
+    {
+        mutexLock(&server->writerLock);
+        status = timetableMoveSection(server->tt, args[1], args[2], args[3], args[4]);
+    }
+    else if (strcmp(cmd, "ASSIGN") == 0 && argCount >= 3 && rest != NULL)
+    {
+        // rest starts at the teacher name; the subject code is args[1]
+        mutexLock(&server->writerLock);
+        status = timetableAssignSubject(server->tt, args[1], rest);
+        if (status == 0)
+            status = TT_ERR_NOT_FOUND;
+        else
+        {
+            replyAppend(reply, "%d\n", status);
+            reply->lines++;
+            status = TT_OK;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (status == TT_OK)
+        publishVersion(server);
+    mutexUnlock(&server->writerLock);
+    if (status != TT_OK)
+        snprintf(message, size, "%s", timetableStrError(status));
+    return 1;
+}
+
+// Split a request into at most maxArgs words; *rest points at the text after the
+// first word (TEACHER) or the second (ASSIGN) so names may contain spaces
+static int splitRequest(char *line, char *args[], int maxArgs, const char **rest)
+{
+    int count = 0;
+    char *p = line;
+    *rest = NULL;
+    while (*p && count < maxArgs)
+    {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '\0')
+            break;
+        if (count == 1 && strcmp(args[0], "TEACHER") == 0)
+        {
+            *rest = p;
+            args[count++] = p;
+            break;
+        }
+        if (count == 2 && strcmp(args[0], "ASSIGN") == 0)
+        {
+            *rest = p;
+            args[count++] = p;
+            break;
+        }
+        args[count++] = p;
+        while (*p && *p != ' ' && *p != '\t')
+            p++;
+        if (*p)
+            *p++ = '\0';
+    }
+    return count;
+}
+
+static void serveClient(void *arg)
+{
+    Connection *conn = (Connection *)arg;
+    Server *server = conn->server;
+    NetReader reader;
+    char line[NET_LINE_MAX];
+    char message[128];
+    char *args[12];
+    const char *rest;
+    Reply reply = {NULL, 0, 0, 0};
+    reply.cap = 4096;
+    reply.data = (char *)memAlloc(MEM_BUFFERS, reply.cap);
+
+    snprintf(message, sizeof(message), "client %d", conn->slot);
+    traceThreadName(message);
+    netReaderInit(&reader, conn->sock);
+    while (reply.data != NULL && netReadLine(&reader, line, sizeof(line)) >= 0)
+    {
+        int argCount = splitRequest(line, args, 12, &rest);
+        if (argCount == 0)
+            continue;
+        if (strcmp(args[0], "QUIT") == 0)
+            break;
+
+        reply.len = 0;
+        reply.lines = 0;
+        message[0] = '\0';
+        TRACE_BEGIN(span, "server", args[0]);
+        const TimetableVersion *version = readBegin(server, conn->slot);
+        int known = answerQuery(version, timetableCalendar(server->tt), args, argCount, rest, &reply);
+        readEnd(server, conn->slot);
+        if (!known)
+            known = applyEdit(server, args, argCount, rest, &reply, message, sizeof(message));
+        if (!known && strcmp(args[0], "TRACE") == 0 && argCount == 1)
+        {
+            int written = traceFlush();
+            if (written < 0)
+                snprintf(message, sizeof(message), "tracing is off");
+            else
+                replyAppend(&reply, "%d\n", written);
+            reply.lines = written < 0 ? 0 : 1;
+            known = 1;
+        }
+        TRACE_ARG(span, reply.lines);
+        TRACE_END(span);
+
+        char header[sizeof(message) + 16];
+        int failed = !known || message[0] != '\0';
+        if (!known)
+            snprintf(header, sizeof(header), "ERR unknown request\n");
+        else if (failed)
+            snprintf(header, sizeof(header), "ERR %s\n", message);
+        else
+            snprintf(header, sizeof(header), "OK %d\n", reply.lines);
+
+        if (netSendAll(conn->sock, header, strlen(header)) != 0 ||
+            (!failed && reply.len > 0 && netSendAll(conn->sock, reply.data, reply.len) != 0))
+            break;
+    }
+
+    memFree(MEM_BUFFERS, reply.data, reply.cap);
+    netClose(conn->sock);
+    atomic_store(&server->slotUsed[conn->slot], 0);
+    free(conn);
+    perfThreadExit();
+}
+
+static int acquireSlot(Server *server)
+{
+    for (int slot = 0; slot < MAX_CLIENTS; slot++)
+    {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&server->slotUsed[slot], &expected, 1))
+            return slot;
+    }
+    return -1;
+}
+
+int runServer(Timetable *tt, const char *address)
+{
+    static Server server; // large reader tables, lives for the whole process
+    server.tt = tt;
+    atomic_store(&server.epoch, 1);
+    mutexInit(&server.writerLock);
+    atomic_store(&server.current, timetablePin(tt));
+    Socket listener = INVALID_SOCK;
+    if (netInit() != 0)
+        fprintf(stderr, "Error: Could not start server!\n");
+    else if ((listener = netListen(address)) == INVALID_SOCK)
+        fprintf(stderr, "Error: Could not listen on %s!\n", address);
+    if (listener == INVALID_SOCK)
+    {
+        timetableUnpin(atomic_load(&server.current));
+        mutexDestroy(&server.writerLock);
+        return 1;
+    }
+    traceThreadName("listener");
+    printf("Serving %d lectures on %s (Ctrl+C to stop)\n", timetableCount(tt), address);
+    fflush(stdout);
+
+    for (;;)
+    {
+        Socket sock = netAccept(listener);
+        if (sock == INVALID_SOCK)
+            continue;
+        int slot = acquireSlot(&server);
+        Connection *conn = slot < 0 ? NULL : (Connection *)malloc(sizeof(Connection));
+        if (conn == NULL)
+        {
+            const char *busy = "ERR server busy\n";
+            netSendAll(sock, busy, strlen(busy));
+            netClose(sock);
+            if (slot >= 0)
+                atomic_store(&server.slotUsed[slot], 0);
+            continue;
+        }
+        conn->server = &server;
+        conn->sock = sock;
+        conn->slot = slot;
+
+        Thread thread;
+        if (threadStart(&thread, serveClient, conn) != 0)
+        {
+            netClose(sock);
+            atomic_store(&server.slotUsed[slot], 0);
+            free(conn);
+            continue;
+        }
+        threadDetach(thread);
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+// Loopback query server: answers timetable queries from many concurrent
+// clients (department portals, scripts) over a small line protocol.
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "scheduler.h"
+
+// Serve tt on address ("unix:/path" or a localhost TCP port) until the process
+// is stopped. Returns non-zero if the server could not start.
+int runServer(Timetable *tt, const char *address);
+
+#endif
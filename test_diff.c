@@ -0,0 +1,117 @@
+// Diff and patch: the changes between two versions are classified by kind, and a
+// patch written from them turns the older timetable back into the newer one.
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+
+static int countChange(int kind, const Lecture *before, const Lecture *after, void *ctx)
+{
+    (void)kind;
+    (void)before;
+    (void)after;
+    (*(int *)ctx)++;
+    return 0;
+}
+
+static void buildBase(Timetable *tt)
+{
+    assert(timetableInsertLecture(tt, "MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "TUE", "8:00-8:55", "TMC203", "Dr. Jyoti Agarwal", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "MON", "8:00-8:55", "TMC202", "Mr. Amit Juyal", "B") == TT_OK);
+    assert(timetableInsertLecture(tt, "WED", "11:05-12:00", "TMC204", "Dr. Nitin Arora", "B") == TT_OK);
+}
+
+// Edits of every kind timetableDiff tells apart; returns how many undoable edits it made
+static int editTimetable(Timetable *tt)
+{
+    assert(timetableSwap(tt, "A", "MON", "8:00-8:55", "A", "MON", "8:55-9:50", 1) == TT_OK);
+    assert(timetableAssignSubject(tt, "TMC203", "Dr. Neeraj Panwar") == 1);
+    assert(timetableSetRoom(tt, "B", "WED", "11:05-12:00", "LT-501") == TT_OK);
+    assert(timetableMoveSection(tt, "B", "MON", "8:00-8:55", "C") == TT_OK);
+    TimetableTxn *txn = timetableBegin(tt); // unlike a plain insert, a commit can be undone
+    assert(txn != NULL);
+    assert(txnInsertLecture(txn, "FRI", "2:10-3:05", "TMC205", "Dr. Udham Singh", "C") == TT_OK);
+    assert(timetableCommit(txn, NULL) == TT_OK);
+    return 5;
+}
+
+static void testDiffCountsChanges(const TimetableVersion *before, const TimetableVersion *after)
+{
+    DiffReport report;
+    int visited = 0;
+    assert(timetableDiff(before, after, countChange, &visited, &report) == TT_OK);
+    assert(report.moved == 2);     // the swapped pair, each with its teacher
+    assert(report.restaffed == 1); // the new teacher
+    assert(report.rooms == 1);
+    assert(report.added == 2 && report.removed == 1); // section change and the new lecture
+    assert(visited == report.added + report.removed + report.moved + report.restaffed + report.rooms);
+
+    assert(timetableDiff(after, after, countChange, &visited, &report) == TT_OK);
+    assert(report.added + report.removed + report.moved + report.restaffed + report.rooms == 0);
+}
+
+static void testPatchRoundTrip(Timetable *tt, const TimetableVersion *before, const TimetableVersion *after,
+                               int edits)
+{
+    FILE *patch = tmpfile();
+    assert(patch != NULL);
+    DiffReport written;
+    assert(timetableWritePatch(before, after, patch, &written) == TT_OK);
+
+    // Back to the older timetable, then forward again by the patch alone
+    for (int i = 0; i < edits; i++)
+        assert(timetableUndo(tt, NULL) == TT_OK);
+    const TimetableVersion *undone = timetablePin(tt);
+    DiffReport report;
+    assert(timetableDiff(before, undone, NULL, NULL, &report) == TT_OK);
+    assert(report.added + report.removed + report.moved + report.restaffed + report.rooms == 0);
+    timetableUnpin(undone);
+
+    rewind(patch);
+    TxnFailure failure;
+    assert(timetableApplyPatch(tt, patch, &failure) > 0);
+    fclose(patch);
+
+    const TimetableVersion *patched = timetablePin(tt);
+    assert(timetableDiff(after, patched, NULL, NULL, &report) == TT_OK);
+    assert(report.added + report.removed + report.moved + report.restaffed + report.rooms == 0);
+    assert(report.sections == 0);
+    timetableUnpin(patched);
+}
+
+static void testPatchNeedsRemovedLecture(Timetable *tt)
+{
+    FILE *patch = tmpfile();
+    assert(patch != NULL);
+    fputs("op,section,day,time,code,faculty,room\n", patch);
+    fputs("-,A,SAT,8:00-8:55,TMC201,Dr. Udham Singh,\n", patch);
+    rewind(patch);
+    int count = timetableCount(tt);
+    TxnFailure failure;
+    assert(timetableApplyPatch(tt, patch, &failure) < 0);
+    assert(failure.op == 1);
+    assert(timetableCount(tt) == count);
+    fclose(patch);
+}
+
+int main(void)
+{
+    Timetable *tt = timetableCreate();
+    assert(tt != NULL);
+    buildBase(tt);
+    const TimetableVersion *before = timetablePin(tt);
+    int edits = editTimetable(tt);
+    const TimetableVersion *after = timetablePin(tt);
+
+    testDiffCountsChanges(before, after);
+    testPatchRoundTrip(tt, before, after, edits);
+    testPatchNeedsRemovedLecture(tt);
+
+    timetableUnpin(before);
+    timetableUnpin(after);
+    timetableDestroy(tt);
+    printf("test_diff: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Slot lookups: a lecture is found at its own time and a block (a lab spanning
+// several periods) at every period inside it, through the library and a pinned version.
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+
+static void testLectureAtItsTime(Timetable *tt)
+{
+    Lecture lec;
+    assert(timetableGetLecture(tt, "A", "MON", "11:05-12:00", &lec) == TT_OK);
+    assert(strcmp(lec.subject, "TMC201") == 0);
+    assert(timetableGetLecture(tt, "A", "MON", "12:00-12:55", &lec) == TT_ERR_NOT_FOUND);
+    assert(timetableGetLecture(tt, "B", "MON", "11:05-12:00", &lec) == TT_ERR_NOT_FOUND);
+}
+
+static void testPeriodInsideBlock(Timetable *tt)
+{
+    Lecture lec;
+    assert(timetableGetLecture(tt, "A", "TUE", "8:00-9:50", &lec) == TT_OK);
+    assert(timetableGetLecture(tt, "A", "TUE", "8:00-8:55", &lec) == TT_OK);
+    assert(strcmp(lec.time, "8:00-9:50") == 0);
+    memset(&lec, 0, sizeof(lec));
+    assert(timetableGetLecture(tt, "A", "TUE", "8:55-9:50", &lec) == TT_OK);
+    assert(strcmp(lec.time, "8:00-9:50") == 0 && strcmp(lec.subject, "PMC201") == 0);
+    assert(!timetableIsSlotFree(tt, "A", "TUE", "8:55-9:50"));
+    assert(timetableGetLecture(tt, "A", "TUE", "9:50-10:45", &lec) == TT_ERR_NOT_FOUND);
+    assert(timetableIsSlotFree(tt, "A", "TUE", "9:50-10:45"));
+}
+
+static void testVersionSlot(Timetable *tt)
+{
+    const TimetableVersion *version = timetablePin(tt);
+    int tue = dayIndex("TUE");
+    const Calendar *calendar = timetableCalendar(tt);
+    const Lecture *lec = versionSlot(version, "A", tue, "8:55-9:50", calendarPeriodMask(calendar, tue, "8:55-9:50"));
+    assert(lec != NULL && strcmp(lec->time, "8:00-9:50") == 0);
+    assert(versionSlot(version, "A", tue, "10:45-11:40", calendarPeriodMask(calendar, tue, "10:45-11:40")) == NULL);
+    assert(versionSlot(version, "Z", tue, "8:55-9:50", calendarPeriodMask(calendar, tue, "8:55-9:50")) == NULL);
+    timetableUnpin(version);
+}
+
+int main(void)
+{
+    Timetable *tt = timetableCreate();
+    assert(tt != NULL);
+    assert(timetableInsertLecture(tt, "MON", "11:05-12:00", "TMC201", "Dr. Udham Singh", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "TUE", "8:00-9:50", "PMC201", "Sec. A (Lab 7)", "A") == TT_OK);
+
+    testLectureAtItsTime(tt);
+    testPeriodInsideBlock(tt);
+    testVersionSlot(tt);
+
+    timetableDestroy(tt);
+    printf("test_lookup: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Three-way merge: changes only they made are applied, changes both sides made the
+// same way count once, and a slot both changed differently or a teacher their change
+// would double-book with ours is a conflict that keeps our version.
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+
+typedef struct
+{
+    int slots;
+    int teachers;
+    char theirRoom[ROOM_NAME_LEN]; // what they put in the conflicting slot
+} Conflicts;
+
+static int recordConflict(int kind, const Lecture *base, const Lecture *ours, const Lecture *theirs, void *ctx)
+{
+    Conflicts *conflicts = (Conflicts *)ctx;
+    (void)base;
+    (void)ours;
+    if (kind == MERGE_SLOT)
+    {
+        conflicts->slots++;
+        strcpy(conflicts->theirRoom, theirs != NULL ? theirs->room : "");
+    }
+    else if (kind == MERGE_TEACHER)
+        conflicts->teachers++;
+    return 0;
+}
+
+static void insertCommitted(Timetable *tt, const char *day, const char *time, const char *subject,
+                            const char *faculty, const char *section)
+{
+    TimetableTxn *txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnInsertLecture(txn, day, time, subject, faculty, section) == TT_OK);
+    assert(timetableCommit(txn, NULL) == TT_OK);
+}
+
+static void roomOf(Timetable *tt, const char *section, const char *day, const char *time, char *room)
+{
+    Lecture lec;
+    assert(timetableGetLecture(tt, section, day, time, &lec) == TT_OK);
+    strcpy(room, lec.room);
+}
+
+int main(void)
+{
+    Timetable *tt = timetableCreate();
+    assert(tt != NULL);
+    assert(timetableInsertLecture(tt, "MON", "8:00-8:55", "TMC201", "Dr. Udham Singh", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "MON", "8:55-9:50", "TMC202", "Mr. Amit Juyal", "A") == TT_OK);
+    assert(timetableInsertLecture(tt, "WED", "8:00-8:55", "TMC204", "Dr. Nitin Arora", "B") == TT_OK);
+    const TimetableVersion *base = timetablePin(tt);
+
+    // Their edit of base, then back to base for ours
+    assert(timetableSetRoom(tt, "A", "MON", "8:00-8:55", "LT-402") == TT_OK);
+    assert(timetableSetRoom(tt, "A", "MON", "8:55-9:50", "LT-402") == TT_OK);
+    assert(timetableSetRoom(tt, "B", "WED", "8:00-8:55", "LT-501") == TT_OK);
+    insertCommitted(tt, "THU", "8:00-8:55", "TMC206", "Dr. Jyoti Agarwal", "D");
+    const TimetableVersion *theirs = timetablePin(tt);
+    for (int i = 0; i < 4; i++)
+        assert(timetableUndo(tt, NULL) == TT_OK);
+
+    assert(timetableSetRoom(tt, "A", "MON", "8:00-8:55", "LT-501") == TT_OK);
+    assert(timetableSetRoom(tt, "A", "MON", "8:55-9:50", "LT-402") == TT_OK);
+    insertCommitted(tt, "THU", "8:00-8:55", "TMC205", "Dr. Jyoti Agarwal", "C");
+
+    Conflicts conflicts = {0, 0, ""};
+    MergeReport report;
+    assert(timetableMerge(tt, base, theirs, recordConflict, &conflicts, &report) == TT_OK);
+    assert(report.ours == 2);   // the room of A MON 8:00 and the lecture of C
+    assert(report.same == 1);   // both put A MON 8:55 in LT-402
+    assert(report.theirs == 1); // only they moved B WED 8:00
+    assert(report.conflicts == 2);
+    assert(conflicts.slots == 1 && strcmp(conflicts.theirRoom, "LT-402") == 0);
+    assert(conflicts.teachers == 1); // their D THU 8:00 has our teacher of C THU 8:00
+
+    char room[ROOM_NAME_LEN];
+    roomOf(tt, "A", "MON", "8:00-8:55", room);
+    assert(strcmp(room, "LT-501") == 0); // a conflict keeps ours
+    roomOf(tt, "A", "MON", "8:55-9:50", room);
+    assert(strcmp(room, "LT-402") == 0);
+    roomOf(tt, "B", "WED", "8:00-8:55", room);
+    assert(strcmp(room, "LT-501") == 0); // theirs applied
+    assert(timetableGetLecture(tt, "D", "THU", "8:00-8:55", NULL) == TT_ERR_NOT_FOUND);
+    assert(timetableGetLecture(tt, "C", "THU", "8:00-8:55", NULL) == TT_OK);
+
+    // The merge is one undoable edit
+    assert(timetableUndo(tt, NULL) == TT_OK);
+    roomOf(tt, "B", "WED", "8:00-8:55", room);
+    assert(room[0] == '\0');
+
+    timetableUnpin(base);
+    timetableUnpin(theirs);
+    timetableDestroy(tt);
+    printf("test_merge: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Transaction validation: a commit may not double-book a section's period, a
+// teacher or a room beyond its capacity, a combined lecture books its teacher
+// once, and clashes the timetable already had do not block unrelated edits.
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+
+#define TEACHER "Dr. Udham Singh"
+
+static int commitInsert(Timetable *tt, const char *time, const char *subject, const char *faculty,
+                        const char *section, const char *room, TxnFailure *failure)
+{
+    TimetableTxn *txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnInsertLecture(txn, "MON", time, subject, faculty, section) == TT_OK);
+    if (room != NULL)
+        assert(txnSetRoom(txn, section, "MON", time, room) == TT_OK);
+    return timetableCommit(txn, failure);
+}
+
+static void testCombinedLecture(Timetable *tt)
+{
+    TxnFailure failure;
+    assert(commitInsert(tt, "8:00-8:55", "TMC201", TEACHER, "A", "LT-402", &failure) == TT_OK);
+    assert(commitInsert(tt, "8:00-8:55", "TMC201", TEACHER, "B", "LT-402", &failure) == TT_OK);
+    assert(timetableCount(tt) == 2);
+}
+
+static void testTeacherClash(Timetable *tt)
+{
+    TxnFailure failure;
+    assert(commitInsert(tt, "8:00-8:55", "TMC202", TEACHER, "C", "LT-501", &failure) == TT_ERR_CONFLICT);
+    assert(strcmp(failure.lecture.section, "C") == 0);
+    assert(strcmp(failure.other.faculty, TEACHER) == 0 && strcmp(failure.other.subject, "TMC201") == 0);
+
+    // The same teacher in the combined lecture's room but another subject is a clash too
+    assert(commitInsert(tt, "8:00-8:55", "TMC202", TEACHER, "C", "LT-402", &failure) == TT_ERR_CONFLICT);
+    assert(timetableCount(tt) == 2);
+}
+
+static void testRoomCapacity(Timetable *tt)
+{
+    TxnFailure failure;
+    assert(commitInsert(tt, "8:00-8:55", "TMC203", "Mr. Amit Juyal", "D", "LT-402", &failure) == TT_ERR_CONFLICT);
+    assert(strcmp(failure.other.room, "LT-402") == 0);
+    assert(commitInsert(tt, "8:00-8:55", "TMC203", "Mr. Amit Juyal", "D", "LT-501", &failure) == TT_OK);
+}
+
+static void testAssignClash(Timetable *tt)
+{
+    TimetableTxn *txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnAssignSubject(txn, "TMC203", TEACHER) == TT_OK);
+    TxnFailure failure;
+    assert(timetableCommit(txn, &failure) == TT_ERR_CONFLICT);
+    assert(strcmp(failure.lecture.faculty, TEACHER) == 0);
+}
+
+static void testSectionClash(Timetable *tt)
+{
+    // A lab block over the period section A already has at 8:00
+    TimetableTxn *txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnInsertLecture(txn, "MON", "8:00-9:50", "PMC201", "Sec. A (Lab 7)", "A") == TT_OK);
+    TxnFailure failure;
+    assert(timetableCommit(txn, &failure) == TT_ERR_CONFLICT);
+    assert(strcmp(failure.other.section, "A") == 0 && strcmp(failure.other.subject, "TMC201") == 0);
+
+    // Moving a lecture into a section that has that period taken
+    txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnMoveSection(txn, "D", "MON", "8:00-8:55", "A") == TT_OK);
+    assert(timetableCommit(txn, &failure) == TT_ERR_CONFLICT);
+    assert(strcmp(failure.lecture.section, "A") == 0);
+
+    // The period after it is free
+    txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnInsertLecture(txn, "MON", "8:55-9:50", "PMC201", "Sec. A (Lab 7)", "A") == TT_OK);
+    assert(timetableCommit(txn, &failure) == TT_OK);
+}
+
+static void testClashAlreadyPresent(Timetable *tt)
+{
+    // Plain inserts do not check teachers, so this clash predates the commit
+    assert(timetableInsertLecture(tt, "TUE", "9:50-10:45", "TMC205", "Dr. Jyoti Agarwal", "E") == TT_OK);
+    assert(timetableInsertLecture(tt, "TUE", "9:50-10:45", "TMC206", "Dr. Jyoti Agarwal", "F") == TT_OK);
+    TimetableTxn *txn = timetableBegin(tt);
+    assert(txn != NULL);
+    assert(txnSetRoom(txn, "E", "TUE", "9:50-10:45", "LT-601") == TT_OK);
+    assert(timetableCommit(txn, NULL) == TT_OK);
+}
+
+int main(void)
+{
+    Timetable *tt = timetableCreate();
+    assert(tt != NULL);
+    assert(timetableAddRoom(tt, "LT-402", 2) >= 0);
+    assert(timetableAddRoom(tt, "LT-501", 2) >= 0);
+
+    testCombinedLecture(tt);
+    testTeacherClash(tt);
+    testRoomCapacity(tt);
+    testAssignClash(tt);
+    testSectionClash(tt);
+    testClashAlreadyPresent(tt);
+
+    timetableDestroy(tt);
+    printf("test_txn: all tests passed\n");
+    return 0;
+}
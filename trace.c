@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "perf.h"
+#include "platform.h"
+
+#define TRACE_MAX_THREADS 256
+
+// One finished span. seq is the event's position in the stream plus one, written
+// last, so an exporter can skip a slot a writer is still filling or reusing.
+typedef struct
+{
+    atomic_ullong seq;
+    const char *category;
+    char name[TRACE_NAME_LEN];
+    double start, duration;
+    int tid;
+    long long arg;
+} TraceEvent;
+
+atomic_int traceOn;
+
+static TraceEvent *ring;
+static unsigned long long ringMask;
+static atomic_ullong nextEvent;
+static double traceEpoch;
+static char traceFile[260];
+
+// Threads are numbered in the order they first record, names are optional
+static atomic_int threadCount;
+static char threadNames[TRACE_MAX_THREADS][TRACE_NAME_LEN];
+static PERF_THREAD_LOCAL int traceTid;
+
+static int currentTid(void)
+{
+    if (traceTid == 0)
+        traceTid = atomic_fetch_add(&threadCount, 1) + 1;
+    return traceTid;
+}
+
+static void copyName(char *dest, const char *src)
+{
+    size_t len = strlen(src);
+    if (len >= TRACE_NAME_LEN)
+        len = TRACE_NAME_LEN - 1;
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+int traceOpen(const char *filename, int capacity)
+{
+    if (ring != NULL || strlen(filename) >= sizeof(traceFile))
+        return -1;
+    unsigned long long size = 1;
+    while (size < (unsigned long long)(capacity > 0 ? capacity : 1))
+        size <<= 1;
+    ring = (TraceEvent *)calloc(size, sizeof(TraceEvent));
+    if (ring == NULL)
+        return -1;
+    ringMask = size - 1;
+    strcpy(traceFile, filename);
+    atomic_store(&nextEvent, 0);
+    traceEpoch = monotonicMicros();
+    atomic_store(&traceOn, 1);
+    return 0;
+}
+
+void traceClose(void)
+{
+    atomic_store(&traceOn, 0);
+    free(ring);
+    ring = NULL;
+}
+
+void traceThreadName(const char *name)
+{
+    int tid = currentTid();
+    if (tid < TRACE_MAX_THREADS)
+        copyName(threadNames[tid], name);
+}
+
+void traceStartSpan(TraceSpan *span, const char *category, const char *name)
+{
+    span->category = category;
+    copyName(span->name, name);
+    span->arg = 0;
+    span->start = monotonicMicros() - traceEpoch;
+}
+
+void traceRecord(const TraceSpan *span)
+{
+    double end = monotonicMicros() - traceEpoch;
+    if (!atomic_load_explicit(&traceOn, memory_order_relaxed))
+        return;
+    unsigned long long index = atomic_fetch_add_explicit(&nextEvent, 1, memory_order_relaxed);
+    TraceEvent *event = &ring[index & ringMask];
+    atomic_store_explicit(&event->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event->category = span->category;
+    memcpy(event->name, span->name, TRACE_NAME_LEN);
+    event->start = span->start;
+    event->duration = end - span->start;
+    event->tid = currentTid();
+    event->arg = span->arg;
+    atomic_store_explicit(&event->seq, index + 1, memory_order_release);
+}
+
+static void writeJsonString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+int traceFlush(void)
+{
+    if (ring == NULL)
+        return -1;
+    FILE *fp = fopen(traceFile, "w");
+    if (fp == NULL)
+        return -1;
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"Classroom Scheduler\"}}");
+    int threads = atomic_load(&threadCount);
+    for (int tid = 1; tid <= threads && tid < TRACE_MAX_THREADS; tid++)
+    {
+        if (threadNames[tid][0] == '\0')
+            continue;
+        fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", tid);
+        writeJsonString(fp, threadNames[tid]);
+        fprintf(fp, "}}");
+    }
+
+    // Oldest surviving event first; slots being rewritten right now are skipped
+    unsigned long long end = atomic_load_explicit(&nextEvent, memory_order_acquire);
+    unsigned long long begin = end > ringMask + 1 ? end - (ringMask + 1) : 0;
+    int written = 0;
+    for (unsigned long long i = begin; i < end; i++)
+    {
+        TraceEvent *slot = &ring[i & ringMask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != i + 1)
+            continue;
+        TraceEvent event;
+        event.category = slot->category;
+        memcpy(event.name, slot->name, TRACE_NAME_LEN);
+        event.start = slot->start;
+        event.duration = slot->duration;
+        event.tid = slot->tid;
+        event.arg = slot->arg;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != i + 1)
+            continue;
+        event.name[TRACE_NAME_LEN - 1] = '\0';
+
+        fprintf(fp, ",\n{\"name\": ");
+        writeJsonString(fp, event.name);
+        fprintf(fp, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, "
+                    "\"args\": {\"n\": %lld}}",
+                event.category, event.start, event.duration, event.tid, event.arg);
+        written++;
+    }
+    fprintf(fp, "\n]}\n");
+    if (fclose(fp) != 0)
+        return -1;
+    return written;
+}
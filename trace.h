@@ -0,0 +1,56 @@
+// Timeline tracing in Chrome trace format (chrome://tracing, ui.perfetto.dev).
+//
+// traceOpen starts recording: every TRACE_BEGIN/TRACE_END pair then becomes one
+// complete event with its thread, start and duration, written to a fixed size
+// ring that keeps the most recent events. traceFlush writes the ring as JSON to
+// the file given to traceOpen. While tracing is off a span costs one relaxed load.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+
+#define TRACE_NAME_LEN 32
+
+typedef struct
+{
+    const char *category;
+    char name[TRACE_NAME_LEN];
+    double start; // microseconds, negative when tracing was off at the start
+    long long arg;
+} TraceSpan;
+
+extern atomic_int traceOn;
+
+// Start recording up to capacity events (rounded up to a power of two) for filename
+int traceOpen(const char *filename, int capacity);
+// Write the events recorded so far to the file, returns the number written or -1
+int traceFlush(void);
+// Stop recording and free the ring; no other thread may be inside a span
+void traceClose(void);
+// Name the calling thread in the timeline
+void traceThreadName(const char *name);
+
+void traceStartSpan(TraceSpan *span, const char *category, const char *name);
+void traceRecord(const TraceSpan *span);
+
+static inline void traceSpanBegin(TraceSpan *span, const char *category, const char *name)
+{
+    span->start = -1.0;
+    if (atomic_load_explicit(&traceOn, memory_order_relaxed))
+        traceStartSpan(span, category, name);
+}
+
+static inline void traceSpanEnd(const TraceSpan *span)
+{
+    if (span->start >= 0.0)
+        traceRecord(span);
+}
+
+// Spans are locals named by the first argument; arg is shown with the event
+#define TRACE_BEGIN(span, category, name) \
+    TraceSpan span;                       \
+    traceSpanBegin(&span, category, name)
+#define TRACE_ARG(span, value) ((span).arg = (long long)(value))
+#define TRACE_END(span) traceSpanEnd(&span)
+
+#endif
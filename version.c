@@ -0,0 +1,954 @@
+#include <stdlib.h>
+#include <string.h>
+#include "version.h"
+#include "memstat.h"
+#include "columns.h"
+
+#define BLOCK_BYTES(capacity) (sizeof(Block) + sizeof(Lecture) * (size_t)(capacity))
+#define TEACHER_BYTES(capacity) (sizeof(TeacherWeek) + sizeof(TeacherClass) * (size_t)(capacity))
+
+static void headerInit(NodeHeader *hdr, unsigned long owner)
+{
+    atomic_init(&hdr->refs, 1);
+    hdr->owner = owner;
+}
+
+static void retain(NodeHeader *hdr)
+{
+    if (hdr != NULL)
+        atomic_fetch_add_explicit(&hdr->refs, 1, memory_order_relaxed);
+}
+
+// Drop a reference, returns 1 if it was the last one
+static int dropRef(NodeHeader *hdr)
+{
+    return atomic_fetch_sub_explicit(&hdr->refs, 1, memory_order_acq_rel) == 1;
+}
+
+static void releaseBlock(Block *block)
+{
+    if (block != NULL && dropRef(&block->hdr))
+        memFree(MEM_LECTURES, block, BLOCK_BYTES(block->capacity));
+}
+
+static void releaseSection(SectionDays *section)
+{
+    if (section == NULL || !dropRef(&section->hdr))
+        return;
+    for (int d = 0; d < DAY_COUNT; d++)
+        releaseBlock(section->days[d]);
+    memFree(MEM_INDEX, section, sizeof(SectionDays));
+}
+
+static void releaseChunk(SectionChunk *chunk)
+{
+    if (chunk == NULL || !dropRef(&chunk->hdr))
+        return;
+    for (int i = 0; i < CHUNK_SECTIONS; i++)
+        releaseSection(chunk->sections[i]);
+    memFree(MEM_INDEX, chunk, sizeof(SectionChunk));
+}
+
+static void releaseRoom(RoomWeek *room)
+{
+    if (room != NULL && dropRef(&room->hdr))
+        memFree(MEM_INDEX, room, sizeof(RoomWeek));
+}
+
+static void releaseTeacher(TeacherWeek *teacher)
+{
+    if (teacher != NULL && dropRef(&teacher->hdr))
+        memFree(MEM_INDEX, teacher, TEACHER_BYTES(teacher->capacity));
+}
+
+static void releaseTeacherChunk(TeacherChunk *chunk)
+{
+    if (chunk == NULL || !dropRef(&chunk->hdr))
+        return;
+    for (int i = 0; i < CHUNK_TEACHERS; i++)
+        releaseTeacher(chunk->teachers[i]);
+    memFree(MEM_INDEX, chunk, sizeof(TeacherChunk));
+}
+
+void sectionTableInit(SectionTable *table)
+{
+    for (int i = 0; i < SECTION_SLOTS; i++)
+        atomic_init(&table->slots[i], 0);
+    atomic_init(&table->count, 0);
+}
+
+static unsigned int hashName(const char *name)
+{
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *name; name++)
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    return hash;
+}
+
+// Slot holding a section name, or the empty slot where it would go. The table is
+// at most half full, so probing always ends.
+static int sectionSlot(const SectionTable *table, const char *section, int *id)
+{
+    unsigned int slot = hashName(section) % SECTION_SLOTS;
+    for (;; slot = (slot + 1) % SECTION_SLOTS)
+    {
+        *id = atomic_load_explicit(&table->slots[slot], memory_order_acquire) - 1;
+        if (*id < 0 || strcmp(table->names[*id], section) == 0)
+            return (int)slot;
+    }
+}
+
+// Id of a section name, or -1 if it was never used
+int sectionTableFind(const SectionTable *table, const char *section)
+{
+    int id;
+    sectionSlot(table, section, &id);
+    return id;
+}
+
+// Id of a section name, registering it if needed (writer only); -1 when the
+// table is full or the name is empty, too long or holds spaces or '|'
+int sectionTableAdd(SectionTable *table, const char *section)
+{
+    int id;
+    int slot = sectionSlot(table, section, &id);
+    if (id >= 0)
+        return id;
+    size_t len = strcspn(section, " \t\r\n|");
+    if (len == 0 || section[len] != '\0' || len >= SECTION_NAME_LEN)
+        return -1;
+    id = atomic_load(&table->count);
+    if (id == MAX_SECTIONS)
+        return -1;
+    strcpy(table->names[id], section);
+    atomic_store(&table->count, id + 1);
+    atomic_store_explicit(&table->slots[slot], id + 1, memory_order_release);
+    return id;
+}
+
+void roomTableInit(RoomTable *table)
+{
+    for (int i = 0; i < ROOM_SLOTS; i++)
+        atomic_init(&table->slots[i], 0);
+    for (int i = 0; i < MAX_ROOMS; i++)
+        atomic_init(&table->capacity[i], 0);
+    atomic_init(&table->count, 0);
+}
+
+static int roomSlot(const RoomTable *table, const char *room, int *id)
+{
+    unsigned int slot = hashName(room) % ROOM_SLOTS;
+    for (;; slot = (slot + 1) % ROOM_SLOTS)
+    {
+        *id = atomic_load_explicit(&table->slots[slot], memory_order_acquire) - 1;
+        if (*id < 0 || strcmp(table->names[*id], room) == 0)
+            return (int)slot;
+    }
+}
+
+// Id of a room, or -1 if it is not registered
+int roomTableFind(const RoomTable *table, const char *room)
+{
+    int id;
+    roomSlot(table, room, &id);
+    return id;
+}
+
+// Id of a room, registering it if needed (writer only); -1 when the table is
+// full, the capacity is not positive or the name is empty, too long or holds '|'
+int roomTableAdd(RoomTable *table, const char *room, int capacity)
+{
+    int id;
+    int slot = roomSlot(table, room, &id);
+    if (id >= 0)
+        return id;
+    size_t len = strcspn(room, "|\t\r\n");
+    if (len == 0 || room[len] != '\0' || len >= ROOM_NAME_LEN || capacity < 1)
+        return -1;
+    id = atomic_load(&table->count);
+    if (id == MAX_ROOMS)
+        return -1;
+    strcpy(table->names[id], room);
+    atomic_store(&table->capacity[id], capacity);
+    atomic_store(&table->count, id + 1);
+    atomic_store_explicit(&table->slots[slot], id + 1, memory_order_release);
+    return id;
+}
+
+void teacherTableInit(TeacherTable *table)
+{
+    for (int i = 0; i < TEACHER_SLOTS; i++)
+        atomic_init(&table->slots[i], 0);
+    atomic_init(&table->count, 0);
+}
+
+static int teacherSlot(const TeacherTable *table, const char *teacher, int *id)
+{
+    unsigned int slot = hashName(teacher) % TEACHER_SLOTS;
+    for (;; slot = (slot + 1) % TEACHER_SLOTS)
+    {
+        *id = atomic_load_explicit(&table->slots[slot], memory_order_acquire) - 1;
+        if (*id < 0 || strcmp(table->names[*id], teacher) == 0)
+            return (int)slot;
+    }
+}
+
+int teacherTableFind(const TeacherTable *table, const char *teacher)
+{
+    int id;
+    teacherSlot(table, teacher, &id);
+    return id;
+}
+
+int teacherTableAdd(TeacherTable *table, const char *teacher)
+{
+    int id;
+    int slot = teacherSlot(table, teacher, &id);
+    if (id >= 0)
+        return id;
+    id = atomic_load(&table->count);
+    if (id == MAX_TEACHERS || strlen(teacher) >= MAX_LEN)
+        return -1;
+    strcpy(table->names[id], teacher);
+    atomic_store(&table->count, id + 1);
+    atomic_store_explicit(&table->slots[slot], id + 1, memory_order_release);
+    return id;
+}
+
+TimetableVersion *versionCreateEmpty(const SectionTable *sections, const RoomTable *rooms, TeacherTable *teachers,
+                                     unsigned long id)
+{
+    TimetableVersion *version = (TimetableVersion *)memCalloc(MEM_INDEX, 1, sizeof(TimetableVersion));
+    if (version == NULL)
+        return NULL;
+    atomic_init(&version->refs, 1);
+    atomic_init(&version->columns, NULL);
+    version->id = id;
+    version->sections = sections;
+    version->roomTable = rooms;
+    version->teacherTable = teachers;
+    version->chunkCount = MAX_SECTIONS / CHUNK_SECTIONS;
+    return version;
+}
+
+// New draft sharing every node of base; only the chunk pointers are copied
+TimetableVersion *versionCreateDraft(const TimetableVersion *base, unsigned long id)
+{
+    TimetableVersion *draft = versionCreateEmpty(base->sections, base->roomTable, base->teacherTable, id);
+    if (draft == NULL)
+        return NULL;
+    draft->count = base->count;
+    for (int c = 0; c < base->chunkCount; c++)
+    {
+        draft->chunks[c] = base->chunks[c];
+        retain(draft->chunks[c] ? &draft->chunks[c]->hdr : NULL);
+    }
+    draft->roomCount = base->roomCount;
+    for (int r = 0; r < base->roomCount; r++)
+    {
+        draft->rooms[r] = base->rooms[r];
+        retain(draft->rooms[r] ? &draft->rooms[r]->hdr : NULL);
+    }
+    for (int c = 0; c < MAX_TEACHERS / CHUNK_TEACHERS; c++)
+    {
+        draft->teacherChunks[c] = base->teacherChunks[c];
+        retain(draft->teacherChunks[c] ? &draft->teacherChunks[c]->hdr : NULL);
+    }
+    return draft;
+}
+
+void versionRetain(const TimetableVersion *version)
+{
+    atomic_fetch_add_explicit(&((TimetableVersion *)version)->refs, 1, memory_order_relaxed);
+}
+
+void versionRelease(const TimetableVersion *version)
+{
+    TimetableVersion *v = (TimetableVersion *)version;
+    if (v == NULL || atomic_fetch_sub_explicit(&v->refs, 1, memory_order_acq_rel) != 1)
+        return;
+    for (int c = 0; c < v->chunkCount; c++)
+        releaseChunk(v->chunks[c]);
+    for (int r = 0; r < v->roomCount; r++)
+        releaseRoom(v->rooms[r]);
+    for (int c = 0; c < MAX_TEACHERS / CHUNK_TEACHERS; c++)
+        releaseTeacherChunk(v->teacherChunks[c]);
+    columnsFree(atomic_load(&v->columns));
+    memFree(MEM_INDEX, v, sizeof(TimetableVersion));
+}
+
+const Block *versionBlock(const TimetableVersion *version, int sectionId, int day)
+{
+    if (sectionId < 0 || sectionId >= MAX_SECTIONS || day < 0 || day >= DAY_COUNT)
+        return NULL;
+    const SectionChunk *chunk = version->chunks[sectionId / CHUNK_SECTIONS];
+    if (chunk == NULL)
+        return NULL;
+    const SectionDays *section = chunk->sections[sectionId % CHUNK_SECTIONS];
+    return section ? section->days[day] : NULL;
+}
+
+// Private (copied if shared) chunk and day table on the path to a section
+static SectionDays *mutableSection(TimetableVersion *draft, int sectionId, int create)
+{
+    SectionChunk **chunkSlot = &draft->chunks[sectionId / CHUNK_SECTIONS];
+    SectionChunk *chunk = *chunkSlot;
+    if (chunk == NULL)
+    {
+        if (!create)
+            return NULL;
+        chunk = (SectionChunk *)memCalloc(MEM_INDEX, 1, sizeof(SectionChunk));
+        if (chunk == NULL)
+            return NULL;
+        headerInit(&chunk->hdr, draft->id);
+        *chunkSlot = chunk;
+    }
+    else if (chunk->hdr.owner != draft->id)
+    {
+        SectionChunk *copy = (SectionChunk *)memAlloc(MEM_INDEX, sizeof(SectionChunk));
+        if (copy == NULL)
+            return NULL;
+        *copy = *chunk;
+        headerInit(&copy->hdr, draft->id);
+        for (int i = 0; i < CHUNK_SECTIONS; i++)
+            retain(copy->sections[i] ? &copy->sections[i]->hdr : NULL);
+        releaseChunk(chunk);
+        *chunkSlot = chunk = copy;
+    }
+
+    SectionDays **sectionSlot = &chunk->sections[sectionId % CHUNK_SECTIONS];
+    SectionDays *section = *sectionSlot;
+    if (section == NULL)
+    {
+        if (!create)
+            return NULL;
+        section = (SectionDays *)memCalloc(MEM_INDEX, 1, sizeof(SectionDays));
+        if (section == NULL)
+            return NULL;
+        headerInit(&section->hdr, draft->id);
+        *sectionSlot = section;
+    }
+    else if (section->hdr.owner != draft->id)
+    {
+        SectionDays *copy = (SectionDays *)memAlloc(MEM_INDEX, sizeof(SectionDays));
+        if (copy == NULL)
+            return NULL;
+        *copy = *section;
+        headerInit(&copy->hdr, draft->id);
+        for (int d = 0; d < DAY_COUNT; d++)
+            retain(copy->days[d] ? &copy->days[d]->hdr : NULL);
+        releaseSection(section);
+        *sectionSlot = section = copy;
+    }
+    return section;
+}
+
+static Block *allocBlock(int count, unsigned long owner)
+{
+    int capacity = count > 0 ? count : 1;
+    Block *block = (Block *)memAlloc(MEM_LECTURES, BLOCK_BYTES(capacity));
+    if (block != NULL)
+    {
+        headerInit(&block->hdr, owner);
+        block->busy = 0;
+        block->doubled = 0;
+        atomic_init(&block->hash, 0);
+        block->count = count;
+        block->capacity = capacity;
+    }
+    return block;
+}
+
+// First index whose time is not less than time (blocks are sorted by time)
+static int lowerBound(const Block *block, const char *time)
+{
+    int lo = 0, hi = block->count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (strcmp(block->lectures[mid].time, time) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Index of the first lecture at a time, or -1
+int findInBlock(const Block *block, const char *time)
+{
+    if (block == NULL)
+        return -1;
+    int i = lowerBound(block, time);
+    return i < block->count && strcmp(block->lectures[i].time, time) == 0 ? i : -1;
+}
+
+void blockUpdateBusy(Block *block)
+{
+    block->busy = 0;
+    block->doubled = 0;
+    for (int i = 0; i < block->count; i++)
+    {
+        block->doubled |= block->busy & block->lectures[i].periods;
+        block->busy |= block->lectures[i].periods;
+    }
+}
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+static unsigned long long hashField(unsigned long long hash, const char *text)
+{
+    for (; *text; text++)
+        hash = (hash ^ (unsigned char)*text) * FNV_PRIME;
+    return (hash ^ 0x1f) * FNV_PRIME; // separator, so "ab" "c" and "a" "bc" differ
+}
+
+static unsigned long long blockHash(const Block *block)
+{
+    Block *cached = (Block *)block; // readers race only to store the same value
+    unsigned long long hash = atomic_load_explicit(&cached->hash, memory_order_relaxed);
+    if (hash != 0)
+        return hash;
+    hash = FNV_OFFSET;
+    for (int i = 0; i < block->count; i++)
+    {
+        const Lecture *lec = &block->lectures[i];
+        hash = hashField(hashField(hashField(hash, lec->day), lec->time), lec->subject);
+        hash = hashField(hashField(hash, lec->faculty), lec->room);
+    }
+    hash += hash == 0;
+    atomic_store_explicit(&cached->hash, hash, memory_order_relaxed);
+    return hash;
+}
+
+unsigned long long versionSectionHash(const TimetableVersion *version, int sectionId)
+{
+    unsigned long long hash = FNV_OFFSET;
+    for (int d = 0; d < DAY_COUNT; d++)
+    {
+        const Block *block = versionBlock(version, sectionId, d);
+        unsigned long long day = block != NULL && block->count > 0 ? blockHash(block) : (unsigned long long)d + 1;
+        hash = (hash ^ day) * FNV_PRIME;
+        hash ^= hash >> 29;
+    }
+    return hash + (hash == 0);
+}
+
+// Private copy of a section's block for one day, NULL if the day is empty
+Block *draftBlock(TimetableVersion *draft, int sectionId, int day)
+{
+    if (versionBlock(draft, sectionId, day) == NULL)
+        return NULL;
+    SectionDays *section = mutableSection(draft, sectionId, 0);
+    if (section == NULL)
+        return NULL;
+    Block *block = section->days[day];
+    if (block->hdr.owner != draft->id)
+    {
+        Block *copy = allocBlock(block->count, draft->id);
+        if (copy == NULL)
+            return NULL;
+        memcpy(copy->lectures, block->lectures, sizeof(Lecture) * block->count);
+        copy->busy = block->busy;
+        copy->doubled = block->doubled;
+        releaseBlock(block);
+        section->days[day] = block = copy;
+    }
+    return block;
+}
+
+int versionRoomBookings(const TimetableVersion *version, int roomId, int day, unsigned int period)
+{
+    if (roomId < 0 || roomId >= version->roomCount || version->rooms[roomId] == NULL || day < 0 || day >= DAY_COUNT)
+        return 0;
+    const RoomWeek *room = version->rooms[roomId];
+    int p = 0;
+    while (period > 1u << p)
+        p++;
+    return room->busy[day] & period ? room->bookings[day][p] : 0;
+}
+
+int versionRoomFits(const TimetableVersion *version, int roomId, int day, unsigned int periods)
+{
+    if (roomId < 0 || roomId >= version->roomCount || version->rooms[roomId] == NULL || day < 0 || day >= DAY_COUNT)
+        return 1;
+    const RoomWeek *room = version->rooms[roomId];
+    unsigned int taken = room->busy[day] & periods;
+    if (taken == 0)
+        return 1;
+    int capacity = atomic_load_explicit(&version->roomTable->capacity[roomId], memory_order_relaxed);
+    for (int p = 0; taken != 0; p++, taken >>= 1)
+    {
+        if ((taken & 1) && room->bookings[day][p] >= capacity)
+            return 0;
+    }
+    return 1;
+}
+
+// Private (copied if shared) occupancy of a room
+static RoomWeek *mutableRoom(TimetableVersion *draft, int roomId)
+{
+    RoomWeek *room = draft->rooms[roomId];
+    if (room != NULL && room->hdr.owner == draft->id)
+        return room;
+    RoomWeek *copy = (RoomWeek *)memAlloc(MEM_INDEX, sizeof(RoomWeek));
+    if (copy == NULL)
+        return NULL;
+    if (room != NULL)
+        memcpy(copy, room, sizeof(RoomWeek));
+    else
+        memset(copy, 0, sizeof(RoomWeek));
+    headerInit(&copy->hdr, draft->id);
+    releaseRoom(room);
+    draft->rooms[roomId] = copy;
+    if (roomId >= draft->roomCount)
+        draft->roomCount = roomId + 1;
+    return copy;
+}
+
+static int bookRoom(TimetableVersion *draft, const Lecture *lec, int day, int delta)
+{
+    int roomId = lec->room[0] != '\0' ? roomTableFind(draft->roomTable, lec->room) : -1;
+    if (roomId < 0)
+        return TT_OK;
+    RoomWeek *room = mutableRoom(draft, roomId);
+    if (room == NULL)
+        return TT_ERR_NOMEM;
+    unsigned int periods = lec->periods;
+    for (int p = 0; periods != 0; p++, periods >>= 1)
+    {
+        if (!(periods & 1))
+            continue;
+        int bookings = room->bookings[day][p] + delta;
+        room->bookings[day][p] = (unsigned char)(bookings > 0 ? bookings : 0);
+        if (bookings > 0)
+            room->busy[day] |= 1u << p;
+        else
+            room->busy[day] &= ~(1u << p);
+    }
+    return TT_OK;
+}
+
+static const TeacherWeek *teacherAt(const TimetableVersion *version, int teacherId)
+{
+    const TeacherChunk *chunk = version->teacherChunks[teacherId / CHUNK_TEACHERS];
+    return chunk ? chunk->teachers[teacherId % CHUNK_TEACHERS] : NULL;
+}
+
+int versionTeacherBookings(const TimetableVersion *version, int teacherId, int day, unsigned int period)
+{
+    if (teacherId < 0 || teacherId >= MAX_TEACHERS || day < 0 || day >= DAY_COUNT)
+        return 0;
+    const TeacherWeek *teacher = teacherAt(version, teacherId);
+    if (teacher == NULL || !(teacher->busy[day] & period))
+        return 0;
+    int p = 0;
+    while (period > 1u << p)
+        p++;
+    return teacher->bookings[day][p];
+}
+
+// Private (copied if shared) occupancy of a teacher with space for classes classes
+static TeacherWeek *mutableTeacher(TimetableVersion *draft, int teacherId, int classes)
+{
+    TeacherChunk **chunkSlot = &draft->teacherChunks[teacherId / CHUNK_TEACHERS];
+    TeacherChunk *chunk = *chunkSlot;
+    if (chunk == NULL || chunk->hdr.owner != draft->id)
+    {
+        TeacherChunk *copy = (TeacherChunk *)memAlloc(MEM_INDEX, sizeof(TeacherChunk));
+        if (copy == NULL)
+            return NULL;
+        if (chunk != NULL)
+            *copy = *chunk;
+        else
+            memset(copy, 0, sizeof(TeacherChunk));
+        headerInit(&copy->hdr, draft->id);
+        for (int i = 0; i < CHUNK_TEACHERS; i++)
+            retain(copy->teachers[i] ? &copy->teachers[i]->hdr : NULL);
+        releaseTeacherChunk(chunk);
+        *chunkSlot = chunk = copy;
+    }
+
+    TeacherWeek **slot = &chunk->teachers[teacherId % CHUNK_TEACHERS];
+    TeacherWeek *teacher = *slot;
+    if (teacher != NULL && teacher->hdr.owner == draft->id && teacher->capacity >= classes)
+        return teacher;
+    int capacity = teacher != NULL ? teacher->capacity : 2;
+    while (capacity < classes)
+        capacity *= 2;
+    TeacherWeek *copy = (TeacherWeek *)memAlloc(MEM_INDEX, TEACHER_BYTES(capacity));
+    if (copy == NULL)
+        return NULL;
+    if (teacher != NULL)
+        memcpy(copy, teacher, TEACHER_BYTES(teacher->classCount));
+    else
+        memset(copy, 0, sizeof(TeacherWeek));
+    headerInit(&copy->hdr, draft->id);
+    copy->capacity = capacity;
+    releaseTeacher(teacher);
+    *slot = copy;
+    return copy;
+}
+
+// Index of the class a lecture belongs to, or -1
+static int findClass(const TeacherWeek *teacher, const Lecture *lec)
+{
+    for (int c = 0; teacher != NULL && c < teacher->classCount; c++)
+    {
+        if (strcmp(teacher->classes[c].subject, lec->subject) == 0 && strcmp(teacher->classes[c].room, lec->room) == 0)
+            return c;
+    }
+    return -1;
+}
+
+// A teacher is booked once per class at a period, however many sections it holds
+static int bookTeacher(TimetableVersion *draft, const Lecture *lec, int day, int delta)
+{
+    if (!isTeacher(lec->faculty))
+        return TT_OK;
+    int teacherId = delta > 0 ? teacherTableAdd(draft->teacherTable, lec->faculty)
+                              : teacherTableFind(draft->teacherTable, lec->faculty);
+    if (teacherId < 0)
+        return TT_OK; // past MAX_TEACHERS the validation scans for the teacher instead
+    const TeacherWeek *current = teacherAt(draft, teacherId);
+    int c = findClass(current, lec);
+    if (c < 0 && delta < 0)
+        return TT_OK;
+    int classCount = current != NULL ? current->classCount : 0;
+    TeacherWeek *teacher = mutableTeacher(draft, teacherId, c < 0 ? classCount + 1 : classCount);
+    if (teacher == NULL)
+        return TT_ERR_NOMEM;
+    if (c < 0)
+    {
+        c = teacher->classCount++;
+        memset(&teacher->classes[c], 0, sizeof(TeacherClass));
+        strcpy(teacher->classes[c].subject, lec->subject);
+        strcpy(teacher->classes[c].room, lec->room);
+    }
+    TeacherClass *cls = &teacher->classes[c];
+    unsigned int periods = lec->periods;
+    for (int p = 0; periods != 0; p++, periods >>= 1)
+    {
+        if (!(periods & 1))
+            continue;
+        int was = cls->lectures[day][p], now = was + delta;
+        cls->lectures[day][p] = (unsigned char)(now > 0 ? now : 0);
+        if ((was > 0) == (now > 0))
+            continue; // another section joined or left a combined lecture
+        int bookings = teacher->bookings[day][p] + (now > 0 ? 1 : -1);
+        teacher->bookings[day][p] = (unsigned char)(bookings > 0 ? bookings : 0);
+        if (bookings > 0)
+            teacher->busy[day] |= 1u << p;
+        else
+            teacher->busy[day] &= ~(1u << p);
+    }
+    return TT_OK;
+}
+
+int draftBook(TimetableVersion *draft, const Lecture *lec, int day, int delta)
+{
+    if (lec->periods == 0 || day < 0 || day >= DAY_COUNT)
+        return TT_OK;
+    int status = bookRoom(draft, lec, day, delta);
+    return status == TT_OK ? bookTeacher(draft, lec, day, delta) : status;
+}
+
+Lecture *draftFind(TimetableVersion *draft, int sectionId, int day, const char *time)
+{
+    int index = findInBlock(versionBlock(draft, sectionId, day), time);
+    if (index < 0)
+        return NULL;
+    Block *block = draftBlock(draft, sectionId, day);
+    return block ? &block->lectures[index] : NULL;
+}
+
+// Insert keeping the block sorted by time; the caller checks the slot is free.
+// A block the draft already owns grows in place, so bulk loads stay linear.
+int draftInsert(TimetableVersion *draft, int sectionId, int day, const Lecture *lec)
+{
+    SectionDays *section = mutableSection(draft, sectionId, 1);
+    if (section == NULL)
+        return TT_ERR_NOMEM;
+    Block *old = section->days[day];
+    int count = old ? old->count : 0;
+    // After lectures at the same time, so equal times keep insertion order
+    int at = count;
+    if (count > 0 && strcmp(old->lectures[count - 1].time, lec->time) > 0)
+    {
+        at = lowerBound(old, lec->time);
+        while (at < count && strcmp(old->lectures[at].time, lec->time) == 0)
+            at++;
+    }
+
+    Block *block;
+    if (old != NULL && old->hdr.owner == draft->id)
+    {
+        block = old;
+        if (count == block->capacity)
+        {
+            block = (Block *)memRealloc(MEM_LECTURES, old, BLOCK_BYTES(block->capacity), BLOCK_BYTES(block->capacity * 2));
+            if (block == NULL)
+                return TT_ERR_NOMEM;
+            block->capacity *= 2;
+        }
+        memmove(block->lectures + at + 1, block->lectures + at, sizeof(Lecture) * (count - at));
+        block->count++;
+    }
+    else
+    {
+        block = allocBlock(count + 1, draft->id);
+        if (block == NULL)
+            return TT_ERR_NOMEM;
+        if (at > 0)
+            memcpy(block->lectures, old->lectures, sizeof(Lecture) * at);
+        if (count > at)
+            memcpy(block->lectures + at + 1, old->lectures + at, sizeof(Lecture) * (count - at));
+        block->busy = old ? old->busy : 0;
+        block->doubled = old ? old->doubled : 0;
+        releaseBlock(old);
+    }
+    block->lectures[at] = *lec;
+    block->doubled |= block->busy & lec->periods;
+    block->busy |= lec->periods;
+    section->days[day] = block;
+    draft->count++;
+    return draftBook(draft, lec, day, 1);
+}
+
+int draftRemove(TimetableVersion *draft, int sectionId, int day, const char *time, Lecture *removed)
+{
+    int index = findInBlock(versionBlock(draft, sectionId, day), time);
+    if (index < 0)
+        return TT_ERR_NOT_FOUND;
+    SectionDays *section = mutableSection(draft, sectionId, 0);
+    if (section == NULL)
+        return TT_ERR_NOMEM;
+    Block *old = section->days[day];
+    Lecture gone = old->lectures[index];
+    if (removed != NULL)
+        *removed = gone;
+
+    Block *block = NULL;
+    if (old->count > 1 && old->hdr.owner == draft->id)
+    {
+        block = old;
+        memmove(block->lectures + index, block->lectures + index + 1, sizeof(Lecture) * (block->count - index - 1));
+        block->count--;
+    }
+    else
+    {
+        if (old->count > 1)
+        {
+            block = allocBlock(old->count - 1, draft->id);
+            if (block == NULL)
+                return TT_ERR_NOMEM;
+            memcpy(block->lectures, old->lectures, sizeof(Lecture) * index);
+            memcpy(block->lectures + index, old->lectures + index + 1, sizeof(Lecture) * (old->count - index - 1));
+        }
+        releaseBlock(old);
+    }
+    if (block != NULL)
+        blockUpdateBusy(block);
+    section->days[day] = block;
+    draft->count--;
+    return draftBook(draft, &gone, day, -1);
+}
+
+unsigned long versionId(const TimetableVersion *version)
+{
+    return version->id;
+}
+
+int versionCount(const TimetableVersion *version)
+{
+    return version->count;
+}
+
+// Point lectures at a section's lectures on one day (sorted by time), returns the count
+int versionDay(const TimetableVersion *version, const char *section, int day, const Lecture **lectures)
+{
+    const Block *block = versionBlock(version, sectionTableFind(version->sections, section), day);
+    *lectures = block ? block->lectures : NULL;
+    return block ? block->count : 0;
+}
+
+const Lecture *versionSlot(const TimetableVersion *version, const char *section, int day, const char *time,
+                           unsigned int periods)
+{
+    const Block *block = versionBlock(version, sectionTableFind(version->sections, section), day);
+    int index = findInBlock(block, time);
+    if (index >= 0)
+        return &block->lectures[index];
+    if (block == NULL || !(block->busy & periods))
+        return NULL;
+    for (int i = 0; i < block->count; i++)
+    {
+        if (block->lectures[i].periods & periods)
+            return &block->lectures[i];
+    }
+    return NULL;
+}
+
+// Periods a section has taken on one day
+unsigned int versionDayPeriods(const TimetableVersion *version, const char *section, int day)
+{
+    const Block *block = versionBlock(version, sectionTableFind(version->sections, section), day);
+    return block ? block->busy : 0;
+}
+
+// Visit every lecture by section id, day and time; returns the number visited
+int versionForEach(const TimetableVersion *version, LectureVisitor visit, void *ctx)
+{
+    int visited = 0;
+    for (int c = 0; c < version->chunkCount; c++)
+    {
+        const SectionChunk *chunk = version->chunks[c];
+        for (int i = 0; chunk != NULL && i < CHUNK_SECTIONS; i++)
+        {
+            const SectionDays *section = chunk->sections[i];
+            for (int d = 0; section != NULL && d < DAY_COUNT; d++)
+            {
+                const Block *block = section->days[d];
+                for (int k = 0; block != NULL && k < block->count; k++)
+                {
+                    visited++;
+                    if (visit(&block->lectures[k], ctx))
+                        return visited;
+                }
+            }
+        }
+    }
+    return visited;
+}
+
+static int sameLecture(const Lecture *a, const Lecture *b)
+{
+    return strcmp(a->section, b->section) == 0 && strcmp(a->day, b->day) == 0 && strcmp(a->time, b->time) == 0 &&
+           strcmp(a->subject, b->subject) == 0 && strcmp(a->faculty, b->faculty) == 0 && strcmp(a->room, b->room) == 0;
+}
+
+// Walk two blocks sorted by time side by side, reporting the lectures that differ
+static int compareBlocks(const Block *a, const Block *b, LectureChangeVisitor visit, void *ctx, int *changes)
+{
+    int countA = a ? a->count : 0, countB = b ? b->count : 0;
+    int i = 0, j = 0;
+    while (i < countA || j < countB)
+    {
+        int order = i == countA ? 1 : j == countB ? -1 : strcmp(a->lectures[i].time, b->lectures[j].time);
+        const Lecture *before = order <= 0 ? &a->lectures[i++] : NULL;
+        const Lecture *after = order >= 0 ? &b->lectures[j++] : NULL;
+        if (before != NULL && after != NULL && sameLecture(before, after))
+            continue;
+        (*changes)++;
+        if (visit != NULL && visit(before, after, ctx))
+            return 1;
+    }
+    return 0;
+}
+
+// Report every lecture added, removed or changed between two versions of the same
+// timetable. Subtrees the versions share are skipped without being read, so the cost
+// follows the size of the change rather than the timetable. Returns the number of changes.
+int versionCompare(const TimetableVersion *before, const TimetableVersion *after, LectureChangeVisitor visit, void *ctx)
+{
+    if (before->sections != after->sections)
+        return TT_ERR_INVALID;
+    int changes = 0;
+    for (int c = 0; c < before->chunkCount; c++)
+    {
+        const SectionChunk *chunkA = before->chunks[c], *chunkB = after->chunks[c];
+        if (chunkA == chunkB)
+            continue;
+        for (int i = 0; i < CHUNK_SECTIONS; i++)
+        {
+            const SectionDays *sectionA = chunkA ? chunkA->sections[i] : NULL;
+            const SectionDays *sectionB = chunkB ? chunkB->sections[i] : NULL;
+            if (sectionA == sectionB)
+                continue;
+            for (int d = 0; d < DAY_COUNT; d++)
+            {
+                const Block *blockA = sectionA ? sectionA->days[d] : NULL;
+                const Block *blockB = sectionB ? sectionB->days[d] : NULL;
+                if (blockA != blockB && compareBlocks(blockA, blockB, visit, ctx, &changes))
+                    return changes;
+            }
+        }
+    }
+    return changes;
+}
+
+static const SectionDays *sectionAt(const TimetableVersion *version, int c, int i)
+{
+    return version->chunks[c] ? version->chunks[c]->sections[i] : NULL;
+}
+
+// Bytes of the nodes of version that none of the others share. A node is only ever
+// shared at the position it was created for, so each level compares the pointers
+// the versions hold at the same position and skips subtrees another version holds.
+void versionMemory(const TimetableVersion *version, const TimetableVersion *const others[], int otherCount,
+                   VersionMemory *usage)
+{
+    usage->indexBytes += sizeof(TimetableVersion);
+    for (int c = 0; c < version->chunkCount; c++)
+    {
+        const SectionChunk *chunk = version->chunks[c];
+        int shared = chunk == NULL;
+        for (int k = 0; k < otherCount && !shared; k++)
+            shared = others[k]->chunks[c] == chunk;
+        if (shared)
+            continue;
+        usage->indexBytes += sizeof(SectionChunk);
+        for (int i = 0; i < CHUNK_SECTIONS; i++)
+        {
+            const SectionDays *section = chunk->sections[i];
+            shared = section == NULL;
+            for (int k = 0; k < otherCount && !shared; k++)
+                shared = sectionAt(others[k], c, i) == section;
+            if (shared)
+                continue;
+            usage->indexBytes += sizeof(SectionDays);
+            for (int d = 0; d < DAY_COUNT; d++)
+            {
+                const Block *block = section->days[d];
+                shared = block == NULL;
+                for (int k = 0; k < otherCount && !shared; k++)
+                {
+                    const SectionDays *other = sectionAt(others[k], c, i);
+                    shared = other != NULL && other->days[d] == block;
+                }
+                if (shared)
+                    continue;
+                usage->lectureBytes += BLOCK_BYTES(block->capacity);
+                usage->blocks++;
+            }
+        }
+    }
+    for (int r = 0; r < version->roomCount; r++)
+    {
+        int shared = version->rooms[r] == NULL;
+        for (int k = 0; k < otherCount && !shared; k++)
+            shared = r < others[k]->roomCount && others[k]->rooms[r] == version->rooms[r];
+        if (!shared)
+            usage->indexBytes += sizeof(RoomWeek);
+    }
+    for (int c = 0; c < MAX_TEACHERS / CHUNK_TEACHERS; c++)
+    {
+        const TeacherChunk *chunk = version->teacherChunks[c];
+        int shared = chunk == NULL;
+        for (int k = 0; k < otherCount && !shared; k++)
+            shared = others[k]->teacherChunks[c] == chunk;
+        if (shared)
+            continue;
+        usage->indexBytes += sizeof(TeacherChunk);
+        for (int i = 0; i < CHUNK_TEACHERS; i++)
+        {
+            const TeacherWeek *teacher = chunk->teachers[i];
+            shared = teacher == NULL;
+            for (int k = 0; k < otherCount && !shared; k++)
+                shared = others[k]->teacherChunks[c] != NULL && others[k]->teacherChunks[c]->teachers[i] == teacher;
+            if (!shared)
+                usage->indexBytes += TEACHER_BYTES(teacher->capacity);
+        }
+    }
+}
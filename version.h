@@ -0,0 +1,191 @@
+// Copy-on-write timetable versions, internal to the scheduler library.
+//
+// A version is a tree: a spine of section chunks, each chunk points at the day
+// table of up to CHUNK_SECTIONS sections, and each day table points at one block
+// per day holding that section's lectures sorted by time. Every node carries a
+// reference count, so consecutive versions share all the nodes an edit did not
+// touch. A draft version copies a node the first time it is modified; nodes
+// whose owner is the draft's id are already private to it.
+#ifndef VERSION_H
+#define VERSION_H
+
+#include <stdatomic.h>
+#include "scheduler.h"
+
+#define CHUNK_SECTIONS 64
+#define SECTION_SLOTS (2 * MAX_SECTIONS)
+#define ROOM_SLOTS (2 * MAX_ROOMS)
+#define MAX_TEACHERS 4096
+#define CHUNK_TEACHERS 64
+#define TEACHER_SLOTS (2 * MAX_TEACHERS)
+
+typedef struct
+{
+    atomic_int refs;
+    unsigned long owner; // id of the version that created the node
+} NodeHeader;
+
+// One section's lectures on one day, sorted by time
+typedef struct
+{
+    NodeHeader hdr;
+    unsigned int busy;    // periods taken by its lectures, the OR of their masks
+    unsigned int doubled; // periods taken by more than one of its lectures
+    _Atomic unsigned long long hash; // of what exports print, 0 until first asked for
+    int count;
+    int capacity; // room in lectures[], blocks private to a draft grow in place
+    Lecture lectures[];
+} Block;
+
+typedef struct
+{
+    NodeHeader hdr;
+    Block *days[DAY_COUNT];
+} SectionDays;
+
+typedef struct
+{
+    NodeHeader hdr;
+    SectionDays *sections[CHUNK_SECTIONS];
+} SectionChunk;
+
+// Section names get a small integer id the first time they are used. The
+// table is shared by every version of a timetable and only ever grows; readers
+// look names up without locking while the writer adds new ones.
+typedef struct
+{
+    atomic_int slots[SECTION_SLOTS]; // open addressing by name hash: id + 1, 0 if empty
+    char names[MAX_SECTIONS][SECTION_NAME_LEN];
+    atomic_int count;
+} SectionTable;
+
+// Rooms and labs, registered like sections. A room's capacity is how many
+// sections it holds at once; only the writer changes it.
+typedef struct
+{
+    atomic_int slots[ROOM_SLOTS]; // open addressing by name hash: id + 1, 0 if empty
+    char names[MAX_ROOMS][ROOM_NAME_LEN];
+    atomic_int capacity[MAX_ROOMS];
+    atomic_int count;
+} RoomTable;
+
+// Weekly occupancy of one room: the periods booked each day and by how many
+// lectures, so a booking is tested, added or released in constant time
+typedef struct
+{
+    NodeHeader hdr;
+    unsigned int busy[DAY_COUNT];
+    unsigned char bookings[DAY_COUNT][MAX_PERIODS];
+} RoomWeek;
+
+// Teachers get an id the first time one of their lectures is booked, like rooms.
+// Only the writer uses the table.
+typedef struct
+{
+    atomic_int slots[TEACHER_SLOTS]; // open addressing by name hash: id + 1, 0 if empty
+    char names[MAX_TEACHERS][MAX_LEN];
+    atomic_int count;
+} TeacherTable;
+
+// One subject a teacher takes in one room, with its lectures at each period.
+// Several sections in one class at a period are a combined lecture.
+typedef struct
+{
+    char subject[MAX_LEN];
+    char room[ROOM_NAME_LEN];
+    unsigned char lectures[DAY_COUNT][MAX_PERIODS];
+} TeacherClass;
+
+// Weekly occupancy of one teacher: the periods taken each day and by how many
+// classes, so a combined lecture is one booking however many sections it holds
+typedef struct
+{
+    NodeHeader hdr;
+    unsigned int busy[DAY_COUNT];
+    unsigned char bookings[DAY_COUNT][MAX_PERIODS];
+    int classCount;
+    int capacity;
+    TeacherClass classes[];
+} TeacherWeek;
+
+typedef struct
+{
+    NodeHeader hdr;
+    TeacherWeek *teachers[CHUNK_TEACHERS];
+} TeacherChunk;
+
+typedef struct LectureColumns LectureColumns;
+
+struct TimetableVersion
+{
+    atomic_int refs;
+    unsigned long id;
+    const SectionTable *sections;
+    int count;
+    int chunkCount;
+    SectionChunk *chunks[MAX_SECTIONS / CHUNK_SECTIONS];
+    const RoomTable *roomTable;
+    int roomCount;                      // rooms[] entries in use, highest booked room id + 1
+    RoomWeek *rooms[MAX_ROOMS];         // NULL until the room is first booked
+    TeacherTable *teacherTable;         // shared like the section table; the writer adds to it
+    TeacherChunk *teacherChunks[MAX_TEACHERS / CHUNK_TEACHERS];
+    _Atomic(LectureColumns *) columns; // column table, built on first use once published
+};
+
+void sectionTableInit(SectionTable *table);
+int sectionTableFind(const SectionTable *table, const char *section);
+int sectionTableAdd(SectionTable *table, const char *section);
+void roomTableInit(RoomTable *table);
+int roomTableFind(const RoomTable *table, const char *room);
+// Registers a new room with the given capacity; an existing one keeps its capacity
+int roomTableAdd(RoomTable *table, const char *room, int capacity);
+void teacherTableInit(TeacherTable *table);
+int teacherTableFind(const TeacherTable *table, const char *teacher);
+// Id of a teacher, registering them if needed; -1 when the table is full
+int teacherTableAdd(TeacherTable *table, const char *teacher);
+
+TimetableVersion *versionCreateEmpty(const SectionTable *sections, const RoomTable *rooms, TeacherTable *teachers,
+                                     unsigned long id);
+TimetableVersion *versionCreateDraft(const TimetableVersion *base, unsigned long id);
+void versionRetain(const TimetableVersion *version);
+void versionRelease(const TimetableVersion *version);
+
+const Block *versionBlock(const TimetableVersion *version, int sectionId, int day);
+int findInBlock(const Block *block, const char *time);
+// Lectures booked into a room for one period (a single bit), 0 for an unknown room
+int versionRoomBookings(const TimetableVersion *version, int roomId, int day, unsigned int period);
+// Whether a room has space on every period of a mask
+int versionRoomFits(const TimetableVersion *version, int roomId, int day, unsigned int periods);
+// Classes a teacher takes at one period (a single bit), 0 for an unknown teacher
+int versionTeacherBookings(const TimetableVersion *version, int teacherId, int day, unsigned int period);
+// Recompute busy and doubled after lecture masks of a draft block were changed in place
+void blockUpdateBusy(Block *block);
+// Hash of the fields exports print for a section's week, never 0. Each day block
+// is hashed once and keeps the result: published blocks never change and an edit
+// copies a block before changing it, so only the days an edit touched are hashed
+// again. Only for published versions.
+unsigned long long versionSectionHash(const TimetableVersion *version, int sectionId);
+
+// Draft edits (the draft must not be published yet). Pointers returned by
+// draftBlock and draftFind stay valid until the next insert or remove in the same block.
+Block *draftBlock(TimetableVersion *draft, int sectionId, int day);
+Lecture *draftFind(TimetableVersion *draft, int sectionId, int day, const char *time);
+int draftInsert(TimetableVersion *draft, int sectionId, int day, const Lecture *lec);
+int draftRemove(TimetableVersion *draft, int sectionId, int day, const char *time, Lecture *removed);
+// Book (delta 1) or release (delta -1) a lecture's periods in its room and for its
+// teacher. Insert and remove do this themselves; callers that change a lecture's
+// subject, teacher, room or periods in place release it before and book it again after.
+int draftBook(TimetableVersion *draft, const Lecture *lec, int day, int delta);
+
+typedef struct
+{
+    size_t lectureBytes; // lecture blocks, including unused capacity
+    size_t indexBytes;   // version header, chunks and day tables
+    long blocks;
+} VersionMemory;
+
+// Add to usage the nodes of version that are not shared with any of others
+void versionMemory(const TimetableVersion *version, const TimetableVersion *const others[], int otherCount,
+                   VersionMemory *usage);
+
+#endif